@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Shared helpers for the benchmark executables. Each benchmark prints one line per
+// measurement; they are run by hand and not part of ctest.
+namespace bench {
+
+// Wall time of fn() in milliseconds
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best of several runs, to keep one-off stalls out of the result
+template <typename Fn>
+double bestMs(int runs, Fn&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        double ms = timeMs(fn);
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+// Integer argument argv[index], or fallback
+inline int intArg(int argc, char** argv, int index, int fallback) {
+    return argc > index ? std::atoi(argv[index]) : fallback;
+}
+
+// Keeps the optimizer from dropping a computed value
+template <typename T>
+inline void keep(const T& value) {
+    static thread_local const void* volatile sink;
+    sink = &value;
+    (void)sink;
+}
+
+}  // namespace bench
@@ -0,0 +1,190 @@
+// Key press/release lookup cost: replays a dense 7K chart (every note pressed on time, some
+// holds released early and recovered) through the note lookups of Game::checkJudgement and
+// Game::onKeyRelease, once with LaneNoteIndex and once with the whole-chart scans it
+// replaced. Only the lookups and state changes are timed, not scoring or key sounds.
+//
+// Usage: JudgementBench [notes=10000] [runs=20]
+#include "BenchUtil.h"
+#include "LaneNoteIndex.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+struct KeyEvent {
+    int64_t time;
+    int lane;
+    bool down;
+};
+
+std::vector<Note> makeChart(int count, std::mt19937& rng) {
+    std::vector<Note> notes;
+    int64_t laneFree[7] = {};
+    int64_t time = 1000;
+    while ((int)notes.size() < count) {
+        time += 10 + rng() % 40;
+        int lane = rng() % 7;
+        if (laneFree[lane] > time) continue;
+        bool hold = rng() % 5 == 0;
+        int64_t end = hold ? time + 100 + rng() % 500 : 0;
+        notes.emplace_back(lane, time, hold, end);
+        laneFree[lane] = (hold ? end : time) + 30;
+    }
+    return notes;
+}
+
+// Autoplay input, with every tenth hold released halfway and pressed again
+std::vector<KeyEvent> makeInput(const std::vector<Note>& notes) {
+    std::vector<KeyEvent> events;
+    for (size_t i = 0; i < notes.size(); i++) {
+        const Note& n = notes[i];
+        events.push_back({n.time, n.lane, true});
+        if (!n.isHold) {
+            events.push_back({n.time + 1, n.lane, false});
+            continue;
+        }
+        if (i % 10 == 0) {
+            int64_t mid = (n.time + n.endTime) / 2;
+            events.push_back({mid, n.lane, false});
+            events.push_back({mid + 20, n.lane, true});
+        }
+        events.push_back({n.endTime, n.lane, false});
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const KeyEvent& a, const KeyEvent& b) { return a.time < b.time; });
+    return events;
+}
+
+void resetNotes(std::vector<Note>& notes) {
+    for (Note& n : notes) n.state = NoteState::Waiting;
+}
+
+// Press: recover a Released hold, else hit the first Waiting note. Release: end the Holding
+// note, early (Released) before its tail or on it (Hit).
+void applyPress(Note& note) {
+    note.state = note.isHold ? NoteState::Holding : NoteState::Hit;
+}
+
+bool applyRelease(Note& note, int64_t time) {
+    note.state = time < note.endTime ? NoteState::Released : NoteState::Hit;
+    return note.state == NoteState::Hit;
+}
+
+// The scans checkJudgement, onKeyRelease and updateLaneNextNoteIndex used to do
+int64_t replayScan(std::vector<Note>& notes, const std::vector<KeyEvent>& events) {
+    int laneNext[18];
+    std::fill(laneNext, laneNext + 18, -1);
+    int64_t handled = 0;
+    auto updateNext = [&](int lane, int current) {
+        for (size_t i = current + 1; i < notes.size(); i++) {
+            if (notes[i].lane == lane && !notes[i].isFakeNote) {
+                laneNext[lane] = (int)i;
+                return;
+            }
+        }
+        laneNext[lane] = -1;
+    };
+    for (const KeyEvent& e : events) {
+        if (e.down) {
+            bool recovered = false;
+            for (auto& note : notes) {
+                if (note.isFakeNote) continue;
+                if (note.state == NoteState::Released && note.lane == e.lane && note.isHold) {
+                    note.state = NoteState::Holding;
+                    recovered = true;
+                    break;
+                }
+            }
+            if (recovered) {
+                handled++;
+                continue;
+            }
+            for (size_t i = 0; i < notes.size(); i++) {
+                Note& note = notes[i];
+                if (note.state != NoteState::Waiting || note.lane != e.lane) continue;
+                if (note.isFakeNote) continue;
+                applyPress(note);
+                if (!note.isHold) updateNext(e.lane, (int)i);
+                handled++;
+                break;
+            }
+        } else {
+            for (size_t i = 0; i < notes.size(); i++) {
+                Note& note = notes[i];
+                if (note.isFakeNote) continue;
+                if (note.state != NoteState::Holding || note.lane != e.lane) continue;
+                if (applyRelease(note, e.time)) updateNext(e.lane, (int)i);
+                handled++;
+                break;
+            }
+        }
+    }
+    return handled;
+}
+
+int64_t replayIndex(std::vector<Note>& notes, LaneNoteIndex& index, const std::vector<KeyEvent>& events) {
+    int64_t handled = 0;
+    for (const KeyEvent& e : events) {
+        if (e.down) {
+            int released = index.findHold(notes, e.lane, NoteState::Released);
+            if (released >= 0) {
+                notes[released].state = NoteState::Holding;
+                handled++;
+                continue;
+            }
+            int idx = index.findWaiting(notes, e.lane);
+            if (idx >= 0) {
+                applyPress(notes[idx]);
+                if (!notes[idx].isHold) index.onNoteResolved(e.lane, idx);
+                handled++;
+            }
+        } else {
+            int idx = index.findHold(notes, e.lane, NoteState::Holding);
+            if (idx >= 0) {
+                if (applyRelease(notes[idx], e.time)) index.onNoteResolved(e.lane, idx);
+                handled++;
+            }
+        }
+    }
+    return handled;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int count = bench::intArg(argc, argv, 1, 10000);
+    int runs = bench::intArg(argc, argv, 2, 20);
+
+    std::mt19937 rng(2024);
+    std::vector<Note> notes = makeChart(count, rng);
+    std::vector<KeyEvent> events = makeInput(notes);
+
+    int64_t scanHandled = 0, indexHandled = 0;
+    double scanMs = bench::bestMs(runs, [&] {
+        resetNotes(notes);
+        scanHandled = replayScan(notes, events);
+    });
+    std::vector<NoteState> scanStates;
+    for (const Note& n : notes) scanStates.push_back(n.state);
+    LaneNoteIndex index;
+    double indexMs = bench::bestMs(runs, [&] {
+        resetNotes(notes);
+        index.build(notes);
+        indexHandled = replayIndex(notes, index, events);
+    });
+    bool sameStates = true;
+    for (size_t i = 0; i < notes.size(); i++) sameStates &= notes[i].state == scanStates[i];
+    if (scanHandled != indexHandled || !sameStates) {
+        std::printf("mismatch: scan handled %lld events, index %lld\n", (long long)scanHandled,
+                    (long long)indexHandled);
+        return 1;
+    }
+
+    double scanNs = scanMs * 1e6 / events.size();
+    double indexNs = indexMs * 1e6 / events.size();
+    std::printf("%d notes, %zu key events (7K, %.1f s)\n", count, events.size(), notes.back().time / 1000.0);
+    std::printf("whole-chart scan: %9.2f ms  %9.1f ns/event\n", scanMs, scanNs);
+    std::printf("LaneNoteIndex:    %9.2f ms  %9.1f ns/event (incl. build, %.0fx)\n", indexMs, indexNs,
+                scanNs / indexNs);
+    return 0;
+}
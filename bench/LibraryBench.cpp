@@ -0,0 +1,130 @@
+// Library database costs on a synthetic library: saving every song (journal appends, from
+// several threads as the scan does), folding the journal into a snapshot, and the warm
+// startup that follows, i.e. the cached path of Game::scanFolder (folder walk, loadIndex,
+// isIndexValid) with the database reopened each run. Startup is timed both from the snapshot
+// and from an unflushed journal. Runs in a temp directory, so Data/Index is its own.
+//
+// Usage: LibraryBench [songs=20000] [runs=3] [save threads=0 (all)]
+#include "BenchUtil.h"
+#include "SongIndex.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static CachedSong makeSong(const fs::path& folder, int index) {
+    fs::path chart = folder / "chart.osu";
+    std::ofstream(chart) << "osu file format v14\n";
+
+    CachedSong song;
+    song.folderPath = folder.string();
+    song.folderName = folder.filename().string();
+    song.title = "Title " + std::to_string(index);
+    song.titleUnicode = song.title;
+    song.artist = "Artist " + std::to_string(index % 997);
+    song.artistUnicode = song.artist;
+    song.backgroundPath = (folder / "bg.jpg").string();
+    song.audioPath = (folder / "audio.mp3").string();
+    song.tags = "bench library tags";
+    song.previewTime = 1000;
+    song.source = 0;
+    song.lastModified = SongIndex::getFolderModTime(song.folderPath);
+    FileFingerprint fp;
+    SongIndex::getFileFingerprint(chart.string(), fp);
+    fp.contentHash = "0123456789abcdef0123456789abcdef";
+    song.files.push_back(fp);
+    for (int d = 0; d < 3; d++) {
+        CachedDifficulty diff = {};
+        diff.path = chart.string();
+        diff.version = "7K Lv." + std::to_string(d);
+        diff.creator = "Bench";
+        diff.hash = fp.contentHash;
+        diff.keyCount = 7;
+        diff.starRatings[0] = diff.starRatings[1] = 2.0 + d;
+        diff.fileIndex = 0;
+        song.difficulties.push_back(diff);
+    }
+    return song;
+}
+
+// Game::scanFolder's cached path for every folder; returns the songs found valid
+static int warmScan(const fs::path& root) {
+    int valid = 0;
+    for (const auto& entry : fs::directory_iterator(root)) {
+        CachedSong song;
+        if (SongIndex::loadIndex(entry.path().string(), song) && SongIndex::isIndexValid(song)) valid++;
+    }
+    return valid;
+}
+
+int main(int argc, char** argv) {
+    int count = bench::intArg(argc, argv, 1, 20000);
+    int runs = bench::intArg(argc, argv, 2, 3);
+    unsigned threads = (unsigned)bench::intArg(argc, argv, 3, 0);
+
+    fs::path dir = fs::temp_directory_path() / "mania_library_bench";
+    fs::remove_all(dir);
+    fs::path root = dir / "Songs";
+    fs::create_directories(root);
+    fs::current_path(dir);
+
+    std::vector<CachedSong> songs;
+    std::vector<std::string> live;
+    songs.reserve(count);
+    for (int i = 0; i < count; i++) {
+        fs::path folder = root / ("song" + std::to_string(i));
+        fs::create_directories(folder);
+        songs.push_back(makeSong(folder, i));
+        live.push_back(songs.back().folderPath);
+    }
+
+    SongIndex::clear();
+    std::atomic<int> saved{0};
+    double saveMs = bench::timeMs([&] {
+        WorkStealingPool pool(threads);
+        threads = pool.size();
+        for (const CachedSong& song : songs) {
+            pool.submit([&] { saved += SongIndex::saveIndex(song); });
+        }
+        pool.wait();
+    });
+
+    int valid = 0;
+    double journalMs = bench::bestMs(runs, [&] {
+        SongIndex::close();
+        valid = warmScan(root);
+    });
+    bool ok = saved == count && valid == count;
+
+    double flushMs = bench::timeMs([&] { SongIndex::flush(live); });
+    double snapshotMs = bench::bestMs(runs, [&] {
+        SongIndex::close();
+        valid = warmScan(root);
+    });
+    ok = ok && valid == count;
+    double lookupMs = bench::bestMs(runs, [&] {
+        SongIndex::close();
+        CachedSong song;
+        valid = 0;
+        for (const std::string& folder : live) valid += SongIndex::loadIndex(folder, song);
+    });
+    ok = ok && valid == count;
+
+    SongIndex::close();
+    fs::current_path(fs::temp_directory_path());
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    if (!ok) {
+        std::printf("mismatch: %d of %d songs saved, %d found valid\n", saved.load(), count, valid);
+        return 1;
+    }
+
+    std::printf("%d songs, 3 difficulties each\n", count);
+    std::printf("save (%2u threads):      %9.1f ms  %8.1f us/song\n", threads, saveMs, saveMs * 1000.0 / count);
+    std::printf("flush to snapshot:      %9.1f ms\n", flushMs);
+    std::printf("warm startup, journal:  %9.1f ms\n", journalMs);
+    std::printf("warm startup, snapshot: %9.1f ms  (open + lookups only %.1f ms)\n", snapshotMs, lookupMs);
+    return 0;
+}
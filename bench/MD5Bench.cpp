@@ -0,0 +1,173 @@
+// MD5 throughput: the unrolled transform and mapped hashFile against the previous
+// implementation (table-driven loop transform, 4 KB ifstream reads) kept here as LegacyMD5,
+// plus the cost of a hashFileCached hit. The file is hashed warm, out of the page cache.
+//
+// Usage: MD5Bench [size MB=64] [runs=5]
+#include "BenchUtil.h"
+#include "MD5.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t LEGACY_S[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+const uint32_t LEGACY_K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+// MD5 before the unrolled transform
+class LegacyMD5 {
+public:
+    std::string hash(const uint8_t* data, size_t length) {
+        reset();
+        update(data, length);
+        return finish();
+    }
+
+    std::string hashFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return "";
+        reset();
+        char buf[4096];
+        while (file.read(buf, sizeof(buf))) update((uint8_t*)buf, file.gcount());
+        if (file.gcount() > 0) update((uint8_t*)buf, file.gcount());
+        return finish();
+    }
+
+private:
+    uint32_t state[4];
+    uint64_t count;
+    uint8_t buffer[64];
+
+    void reset() {
+        state[0] = 0x67452301;
+        state[1] = 0xefcdab89;
+        state[2] = 0x98badcfe;
+        state[3] = 0x10325476;
+        count = 0;
+    }
+
+    void transform(const uint8_t block[64]) {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t M[16];
+        for (int i = 0; i < 16; i++) {
+            M[i] = (uint32_t)block[i*4] | ((uint32_t)block[i*4+1] << 8) |
+                   ((uint32_t)block[i*4+2] << 16) | ((uint32_t)block[i*4+3] << 24);
+        }
+        for (int i = 0; i < 64; i++) {
+            uint32_t f, g;
+            if (i < 16) {
+                f = (b & c) | ((~b) & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | ((~d) & c);
+                g = (5*i + 1) % 16;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3*i + 5) % 16;
+            } else {
+                f = c ^ (b | (~d));
+                g = (7*i) % 16;
+            }
+            uint32_t temp = d;
+            d = c;
+            c = b;
+            uint32_t x = a + f + LEGACY_K[i] + M[g];
+            b = b + ((x << LEGACY_S[i]) | (x >> (32 - LEGACY_S[i])));
+            a = temp;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+
+    void update(const uint8_t* data, size_t length) {
+        size_t index = (count / 8) % 64;
+        count += length * 8;
+        size_t firstPart = 64 - index;
+        size_t i = 0;
+        if (length >= firstPart) {
+            memcpy(&buffer[index], data, firstPart);
+            transform(buffer);
+            for (i = firstPart; i + 63 < length; i += 64) transform(&data[i]);
+            index = 0;
+        }
+        memcpy(&buffer[index], &data[i], length - i);
+    }
+
+    std::string finish() {
+        uint8_t padding[64] = {0x80};
+        uint8_t bits[8];
+        for (int i = 0; i < 8; i++) bits[i] = (uint8_t)(count >> (i * 8));
+        size_t index = (count / 8) % 64;
+        update(padding, index < 56 ? 56 - index : 120 - index);
+        update(bits, 8);
+        char hex[33];
+        for (int i = 0; i < 16; i++) snprintf(hex + i * 2, 3, "%02x", (state[i / 4] >> ((i % 4) * 8)) & 0xff);
+        return hex;
+    }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int sizeMb = bench::intArg(argc, argv, 1, 64);
+    int runs = bench::intArg(argc, argv, 2, 5);
+    size_t size = (size_t)sizeMb << 20;
+
+    std::vector<uint8_t> data(size);
+    std::mt19937 rng(99);
+    for (auto& b : data) b = (uint8_t)rng();
+    fs::path path = fs::temp_directory_path() / "mania_md5_bench.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    LegacyMD5 legacy;
+    std::string digest, legacyDigest, fileDigest, legacyFileDigest;
+    double memNew = bench::bestMs(runs, [&] { digest = MD5::hash(data.data(), data.size()); });
+    double memOld = bench::bestMs(runs, [&] { legacyDigest = legacy.hash(data.data(), data.size()); });
+    double fileNew = bench::bestMs(runs, [&] { fileDigest = MD5::hashFile(path.string()); });
+    double fileOld = bench::bestMs(runs, [&] { legacyFileDigest = legacy.hashFile(path.string()); });
+
+    MD5::hashFileCached(path.string());
+    const int hits = 10000;
+    double cachedMs = bench::bestMs(runs, [&] {
+        for (int i = 0; i < hits; i++) bench::keep(MD5::hashFileCached(path.string()));
+    });
+
+    fs::remove(path);
+    if (digest != legacyDigest || fileDigest != digest || legacyFileDigest != digest) {
+        std::printf("digest mismatch: %s %s %s %s\n", digest.c_str(), legacyDigest.c_str(), fileDigest.c_str(),
+                    legacyFileDigest.c_str());
+        return 1;
+    }
+
+    std::printf("%d MB, digest %s\n", sizeMb, digest.c_str());
+    std::printf("memory:   %8.1f MB/s  (legacy %8.1f MB/s, %.2fx)\n", sizeMb * 1000.0 / memNew,
+                sizeMb * 1000.0 / memOld, memOld / memNew);
+    std::printf("hashFile: %8.1f MB/s  (legacy %8.1f MB/s, %.2fx)\n", sizeMb * 1000.0 / fileNew,
+                sizeMb * 1000.0 / fileOld, fileOld / fileNew);
+    std::printf("hashFileCached hit: %.2f us\n", cachedMs * 1000.0 / hits);
+    return 0;
+}
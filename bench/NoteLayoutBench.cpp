@@ -0,0 +1,259 @@
+// Note layout: the judgement and render loops over a chart with the hot/cold Note and
+// interned key sound names, against the previous layout (std::string filenames, fields in
+// declaration order) kept here as LegacyNote. Also prints a memory report, and times
+// KeysoundName::str() against the shared_mutex lookup it replaced, alone and with readers
+// running while another thread interns.
+//
+// Usage: NoteLayoutBench [notes=10000] [frames=2000] [reader threads=4]
+#include "BenchUtil.h"
+#include "Note.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Note before the hot/cold split
+struct LegacyNote {
+    int lane;
+    int64_t time;
+    bool isHold;
+    int64_t endTime;
+    NoteState state;
+    int64_t nextTickTime;
+    int64_t headHitError;
+    bool hadComboBreak;
+    bool headHit;
+    bool headHitEarly;
+    int64_t headReleaseTime;
+    int64_t headGrayStartTime;
+    float x;
+    ObjectType objectType;
+    int spanCount;
+    int segmentDuration;
+    bool hasClap;
+    bool hasFinish;
+    bool hasWhistle;
+    bool isFakeNote;
+    bool fakeNoteShouldFix;
+    float fakeNoteFixedY;
+    bool fakeNoteHasFixedY;
+    SampleSet sampleSet;
+    SampleSet additions;
+    int customIndex;
+    int volume;
+    std::string filename;
+    int sampleHandle;
+    SampleSet tailSampleSet;
+    SampleSet tailAdditions;
+    int tailCustomIndex;
+    int tailVolume;
+    std::string tailFilename;
+    int tailSampleHandle;
+    int64_t missedTime;
+    float missedY;
+    bool missedYSet;
+
+    LegacyNote(int lane, int64_t time, bool isHold, int64_t endTime)
+        : lane(lane), time(time), isHold(isHold), endTime(endTime), state(NoteState::Waiting),
+          nextTickTime(0), headHitError(0), hadComboBreak(false), headHit(false), headHitEarly(false),
+          headReleaseTime(0), headGrayStartTime(0), x(0), objectType(ObjectType::HitCircle),
+          spanCount(1), segmentDuration(0), hasClap(false), hasFinish(false), hasWhistle(false),
+          isFakeNote(false), fakeNoteShouldFix(false), fakeNoteFixedY(0), fakeNoteHasFixedY(false),
+          sampleSet(SampleSet::None), additions(SampleSet::None), customIndex(0), volume(0),
+          sampleHandle(-1), tailSampleSet(SampleSet::None), tailAdditions(SampleSet::None),
+          tailCustomIndex(0), tailVolume(0), tailSampleHandle(-1), missedTime(0), missedY(0),
+          missedYSet(false) {}
+};
+
+// The string table before it went lock-free
+struct LockedTable {
+    std::shared_mutex mutex;
+    std::deque<std::string> names{std::string()};
+    std::unordered_map<std::string, uint32_t> ids;
+
+    uint32_t intern(const std::string& name) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        names.push_back(name);
+        return ids[name] = (uint32_t)names.size() - 1;
+    }
+    const std::string& lookup(uint32_t id) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return names[id];
+    }
+};
+
+static std::vector<std::string> sampleNames(int count) {
+    std::vector<std::string> names;
+    for (int i = 0; i < count; i++) names.push_back("keysound_" + std::to_string(i) + "_layer.wav");
+    return names;
+}
+
+template <typename N>
+static std::vector<N> makeChart(int count, const std::vector<std::string>& names) {
+    std::mt19937 rng(7);
+    std::vector<N> notes;
+    notes.reserve(count);
+    int64_t time = 1000;
+    for (int i = 0; i < count; i++) {
+        time += 20 + rng() % 100;
+        bool hold = rng() % 6 == 0;
+        N note(rng() % 7, time, hold, hold ? time + 150 + rng() % 400 : 0);
+        note.filename = names[rng() % names.size()];
+        if (hold) note.tailFilename = names[rng() % names.size()];
+        notes.push_back(note);
+    }
+    return notes;
+}
+
+// Render pass: every frame walks the chart for notes in a 2 s window that are still shown
+template <typename N>
+static int64_t renderLoop(const std::vector<N>& notes, int frames, int64_t chartEnd) {
+    int64_t visible = 0;
+    for (int f = 0; f < frames; f++) {
+        int64_t now = chartEnd * f / frames;
+        for (const N& n : notes) {
+            if (n.isFakeNote || n.state == NoteState::Hit) continue;
+            int64_t end = n.isHold ? n.endTime : n.time;
+            if (end < now - 200 || n.time > now + 2000) continue;
+            visible += n.lane + (n.time - now);
+        }
+    }
+    return visible;
+}
+
+// Judgement pass: a sweep per 1 ms step hitting or missing notes as they pass the line
+template <typename N>
+static int64_t judgementLoop(std::vector<N>& notes, int64_t chartEnd) {
+    for (N& n : notes) n.state = NoteState::Waiting;
+    int64_t hits = 0;
+    size_t first = 0;
+    for (int64_t now = 0; now <= chartEnd + 200; now++) {
+        while (first < notes.size() && notes[first].state != NoteState::Waiting) first++;
+        for (size_t i = first; i < notes.size() && notes[i].time <= now + 200; i++) {
+            N& n = notes[i];
+            if (n.state != NoteState::Waiting || n.isFakeNote) continue;
+            if (now - n.time > 150) {
+                n.state = NoteState::Missed;
+            } else if (n.time == now && n.lane != 3) {
+                n.state = n.isHold ? NoteState::Holding : NoteState::Hit;
+                n.headHit = true;
+                hits++;
+            }
+        }
+    }
+    return hits;
+}
+
+template <typename N>
+static size_t heapBytes(const std::vector<N>& notes) {
+    size_t bytes = 0;
+    for (const N& n : notes) {
+        if (n.filename.capacity() > 15) bytes += n.filename.capacity() + 1;
+        if (n.tailFilename.capacity() > 15) bytes += n.tailFilename.capacity() + 1;
+    }
+    return bytes;
+}
+
+// Lookups per second from several readers while another thread keeps interning new names.
+// pass() looks every note's name up once and returns the summed lengths.
+template <typename Pass, typename Intern>
+static double concurrentLookupsPerSec(int readers, size_t perPass, Pass pass, Intern intern) {
+    std::atomic<bool> stop{false};
+    std::atomic<int64_t> total{0};
+    std::thread writer([&] {
+        for (int i = 0; !stop; i++) {
+            intern("streamed_" + std::to_string(i) + ".ogg");
+            if (i % 64 == 0) std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            size_t sum = 0;
+            int64_t count = 0;
+            while (!stop) {
+                sum += pass();
+                count += (int64_t)perPass;
+            }
+            bench::keep(sum);
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop = true;
+    for (auto& t : threads) t.join();
+    writer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total.load() / seconds;
+}
+
+int main(int argc, char** argv) {
+    int count = bench::intArg(argc, argv, 1, 10000);
+    int frames = bench::intArg(argc, argv, 2, 2000);
+    int readers = bench::intArg(argc, argv, 3, 4);
+    std::vector<std::string> names = sampleNames(300);
+
+    std::vector<Note> notes = makeChart<Note>(count, names);
+    std::vector<LegacyNote> legacy = makeChart<LegacyNote>(count, names);
+    int64_t chartEnd = notes.back().isHold ? notes.back().endTime : notes.back().time;
+
+    std::printf("%d notes, %d distinct key sounds\n", count, (int)names.size());
+    std::printf("memory:  sizeof(Note) %zu  (legacy %zu)\n", sizeof(Note), sizeof(LegacyNote));
+    std::printf("         array %zu KB + %zu names in the shared table  (legacy %zu KB + %zu KB filename heap)\n",
+                notes.size() * sizeof(Note) / 1024, KeysoundName::tableSize(),
+                legacy.size() * sizeof(LegacyNote) / 1024, heapBytes(legacy) / 1024);
+
+    int64_t sink = 0;
+    double renderNew = bench::bestMs(5, [&] { sink += renderLoop(notes, frames, chartEnd); });
+    double renderOld = bench::bestMs(5, [&] { sink += renderLoop(legacy, frames, chartEnd); });
+    double judgeNew = bench::bestMs(5, [&] { sink += judgementLoop(notes, chartEnd); });
+    double judgeOld = bench::bestMs(5, [&] { sink += judgementLoop(legacy, chartEnd); });
+    double copyNew = bench::bestMs(20, [&] { std::vector<Note> copy = notes; sink += copy.size(); });
+    double copyOld = bench::bestMs(20, [&] { std::vector<LegacyNote> copy = legacy; sink += copy.size(); });
+    bench::keep(sink);
+    std::printf("render (%d frames): %8.2f ms  (legacy %8.2f ms, %.2fx)\n", frames, renderNew, renderOld, renderOld / renderNew);
+    std::printf("judgement sweep:    %8.2f ms  (legacy %8.2f ms, %.2fx)\n", judgeNew, judgeOld, judgeOld / judgeNew);
+    std::printf("copy chart:         %8.3f ms  (legacy %8.3f ms, %.2fx)\n", copyNew, copyOld, copyOld / copyNew);
+
+    // Name lookups: the lock-free table against the shared_mutex one
+    LockedTable locked;
+    std::vector<uint32_t> lockedIds;
+    for (const Note& n : notes) lockedIds.push_back(locked.intern(n.filename.str()));
+    auto passNew = [&] {
+        size_t sum = 0;
+        for (const Note& n : notes) sum += n.filename.str().size();
+        return sum;
+    };
+    auto passOld = [&] {
+        size_t sum = 0;
+        for (uint32_t id : lockedIds) sum += locked.lookup(id).size();
+        return sum;
+    };
+    const int passes = 200;
+    size_t total = 0;
+    double lookupNew = bench::bestMs(3, [&] {
+        for (int p = 0; p < passes; p++) total += passNew();
+    });
+    double lookupOld = bench::bestMs(3, [&] {
+        for (int p = 0; p < passes; p++) total += passOld();
+    });
+    bench::keep(total);
+    double nsPerLookup = 1e6 / ((double)passes * count);
+    std::printf("str() lookup:       %8.2f ns  (shared_mutex %8.2f ns)\n", lookupNew * nsPerLookup,
+                lookupOld * nsPerLookup);
+
+    double concurrentNew = concurrentLookupsPerSec(readers, notes.size(), passNew,
+        [](const std::string& name) { bench::keep(KeysoundName(name).id()); });
+    double concurrentOld = concurrentLookupsPerSec(readers, notes.size(), passOld,
+        [&](const std::string& name) { bench::keep(locked.intern(name)); });
+    std::printf("%d readers + 1 interning: %8.1f M lookups/s  (shared_mutex %8.1f M lookups/s)\n", readers,
+                concurrentNew / 1e6, concurrentOld / 1e6);
+    return 0;
+}
@@ -0,0 +1,199 @@
+// OJM keysound loading: parses a generated M30 file and gets every sample to PCM, once the
+// way Game::loadBeatmap used to (each sample written to a temp directory and loaded back from
+// its file) and once from the parsed buffers in memory, decoded on a WorkStealingPool as
+// AudioManager::loadSamplesFromMemory does. BASS is not linked here, so copying the WAV's
+// PCM out stands in for BASS_SampleLoad in both paths; the difference measured is the file
+// round trip, not the decoder.
+//
+// Usage: OjmLoadBench [samples=500] [runs=5]
+#include "BenchUtil.h"
+#include "OjmParser.h"
+#include "PcmSample.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void putU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (i * 8)));
+}
+
+std::vector<uint8_t> makeWav(uint32_t freq, uint16_t channels, uint32_t frames, std::mt19937& rng) {
+    uint32_t dataSize = frames * channels * 2;
+    std::vector<uint8_t> wav;
+    wav.reserve(44 + dataSize);
+    wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+    putU32(wav, dataSize + 36);
+    wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    putU32(wav, 16);
+    putU16(wav, 1);
+    putU16(wav, channels);
+    putU32(wav, freq);
+    putU32(wav, freq * channels * 2);
+    putU16(wav, channels * 2);
+    putU16(wav, 16);
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    putU32(wav, dataSize);
+    for (uint32_t i = 0; i < dataSize; i++) wav.push_back((uint8_t)rng());
+    return wav;
+}
+
+// Unencrypted M30 holding WAV keysounds of 0.1 - 1 s (the parser does not look inside them)
+std::vector<uint8_t> makeM30(int count, size_t& payloadBytes) {
+    std::mt19937 rng(21);
+    std::vector<uint8_t> file;
+    file.insert(file.end(), {'M', '3', '0', 0});
+    putU32(file, 1);      // Version
+    putU32(file, 0);      // No encryption
+    putU32(file, count);  // Sample count
+    putU32(file, 28);     // Samples offset
+    putU32(file, 0);      // Payload size
+    putU32(file, 0);
+    payloadBytes = 0;
+    for (int i = 0; i < count; i++) {
+        uint16_t channels = rng() % 3 == 0 ? 1 : 2;
+        std::vector<uint8_t> wav = makeWav(44100, channels, 4410 + rng() % 39690, rng);
+        char name[32] = {};
+        snprintf(name, sizeof(name), "W%03d.wav", i);
+        file.insert(file.end(), name, name + 32);
+        putU32(file, (uint32_t)wav.size());
+        putU16(file, 5);  // Keysound
+        putU16(file, 0);
+        putU32(file, 0);
+        putU16(file, (uint16_t)i);
+        putU16(file, 0);
+        putU32(file, 0);
+        file.insert(file.end(), wav.begin(), wav.end());
+        payloadBytes += wav.size();
+    }
+    return file;
+}
+
+// Stand-in for BASS_SampleLoad: find the fmt and data chunks and copy the PCM out
+bool decodeWav(const uint8_t* data, size_t size, PcmSample& out) {
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) return false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        uint32_t chunkSize;
+        memcpy(&chunkSize, data + pos + 4, 4);
+        const uint8_t* body = data + pos + 8;
+        if (chunkSize > size - pos - 8) return false;
+        if (memcmp(data + pos, "fmt ", 4) == 0 && chunkSize >= 16) {
+            memcpy(&out.channels, body + 2, 2);
+            memcpy(&out.freq, body + 4, 4);
+        } else if (memcmp(data + pos, "data", 4) == 0) {
+            out.data.assign(body, body + chunkSize);
+            return out.channels > 0 && !out.empty();
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+bool decodeFile(const fs::path& path, PcmSample& out) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::vector<uint8_t> data((size_t)in.tellg());
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(data.data()), data.size());
+    return in && decodeWav(data.data(), data.size(), out);
+}
+
+// Before: every sample written under the temp directory and loaded back by path
+std::vector<PcmSample> loadViaTempFiles(const std::string& ojmPath, const fs::path& tempDir) {
+    OjmInfo info;
+    std::vector<PcmSample> pcm;
+    if (!OjmParser::parse(ojmPath, info)) return pcm;
+    fs::create_directories(tempDir);
+    std::vector<int> ids;
+    for (const auto& [id, sample] : info.samples) ids.push_back(id);
+    std::sort(ids.begin(), ids.end());
+    pcm.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        const OjmSample& sample = info.samples[ids[i]];
+        fs::path tempFile = tempDir / (std::to_string(ids[i]) + (sample.isOgg ? ".ogg" : ".wav"));
+        std::ofstream out(tempFile, std::ios::binary);
+        if (!out) continue;
+        out.write(reinterpret_cast<const char*>(sample.data.data()), sample.data.size());
+        out.close();
+        decodeFile(tempFile, pcm[i]);
+    }
+    return pcm;
+}
+
+// After: the parsed buffers decoded in place, side by side
+std::vector<PcmSample> loadFromMemory(const std::string& ojmPath) {
+    OjmInfo info;
+    std::vector<PcmSample> pcm;
+    if (!OjmParser::parse(ojmPath, info)) return pcm;
+    std::vector<int> ids;
+    for (const auto& [id, sample] : info.samples) ids.push_back(id);
+    std::sort(ids.begin(), ids.end());
+    pcm.resize(ids.size());
+    unsigned threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), ids.size());
+    WorkStealingPool pool(threads);
+    for (size_t i = 0; i < ids.size(); i++) {
+        const OjmSample* sample = &info.samples[ids[i]];
+        pool.submit([sample, &pcm, i]() { decodeWav(sample->data.data(), sample->data.size(), pcm[i]); });
+    }
+    pool.wait();
+    return pcm;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int count = bench::intArg(argc, argv, 1, 500);
+    int runs = bench::intArg(argc, argv, 2, 5);
+
+    size_t payloadBytes = 0;
+    std::vector<uint8_t> ojm = makeM30(count, payloadBytes);
+    fs::path dir = fs::temp_directory_path() / "mania_ojm_bench";
+    fs::create_directories(dir);
+    fs::path ojmPath = dir / "bench.ojm";
+    {
+        std::ofstream out(ojmPath, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(ojm.data()), ojm.size());
+    }
+    fs::path tempDir = dir / "Tmp" / "ojm";
+
+    OjmInfo info;
+    double parseMs = bench::bestMs(runs, [&] {
+        info = OjmInfo();
+        OjmParser::parse(ojmPath.string(), info);
+    });
+    std::vector<PcmSample> before, after;
+    double beforeMs = bench::bestMs(runs, [&] { before = loadViaTempFiles(ojmPath.string(), tempDir); });
+    double afterMs = bench::bestMs(runs, [&] { after = loadFromMemory(ojmPath.string()); });
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    bool same = before.size() == (size_t)count && after.size() == before.size();
+    for (size_t i = 0; same && i < before.size(); i++) {
+        same = !before[i].empty() && before[i].data == after[i].data && before[i].freq == after[i].freq &&
+               before[i].channels == after[i].channels;
+    }
+    if (!same) {
+        std::printf("mismatch: %zu samples via temp files, %zu from memory\n", before.size(), after.size());
+        return 1;
+    }
+
+    std::printf("%d samples, %.1f MB OJM\n", count, payloadBytes / 1048576.0);
+    std::printf("parse only:       %8.2f ms\n", parseMs);
+    std::printf("via temp files:   %8.2f ms  (%.1f us/sample)\n", beforeMs, beforeMs * 1000.0 / count);
+    std::printf("from memory:      %8.2f ms  (%.1f us/sample, %.2fx)\n", afterMs, afterMs * 1000.0 / count,
+                beforeMs / afterMs);
+    return 0;
+}
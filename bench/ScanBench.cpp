@@ -0,0 +1,108 @@
+// Folder scan throughput: builds a synthetic osu!mania library and runs the per-chart work of
+// Game::scanFolder (parse, MD5, both star ratings) one folder after another, then on a
+// WorkStealingPool with the analysis nested the way runDiffAnalysis does it, for every pool
+// size from 1 thread up to the hardware concurrency.
+//
+// Usage: ScanBench [folders=200] [charts per folder=4] [notes per chart=2000] [max threads=0 (all)]
+#include "BenchUtil.h"
+#include "OsuParser.h"
+#include "StarRating.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static void writeChart(const fs::path& path, int index, int notes, std::mt19937& rng) {
+    std::ofstream out(path);
+    out << "osu file format v14\n\n[General]\nAudioFilename: audio.mp3\nMode: 3\n\n"
+        << "[Metadata]\nTitle:Bench\nArtist:Bench\nCreator:Bench\nVersion:7K " << index << "\n\n"
+        << "[Difficulty]\nCircleSize:7\nOverallDifficulty:8\n\n"
+        << "[TimingPoints]\n0,300,4,2,0,100,1,0\n\n[HitObjects]\n";
+    int64_t time = 1000;
+    for (int i = 0; i < notes; i++) {
+        time += 30 + rng() % 120;
+        int x = 36 + (rng() % 7) * 73;
+        if (rng() % 8 == 0) {
+            out << x << ",192," << time << ",128,0," << time + 200 << ":0:0:0:0:\n";
+        } else {
+            out << x << ",192," << time << ",1,0,0:0:0:0:\n";
+        }
+    }
+}
+
+static std::vector<fs::path> makeLibrary(const fs::path& root, int folders, int charts, int notes) {
+    std::mt19937 rng(1234);
+    std::vector<fs::path> result;
+    for (int f = 0; f < folders; f++) {
+        fs::path folder = root / ("song" + std::to_string(f));
+        fs::create_directories(folder);
+        for (int c = 0; c < charts; c++) {
+            writeChart(folder / ("chart" + std::to_string(c) + ".osu"), c, notes, rng);
+        }
+        result.push_back(folder);
+    }
+    return result;
+}
+
+// One folder's scan work; analysis goes through the pool when called from a worker
+static void scanFolder(const fs::path& folder, std::atomic<int>& ratedCharts) {
+    for (const auto& file : fs::directory_iterator(folder)) {
+        BeatmapInfo info;
+        if (!OsuParser::parse(file.path().string(), info)) continue;
+        double ratings[2] = {0, 0};
+        std::vector<std::function<void()>> tasks;
+        tasks.push_back([&] { ratings[0] = calculateStarRating(info.notes, info.keyCount, StarRatingVersion::OsuStable_b20260101); });
+        tasks.push_back([&] { ratings[1] = calculateStarRating(info.notes, info.keyCount, StarRatingVersion::OsuStable_b20220101); });
+        if (WorkStealingPool* pool = WorkStealingPool::current()) {
+            pool->run(tasks);
+        } else {
+            for (auto& task : tasks) task();
+        }
+        bench::keep(ratings);
+        ratedCharts++;
+    }
+}
+
+int main(int argc, char** argv) {
+    int folders = bench::intArg(argc, argv, 1, 200);
+    int charts = bench::intArg(argc, argv, 2, 4);
+    int notes = bench::intArg(argc, argv, 3, 2000);
+    unsigned maxThreads = (unsigned)bench::intArg(argc, argv, 4, 0);
+    if (maxThreads == 0) maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // A fresh copy per run, so no run can reuse digests cached by an earlier one
+    fs::path root = fs::temp_directory_path() / "mania_scan_bench";
+    fs::remove_all(root);
+    std::vector<fs::path> serialLib = makeLibrary(root / "serial", folders, charts, notes);
+
+    std::atomic<int> rated{0};
+    double serialMs = bench::timeMs([&] {
+        for (const auto& folder : serialLib) scanFolder(folder, rated);
+    });
+    std::printf("%d folders x %d charts x %d notes (%d charts rated)\n", folders, charts, notes, rated.load());
+    std::printf("serial:            %8.1f ms  %8.1f folders/s\n", serialMs, folders * 1000.0 / serialMs);
+
+    for (unsigned threads = 1; threads <= maxThreads; threads++) {
+        fs::path libRoot = root / ("pool" + std::to_string(threads));
+        std::vector<fs::path> poolLib = makeLibrary(libRoot, folders, charts, notes);
+        double poolMs = bench::timeMs([&] {
+            WorkStealingPool pool(threads);
+            for (const auto& folder : poolLib) {
+                pool.submit([&folder, &rated] { scanFolder(folder, rated); });
+            }
+            pool.wait();
+        });
+        fs::remove_all(libRoot);
+        std::printf("pool (%2u threads): %8.1f ms  %8.1f folders/s  (%.2fx)\n", threads, poolMs,
+                    folders * 1000.0 / poolMs, serialMs / poolMs);
+    }
+
+    fs::remove_all(root);
+    return 0;
+}
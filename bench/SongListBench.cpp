@@ -0,0 +1,162 @@
+// Song select memory on a synthetic osu! library: heap bytes of the SongEntry list as the
+// scan builds it and after SongEntry::compact(), of the search index built over it, and of
+// the compact row records (pooled display strings, fixed-size song and difficulty rows) that
+// the list would need if it were materialized from the library database instead. Also times
+// the per-frame std::find for the selected song's filtered position that song select used to
+// do, against the cached position.
+//
+// Usage: SongListBench [songs=50000] [difficulties per song=4]
+#include "BenchUtil.h"
+#include "SongEntry.h"
+#include "SongSearchIndex.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+
+// Live heap bytes, counted by the global allocation functions below (single-threaded)
+static size_t liveBytes = 0;
+
+void* operator new(size_t size) {
+    void* block = std::malloc(size + 16);
+    if (!block) throw std::bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    liveBytes += size;
+    return static_cast<char*>(block) + 16;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    char* block = static_cast<char*>(p) - 16;
+    liveBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+
+// A song select row as a fixed-size record; strings live in one pool
+struct SongRow {
+    uint32_t title, artist;  // Pool offsets, NUL-terminated
+    uint32_t firstDiff;
+    uint16_t diffCount;
+    uint8_t source;
+};
+
+struct DiffRow {
+    uint32_t version;
+    float starRatings[2];
+    uint8_t keyCount;
+};
+
+struct RowModel {
+    std::string pool;
+    std::vector<SongRow> songs;
+    std::vector<DiffRow> diffs;
+
+    uint32_t add(const std::string& s) {
+        uint32_t offset = (uint32_t)pool.size();
+        pool.append(s).push_back('\0');
+        return offset;
+    }
+};
+
+std::vector<SongEntry> makeLibrary(int count, int diffs) {
+    std::vector<SongEntry> songs;
+    for (int i = 0; i < count; i++) {
+        SongEntry song;
+        song.title = "Song Title Number " + std::to_string(i);
+        song.titleUnicode = song.title;
+        song.artist = "Artist Name " + std::to_string(i % 3000);
+        song.artistUnicode = song.artist;
+        song.folderName = std::to_string(100000 + i) + " " + song.artist + " - " + song.title;
+        song.folderPath = "C:/Games/osu!/Songs/" + song.folderName;
+        song.backgroundPath = song.folderPath + "/background.jpg";
+        song.audioPath = song.folderPath + "/audio.mp3";
+        song.sourceText = i % 4 == 0 ? "Touhou Project" : "";
+        song.tags = "mania 7k keysound community pack";
+        song.source = BeatmapSource::Osu;
+        for (int d = 0; d < diffs; d++) {
+            DifficultyInfo diff;
+            diff.version = "7K Level " + std::to_string(d);
+            diff.creator = "Mapper" + std::to_string(i % 500);
+            diff.path = song.folderPath + "/" + song.artist + " - " + song.title + " (" + diff.creator + ") [" +
+                        diff.version + "].osu";
+            diff.hash = "0123456789abcdef0123456789abcdef";
+            diff.keyCount = 7;
+            diff.starRatings[0] = diff.starRatings[1] = 1.5 + d;
+            // The scanner fills these in per difficulty, mostly with the song's own paths
+            diff.backgroundPath = song.backgroundPath;
+            diff.audioPath = song.audioPath;
+            diff.totalLength = 120000;
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        }
+        songs.push_back(std::move(song));
+    }
+    return songs;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int count = bench::intArg(argc, argv, 1, 50000);
+    int diffsPerSong = bench::intArg(argc, argv, 2, 4);
+
+    size_t base = liveBytes;
+    std::vector<SongEntry> songs = makeLibrary(count, diffsPerSong);
+    songs.shrink_to_fit();
+    size_t scanned = liveBytes - base;
+
+    for (SongEntry& song : songs) song.compact();
+    size_t compacted = liveBytes - base;
+
+    size_t beforeIndex = liveBytes;
+    SongSearchIndex index;
+    index.build(songs);
+    size_t searchIndex = liveBytes - beforeIndex;
+
+    size_t beforeRows = liveBytes;
+    RowModel rows;
+    for (const SongEntry& song : songs) {
+        SongRow row = {rows.add(song.title), rows.add(song.artist), (uint32_t)rows.diffs.size(),
+                       (uint16_t)song.difficulties.size(), (uint8_t)song.source};
+        for (const DifficultyInfo& d : song.difficulties) {
+            rows.diffs.push_back({rows.add(d.version), {(float)d.starRatings[0], (float)d.starRatings[1]},
+                                  (uint8_t)d.keyCount});
+        }
+        rows.songs.push_back(row);
+    }
+    rows.pool.shrink_to_fit();
+    rows.songs.shrink_to_fit();
+    rows.diffs.shrink_to_fit();
+    size_t rowModel = liveBytes - beforeRows;
+
+    // Selected song near the end of the list: the worst case of the old per-frame search
+    std::vector<int> filtered(count);
+    std::iota(filtered.begin(), filtered.end(), 0);
+    int selected = count - 1;
+    const int frames = 1000;
+    int64_t sum = 0;
+    double findMs = bench::bestMs(5, [&] {
+        for (int f = 0; f < frames; f++) {
+            bench::keep(selected);
+            sum += std::find(filtered.begin(), filtered.end(), selected) - filtered.begin();
+        }
+    });
+    bench::keep(sum);
+
+    auto mb = [](size_t bytes) { return bytes / 1048576.0; };
+    std::printf("%d songs, %d difficulties each\n", count, diffsPerSong);
+    std::printf("SongEntry list, as scanned: %8.1f MB  %6zu B/song\n", mb(scanned), scanned / count);
+    std::printf("SongEntry list, compacted:  %8.1f MB  %6zu B/song  (%.2fx)\n", mb(compacted), compacted / count,
+                (double)scanned / compacted);
+    std::printf("search index:               %8.1f MB  %6zu B/song\n", mb(searchIndex), searchIndex / count);
+    std::printf("compact row records:        %8.1f MB  %6zu B/song  (%.1fx below the compacted list)\n",
+                mb(rowModel), rowModel / count, (double)compacted / rowModel);
+    std::printf("selected position, std::find per frame: %8.2f us  (cached: one compare)\n", findMs * 1000.0 / frames);
+    return 0;
+}
@@ -0,0 +1,40 @@
+# ============================================================================
+# Test and benchmark executables
+# ============================================================================
+# mania_add_tool(<name> <main.cpp> [SDL] [SOURCES <files...>])
+# One executable built from its own main.cpp plus the repository sources it exercises
+# (paths relative to the repository root). SDL links SDL3 for code that logs through it.
+set(MANIA_ROOT ${CMAKE_CURRENT_LIST_DIR}/..)
+
+function(mania_add_tool name main)
+    cmake_parse_arguments(ARG "SDL" "" "SOURCES" ${ARGN})
+    list(TRANSFORM ARG_SOURCES PREPEND ${MANIA_ROOT}/)
+    add_executable(${name} ${main} ${ARG_SOURCES})
+    target_include_directories(${name} PRIVATE
+        ${CMAKE_CURRENT_SOURCE_DIR}
+        ${MANIA_ROOT}/src/core
+        ${MANIA_ROOT}/src/parsers
+        ${MANIA_ROOT}/src/graphics
+        ${MANIA_ROOT}/src/audio
+        ${MANIA_ROOT}/src/systems
+        ${MANIA_ROOT}/include
+        ${MANIA_ROOT}/third_party/minilzo
+    )
+    if(MSVC)
+        target_compile_options(${name} PRIVATE /utf-8 /EHsc /O2)
+        target_compile_definitions(${name} PRIVATE _CRT_SECURE_NO_WARNINGS NOMINMAX)
+    else()
+        target_compile_options(${name} PRIVATE -Wall -Wextra -Wno-unused-parameter -O2)
+        find_package(Threads REQUIRED)
+        target_link_libraries(${name} PRIVATE Threads::Threads)
+    endif()
+    if(ARG_SDL)
+        if(WIN32)
+            target_link_directories(${name} PRIVATE ${MANIA_ROOT}/lib/x64)
+            target_link_libraries(${name} PRIVATE SDL3)
+        else()
+            target_include_directories(${name} PRIVATE ${SDL3_INCLUDE_DIRS})
+            target_link_libraries(${name} PRIVATE ${SDL3_LIBRARIES})
+        endif()
+    endif()
+endfunction()
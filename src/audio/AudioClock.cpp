@@ -0,0 +1,96 @@
+#include "AudioClock.h"
+#include <cmath>
+
+AudioClock::AudioClock()
+    : rate_(1.0), synced_(false), running_(false), lastRawMs_(0), lastWallMs_(0), smoothedMs_(0),
+      logging_(false), logStartMs_(0), logSamples_(0), logSnaps_(0),
+      logMaxDrift_(0), logMaxJitter_(0), logSumAbsJitter_(0), reportReady_(false), report_() {}
+
+void AudioClock::reset() {
+    synced_ = false;
+}
+
+void AudioClock::setRate(double rate) {
+    rate_ = rate > 0 ? rate : 1.0;
+}
+
+void AudioClock::setLogging(bool enabled) {
+    logging_ = enabled;
+    logSamples_ = 0;
+    logStartMs_ = -1;
+    reportReady_ = false;
+}
+
+bool AudioClock::takeReport(Report& report) {
+    if (!reportReady_) return false;
+    report = report_;
+    reportReady_ = false;
+    return true;
+}
+
+double AudioClock::update(double rawMs, bool running, double wallMs) {
+    Sample sample = {wallMs, rawMs, rawMs, 0.0, 0.0, false};
+    double previousMs = smoothedMs_;
+    double wallDelta = wallMs - lastWallMs_;
+
+    if (!synced_ || !running || !running_ || wallDelta < 0) {
+        // Stopped, paused, just started or reset: follow raw exactly
+        smoothedMs_ = rawMs;
+        sample.snapped = running;
+    } else {
+        double predicted = smoothedMs_ + wallDelta * rate_;
+        if (rawMs != lastRawMs_) {
+            // Raw advanced: compare against extrapolation and correct a fraction of the drift
+            double drift = rawMs - predicted;
+            sample.driftMs = drift;
+            if (std::fabs(drift) > SNAP_MS) {
+                predicted = rawMs;
+                sample.snapped = true;
+            } else {
+                predicted += drift * CORRECTION_GAIN;
+            }
+        }
+        // Never run backwards while playing (except on a snap, e.g. seek)
+        if (predicted < smoothedMs_ && !sample.snapped) {
+            predicted = smoothedMs_;
+        }
+        smoothedMs_ = predicted;
+        sample.jitterMs = (smoothedMs_ - previousMs) - wallDelta * rate_;
+    }
+
+    synced_ = true;
+    running_ = running;
+    lastRawMs_ = rawMs;
+    lastWallMs_ = wallMs;
+    sample.smoothedMs = smoothedMs_;
+
+    if (observer_ || logging_) record(sample);
+    return smoothedMs_;
+}
+
+void AudioClock::record(const Sample& sample) {
+    if (observer_) observer_(sample);
+    if (!logging_ || !running_) return;
+
+    if (logSamples_ == 0 || logStartMs_ < 0) {
+        logStartMs_ = sample.wallMs;
+        logSamples_ = 0;
+        logSnaps_ = 0;
+        logMaxDrift_ = 0;
+        logMaxJitter_ = 0;
+        logSumAbsJitter_ = 0;
+    }
+    logSamples_++;
+    if (sample.snapped) logSnaps_++;
+    logMaxDrift_ = std::fmax(logMaxDrift_, std::fabs(sample.driftMs));
+    logMaxJitter_ = std::fmax(logMaxJitter_, std::fabs(sample.jitterMs));
+    logSumAbsJitter_ += std::fabs(sample.jitterMs);
+
+    if (sample.wallMs - logStartMs_ >= LOG_INTERVAL_MS) {
+        // An unread report is replaced: only the latest interval matters
+        report_ = {logSamples_, logSnaps_, logMaxDrift_, logMaxJitter_,
+                   logSumAbsJitter_ / logSamples_, sample.rawMs - sample.smoothedMs};
+        reportReady_ = true;
+        logSamples_ = 0;
+    }
+}
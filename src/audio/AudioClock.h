@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+// Smoothed playback clock.
+// The raw audio position only advances when the device consumes a buffer, so it steps
+// in device-period chunks. This clock extrapolates between raw updates using a wall clock
+// and the playback rate, and pulls toward the raw position gradually whenever it changes.
+// Large discontinuities (seek, stall, underrun) snap. It has no audio backend dependency,
+// so it can be driven by a stub position source in headless runs.
+class AudioClock {
+public:
+    // One clock update, passed to the instrumentation observer
+    struct Sample {
+        double wallMs;      // Wall clock time of the update
+        double rawMs;       // Raw audio position
+        double smoothedMs;  // Returned clock value
+        double driftMs;     // Raw minus extrapolated time when raw advanced (0 if raw unchanged)
+        double jitterMs;    // Clock step minus ideal step (wall delta * rate)
+        bool snapped;       // Clock was hard-synced to raw
+    };
+    using Observer = std::function<void(const Sample&)>;
+
+    // Jitter/drift over one logging interval
+    struct Report {
+        int samples;
+        int snaps;
+        double maxDriftMs;
+        double maxJitterMs;
+        double meanJitterMs;
+        double driftMs;  // Raw minus smoothed at the end of the interval
+    };
+
+    AudioClock();
+
+    void reset();  // Next update snaps to the raw position
+    void setRate(double rate);
+    double getRate() const { return rate_; }
+
+    // Feed the raw position; returns the smoothed position in ms
+    double update(double rawMs, bool running, double wallMs);
+    double getTime() const { return smoothedMs_; }
+
+    // Instrumentation: observer sees every update; logging sums jitter/drift into a report
+    // once per second, which takeReport() hands out (false if none is ready)
+    void setObserver(Observer observer) { observer_ = std::move(observer); }
+    void setLogging(bool enabled);
+    bool takeReport(Report& report);
+
+private:
+    static constexpr double SNAP_MS = 50.0;          // Drift beyond this is a discontinuity
+    static constexpr double CORRECTION_GAIN = 0.1;   // Fraction of drift corrected per raw update
+    static constexpr double LOG_INTERVAL_MS = 1000.0;
+
+    double rate_;
+    bool synced_;
+    bool running_;
+    double lastRawMs_;
+    double lastWallMs_;
+    double smoothedMs_;
+    Observer observer_;
+
+    // Logging stats (reset every LOG_INTERVAL_MS)
+    bool logging_;
+    double logStartMs_;
+    int logSamples_;
+    int logSnaps_;
+    double logMaxDrift_;
+    double logMaxJitter_;
+    double logSumAbsJitter_;
+    bool reportReady_;
+    Report report_;
+
+    void record(const Sample& sample);
+};
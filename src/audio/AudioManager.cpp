@@ -1,7 +1,11 @@
 #include "AudioManager.h"
+#include "WorkStealingPool.h"
+#include "MappedFile.h"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <SDL3/SDL.h>
 
 // Perceptual volume curve: maps linear 0-100 to exponential 0.0-1.0
@@ -199,8 +203,10 @@ void AudioManager::shutdown() {
 
     // 3. Free streams and samples
     clearSamples();
+    stopKeysoundMixer();
     cleanupMixerChannels();
     if (tempoStream) { BASS_StreamFree(tempoStream); tempoStream = 0; decodeStream = 0; }
+    musicMemory.reset();
     if (mixerStream) { BASS_StreamFree(mixerStream); mixerStream = 0; }
     if (initialized) { BASS_Free(); initialized = false; }
 
@@ -289,8 +295,10 @@ bool AudioManager::reinitialize(int mode, int device, int bufferMs, int asioDevi
 #endif
 
     clearSamples();
+    stopKeysoundMixer();
     cleanupMixerChannels();
     if (tempoStream) { BASS_StreamFree(tempoStream); tempoStream = 0; decodeStream = 0; }
+    musicMemory.reset();
     if (mixerStream) { BASS_StreamFree(mixerStream); mixerStream = 0; }
     if (initialized) { BASS_Free(); initialized = false; }
     useMixer = false;
@@ -594,8 +602,8 @@ bool AudioManager::initDirectSound(int device, int bufferMs) {
 // ============================================================
 // Music loading and playback
 // ============================================================
-bool AudioManager::loadMusic(const std::string& filepath, bool loop) {
-    // Clean up previous streams
+void AudioManager::freeMusic() {
+    resetClock();
     if (tempoStream) {
         // Remove from mixer first
 #ifdef _WIN32
@@ -607,7 +615,11 @@ bool AudioManager::loadMusic(const std::string& filepath, bool loop) {
         tempoStream = 0;
         decodeStream = 0;
     }
+    musicMemory.reset();
+}
 
+bool AudioManager::loadMusic(const std::string& filepath, bool loop) {
+    freeMusic();
     loopMusic = loop;
 
     // Create decode stream
@@ -619,7 +631,31 @@ bool AudioManager::loadMusic(const std::string& filepath, bool loop) {
         std::cerr << "BASS_StreamCreateFile failed: " << BASS_ErrorGetCode() << std::endl;
         return false;
     }
+    if (!attachMusicStream(loop)) return false;
+
+    std::cout << "Loaded music: " << filepath << std::endl;
+    return true;
+}
+
+bool AudioManager::loadMusicFromMemory(std::shared_ptr<const std::vector<uint8_t>> data, bool loop) {
+    freeMusic();
+    loopMusic = loop;
+    if (!data || data->empty()) return false;
+
+    DWORD flags = BASS_STREAM_DECODE;
+    if (loop) flags |= BASS_SAMPLE_LOOP;
+
+    decodeStream = BASS_StreamCreateFile(TRUE, data->data(), 0, data->size(), flags);
+    if (!decodeStream) {
+        std::cerr << "BASS_StreamCreateFile (memory) failed: " << BASS_ErrorGetCode() << std::endl;
+        return false;
+    }
+    if (!attachMusicStream(loop)) return false;
+    musicMemory = std::move(data);  // BASS reads from it until the stream is freed
+    return true;
+}
 
+bool AudioManager::attachMusicStream(bool loop) {
     // Create tempo stream wrapping the decode stream
     // In mixer mode, tempo stream must also be DECODE so mixer can pull from it
     DWORD tempoFlags = BASS_FX_FREESOURCE;
@@ -660,8 +696,6 @@ bool AudioManager::loadMusic(const std::string& filepath, bool loop) {
     // Apply current settings
     setVolume(currentVolume);
     setPlaybackRate(playbackRate);
-
-    std::cout << "Loaded music: " << filepath << std::endl;
     return true;
 }
 
@@ -679,6 +713,7 @@ void AudioManager::play() {
 
 void AudioManager::stop() {
     if (!tempoStream) return;
+    resetClock();
 #ifdef _WIN32
     if (useMixer && mixerFuncs.loaded) {
         // Pause in mixer and reset position
@@ -735,8 +770,22 @@ void AudioManager::resume() {
 }
 
 int64_t AudioManager::getPosition() const {
+    return static_cast<int64_t>(getPrecisePosition());
+}
+
+double AudioManager::getPrecisePosition() const {
     if (!tempoStream) return 0;
+    double wallMs = (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    std::lock_guard<std::mutex> lock(clockMutex);  // Sampled by both the gameplay and render threads
+    return clock.update(getDevicePosition(), isPlaying(), wallMs);
+}
+
+void AudioManager::resetClock() {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    clock.reset();
+}
 
+double AudioManager::getDevicePosition() const {
 #ifdef _WIN32
     if (useMixer && mixerFuncs.loaded && mixerFuncs.ChannelGetPosition) {
         QWORD pos = mixerFuncs.ChannelGetPosition(tempoStream, BASS_POS_BYTE | BASS_POS_MIXER_DELAY);
@@ -744,17 +793,18 @@ int64_t AudioManager::getPosition() const {
             pos = BASS_ChannelGetPosition(tempoStream, BASS_POS_BYTE);
         }
         double seconds = BASS_ChannelBytes2Seconds(tempoStream, pos);
-        return static_cast<int64_t>(seconds * 1000.0);
+        return seconds * 1000.0;
     }
 #endif
 
     QWORD pos = BASS_ChannelGetPosition(tempoStream, BASS_POS_BYTE);
     double seconds = BASS_ChannelBytes2Seconds(tempoStream, pos);
-    return static_cast<int64_t>(seconds * 1000.0);
+    return seconds * 1000.0;
 }
 
 void AudioManager::setPosition(int64_t ms) {
     if (!tempoStream) return;
+    resetClock();
 
     double seconds = ms / 1000.0;
     HSTREAM source = BASS_FX_TempoGetSource(tempoStream);
@@ -853,9 +903,7 @@ int AudioManager::loadSample(const std::string& filepath) {
     return handle;
 }
 
-int AudioManager::loadSampleFromMemory(const void* data, size_t size) {
-    if (!initialized || !data || size == 0) return -1;
-
+HSAMPLE AudioManager::decodeSample(const void* data, size_t size) {
     HSAMPLE sample = BASS_SampleLoad(TRUE, data, 0, static_cast<DWORD>(size), 65535, BASS_SAMPLE_OVER_POS);
 
 #ifndef _WIN32
@@ -866,15 +914,198 @@ int AudioManager::loadSampleFromMemory(const void* data, size_t size) {
 
     if (!sample) {
         std::cerr << "BASS_SampleLoad (memory) failed: " << BASS_ErrorGetCode() << std::endl;
-        return -1;
     }
+    return sample;
+}
+
+int AudioManager::loadSampleFromMemory(const void* data, size_t size) {
+    if (!initialized || !data || size == 0) return -1;
+
+    HSAMPLE sample = decodeSample(data, size);
+    if (!sample) return -1;
 
     int handle = nextSampleHandle++;
     sampleCache[handle] = sample;
     return handle;
 }
 
+std::vector<int> AudioManager::loadSamplesFromMemory(const std::vector<std::pair<const void*, size_t>>& buffers) {
+    std::vector<int> handles(buffers.size(), -1);
+    if (!initialized || buffers.empty()) return handles;
+
+    // The software mixer plays PCM, so decode to that instead of BASS samples
+    if (softwareMixer && startKeysoundMixer()) {
+        std::vector<PcmSample> pcm(buffers.size());
+        {
+            unsigned threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), buffers.size());
+            WorkStealingPool pool(threads);
+            for (size_t i = 0; i < buffers.size(); i++) {
+                if (!buffers[i].first || buffers[i].second == 0) continue;
+                pool.submit([&buffers, &pcm, i]() {
+                    decodeToPcm(buffers[i].first, buffers[i].second, pcm[i]);
+                });
+            }
+        }
+        for (size_t i = 0; i < pcm.size(); i++) {
+            if (!pcm[i].empty()) handles[i] = loadSampleFromPcm(pcm[i]);
+        }
+        return handles;
+    }
+
+    // BASS decodes each file into its own sample, so the decodes can run side by side;
+    // handles are then assigned here in input order
+    std::vector<HSAMPLE> samples(buffers.size(), 0);
+    {
+        unsigned threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), buffers.size());
+        WorkStealingPool pool(threads);
+        for (size_t i = 0; i < buffers.size(); i++) {
+            if (!buffers[i].first || buffers[i].second == 0) continue;
+            pool.submit([&buffers, &samples, i]() {
+                samples[i] = decodeSample(buffers[i].first, buffers[i].second);
+            });
+        }
+    }
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (!samples[i]) continue;
+        handles[i] = nextSampleHandle++;
+        sampleCache[handles[i]] = samples[i];
+    }
+    return handles;
+}
+
+// Read a decode stream to the end and free it
+static bool drainDecodeStream(HSTREAM stream, PcmSample& out) {
+    BASS_CHANNELINFO info;
+    bool ok = BASS_ChannelGetInfo(stream, &info) && info.chans > 0;
+    out.data.clear();
+    if (ok) {
+        QWORD length = BASS_ChannelGetLength(stream, BASS_POS_BYTE);
+        if (length != (QWORD)-1) out.data.reserve((size_t)length);
+        uint8_t buffer[64 * 1024];
+        for (;;) {
+            DWORD n = BASS_ChannelGetData(stream, buffer, sizeof(buffer));
+            if (n == (DWORD)-1 || n == 0) break;
+            out.data.insert(out.data.end(), buffer, buffer + n);
+        }
+        out.freq = info.freq;
+        out.channels = (uint16_t)info.chans;
+    }
+    BASS_StreamFree(stream);
+    return ok && !out.data.empty();
+}
+
+bool AudioManager::decodeToPcm(const void* data, size_t size, PcmSample& out) {
+    if (!data || size == 0) return false;
+    HSTREAM stream = BASS_StreamCreateFile(TRUE, data, 0, size, BASS_STREAM_DECODE);
+
+#ifndef _WIN32
+    if (!stream && BASS_ErrorGetCode() == BASS_ERROR_FILEFORM) {
+        std::vector<uint8_t> wav = transcodeWithFFmpeg(data, size);
+        if (!wav.empty()) {
+            stream = BASS_StreamCreateFile(TRUE, wav.data(), 0, wav.size(), BASS_STREAM_DECODE);
+            if (stream) return drainDecodeStream(stream, out);  // Before wav goes away
+        }
+    }
+#endif
+
+    if (!stream) {
+        std::cerr << "BASS_StreamCreateFile (decode) failed: " << BASS_ErrorGetCode() << std::endl;
+        return false;
+    }
+    return drainDecodeStream(stream, out);
+}
+
+bool AudioManager::decodeFileToPcm(const std::string& filepath, PcmSample& out) {
+    MappedFile file;
+    if (!file.open(filepath)) return false;
+    return decodeToPcm(file.data(), file.size(), out);
+}
+
+int AudioManager::loadSampleFromPcm(const PcmSample& pcm, int handle) {
+    if (!initialized || pcm.empty() || pcm.channels == 0) return -1;
+
+    if (softwareMixer && startKeysoundMixer()) {
+        if (handle < 0) {
+            handle = nextSampleHandle++;
+        } else {
+            freeSample(handle);
+        }
+        keysoundMixer->setSample(handle, pcm);
+        return handle;
+    }
+
+    HSAMPLE sample = BASS_SampleCreate((DWORD)pcm.data.size(), pcm.freq, pcm.channels, 65535, BASS_SAMPLE_OVER_POS);
+    if (!sample) {
+        std::cerr << "BASS_SampleCreate failed: " << BASS_ErrorGetCode() << std::endl;
+        return -1;
+    }
+    BASS_SampleSetData(sample, pcm.data.data());
+
+    if (handle < 0) {
+        handle = nextSampleHandle++;
+    } else {
+        freeSample(handle);
+    }
+    sampleCache[handle] = sample;
+    return handle;
+}
+
+PreparedSample AudioManager::prepareSample(std::shared_ptr<const PcmSample> pcm) const {
+    PreparedSample prepared;
+    if (!initialized || !pcm || pcm->empty() || pcm->channels == 0) return prepared;
+
+    if (softwareMixer) {
+        prepared.mixed = KeySoundMixer::makeSample(*pcm);
+    } else {
+        prepared.sample = BASS_SampleCreate((DWORD)pcm->data.size(), pcm->freq, pcm->channels, 65535, BASS_SAMPLE_OVER_POS);
+        if (prepared.sample) {
+            BASS_SampleSetData(prepared.sample, pcm->data.data());
+        } else {
+            std::cerr << "BASS_SampleCreate failed: " << BASS_ErrorGetCode() << std::endl;
+        }
+    }
+    prepared.pcm = std::move(pcm);
+    return prepared;
+}
+
+int AudioManager::attachSample(PreparedSample& prepared, int handle) {
+    if (!initialized || !prepared.valid()) return -1;
+
+    if (prepared.mixed && !startKeysoundMixer()) {
+        // The mixer stream could not start: fall back to a BASS sample (the slow path)
+        return prepared.pcm ? loadSampleFromPcm(*prepared.pcm, handle) : -1;
+    }
+    if (handle < 0) {
+        handle = nextSampleHandle++;
+    } else {
+        freeSample(handle);
+    }
+    if (prepared.mixed) {
+        keysoundMixer->setSample(handle, std::move(prepared.mixed));
+    } else {
+        sampleCache[handle] = prepared.sample;
+        prepared.sample = 0;  // Owned by sampleCache now
+    }
+    return handle;
+}
+
+void AudioManager::freeSample(int handle) {
+    if (keysoundMixer) keysoundMixer->removeSample(handle);
+    auto it = sampleCache.find(handle);
+    if (it == sampleCache.end()) return;
+    BASS_SampleFree(it->second);
+    sampleCache.erase(it);
+}
+
 void AudioManager::playSample(int handle, int volume, int64_t offsetMs) {
+    if (keysoundMixer && keysoundMixer->hasSample(handle)) {
+        // No channel per hit: a voice in the software mixer, started at a steady latency
+        float finalVolume = (volume / 100.0f) * (sampleVolume / 100.0f);
+        keysoundMixer->play(handle, finalVolume, 0.0f, playbackRate, offsetMs, keysoundMixer->scheduleFrame());
+        return;
+    }
+
     auto it = sampleCache.find(handle);
     if (it == sampleCache.end()) return;
 
@@ -931,6 +1162,7 @@ void AudioManager::playSample(int handle, int volume, int64_t offsetMs) {
 }
 
 void AudioManager::pauseAllSamples() {
+    if (keysoundMixer) keysoundMixer->pauseAll();
 #ifdef _WIN32
     if (useMixer && mixerFuncs.loaded) {
         // Mixer mode: BASS_SampleGetChannels can't find BASS_SAMCHAN_STREAM channels,
@@ -958,6 +1190,7 @@ void AudioManager::pauseAllSamples() {
 }
 
 void AudioManager::resumeAllSamples() {
+    if (keysoundMixer) keysoundMixer->resumeAll();
 #ifdef _WIN32
     if (useMixer && mixerFuncs.loaded) {
         for (DWORD ch : activeMixerChannels) {
@@ -983,6 +1216,7 @@ void AudioManager::resumeAllSamples() {
 }
 
 void AudioManager::stopAllSamples() {
+    if (keysoundMixer) keysoundMixer->stopAll();
 #ifdef _WIN32
     if (useMixer && mixerFuncs.loaded && mixerFuncs.ChannelRemove) {
         for (DWORD ch : activeMixerChannels) {
@@ -1045,6 +1279,7 @@ void AudioManager::warmupSamples() {
 }
 
 void AudioManager::clearSamples() {
+    if (keysoundMixer) keysoundMixer->clear();
     activeMixerChannels.clear();
     for (auto& pair : sampleCache) {
         BASS_SampleFree(pair.second);
@@ -1053,6 +1288,70 @@ void AudioManager::clearSamples() {
     nextSampleHandle = 1;
 }
 
+bool AudioManager::startKeysoundMixer() {
+    if (keysoundStream) return true;
+    if (!initialized) return false;
+
+    // Mixed at the output rate, so samples at that rate need no resampling
+    DWORD freq = 44100;
+#ifdef _WIN32
+    if (useMixer && mixerStream) {
+        BASS_CHANNELINFO info;
+        if (BASS_ChannelGetInfo(mixerStream, &info) && info.freq) freq = info.freq;
+    } else
+#endif
+    {
+        BASS_INFO info;
+        if (BASS_GetInfo(&info) && info.freq) freq = info.freq;
+    }
+
+    keysoundMixer = std::make_unique<KeySoundMixer>(freq);
+    DWORD flags = BASS_SAMPLE_FLOAT;
+    if (useMixer) flags |= BASS_STREAM_DECODE;  // Pulled by the BASSmix mixer
+    keysoundStream = BASS_StreamCreate(freq, 2, flags, &AudioManager::KeysoundMixerProc, keysoundMixer.get());
+    if (!keysoundStream) {
+        std::cerr << "Keysound mixer stream failed: " << BASS_ErrorGetCode()
+                  << ", using BASS samples" << std::endl;
+        keysoundMixer.reset();
+        softwareMixer = false;
+        return false;
+    }
+    DWORD streamBufferMs = 0;
+#ifdef _WIN32
+    if (useMixer && mixerFuncs.loaded && mixerStream) {
+        mixerFuncs.StreamAddChannel(mixerStream, keysoundStream, BASS_MIXER_CHAN_NORAMPIN);
+    } else
+#endif
+    {
+        // A playing stream is buffered BASS_CONFIG_BUFFER (500 ms by default) ahead, which
+        // every hit would wait out: render straight into the device's updates instead
+        if (!BASS_ChannelSetAttribute(keysoundStream, BASS_ATTRIB_BUFFER, 0)) {
+            streamBufferMs = BASS_GetConfig(BASS_CONFIG_BUFFER);
+        }
+        BASS_ChannelPlay(keysoundStream, FALSE);
+    }
+    // What render() writes is still queued in the device buffer (and any stream buffer left)
+    keysoundMixer->setOutputBuffer((uint32_t)((uint64_t)(bufferSizeMs + streamBufferMs) * freq / 1000));
+    std::cout << "Audio: software keysound mixer at " << freq << " Hz, "
+              << bufferSizeMs + streamBufferMs << " ms output buffer" << std::endl;
+    return true;
+}
+
+void AudioManager::stopKeysoundMixer() {
+    // Freeing the stream also takes it out of the BASSmix mixer
+    if (keysoundStream) { BASS_StreamFree(keysoundStream); keysoundStream = 0; }
+    keysoundMixer.reset();
+}
+
+DWORD CALLBACK AudioManager::KeysoundMixerProc(HSTREAM handle, void* buffer, DWORD length, void* user) {
+    if (shuttingDown) {
+        memset(buffer, 0, length);
+        return length;
+    }
+    static_cast<KeySoundMixer*>(user)->render(static_cast<float*>(buffer), length / (2 * sizeof(float)));
+    return length;
+}
+
 void AudioManager::setSampleVolume(int volume) {
     sampleVolume = std::max(0, std::min(100, volume));
 }
@@ -1066,6 +1365,10 @@ int AudioManager::getSampleVolume() const {
 // ============================================================
 void AudioManager::setPlaybackRate(float rate) {
     playbackRate = rate;
+    {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        clock.setRate(rate);
+    }
     if (tempoStream) {
         float tempo = (rate - 1.0f) * 100.0f;
         BASS_ChannelSetAttribute(tempoStream, BASS_ATTRIB_TEMPO, tempo);
@@ -1098,29 +1401,29 @@ bool AudioManager::getChangePitch() const {
 // Linux FFmpeg transcoding
 // ============================================================
 #ifndef _WIN32
-HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
+std::vector<uint8_t> AudioManager::transcodeWithFFmpeg(const void* data, size_t size) {
     fs::path tempDir = fs::current_path() / "Data" / "Tmp" / "ffmpeg";
     fs::create_directories(tempDir);
 
-    static int tempCounter = 0;
+    static std::atomic<int> tempCounter{0};  // Samples may be decoded on several threads
     std::string inputPath = (tempDir / ("in_" + std::to_string(tempCounter++) + ".wav")).string();
 
     {
         std::ofstream out(inputPath, std::ios::binary);
-        if (!out) return 0;
+        if (!out) return {};
         out.write(static_cast<const char*>(data), size);
     }
 
     AVFormatContext* fmtCtx = nullptr;
     if (avformat_open_input(&fmtCtx, inputPath.c_str(), nullptr, nullptr) < 0) {
         fs::remove(inputPath);
-        return 0;
+        return {};
     }
 
     if (avformat_find_stream_info(fmtCtx, nullptr) < 0) {
         avformat_close_input(&fmtCtx);
         fs::remove(inputPath);
-        return 0;
+        return {};
     }
 
     int audioIdx = -1;
@@ -1134,7 +1437,7 @@ HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
     if (audioIdx < 0) {
         avformat_close_input(&fmtCtx);
         fs::remove(inputPath);
-        return 0;
+        return {};
     }
 
     AVCodecParameters* codecPar = fmtCtx->streams[audioIdx]->codecpar;
@@ -1142,7 +1445,7 @@ HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
     if (!codec) {
         avformat_close_input(&fmtCtx);
         fs::remove(inputPath);
-        return 0;
+        return {};
     }
 
     AVCodecContext* codecCtx = avcodec_alloc_context3(codec);
@@ -1151,7 +1454,7 @@ HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
         avcodec_free_context(&codecCtx);
         avformat_close_input(&fmtCtx);
         fs::remove(inputPath);
-        return 0;
+        return {};
     }
 
     SwrContext* swr = swr_alloc();
@@ -1195,7 +1498,7 @@ HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
     avformat_close_input(&fmtCtx);
     fs::remove(inputPath);
 
-    if (pcmData.empty()) return 0;
+    if (pcmData.empty()) return {};
 
     // Build WAV header
     std::vector<uint8_t> wavData;
@@ -1224,7 +1527,12 @@ HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
     wavData.insert(wavData.end(), (uint8_t*)&dataSize, (uint8_t*)&dataSize + 4);
     wavData.insert(wavData.end(), pcmData.begin(), pcmData.end());
 
-    HSAMPLE sample = BASS_SampleLoad(TRUE, wavData.data(), 0, wavData.size(), 65535, BASS_SAMPLE_OVER_POS);
-    return sample;
+    return wavData;
+}
+
+HSAMPLE AudioManager::loadSampleWithFFmpeg(const void* data, size_t size) {
+    std::vector<uint8_t> wavData = transcodeWithFFmpeg(data, size);
+    if (wavData.empty()) return 0;
+    return BASS_SampleLoad(TRUE, wavData.data(), 0, wavData.size(), 65535, BASS_SAMPLE_OVER_POS);
 }
 #endif
@@ -1,10 +1,17 @@
 #pragma once
 #define NOMINMAX
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 #include <bass.h>
 #include <bass_fx.h>
+#include "AudioClock.h"
+#include "KeySoundMixer.h"
+#include "PcmSample.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -73,6 +80,35 @@ struct AsioFuncs {
 };
 #endif
 
+// A sample copied into playback memory (a BASS sample, or the software mixer's format) but not
+// yet given a handle. Freed with its BASS sample unless AudioManager::attachSample takes it.
+struct PreparedSample {
+    std::shared_ptr<const PcmSample> pcm;
+    HSAMPLE sample = 0;
+    std::unique_ptr<KeySoundMixer::Sample> mixed;
+
+    PreparedSample() = default;
+    PreparedSample(PreparedSample&& other) noexcept { *this = std::move(other); }
+    PreparedSample& operator=(PreparedSample&& other) noexcept {
+        if (this != &other) {
+            release();
+            pcm = std::move(other.pcm);
+            sample = other.sample;
+            mixed = std::move(other.mixed);
+            other.sample = 0;
+        }
+        return *this;
+    }
+    ~PreparedSample() { release(); }
+    bool valid() const { return sample || mixed; }
+
+private:
+    void release() {
+        if (sample) BASS_SampleFree(sample);
+        sample = 0;
+    }
+};
+
 class AudioManager {
 public:
     AudioManager();
@@ -84,6 +120,8 @@ public:
     bool reinitialize(int outputMode, int device, int bufferMs, int asioDevice = 0);
 
     bool loadMusic(const std::string& filepath, bool loop = true);
+    // Play an in-memory audio file; the data is kept alive until the next load
+    bool loadMusicFromMemory(std::shared_ptr<const std::vector<uint8_t>> data, bool loop = true);
 
     void play();
     void stop();
@@ -93,6 +131,7 @@ public:
     void resume();
     int64_t getPosition() const;
     int64_t getRawPosition() const { return getPosition(); }
+    double getPrecisePosition() const;  // Smoothed position in ms (sub-millisecond)
     void setPosition(int64_t ms);
     int64_t getDuration() const;
     bool isPlaying() const;
@@ -105,6 +144,20 @@ public:
     // Sample (key sound) support
     int loadSample(const std::string& filepath);
     int loadSampleFromMemory(const void* data, size_t size);
+    // Decode many in-memory files in parallel; one handle per buffer (-1 = failed), same order
+    std::vector<int> loadSamplesFromMemory(const std::vector<std::pair<const void*, size_t>>& buffers);
+    // Decode a whole audio file to PCM (thread-safe once BASS is initialized)
+    static bool decodeToPcm(const void* data, size_t size, PcmSample& out);
+    static bool decodeFileToPcm(const std::string& filepath, PcmSample& out);
+    // Into a new handle, or into one taken from reserveSample() (replacing its sample)
+    int loadSampleFromPcm(const PcmSample& pcm, int handle = -1);
+    // loadSampleFromPcm in two steps, for samples loaded during play: prepareSample() does the
+    // copy into playback memory on any thread, attachSample() only stores the result under a
+    // handle on the thread that plays samples
+    PreparedSample prepareSample(std::shared_ptr<const PcmSample> pcm) const;
+    int attachSample(PreparedSample& prepared, int handle = -1);
+    int reserveSample() { return nextSampleHandle++; }  // Handle without a sample; plays nothing
+    void freeSample(int handle);                          // The handle stays valid but silent
     void playSample(int handle, int volume = 100, int64_t offsetMs = 0);
     void pauseAllSamples();
     void resumeAllSamples();
@@ -113,6 +166,9 @@ public:
     void setSampleVolume(int volume);
     int getSampleVolume() const;
     void warmupSamples();
+    // Play PCM-loaded samples through one software-mixed stream instead of a BASS channel per
+    // hit; applies to samples loaded afterwards
+    void setSoftwareMixer(bool enabled) { softwareMixer = enabled; }
 
     // Playback speed control (for DT/HT mods)
     void setPlaybackRate(float rate);
@@ -120,6 +176,20 @@ public:
     void setChangePitch(bool change);
     bool getChangePitch() const;
 
+    // Clock instrumentation (jitter/drift of the smoothed position)
+    void setClockObserver(AudioClock::Observer observer) {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        clock.setObserver(std::move(observer));
+    }
+    void setClockLogging(bool enabled) {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        clock.setLogging(enabled);
+    }
+    bool takeClockReport(AudioClock::Report& report) {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        return clock.takeReport(report);
+    }
+
     // Output mode info
     AudioOutputMode getOutputMode() const { return outputMode; }
     bool isUsingMixer() const { return useMixer; }
@@ -154,15 +224,31 @@ private:
     float playbackRate;
     bool changePitch;
     bool loopMusic;
+    std::shared_ptr<const std::vector<uint8_t>> musicMemory;  // Backing data of an in-memory music stream
+    void freeMusic();
+    bool attachMusicStream(bool loop);  // Wrap decodeStream in the tempo stream (and mixer)
+    mutable AudioClock clock;  // Smooths the stepped device position between buffer updates
+    mutable std::mutex clockMutex;
+    void resetClock();
+    double getDevicePosition() const;  // Raw position in ms
 
     // Sample cache: handle -> HSAMPLE
     std::unordered_map<int, HSAMPLE> sampleCache;
     int nextSampleHandle;
+    static HSAMPLE decodeSample(const void* data, size_t size);  // Thread-safe, 0 on failure
 
     // Track mixer source channels for cleanup
     std::vector<DWORD> activeMixerChannels;
     void cleanupMixerChannels();
 
+    // Software keysound mixer: a float stream rendered by KeySoundMixer, created on first use
+    std::atomic<bool> softwareMixer{false};  // Also read by loader threads (prepareSample)
+    std::unique_ptr<KeySoundMixer> keysoundMixer;
+    HSTREAM keysoundStream = 0;
+    bool startKeysoundMixer();
+    void stopKeysoundMixer();
+    static DWORD CALLBACK KeysoundMixerProc(HSTREAM handle, void* buffer, DWORD length, void* user);
+
 #ifdef _WIN32
     // Runtime DLL handles
     HMODULE hMixerDll = nullptr;
@@ -191,6 +277,7 @@ private:
 #endif
 
 #ifndef _WIN32
-    HSAMPLE loadSampleWithFFmpeg(const void* data, size_t size);
+    static std::vector<uint8_t> transcodeWithFFmpeg(const void* data, size_t size);  // To 16-bit WAV
+    static HSAMPLE loadSampleWithFFmpeg(const void* data, size_t size);
 #endif
 };
@@ -2,17 +2,22 @@
 #include "AudioManager.h"
 #include "S3PParser.h"
 #include "2dxSoundParser.h"
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
 #include <filesystem>
 #include <algorithm>
-#include <fstream>
+#include <cctype>
+#include <condition_variable>
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <SDL3/SDL.h>
 
 namespace fs = std::filesystem;
 
 KeySoundManager::KeySoundManager()
-    : audioManager(nullptr), timingPointVolume(100), keysoundVolume(100) {
+    : audioManager(nullptr), streaming(false), streamer(pcmCache), timingPointVolume(100), keysoundVolume(100) {
 }
 
 KeySoundManager::~KeySoundManager() {
@@ -21,147 +26,291 @@ KeySoundManager::~KeySoundManager() {
 
 std::string KeySoundManager::removeExtension(const std::string& filename) {
     size_t pos = filename.rfind('.');
-    if (pos != std::string::npos) {
+    size_t sep = filename.find_last_of("/\\");
+    if (pos != std::string::npos && (sep == std::string::npos || pos > sep)) {  // Not a dot in a folder name
         return filename.substr(0, pos);
     }
     return filename;
 }
 
+const std::unordered_map<std::string, std::string>& KeySoundManager::listDirectory(const std::string& dir) {
+    auto it = dirListings.find(dir);
+    if (it != dirListings.end()) return it->second;
+
+    // One directory scan replaces an fs::exists probe per candidate extension
+    auto& files = dirListings[dir];
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (fs::directory_iterator entry(dir.empty() ? fs::path(".") : fs::path(dir), ec), end;
+         !ec && entry != end; entry.increment(ec)) {
+        if (!entry->is_directory(ec)) names.push_back(entry->path().filename().string());
+    }
+    for (const auto& name : names) {
+        files[name] = dir.empty() ? name : (fs::path(dir) / name).string();
+    }
+    // Case-insensitive fallback; an exact name always wins
+    for (const auto& name : names) {
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        files.emplace(lower, files[name]);
+    }
+    return files;
+}
+
 std::string KeySoundManager::findAudioFile(const std::string& baseName) {
     static const std::vector<std::string> extensions = {".wav", ".ogg", ".mp3", ".flac", ".ssf"};
 
     // Check if baseName is already a full path (contains directory separator)
-    if (baseName.find('/') != std::string::npos || baseName.find('\\') != std::string::npos) {
-        // Try with extensions first
-        for (const auto& ext : extensions) {
-            std::string fullPath = baseName + ext;
-            if (fs::exists(fullPath)) {
-                return fullPath;
-            }
-        }
-        // Try as-is (might already have extension)
-        if (fs::exists(baseName)) {
-            return baseName;
+    bool fullPath = baseName.find('/') != std::string::npos || baseName.find('\\') != std::string::npos;
+    fs::path base = fullPath ? fs::path(baseName) : fs::path(beatmapDir) / baseName;
+    const auto& files = listDirectory(base.parent_path().string());
+    std::string name = base.filename().string();
+
+    auto lookup = [&files](std::string candidate) -> std::string {
+        auto it = files.find(candidate);
+        if (it == files.end()) {
+            std::transform(candidate.begin(), candidate.end(), candidate.begin(),
+                           [](unsigned char c) { return (char)std::tolower(c); });
+            it = files.find(candidate);
         }
-        return "";
-    }
+        return it != files.end() ? it->second : std::string();
+    };
 
     for (const auto& ext : extensions) {
-        fs::path path = fs::path(beatmapDir) / (baseName + ext);
-        if (fs::exists(path)) {
-            return path.string();
-        }
+        std::string path = lookup(name + ext);
+        if (!path.empty()) return path;
     }
 
     // Try with original name (might already have extension)
-    fs::path path = fs::path(beatmapDir) / baseName;
-    if (fs::exists(path)) {
-        return path.string();
+    return lookup(name);
+}
+
+std::vector<uint8_t> KeySoundManager::ssfToWav(const uint8_t* data, size_t size) {
+    if (size <= 16) return {};
+
+    // SSF header: [0]format(u16) [2]sampleRate(u16) [8]channels(u16)
+    //              [10]blockAlign(u16) [12]bitsPerSample(u16)
+    uint16_t rawFmt, rawRate, rawCh, rawBlockAlign, rawBits;
+    memcpy(&rawFmt, &data[0], 2);
+    memcpy(&rawRate, &data[2], 2);
+    memcpy(&rawCh, &data[8], 2);
+    memcpy(&rawBlockAlign, &data[10], 2);
+    memcpy(&rawBits, &data[12], 2);
+
+    uint32_t sampleRate32 = rawRate ? rawRate : 44100;
+    uint16_t channels = rawCh ? rawCh : 1;
+    uint16_t bitsPerSample = rawBits ? rawBits : 16;
+    uint32_t rawPcmSize = (uint32_t)(size - 16);
+    const uint8_t* rawPcm = &data[16];
+
+    // Format=2 mono: data is 32-bit per sample, actual audio in upper 16 bits.
+    // Convert to standard 16-bit PCM by extracting high word of each int32.
+    std::vector<uint8_t> convertedPcm;
+    uint32_t pcmSize = rawPcmSize;
+    const uint8_t* pcmPtr = rawPcm;
+
+    int bytesPerSample = rawBlockAlign ? (rawBlockAlign / (channels ? channels : 1)) : (bitsPerSample / 8);
+    if (rawFmt == 2 && bytesPerSample == 4) {
+        // 32-bit stored samples -> extract upper 16 bits
+        uint32_t sampleCount = rawPcmSize / (4 * channels);
+        convertedPcm.resize(sampleCount * 2 * channels);
+        for (uint32_t i = 0; i < sampleCount * channels; i++) {
+            // Upper 16 bits of each 32-bit LE value = bytes at offset +2
+            uint16_t hi;
+            memcpy(&hi, rawPcm + i * 4 + 2, 2);
+            memcpy(&convertedPcm[i * 2], &hi, 2);
+        }
+        pcmPtr = convertedPcm.data();
+        pcmSize = (uint32_t)convertedPcm.size();
+        bitsPerSample = 16;
     }
 
-    return "";
+    uint16_t blockAlign = channels * (bitsPerSample / 8);
+    uint32_t byteRate = sampleRate32 * blockAlign;
+
+    // Build WAV in memory: 44-byte header + PCM data
+    std::vector<uint8_t> wav(44 + pcmSize, 0);
+    memcpy(&wav[0], "RIFF", 4);
+    uint32_t riffSize = 36 + pcmSize;
+    memcpy(&wav[4], &riffSize, 4);
+    memcpy(&wav[8], "WAVEfmt ", 8);
+    uint32_t fmtSize = 16;
+    memcpy(&wav[16], &fmtSize, 4);
+    uint16_t audioFmt = 1; // PCM
+    memcpy(&wav[20], &audioFmt, 2);
+    memcpy(&wav[22], &channels, 2);
+    memcpy(&wav[24], &sampleRate32, 4);
+    memcpy(&wav[28], &byteRate, 4);
+    memcpy(&wav[32], &blockAlign, 2);
+    memcpy(&wav[34], &bitsPerSample, 2);
+    memcpy(&wav[36], "data", 4);
+    memcpy(&wav[40], &pcmSize, 4);
+    memcpy(&wav[44], pcmPtr, pcmSize);
+    return wav;
 }
 
-int KeySoundManager::loadSample(const std::string& filename) {
-    if (!audioManager || filename.empty()) {
-        return -1;
+bool KeySoundManager::decodeFile(const std::string& filepath, PcmSample& out) {
+    std::string ext = fs::path(filepath).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext == ".ssf") {
+        MappedFile file;
+        if (!file.open(filepath)) return false;
+        std::vector<uint8_t> wav = ssfToWav(file.data(), file.size());
+        return !wav.empty() && AudioManager::decodeToPcm(wav.data(), wav.size(), out);
+    }
+    return AudioManager::decodeFileToPcm(filepath, out);
+}
+
+// Cache keys for the entries of an S3P/2DX container
+static std::vector<std::string> containerKeys(const std::string& path, size_t count) {
+    std::string base = PcmCache::keyOf(path);
+    std::vector<std::string> keys(count);
+    if (base.empty()) return keys;
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = base + '#' + std::to_string(i);
     }
+    return keys;
+}
 
-    std::string baseName = removeExtension(filename);
+// Decoders for the wave data of each entry of an S3P/2DX container; they keep the mapping
+// alive for as long as a streamed entry may still be decoded
+template <typename Sample>
+static std::vector<KeySoundStreamer::Decoder> containerDecoders(const std::shared_ptr<const MappedFile>& file,
+                                                                const std::vector<Sample>& samples) {
+    std::vector<KeySoundStreamer::Decoder> decoders;
+    decoders.reserve(samples.size());
+    for (const auto& sample : samples) {
+        uint32_t offset = sample.waveOffset;
+        int32_t size = sample.waveSize;
+        decoders.push_back([file, offset, size](PcmSample& out) {
+            if (size <= 0 || offset > file->size() || file->size() - offset < (size_t)size) return false;
+            return AudioManager::decodeToPcm(file->data() + offset, (size_t)size, out);
+        });
+    }
+    return decoders;
+}
 
-    // Check cache first
-    auto it = sampleCache.find(baseName);
-    if (it != sampleCache.end()) {
-        return it->second;
+std::vector<int> KeySoundManager::loadDecoded(const std::vector<std::string>& keys,
+                                              const std::vector<Decoder>& decoders) {
+    std::vector<int> handles(keys.size(), -1);
+    if (streaming) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            handles[i] = streamer.add(keys[i], decoders[i]);
+        }
+        return handles;
     }
+    decodeAndLoad(keys, decoders, [&](size_t i, const PcmCache::Entry& pcm) {
+        if (pcm) handles[i] = audioManager->loadSampleFromPcm(*pcm);
+    });
+    return handles;
+}
 
-    // Find and load the file
-    std::string filepath = findAudioFile(baseName);
-    if (filepath.empty()) {
-        sampleCache[baseName] = -1;
-        return -1;
+void KeySoundManager::decodeAndLoad(const std::vector<std::string>& keys, const std::vector<Decoder>& decoders,
+                                    const std::function<void(size_t, const PcmCache::Entry&)>& load) {
+    const size_t count = keys.size();
+    if (count == 0) return;
+
+    // Already decoded (a retry, or another chart of the same song): no decoding at all
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < count; i++) {
+        PcmCache::Entry pcm = keys[i].empty() ? nullptr : pcmCache.get(keys[i]);
+        if (pcm) {
+            load(i, pcm);
+        } else {
+            misses.push_back(i);
+        }
     }
 
-    int handle = -1;
+    if (misses.size() <= 1) {
+        for (size_t i : misses) {
+            load(i, pcmCache.getOrDecode(keys[i], decoders[i]));
+        }
+        if (progressCallback) progressCallback(1.0f);
+        return;
+    }
 
-    // SSF: EZ2AC custom format (16-byte header + raw PCM), convert to WAV in memory
-    std::string ext = fs::path(filepath).extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    if (ext == ".ssf") {
-        std::ifstream ssfFile(filepath, std::ios::binary);
-        if (!ssfFile) { sampleCache[baseName] = -1; return -1; }
-        std::vector<uint8_t> ssfData((std::istreambuf_iterator<char>(ssfFile)),
-                                      std::istreambuf_iterator<char>());
-        ssfFile.close();
-        if (ssfData.size() <= 16) { sampleCache[baseName] = -1; return -1; }
-
-        // SSF header: [0]format(u16) [2]sampleRate(u16) [8]channels(u16)
-        //              [10]blockAlign(u16) [12]bitsPerSample(u16)
-        uint16_t rawFmt, rawRate, rawCh, rawBlockAlign, rawBits;
-        memcpy(&rawFmt, &ssfData[0], 2);
-        memcpy(&rawRate, &ssfData[2], 2);
-        memcpy(&rawCh, &ssfData[8], 2);
-        memcpy(&rawBlockAlign, &ssfData[10], 2);
-        memcpy(&rawBits, &ssfData[12], 2);
-
-        uint32_t sampleRate32 = rawRate ? rawRate : 44100;
-        uint16_t channels = rawCh ? rawCh : 1;
-        uint16_t bitsPerSample = rawBits ? rawBits : 16;
-        uint32_t rawPcmSize = (uint32_t)(ssfData.size() - 16);
-        const uint8_t* rawPcm = &ssfData[16];
-
-        // Format=2 mono: data is 32-bit per sample, actual audio in upper 16 bits.
-        // Convert to standard 16-bit PCM by extracting high word of each int32.
-        std::vector<uint8_t> convertedPcm;
-        uint32_t pcmSize = rawPcmSize;
-        const uint8_t* pcmPtr = rawPcm;
-
-        int bytesPerSample = rawBlockAlign ? (rawBlockAlign / (channels ? channels : 1)) : (bitsPerSample / 8);
-        if (rawFmt == 2 && bytesPerSample == 4) {
-            // 32-bit stored samples -> extract upper 16 bits
-            uint32_t sampleCount = rawPcmSize / (4 * channels);
-            convertedPcm.resize(sampleCount * 2 * channels);
-            for (uint32_t i = 0; i < sampleCount * channels; i++) {
-                // Upper 16 bits of each 32-bit LE value = bytes at offset +2
-                uint16_t hi;
-                memcpy(&hi, rawPcm + i * 4 + 2, 2);
-                memcpy(&convertedPcm[i * 2], &hi, 2);
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<std::pair<size_t, PcmCache::Entry>> done;
+
+    unsigned threads = (unsigned)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), misses.size());
+    WorkStealingPool pool(threads);
+    for (size_t i : misses) {
+        pool.submit([&, i]() {
+            // Every job must report back, or the loop below would wait forever
+            PcmCache::Entry pcm;
+            try {
+                pcm = pcmCache.getOrDecode(keys[i], decoders[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "KeySoundManager: decode failed: " << e.what() << std::endl;
             }
-            pcmPtr = convertedPcm.data();
-            pcmSize = (uint32_t)convertedPcm.size();
-            bitsPerSample = 16;
+            std::lock_guard<std::mutex> lock(mutex);
+            done.emplace_back(i, std::move(pcm));
+            ready.notify_one();
+        });
+    }
+
+    // Hand finished samples to BASS as they come in
+    size_t loaded = count - misses.size();
+    std::vector<std::pair<size_t, PcmCache::Entry>> batch;
+    while (loaded < count) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&done] { return !done.empty(); });
+            batch.swap(done);
+        }
+        for (const auto& [i, pcm] : batch) {
+            load(i, pcm);
         }
+        loaded += batch.size();
+        batch.clear();
+        if (progressCallback) progressCallback((float)loaded / count);
+    }
+}
 
-        uint16_t blockAlign = channels * (bitsPerSample / 8);
-        uint32_t byteRate = sampleRate32 * blockAlign;
-
-        // Build WAV in memory: 44-byte header + PCM data
-        std::vector<uint8_t> wav(44 + pcmSize, 0);
-        memcpy(&wav[0], "RIFF", 4);
-        uint32_t riffSize = 36 + pcmSize;
-        memcpy(&wav[4], &riffSize, 4);
-        memcpy(&wav[8], "WAVEfmt ", 8);
-        uint32_t fmtSize = 16;
-        memcpy(&wav[16], &fmtSize, 4);
-        uint16_t audioFmt = 1; // PCM
-        memcpy(&wav[20], &audioFmt, 2);
-        memcpy(&wav[22], &channels, 2);
-        memcpy(&wav[24], &sampleRate32, 4);
-        memcpy(&wav[28], &byteRate, 4);
-        memcpy(&wav[32], &blockAlign, 2);
-        memcpy(&wav[34], &bitsPerSample, 2);
-        memcpy(&wav[36], "data", 4);
-        memcpy(&wav[40], &pcmSize, 4);
-        memcpy(&wav[44], pcmPtr, pcmSize);
-
-        handle = audioManager->loadSampleFromMemory(wav.data(), wav.size());
-    } else {
-        handle = audioManager->loadSample(filepath);
-    }
-
-    sampleCache[baseName] = handle;
-
-    return handle;
+int KeySoundManager::loadSample(const std::string& filename) {
+    if (!audioManager || filename.empty()) {
+        return -1;
+    }
+    return loadSamples({filename})[0];
+}
+
+std::vector<int> KeySoundManager::loadSamples(const std::vector<std::string>& filenames) {
+    std::vector<int> handles(filenames.size(), -1);
+    if (!audioManager) return handles;
+
+    // Resolve each name not in the cache once, then decode all of them together
+    std::vector<std::string> baseNames;
+    std::vector<std::string> paths;
+    for (const auto& filename : filenames) {
+        if (filename.empty()) continue;
+        std::string baseName = removeExtension(filename);
+        if (sampleCache.count(baseName)) continue;
+        std::string filepath = findAudioFile(baseName);
+        sampleCache[baseName] = -1;  // Also marks it as queued
+        if (filepath.empty()) continue;
+        baseNames.push_back(baseName);
+        paths.push_back(filepath);
+    }
+
+    std::vector<std::string> keys;
+    std::vector<Decoder> decoders;
+    keys.reserve(paths.size());
+    decoders.reserve(paths.size());
+    for (const auto& path : paths) {
+        keys.push_back(PcmCache::keyOf(path));
+        decoders.push_back([path](PcmSample& pcm) { return decodeFile(path, pcm); });
+    }
+    std::vector<int> loaded = loadDecoded(keys, decoders);
+    for (size_t i = 0; i < loaded.size(); i++) {
+        sampleCache[baseNames[i]] = loaded[i];
+    }
+
+    for (size_t i = 0; i < filenames.size(); i++) {
+        if (filenames[i].empty()) continue;
+        handles[i] = sampleCache[removeExtension(filenames[i])];
+    }
+    return handles;
 }
 
 bool KeySoundManager::loadS3PSamples(const std::string& s3pPath) {
@@ -172,23 +321,16 @@ bool KeySoundManager::loadS3PSamples(const std::string& s3pPath) {
         return false;
     }
 
-    std::ifstream file(s3pPath, std::ios::binary);
-    if (!file) return false;
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(s3pPath)) return false;
 
     s3pSampleCache.clear();
 
-    for (size_t i = 0; i < samples.size(); i++) {
-        const auto& sample = samples[i];
-        if (sample.waveSize <= 0) continue;
-
-        std::vector<uint8_t> waveData(sample.waveSize);
-        file.seekg(sample.waveOffset, std::ios::beg);
-        file.read(reinterpret_cast<char*>(waveData.data()), sample.waveSize);
-
-        int handle = audioManager->loadSampleFromMemory(waveData.data(), waveData.size());
-        if (handle >= 0) {
+    std::vector<int> handles = loadDecoded(containerKeys(s3pPath, samples.size()), containerDecoders(file, samples));
+    for (size_t i = 0; i < handles.size(); i++) {
+        if (handles[i] >= 0) {
             // Sample IDs in chart files are 1-based, so store with i+1
-            s3pSampleCache[static_cast<int>(i) + 1] = handle;
+            s3pSampleCache[static_cast<int>(i) + 1] = handles[i];
         }
     }
 
@@ -205,25 +347,18 @@ bool KeySoundManager::load2DXSamples(const std::string& twoDxPath) {
         return false;
     }
 
-    std::ifstream file(twoDxPath, std::ios::binary);
-    if (!file) return false;
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(twoDxPath)) return false;
 
     // Don't clear cache - may have S3P samples loaded already
     // s3pSampleCache.clear();
 
+    std::vector<int> handles = loadDecoded(containerKeys(twoDxPath, samples.size()), containerDecoders(file, samples));
     int loadedCount = 0;
-    for (size_t i = 0; i < samples.size(); i++) {
-        const auto& sample = samples[i];
-        if (sample.waveSize <= 0) continue;
-
-        std::vector<uint8_t> waveData(sample.waveSize);
-        file.seekg(sample.waveOffset, std::ios::beg);
-        file.read(reinterpret_cast<char*>(waveData.data()), sample.waveSize);
-
-        int handle = audioManager->loadSampleFromMemory(waveData.data(), waveData.size());
-        if (handle >= 0) {
+    for (size_t i = 0; i < handles.size(); i++) {
+        if (handles[i] >= 0) {
             // Sample IDs in chart files are 1-based
-            s3pSampleCache[static_cast<int>(i) + 1] = handle;
+            s3pSampleCache[static_cast<int>(i) + 1] = handles[i];
             loadedCount++;
         }
     }
@@ -246,6 +381,26 @@ std::string KeySoundManager::constructHitsoundName(SampleSet ss, const char* hit
 }
 
 void KeySoundManager::preloadKeySounds(std::vector<Note>& notes) {
+    // Decode every file the loop below asks for in one parallel batch; the loop then only
+    // hits the cache
+    std::vector<std::string> names;
+    for (const auto& note : notes) {
+        if (!note.filename.empty()) {
+            names.push_back(note.filename);
+        } else if (note.customIndex > 0 && note.sampleHandle < 0) {
+            SampleSet ss = (note.sampleSet != SampleSet::None) ? note.sampleSet : SampleSet::Normal;
+            SampleSet addSs = (note.additions != SampleSet::None) ? note.additions : ss;
+            names.push_back(constructHitsoundName(ss, "hitnormal", note.customIndex));
+            if (note.hasWhistle) names.push_back(constructHitsoundName(addSs, "hitwhistle", note.customIndex));
+            if (note.hasFinish) names.push_back(constructHitsoundName(addSs, "hitfinish", note.customIndex));
+            if (note.hasClap) names.push_back(constructHitsoundName(addSs, "hitclap", note.customIndex));
+        }
+        if (note.isHold && !note.tailFilename.empty()) {
+            names.push_back(note.tailFilename);
+        }
+    }
+    loadSamples(names);
+
     for (auto& note : notes) {
         // Load head/normal key sound
         if (!note.filename.empty()) {
@@ -306,6 +461,9 @@ void KeySoundManager::playKeySound(const Note& note, bool isTail) {
         return;
     }
 
+    // Streamed sample that has not arrived yet: counted as late and skipped
+    if (!streamer.ready(handle)) return;
+
     // Use timing point volume if note volume is 0
     if (volume == 0) {
         volume = timingPointVolume;
@@ -322,13 +480,65 @@ void KeySoundManager::playKeySound(const Note& note, bool isTail) {
 void KeySoundManager::clear() {
     sampleCache.clear();
     s3pSampleCache.clear();
+    dirListings.clear();
+    streamer.clear();
+    streaming = false;
     // Note: actual audio data is managed by AudioManager
 }
 
+void KeySoundManager::startStreaming(const std::vector<Note>& notes, const std::vector<StoryboardSample>& samples) {
+    if (!streaming || streamer.empty()) return;
+
+    // Same lookup as playKeySound(), without loading anything
+    auto handleOf = [this](int handle, int customIndex, const std::string& filename) {
+        if (handle == -1 && customIndex >= 0) {
+            auto it = s3pSampleCache.find(customIndex);
+            if (it != s3pSampleCache.end()) handle = it->second;
+        }
+        if (handle == -1 && !filename.empty()) {
+            auto it = sampleCache.find(removeExtension(filename));
+            if (it != sampleCache.end()) handle = it->second;
+        }
+        return handle;
+    };
+
+    std::vector<std::pair<int64_t, int>> uses;
+    uses.reserve(notes.size() * 2 + samples.size());
+    for (const auto& note : notes) {
+        uses.push_back({note.time, handleOf(note.sampleHandle, note.customIndex, note.filename)});
+        if (note.isHold) {
+            uses.push_back({note.endTime, handleOf(note.tailSampleHandle, note.customIndex, note.tailFilename)});
+        }
+    }
+    for (const auto& sample : samples) {
+        uses.push_back({sample.time, handleOf(sample.sampleHandle, sample.customIndex, sample.filename)});
+    }
+
+    // The opening is decoded now, like a full preload
+    std::vector<int> preload = streamer.start(std::move(uses));
+    std::vector<std::string> keys;
+    std::vector<Decoder> decoders;
+    keys.reserve(preload.size());
+    decoders.reserve(preload.size());
+    for (int handle : preload) {
+        keys.push_back(streamer.keyOf(handle));
+        decoders.push_back(streamer.decoderOf(handle));
+    }
+    decodeAndLoad(keys, decoders, [&](size_t i, const PcmCache::Entry& pcm) {
+        streamer.load(preload[i], pcm);
+    });
+}
+
 void KeySoundManager::preloadStoryboardSamples(std::vector<StoryboardSample>& samples) {
-    for (auto& sample : samples) {
-        if (!sample.filename.empty()) {
-            sample.sampleHandle = loadSample(sample.filename);
+    std::vector<std::string> names;
+    names.reserve(samples.size());
+    for (const auto& sample : samples) {
+        names.push_back(sample.filename);
+    }
+    std::vector<int> handles = loadSamples(names);
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (!samples[i].filename.empty()) {
+            samples[i].sampleHandle = handles[i];
         }
     }
 }
@@ -351,7 +561,7 @@ void KeySoundManager::playStoryboardSample(const StoryboardSample& sample, int64
         handle = loadSample(sample.filename);
     }
 
-    if (handle == -1) return;
+    if (handle == -1 || !streamer.ready(handle)) return;
 
     audioManager->playSample(handle, sample.volume, offsetMs);
 }
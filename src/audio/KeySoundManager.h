@@ -1,23 +1,48 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "Note.h"
 #include "OsuParser.h"
+#include "KeySoundStreamer.h"
+#include "PcmCache.h"
 
 class AudioManager;
+struct PcmSample;
 
 class KeySoundManager {
 public:
     KeySoundManager();
     ~KeySoundManager();
 
-    void setAudioManager(AudioManager* audio) { audioManager = audio; }
+    void setAudioManager(AudioManager* audio) {
+        audioManager = audio;
+        streamer.setAudioManager(audio);
+    }
     void setBeatmapDirectory(const std::string& dir) { beatmapDir = dir; }
 
     // Load a sample file, returns handle (-1 on failure)
     int loadSample(const std::string& filename);
 
+    // Load many sample files at once, one handle per name. Names resolve like loadSample();
+    // the files are decoded on a worker pool and handed to the audio manager in batches.
+    std::vector<int> loadSamples(const std::vector<std::string>& filenames);
+
+    // Also keep decoded keysounds on disk for later sessions
+    void setDiskCacheEnabled(bool enabled) { pcmCache.setDiskEnabled(enabled); }
+
+    // Receives the loaded fraction (0-1) of a batch as its samples arrive
+    void setProgressCallback(std::function<void(float)> callback) { progressCallback = std::move(callback); }
+
+    // Streaming mode (until clear()): loads only reserve handles; startStreaming() then
+    // decodes what the opening needs, and loader threads the rest during play.
+    // updateStreaming() runs on the gameplay thread and only attaches finished samples.
+    void setStreaming(bool enabled) { streaming = enabled; }
+    void startStreaming(const std::vector<Note>& notes, const std::vector<StoryboardSample>& samples);
+    void updateStreaming(int64_t timeMs) { streamer.update(timeMs); }
+    int getLateSampleCount() const { return streamer.lateCount(); }
+
     // Load all samples from S3P file (IIDX format)
     bool loadS3PSamples(const std::string& s3pPath);
 
@@ -53,6 +78,17 @@ private:
     // S3P sample cache: sample ID -> handle
     std::unordered_map<int, int> s3pSampleCache;
 
+    // Directory -> its files by name and by lower-case name, listed once per beatmap
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> dirListings;
+
+    std::function<void(float)> progressCallback;
+
+    // Decoded PCM, kept across clear() so reloading a chart skips decoding
+    PcmCache pcmCache;
+
+    bool streaming;
+    KeySoundStreamer streamer;
+
     // Timing point volume (0-100)
     int timingPointVolume;
 
@@ -64,6 +100,21 @@ private:
 
     // Helper: find audio file with various extensions
     std::string findAudioFile(const std::string& baseName);
+    const std::unordered_map<std::string, std::string>& listDirectory(const std::string& dir);
+
+    using Decoder = KeySoundStreamer::Decoder;
+
+    // One handle per cache key (-1 where decoding failed), or reserved handles when streaming
+    std::vector<int> loadDecoded(const std::vector<std::string>& keys, const std::vector<Decoder>& decoders);
+
+    // Decode one sample per cache key (cached PCM directly, the rest on a worker pool) and pass
+    // each to load() on this thread as it is ready, nullptr where decoding failed
+    void decodeAndLoad(const std::vector<std::string>& keys, const std::vector<Decoder>& decoders,
+                       const std::function<void(size_t, const PcmCache::Entry&)>& load);
+    static bool decodeFile(const std::string& filepath, PcmSample& out);
+
+    // Helper: EZ2AC .ssf (16-byte header + raw PCM) as an in-memory WAV, empty if invalid
+    static std::vector<uint8_t> ssfToWav(const uint8_t* data, size_t size);
 
     // Helper: construct osu! hitsound filename from sampleSet + hitSound + customIndex
     static std::string constructHitsoundName(SampleSet ss, const char* hitType, int customIndex);
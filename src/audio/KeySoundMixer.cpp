@@ -0,0 +1,278 @@
+#include "KeySoundMixer.h"
+#include "PcmSample.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KEYSOUND_MIXER_SSE2
+#endif
+
+static const uint64_t FIXED_ONE = 1ull << 32;
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// out[LR] += src * gain, 4 frames per step; the gains include the 1/32768 scale
+static void mixStereo(const int16_t* src, float* out, size_t frames, float gainL, float gainR) {
+    size_t i = 0;
+#ifdef KEYSOUND_MIXER_SSE2
+    const __m128 gain = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    for (; i + 4 <= frames; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        // Sign-extend by unpacking each sample into the top half of a 32-bit lane
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(lo, gain)));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(out + i * 2 + 4), _mm_mul_ps(hi, gain)));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i * 2] += src[i * 2] * gainL;
+        out[i * 2 + 1] += src[i * 2 + 1] * gainR;
+    }
+}
+
+static void mixMono(const int16_t* src, float* out, size_t frames, float gainL, float gainR) {
+    size_t i = 0;
+#ifdef KEYSOUND_MIXER_SSE2
+    const __m128 gain = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    for (; i + 4 <= frames; i += 4) {
+        __m128i m = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_unpacklo_epi16(m, m);  // Each sample twice: L and R
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16));
+        _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(lo, gain)));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(out + i * 2 + 4), _mm_mul_ps(hi, gain)));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i * 2] += src[i] * gainL;
+        out[i * 2 + 1] += src[i] * gainR;
+    }
+}
+
+std::unique_ptr<KeySoundMixer::Sample> KeySoundMixer::makeSample(const PcmSample& pcm) {
+    if (pcm.channels == 0 || pcm.freq == 0) return nullptr;
+
+    // Kept as 16-bit; anything past the first two channels is dropped
+    size_t frames = std::min<size_t>(pcm.data.size() / (2u * pcm.channels), UINT32_MAX);
+    if (frames == 0) return nullptr;
+    auto sample = std::make_unique<Sample>();
+    sample->frames = (uint32_t)frames;
+    sample->freq = pcm.freq;
+    sample->channels = pcm.channels >= 2 ? 2 : 1;
+    sample->pcm.resize(frames * sample->channels);
+    if (sample->channels == pcm.channels) {
+        memcpy(sample->pcm.data(), pcm.data.data(), sample->pcm.size() * 2);
+    } else {
+        for (size_t f = 0; f < frames; f++) {
+            memcpy(&sample->pcm[f * 2], &pcm.data[f * pcm.channels * 2], 4);
+        }
+    }
+    return sample;
+}
+
+void KeySoundMixer::setSample(int id, std::unique_ptr<Sample> sample) {
+    collectRetired();
+    if (!sample) return;
+    removeSample(id);
+    samples_[id] = std::move(sample);
+}
+
+void KeySoundMixer::removeSample(int id) {
+    auto it = samples_.find(id);
+    if (it == samples_.end()) return;
+    std::unique_ptr<Sample> sample = std::move(it->second);
+    samples_.erase(it);
+    bool stopped = push({Command::Type::Stop, sample.get(), 0, 0, 0, 0, 0});
+    retired_.push_back({std::move(sample), renderStarts_.load(), stopped});
+}
+
+void KeySoundMixer::clear() {
+    bool stopped = push({Command::Type::StopAll, nullptr, 0, 0, 0, 0, 0});
+    uint64_t renders = renderStarts_.load();
+    for (auto& [id, sample] : samples_) {
+        retired_.push_back({std::move(sample), renders, stopped});
+    }
+    samples_.clear();
+    collectRetired();
+}
+
+// A removed sample is freed once no render() can still be reading it: its stop command has
+// been queued and every render() that started before that has finished
+void KeySoundMixer::collectRetired() {
+    for (auto& r : retired_) {
+        if (!r.stopped && push({Command::Type::Stop, r.sample.get(), 0, 0, 0, 0, 0})) {
+            r.stopped = true;
+            r.renders = renderStarts_.load();
+        }
+    }
+    uint64_t finished = renderEnds_.load();
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [finished](const Retired& r) { return r.stopped && finished >= r.renders; }),
+                   retired_.end());
+}
+
+bool KeySoundMixer::play(int id, float volume, float pan, float rate, int64_t offsetMs, uint64_t startFrame) {
+    auto it = samples_.find(id);
+    if (it == samples_.end() || rate <= 0.0f) return false;
+    const Sample* sample = it->second.get();
+
+    uint64_t offsetFrames = offsetMs > 0 ? (uint64_t)offsetMs * sample->freq / 1000 : 0;
+    if (offsetFrames >= sample->frames) return true;  // Starts past its end
+
+    pan = std::max(-1.0f, std::min(1.0f, pan));
+    Command command;
+    command.type = Command::Type::Play;
+    command.sample = sample;
+    command.gainL = volume * std::min(1.0f, 1.0f - pan) / 32768.0f;
+    command.gainR = volume * std::min(1.0f, 1.0f + pan) / 32768.0f;
+    command.step = (uint64_t)((double)sample->freq * rate / outputFreq_ * FIXED_ONE);
+    command.position = offsetFrames << 32;
+    command.startFrame = startFrame;
+    return command.step > 0 && push(command);
+}
+
+void KeySoundMixer::pauseAll() {
+    push({Command::Type::Pause, nullptr, 0, 0, 0, 0, 0});
+}
+
+void KeySoundMixer::resumeAll() {
+    push({Command::Type::Resume, nullptr, 0, 0, 0, 0, 0});
+}
+
+void KeySoundMixer::stopAll() {
+    push({Command::Type::StopAll, nullptr, 0, 0, 0, 0, 0});
+}
+
+uint64_t KeySoundMixer::scheduleFrame() const {
+    uint32_t block = blockFrames_.load();
+    int64_t renderedAt = renderedAtNs_.load();
+    if (block == 0) return 0;
+    int64_t elapsedNs = std::max<int64_t>(0, steadyNs() - renderedAt);
+    uint64_t elapsed = (uint64_t)elapsedNs * outputFreq_ / 1000000000ull;
+    // A buffered output refills in bursts, so the gap between two renders can be as long
+    // as its buffer; past that the output is not running steadily: just the next block
+    if (elapsed > 2ull * block + outputBuffer_.load()) return 0;
+    return renderedFrame_.load() + elapsed + block;
+}
+
+bool KeySoundMixer::push(const Command& command) {
+    size_t tail = queueTail_.load(std::memory_order_relaxed);
+    if (tail - queueHead_.load() >= QUEUE_SIZE) return false;
+    queue_[tail % QUEUE_SIZE] = command;
+    queueTail_.store(tail + 1);
+    return true;
+}
+
+void KeySoundMixer::render(float* out, size_t frames) {
+    renderStarts_.fetch_add(1);
+    const uint64_t blockStart = frame_;
+
+    size_t head = queueHead_.load(std::memory_order_relaxed);
+    const size_t tail = queueTail_.load();
+    for (; head != tail; head++) {
+        const Command& command = queue_[head % QUEUE_SIZE];
+        switch (command.type) {
+            case Command::Type::Play:
+                startVoice(command, blockStart);
+                break;
+            case Command::Type::Stop:
+                for (Voice& v : voices_) {
+                    if (v.sample == command.sample) v.sample = nullptr;
+                }
+                break;
+            case Command::Type::StopAll:
+                for (Voice& v : voices_) v.sample = nullptr;
+                break;
+            case Command::Type::Pause:
+                paused_ = true;
+                break;
+            case Command::Type::Resume:
+                paused_ = false;
+                break;
+        }
+    }
+    queueHead_.store(head);
+
+    std::fill(out, out + frames * 2, 0.0f);
+    if (!paused_) {
+        for (Voice& v : voices_) {
+            if (!v.sample) continue;
+            // A voice scheduled inside this block starts on its own frame
+            uint64_t offset = v.startFrame > blockStart ? v.startFrame - blockStart : 0;
+            if (offset >= frames) continue;
+            mixVoice(v, out + offset * 2, frames - (size_t)offset);
+        }
+    }
+
+    frame_ += frames;
+    renderedFrame_.store(frame_);
+    renderedAtNs_.store(steadyNs());
+    blockFrames_.store((uint32_t)frames);
+    renderEnds_.fetch_add(1);
+}
+
+void KeySoundMixer::startVoice(const Command& command, uint64_t blockStart) {
+    Voice* voice = nullptr;
+    for (Voice& v : voices_) {
+        if (!v.sample) {
+            voice = &v;
+            break;
+        }
+    }
+    if (!voice) {
+        // All busy: steal the one that started first
+        voice = &voices_[0];
+        for (Voice& v : voices_) {
+            if (v.startFrame < voice->startFrame) voice = &v;
+        }
+    }
+    voice->sample = command.sample;
+    voice->gainL = command.gainL;
+    voice->gainR = command.gainR;
+    voice->step = command.step;
+    voice->position = command.position;
+    voice->startFrame = command.startFrame ? command.startFrame : blockStart;
+}
+
+void KeySoundMixer::mixVoice(Voice& voice, float* out, size_t frames) {
+    const Sample& s = *voice.sample;
+    const uint64_t end = (uint64_t)s.frames << 32;
+
+    if (voice.step == FIXED_ONE && (voice.position & (FIXED_ONE - 1)) == 0) {
+        // Same rate as the output: straight 16-bit to float mix
+        size_t first = (size_t)(voice.position >> 32);
+        size_t n = std::min<size_t>(frames, s.frames - first);
+        if (s.channels == 2) {
+            mixStereo(s.pcm.data() + first * 2, out, n, voice.gainL, voice.gainR);
+        } else {
+            mixMono(s.pcm.data() + first, out, n, voice.gainL, voice.gainR);
+        }
+        voice.position += (uint64_t)n << 32;
+    } else {
+        // Resampled (other sample rate or DT/HT): linear interpolation
+        uint64_t pos = voice.position;
+        for (size_t i = 0; i < frames && pos < end; i++, pos += voice.step) {
+            size_t idx = (size_t)(pos >> 32);
+            size_t next = std::min<size_t>(idx + 1, s.frames - 1);
+            float frac = (float)(pos & (FIXED_ONE - 1)) * (1.0f / 4294967296.0f);
+            if (s.channels == 2) {
+                float l = s.pcm[idx * 2] + (s.pcm[next * 2] - s.pcm[idx * 2]) * frac;
+                float r = s.pcm[idx * 2 + 1] + (s.pcm[next * 2 + 1] - s.pcm[idx * 2 + 1]) * frac;
+                out[i * 2] += l * voice.gainL;
+                out[i * 2 + 1] += r * voice.gainR;
+            } else {
+                float m = s.pcm[idx] + (s.pcm[next] - s.pcm[idx]) * frac;
+                out[i * 2] += m * voice.gainL;
+                out[i * 2 + 1] += m * voice.gainR;
+            }
+        }
+        voice.position = pos;
+    }
+    if (voice.position >= end) voice.sample = nullptr;
+}
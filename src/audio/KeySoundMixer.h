@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+struct PcmSample;
+
+// Software keysound mixer: a fixed pool of voices over decoded 16-bit PCM, mixed into one
+// float stereo stream by render() on the audio thread. Hits never create channels; the game
+// thread only pushes commands into a lock-free queue, and every play carries the output frame
+// it starts on, so starts are sample-accurate instead of snapping to block boundaries.
+// render() needs no device, so the mixer also runs headless against a null output.
+class KeySoundMixer {
+public:
+    static const int MAX_VOICES = 128;     // The oldest voice is stolen beyond this
+    static const size_t QUEUE_SIZE = 1024;  // Commands between two render() calls
+
+    struct Sample {
+        std::vector<int16_t> pcm;  // Interleaved, 1 or 2 channels
+        uint32_t frames;
+        uint32_t freq;
+        uint16_t channels;
+    };
+
+    // PCM in mixer format (nullptr if empty). Only copies, so any thread can build one.
+    static std::unique_ptr<Sample> makeSample(const PcmSample& pcm);
+
+    explicit KeySoundMixer(uint32_t outputFreq) : outputFreq_(outputFreq) {}
+    ~KeySoundMixer() = default;
+    KeySoundMixer(const KeySoundMixer&) = delete;
+    KeySoundMixer& operator=(const KeySoundMixer&) = delete;
+
+    uint32_t outputFreq() const { return outputFreq_; }
+    // Frames the output still holds after render() returns (device and stream buffers).
+    // Rendering then runs that far ahead of what is heard and comes in bursts.
+    void setOutputBuffer(uint32_t frames) { outputBuffer_.store(frames); }
+
+    // Game thread
+    void setSample(int id, const PcmSample& pcm) { setSample(id, makeSample(pcm)); }
+    void setSample(int id, std::unique_ptr<Sample> sample);  // Replaces a sample with the same id
+    void removeSample(int id);
+    bool hasSample(int id) const { return samples_.count(id) > 0; }
+    void clear();  // Removes every sample
+    size_t retiredCount() const { return retired_.size(); }  // Removed but not yet freed
+    // volume 0-1, pan -1 (left) to 1 (right), rate scales the sample's speed and pitch.
+    // Starts on output frame startFrame (0 = the next block); false if the queue is full.
+    bool play(int id, float volume, float pan = 0.0f, float rate = 1.0f, int64_t offsetMs = 0,
+              uint64_t startFrame = 0);
+    void pauseAll();
+    void resumeAll();
+    void stopAll();
+    // Start frame for a hit submitted now: one block after the current time, so hits keep
+    // their spacing however they fall between two render() calls (or bursts of them, with
+    // an output buffer)
+    uint64_t scheduleFrame() const;
+
+    // Audio thread: mix the next frames into interleaved stereo (overwrites out)
+    void render(float* out, size_t frames);
+
+private:
+    struct Command {
+        enum class Type : uint8_t { Play, Stop, StopAll, Pause, Resume } type;
+        const Sample* sample;
+        float gainL, gainR;
+        uint64_t step;        // Source frames per output frame, 32.32 fixed point
+        uint64_t position;    // Start position in the sample, 32.32 fixed point
+        uint64_t startFrame;  // 0 = the next block
+    };
+
+    struct Voice {
+        const Sample* sample = nullptr;  // nullptr = free
+        float gainL, gainR;
+        uint64_t step;
+        uint64_t position;
+        uint64_t startFrame;
+    };
+
+    struct Retired {
+        std::unique_ptr<Sample> sample;
+        uint64_t renders;  // Safe to free once this many renders have finished...
+        bool stopped;      // ...and its stop command made it into the queue
+    };
+
+    const uint32_t outputFreq_;
+
+    // Game thread
+    std::unordered_map<int, std::unique_ptr<Sample>> samples_;
+    std::vector<Retired> retired_;
+
+    // Single-producer, single-consumer command ring
+    Command queue_[QUEUE_SIZE];
+    std::atomic<size_t> queueHead_{0};  // Next command render() reads
+    std::atomic<size_t> queueTail_{0};  // Next free slot
+
+    // Audio thread
+    Voice voices_[MAX_VOICES];
+    uint64_t frame_ = 1;  // Output frame of the next block (0 means "next block" in commands)
+    bool paused_ = false;
+
+    // Written by render(), read by the game thread
+    std::atomic<uint64_t> renderStarts_{0};
+    std::atomic<uint64_t> renderEnds_{0};
+    std::atomic<uint64_t> renderedFrame_{1};
+    std::atomic<int64_t> renderedAtNs_{0};
+    std::atomic<uint32_t> blockFrames_{0};
+
+    std::atomic<uint32_t> outputBuffer_{0};
+
+    bool push(const Command& command);
+    void collectRetired();
+    void startVoice(const Command& command, uint64_t blockStart);
+    static void mixVoice(Voice& voice, float* out, size_t frames);
+};
@@ -0,0 +1,209 @@
+#include "KeySoundStreamer.h"
+#include "AudioManager.h"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+KeySoundStreamer::~KeySoundStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    workReady_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+int KeySoundStreamer::add(const std::string& key, Decoder decode) {
+    if (!audio_) return -1;
+    int handle = audio_->reserveSample();
+    Slot& slot = slots_[handle];
+    slot.key = key;
+    slot.decode = std::move(decode);
+    return handle;
+}
+
+std::vector<int> KeySoundStreamer::start(std::vector<TimedHandle> uses) {
+    uses.erase(std::remove_if(uses.begin(), uses.end(),
+                              [this](const TimedHandle& use) { return !slots_.count(use.second); }),
+               uses.end());
+    std::sort(uses.begin(), uses.end());
+    for (const auto& [time, handle] : uses) {
+        slots_[handle].lastUse = time;
+    }
+    lastUses_.clear();
+    for (const auto& [handle, slot] : slots_) {
+        if (slot.lastUse != INT64_MIN) lastUses_.push_back({slot.lastUse, handle});
+    }
+    std::sort(lastUses_.begin(), lastUses_.end());
+    uses_ = std::move(uses);
+    useCursor_ = 0;
+    lastUseCursor_ = 0;
+    time_ = INT64_MIN;
+
+    // The opening is decoded up front by the caller; samples no note uses are never decoded
+    std::vector<int> preload;
+    if (!uses_.empty()) {
+        int64_t until = uses_.front().first + PRELOAD_MS;
+        for (size_t i = 0; i < uses_.size() && uses_[i].first <= until; i++) {
+            Slot& slot = slots_[uses_[i].second];
+            if (slot.state != State::Unloaded) continue;
+            slot.state = State::Queued;
+            preload.push_back(uses_[i].second);
+        }
+    }
+
+    if (workers_.empty()) {
+        for (unsigned i = 0; i < LOADER_THREADS; i++) {
+            workers_.emplace_back(&KeySoundStreamer::workerMain, this);
+        }
+    }
+    std::cout << "[KEYSOUND] Streaming " << lastUses_.size() << " samples, " << preload.size()
+              << " before start" << std::endl;
+    return preload;
+}
+
+void KeySoundStreamer::load(int handle, const PcmCache::Entry& pcm) {
+    PreparedSample prepared;
+    if (pcm && audio_) prepared = audio_->prepareSample(pcm);
+    attach(handle, prepared);
+}
+
+void KeySoundStreamer::attach(int handle, PreparedSample& prepared) {
+    auto it = slots_.find(handle);
+    if (it == slots_.end() || it->second.state != State::Queued) return;
+    Slot& slot = it->second;
+    std::shared_ptr<const PcmSample> pcm = prepared.pcm;
+    if (!prepared.valid() || !audio_ || audio_->attachSample(prepared, handle) < 0) {
+        slot.state = State::Failed;
+        return;
+    }
+    slot.state = State::Loaded;
+    slot.durationMs = pcm->freq ? (int64_t)(pcm->data.size() / (pcm->channels * 2u)) * 1000 / pcm->freq : 0;
+
+    // Arrived after its last use (a late sample): free it again once it has played
+    if (time_ != INT64_MIN && slot.lastUse != INT64_MIN && slot.lastUse < time_) {
+        scheduleEviction(handle, slot);
+    }
+}
+
+void KeySoundStreamer::update(int64_t timeMs) {
+    std::vector<std::pair<int, PreparedSample>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(done_);
+    }
+
+    // A jump back walks the uses after the new time again
+    if (timeMs < time_) {
+        useCursor_ = std::lower_bound(uses_.begin(), uses_.end(), TimedHandle{timeMs, INT_MIN}) - uses_.begin();
+        lastUseCursor_ = std::lower_bound(lastUses_.begin(), lastUses_.end(), TimedHandle{timeMs, INT_MIN}) - lastUses_.begin();
+    }
+    time_ = timeMs;
+
+    for (auto& [handle, prepared] : done) {
+        attach(handle, prepared);
+    }
+
+    while (useCursor_ < uses_.size() && uses_[useCursor_].first <= timeMs + LOOKAHEAD_MS) {
+        request(uses_[useCursor_++].second, false);
+    }
+
+    while (lastUseCursor_ < lastUses_.size() && lastUses_[lastUseCursor_].first < timeMs) {
+        int handle = lastUses_[lastUseCursor_++].second;
+        scheduleEviction(handle, slots_[handle]);
+    }
+    while (!evictions_.empty() && evictions_.top().first <= timeMs) {
+        int handle = evictions_.top().second;
+        evictions_.pop();
+        Slot& slot = slots_[handle];
+        if (slot.state != State::Loaded || slot.lastUse >= timeMs) continue;  // Needed again after a jump back
+        audio_->freeSample(handle);
+        slot.state = State::Unloaded;
+    }
+}
+
+bool KeySoundStreamer::ready(int handle) {
+    if (slots_.empty()) return true;
+    auto it = slots_.find(handle);
+    if (it == slots_.end()) return true;
+    if (it->second.state == State::Loaded || it->second.state == State::Failed) return true;
+    lateCount_++;
+    request(handle, true);
+    return false;
+}
+
+void KeySoundStreamer::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        done_.clear();
+        generation_++;
+    }
+    slots_.clear();
+    uses_.clear();
+    lastUses_.clear();
+    useCursor_ = 0;
+    lastUseCursor_ = 0;
+    time_ = INT64_MIN;
+    evictions_ = {};
+    lateCount_ = 0;
+}
+
+void KeySoundStreamer::request(int handle, bool urgent) {
+    Slot& slot = slots_[handle];
+    if (slot.state == State::Loaded || slot.state == State::Failed) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot.state == State::Queued) {
+        if (!urgent) return;
+        // Still waiting behind the lookahead work: move it to the front
+        auto it = std::find_if(queue_.begin(), queue_.end(), [handle](const Job& job) { return job.handle == handle; });
+        if (it == queue_.end() || it == queue_.begin()) return;
+        Job job = std::move(*it);
+        queue_.erase(it);
+        queue_.push_front(std::move(job));
+        return;
+    }
+
+    slot.state = State::Queued;
+    Job job{handle, generation_, slot.key, slot.decode};
+    if (urgent) {
+        queue_.push_front(std::move(job));
+    } else {
+        queue_.push_back(std::move(job));
+    }
+    workReady_.notify_one();
+}
+
+void KeySoundStreamer::scheduleEviction(int handle, const Slot& slot) {
+    if (slot.state != State::Loaded) return;
+    evictions_.push({slot.lastUse + slot.durationMs + EVICT_DELAY_MS, handle});
+}
+
+void KeySoundStreamer::workerMain() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workReady_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // Decode and copy into playback memory here, off the gameplay thread
+        PreparedSample prepared;
+        try {
+            PcmCache::Entry pcm = cache_.getOrDecode(job.key, job.decode);
+            if (pcm) prepared = audio_->prepareSample(std::move(pcm));
+        } catch (const std::exception& e) {
+            std::cerr << "[KEYSOUND] Decode failed: " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (job.generation == generation_) done_.emplace_back(job.handle, std::move(prepared));
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "AudioManager.h"
+#include "PcmCache.h"
+
+// Streamed keysound loading for large charts: each sample gets a reserved audio handle at load
+// time, only the chart's opening is decoded before play, and loader threads decode the rest
+// shortly before the first note that uses it and copy it into playback memory, so the gameplay
+// thread only attaches finished samples. Samples are freed once their last use has played.
+// A sample played before it is ready stays silent and is counted as late.
+class KeySoundStreamer {
+public:
+    using Decoder = std::function<bool(PcmSample&)>;
+
+    static const int64_t PRELOAD_MS = 10000;     // Decoded before play, from the first use
+    static const int64_t LOOKAHEAD_MS = 8000;    // Decoded this far ahead of the playhead
+    static const int64_t EVICT_DELAY_MS = 1000;  // Kept after the last use has finished playing
+
+    explicit KeySoundStreamer(PcmCache& cache) : cache_(cache) {}
+    ~KeySoundStreamer();
+    KeySoundStreamer(const KeySoundStreamer&) = delete;
+    KeySoundStreamer& operator=(const KeySoundStreamer&) = delete;
+
+    void setAudioManager(AudioManager* audio) { audio_ = audio; }
+
+    // Reserve a handle for a sample decoded later by decode() (cached under key if not empty)
+    int add(const std::string& key, Decoder decode);
+    bool empty() const { return slots_.empty(); }
+
+    // Set the play times of each handle (in any order) and return the handles to decode now
+    std::vector<int> start(std::vector<std::pair<int64_t, int>> uses);
+    const std::string& keyOf(int handle) const { return slots_.at(handle).key; }
+    const Decoder& decoderOf(int handle) const { return slots_.at(handle).decode; }
+
+    // Hand decoded PCM to its handle (nullptr = decoding failed). Thread that plays samples,
+    // before play starts (the copy into playback memory happens here).
+    void load(int handle, const PcmCache::Entry& pcm);
+
+    // Attach samples the loader threads finished, queue the ones coming up and free the ones
+    // done with. Gameplay thread, every tick: no decoding or copying happens here.
+    void update(int64_t timeMs);
+
+    // Whether a handle can play; a streamed sample that is not loaded yet is counted as late
+    // and moved to the front of the queue
+    bool ready(int handle);
+    int lateCount() const { return lateCount_; }
+
+    void clear();
+
+private:
+    static const unsigned LOADER_THREADS = 2;
+
+    enum class State : uint8_t { Unloaded, Queued, Loaded, Failed };
+
+    struct Slot {
+        std::string key;
+        Decoder decode;
+        int64_t lastUse = INT64_MIN;
+        int64_t durationMs = 0;
+        State state = State::Unloaded;
+    };
+
+    struct Job {
+        int handle;
+        uint64_t generation;
+        std::string key;
+        Decoder decode;
+    };
+
+    using TimedHandle = std::pair<int64_t, int>;
+
+    PcmCache& cache_;
+    AudioManager* audio_ = nullptr;
+
+    // Main thread only
+    std::unordered_map<int, Slot> slots_;
+    std::vector<TimedHandle> uses_;      // By time
+    std::vector<TimedHandle> lastUses_;  // By time
+    size_t useCursor_ = 0;
+    size_t lastUseCursor_ = 0;
+    int64_t time_ = INT64_MIN;
+    std::priority_queue<TimedHandle, std::vector<TimedHandle>, std::greater<TimedHandle>> evictions_;
+    int lateCount_ = 0;
+
+    // Shared with the loader threads
+    std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::deque<Job> queue_;
+    std::vector<std::pair<int, PreparedSample>> done_;
+    uint64_t generation_ = 0;  // Bumped by clear() so results of an old chart are dropped
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void attach(int handle, PreparedSample& prepared);
+    void request(int handle, bool urgent);
+    void scheduleEviction(int handle, const Slot& slot);
+    void workerMain();
+};
@@ -0,0 +1,224 @@
+#include "PcmCache.h"
+#include "PcmSample.h"
+#include "MappedFile.h"
+#include "SongIndex.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+extern "C" {
+#include "minilzo.h"
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char DISK_MAGIC[4] = {'K', 'P', 'C', 'M'};
+const uint32_t DISK_VERSION = 2;
+
+// Followed by the key (file names are only a hash of it) and then the packed PCM
+struct DiskHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t freq;
+    uint32_t channels;
+    uint64_t rawSize;
+    uint64_t packedSize;
+    uint64_t keySize;
+};
+
+// LZO1X output per input byte is bounded: the longest run costs a zero byte per 255 bytes
+const uint64_t LZO_MAX_EXPANSION = 256;
+
+bool lzoReady() {
+    static const bool ready = lzo_init() == LZO_E_OK;
+    return ready;
+}
+
+// Per-channel sample deltas: neighbouring 16-bit samples are close, so the deltas compress
+// far better than the raw PCM
+void deltaEncode(std::vector<uint8_t>& data, unsigned channels) {
+    size_t count = data.size() / 2;
+    uint16_t prev[16] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint16_t s;
+        memcpy(&s, &data[i * 2], 2);
+        uint16_t d = (uint16_t)(s - prev[i % channels]);
+        prev[i % channels] = s;
+        memcpy(&data[i * 2], &d, 2);
+    }
+}
+
+void deltaDecode(std::vector<uint8_t>& data, unsigned channels) {
+    size_t count = data.size() / 2;
+    uint16_t prev[16] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint16_t d;
+        memcpy(&d, &data[i * 2], 2);
+        uint16_t s = (uint16_t)(prev[i % channels] + d);
+        prev[i % channels] = s;
+        memcpy(&data[i * 2], &s, 2);
+    }
+}
+
+}  // namespace
+
+std::string PcmCache::keyOf(const std::string& path) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec) return "";
+    int64_t mtime = (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) return "";
+    return path + '|' + std::to_string(size) + '|' + std::to_string(mtime);
+}
+
+PcmCache::Entry PcmCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->pcm;
+}
+
+PcmCache::Entry PcmCache::getFromDisk(const std::string& key) {
+    if (!diskEnabled_ || key.empty()) return nullptr;
+    auto pcm = std::make_shared<PcmSample>();
+    std::string path = diskPath(key);
+    if (!readFile(path, key, *pcm)) {
+        // Corrupt, from an older version or another key's: drop it so put() can store this one
+        std::error_code ec;
+        fs::remove(path, ec);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(key, pcm);
+    return pcm;
+}
+
+void PcmCache::put(const std::string& key, Entry pcm) {
+    if (key.empty() || !pcm || pcm->empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert(key, pcm);
+    }
+    if (diskEnabled_) {
+        std::string path = diskPath(key);
+        std::error_code ec;
+        if (!fs::exists(path, ec)) writeFile(path, key, *pcm);
+    }
+}
+
+PcmCache::Entry PcmCache::getOrDecode(const std::string& key, const std::function<bool(PcmSample&)>& decode) {
+    if (Entry cached = get(key)) return cached;
+    if (Entry cached = getFromDisk(key)) return cached;
+    auto pcm = std::make_shared<PcmSample>();
+    if (!decode(*pcm)) return nullptr;
+    put(key, pcm);
+    return pcm;
+}
+
+void PcmCache::insert(const std::string& key, Entry pcm) {
+    if (index_.count(key)) return;
+    bytes_ += pcm->data.size();
+    lru_.push_front({key, std::move(pcm)});
+    index_[key] = lru_.begin();
+
+    // The newest entry always stays, even if it alone is over budget
+    while (bytes_ > MAX_BYTES && lru_.size() > 1) {
+        Item& oldest = lru_.back();
+        bytes_ -= oldest.pcm->data.size();  // Samples being uploaded stay alive through their shared_ptr
+        index_.erase(oldest.key);
+        lru_.pop_back();
+    }
+}
+
+std::string PcmCache::diskPath(const std::string& key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) hash = (hash ^ c) * 1099511628211ull;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.pcm", (unsigned long long)hash);
+    return (fs::path(SongIndex::getIndexDir()) / "Keysounds" / name).string();
+}
+
+bool PcmCache::writeFile(const std::string& path, const std::string& key, const PcmSample& pcm) {
+    // Larger samples would not pass readFile's size check
+    if (!lzoReady() || pcm.channels == 0 || pcm.channels > 16 || pcm.data.size() > MAX_BYTES) return false;
+
+    std::vector<uint8_t> raw = pcm.data;
+    deltaEncode(raw, pcm.channels);
+    std::vector<uint8_t> packed(raw.size() + raw.size() / 16 + 64 + 3);
+    std::vector<uint8_t> work(LZO1X_1_MEM_COMPRESS);
+    lzo_uint packedSize = packed.size();
+    if (lzo1x_1_compress(raw.data(), raw.size(), packed.data(), &packedSize, work.data()) != LZO_E_OK) {
+        return false;
+    }
+
+    DiskHeader header;
+    memcpy(header.magic, DISK_MAGIC, 4);
+    header.version = DISK_VERSION;
+    header.freq = pcm.freq;
+    header.channels = pcm.channels;
+    header.rawSize = raw.size();
+    header.packedSize = packedSize;
+    header.keySize = key.size();
+
+    // Written under a temporary name so a reader never sees a partial file
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(key.data(), key.size());
+        out.write(reinterpret_cast<const char*>(packed.data()), packedSize);
+        if (!out) {
+            out.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "[KEYSOUND] Could not store " << path << ": " << ec.message() << std::endl;
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool PcmCache::readFile(const std::string& path, const std::string& key, PcmSample& pcm) {
+    MappedFile file;
+    if (!lzoReady() || !file.open(path) || file.size() < sizeof(DiskHeader)) return false;
+
+    DiskHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, DISK_MAGIC, 4) != 0 || header.version != DISK_VERSION ||
+        header.channels == 0 || header.channels > 16 || header.keySize != key.size() ||
+        file.size() < sizeof(DiskHeader) + key.size() ||
+        header.packedSize != file.size() - sizeof(DiskHeader) - key.size() ||
+        memcmp(file.data() + sizeof(DiskHeader), key.data(), key.size()) != 0) {
+        return false;
+    }
+    // Checked before allocating: a damaged size must not become a huge resize()
+    if (header.rawSize == 0 || header.rawSize > MAX_BYTES ||
+        header.rawSize > header.packedSize * LZO_MAX_EXPANSION) {
+        return false;
+    }
+
+    pcm.data.resize(header.rawSize);
+    lzo_uint rawSize = header.rawSize;
+    if (lzo1x_decompress_safe(file.data() + sizeof(DiskHeader) + key.size(), header.packedSize,
+                              pcm.data.data(), &rawSize, nullptr) != LZO_E_OK ||
+        rawSize != header.rawSize) {
+        pcm.data.clear();
+        return false;
+    }
+    deltaDecode(pcm.data, header.channels);
+    pcm.freq = header.freq;
+    pcm.channels = (uint16_t)header.channels;
+    return !pcm.empty();
+}
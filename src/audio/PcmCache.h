@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct PcmSample;
+
+// Decoded keysounds kept across chart loads, so a retry or a replay of the same chart skips
+// decoding. Entries are keyed by source file, entry index and modification time and kept in
+// an LRU under a byte budget. Optionally they are also stored LZO-compressed under the library
+// index directory and reused across sessions (Clear Index removes them). Thread-safe.
+class PcmCache {
+public:
+    using Entry = std::shared_ptr<const PcmSample>;
+
+    // Key for a file, empty if it is missing. Entries of a container (S3P/2DX) use the
+    // container's key with '#' and their index appended.
+    static std::string keyOf(const std::string& path);
+
+    Entry get(const std::string& key);          // From memory, or nullptr
+    Entry getFromDisk(const std::string& key);  // From the disk cache (if enabled), or nullptr
+    void put(const std::string& key, Entry pcm);
+    // From memory, then disk, else decode() and store; nullptr if decoding fails
+    Entry getOrDecode(const std::string& key, const std::function<bool(PcmSample&)>& decode);
+
+    void setDiskEnabled(bool enabled) { diskEnabled_ = enabled; }
+
+private:
+    static const size_t MAX_BYTES = 256 * 1024 * 1024;
+
+    struct Item {
+        std::string key;
+        Entry pcm;
+    };
+
+    std::mutex mutex_;
+    std::list<Item> lru_;  // Front = most recently used
+    std::unordered_map<std::string, std::list<Item>::iterator> index_;
+    size_t bytes_ = 0;
+    std::atomic<bool> diskEnabled_{false};
+
+    void insert(const std::string& key, Entry pcm);
+    static std::string diskPath(const std::string& key);
+    // The key is stored in the file and must match on read (file names are only its hash)
+    static bool writeFile(const std::string& path, const std::string& key, const PcmSample& pcm);
+    static bool readFile(const std::string& path, const std::string& key, PcmSample& pcm);
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// A keysound decoded to interleaved 16-bit PCM, ready to become a BASS sample
+struct PcmSample {
+    std::vector<uint8_t> data;
+    uint32_t freq = 0;
+    uint16_t channels = 0;
+
+    bool empty() const { return data.empty(); }
+};
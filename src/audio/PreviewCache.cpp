@@ -0,0 +1,222 @@
+#include "PreviewCache.h"
+#include "OjmParser.h"
+#include "SongIndex.h"
+#include <bass.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static const size_t WAV_HEADER_SIZE = 44;
+
+static void writeWavHeader(uint8_t* out, uint32_t dataSize, uint16_t channels, uint32_t sampleRate, uint16_t bits) {
+    auto u16 = [](uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); };
+    auto u32 = [](uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (i * 8)); };
+    uint16_t blockAlign = channels * bits / 8;
+    memcpy(out, "RIFF", 4);
+    u32(out + 4, 36 + dataSize);
+    memcpy(out + 8, "WAVEfmt ", 8);
+    u32(out + 16, 16);
+    u16(out + 20, 1);  // PCM
+    u16(out + 22, channels);
+    u32(out + 24, sampleRate);
+    u32(out + 28, sampleRate * blockAlign);
+    u16(out + 32, blockAlign);
+    u16(out + 34, bits);
+    memcpy(out + 36, "data", 4);
+    u32(out + 40, dataSize);
+}
+
+PreviewCache::~PreviewCache() {
+    stop();
+}
+
+void PreviewCache::start() {
+    if (thread_.joinable()) return;
+    stopping_ = false;
+    thread_ = std::thread(&PreviewCache::threadMain, this);
+}
+
+void PreviewCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        urgent_.clear();
+        prefetch_.clear();
+        inFlight_.clear();
+        failed_.clear();
+    }
+    workReady_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+std::string PreviewCache::keyOf(const PreviewSource& source) {
+    if (source.audioPath.empty()) return source.ojnPath;
+    return source.audioPath + '@' + std::to_string(source.previewTime);
+}
+
+PreviewCache::Clip PreviewCache::get(const PreviewSource& source) {
+    std::string key = keyOf(source);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->clip;
+}
+
+void PreviewCache::enqueue(std::deque<PreviewSource>& queue, const PreviewSource& source) {
+    std::string key = keyOf(source);
+    if (index_.count(key) || inFlight_.count(key)) return;
+    auto failed = failed_.find(key);
+    if (failed != failed_.end()) {
+        if (std::chrono::steady_clock::now() < failed->second) return;
+        failed_.erase(failed);
+    }
+    queue.push_back(source);
+    inFlight_.insert(key);
+}
+
+void PreviewCache::request(const PreviewSource& source) {
+    if (source.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    pinnedKey_ = keyOf(source);
+    // A queued prefetch of the same clip moves to the front
+    for (auto it = prefetch_.begin(); it != prefetch_.end(); ++it) {
+        if (keyOf(*it) == pinnedKey_) {
+            urgent_.push_back(*it);
+            prefetch_.erase(it);
+            workReady_.notify_one();
+            return;
+        }
+    }
+    enqueue(urgent_, source);
+    workReady_.notify_one();
+}
+
+void PreviewCache::prefetch(const std::vector<PreviewSource>& sources) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& s : prefetch_) inFlight_.erase(keyOf(s));
+    prefetch_.clear();
+    for (const auto& s : sources) {
+        if (!s.empty()) enqueue(prefetch_, s);
+    }
+    if (!prefetch_.empty()) workReady_.notify_one();
+}
+
+void PreviewCache::insert(const std::string& key, Clip clip) {
+    if (index_.count(key)) return;
+    bytes_ += clip->size();
+    lru_.push_front({key, std::move(clip)});
+    index_[key] = lru_.begin();
+
+    auto it = lru_.end();
+    while (bytes_ > MAX_BYTES && it != lru_.begin()) {
+        --it;
+        if (it->key == pinnedKey_ || it == lru_.begin()) continue;
+        bytes_ -= it->clip->size();  // Playing clips stay alive through their shared_ptr
+        index_.erase(it->key);
+        it = lru_.erase(it);
+    }
+}
+
+void PreviewCache::threadMain() {
+    for (;;) {
+        PreviewSource source;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workReady_.wait(lock, [this] { return stopping_ || !urgent_.empty() || !prefetch_.empty(); });
+            if (stopping_) return;
+            std::deque<PreviewSource>& queue = urgent_.empty() ? prefetch_ : urgent_;
+            source = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        Clip clip = source.audioPath.empty() ? generateClip(source.ojnPath) : decodeClip(source);
+
+        std::string key = keyOf(source);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        inFlight_.erase(key);
+        if (clip) {
+            insert(key, std::move(clip));
+        } else {
+            failed_[key] = std::chrono::steady_clock::now() + std::chrono::milliseconds(RETRY_MS);
+        }
+    }
+}
+
+PreviewCache::Clip PreviewCache::decodeClip(const PreviewSource& source) {
+    HSTREAM stream = BASS_StreamCreateFile(FALSE, source.audioPath.c_str(), 0, 0, BASS_STREAM_DECODE | BASS_STREAM_PRESCAN);
+    if (!stream) return nullptr;
+
+    BASS_CHANNELINFO info;
+    if (!BASS_ChannelGetInfo(stream, &info) || (info.flags & (BASS_SAMPLE_8BITS | BASS_SAMPLE_FLOAT))) {
+        BASS_StreamFree(stream);
+        return nullptr;
+    }
+
+    // Same start point as seeking the full song: previewTime, or 40% in when it is -1
+    double start = 0;
+    if (source.previewTime > 0) {
+        start = source.previewTime / 1000.0;
+    } else if (source.previewTime == -1) {
+        start = 0.4 * BASS_ChannelBytes2Seconds(stream, BASS_ChannelGetLength(stream, BASS_POS_BYTE));
+    }
+    if (start > 0) BASS_ChannelSetPosition(stream, BASS_ChannelSeconds2Bytes(stream, start), BASS_POS_BYTE);
+
+    size_t want = (size_t)BASS_ChannelSeconds2Bytes(stream, CLIP_MS / 1000.0);
+    auto wav = std::make_shared<std::vector<uint8_t>>(WAV_HEADER_SIZE + want);
+    size_t got = 0;
+    while (got < want) {
+        DWORD n = BASS_ChannelGetData(stream, wav->data() + WAV_HEADER_SIZE + got, (DWORD)std::min<size_t>(want - got, 1 << 20));
+        if (n == (DWORD)-1 || n == 0) break;
+        got += n;
+    }
+    BASS_StreamFree(stream);
+
+    // Anything under a second means the file is broken or BASS went away mid-decode
+    uint32_t blockAlign = info.chans * 2;
+    if (blockAlign == 0 || got < (size_t)info.freq * blockAlign) return nullptr;
+    got -= got % blockAlign;
+    wav->resize(WAV_HEADER_SIZE + got);
+    wav->shrink_to_fit();
+    writeWavHeader(wav->data(), (uint32_t)got, (uint16_t)info.chans, info.freq, 16);
+    return wav;
+}
+
+PreviewCache::Clip PreviewCache::generateClip(const std::string& ojnPath) {
+    // Persisted under a name derived from the chart's path, size and time, so an edited chart
+    // gets a fresh preview
+    std::error_code ec;
+    uint64_t size = fs::file_size(ojnPath, ec);
+    if (ec) return nullptr;
+    int64_t mtime = (int64_t)fs::last_write_time(ojnPath, ec).time_since_epoch().count();
+    std::string id = ojnPath + '|' + std::to_string(size) + '|' + std::to_string(mtime);
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : id) hash = (hash ^ c) * 1099511628211ull;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.wav", (unsigned long long)hash);
+
+    fs::path dir = fs::path(SongIndex::getIndexDir()) / "Previews";
+    fs::path path = dir / name;
+    if (!fs::exists(path, ec)) {
+        std::string generated = OjmParser::generatePreview(ojnPath, CLIP_MS);
+        if (generated.empty()) return nullptr;
+        fs::create_directories(dir, ec);
+        fs::rename(generated, path, ec);
+        if (ec) {
+            std::cerr << "[PREVIEW] Could not store " << path.string() << ": " << ec.message() << std::endl;
+            path = generated;
+        }
+    }
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return nullptr;
+    auto wav = std::make_shared<std::vector<uint8_t>>((size_t)in.tellg());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(wav->data()), wav->size())) return nullptr;
+    return wav;
+}
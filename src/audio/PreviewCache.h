@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// What a song-select preview plays: the song's audio from its preview point, or for
+// keysound-only O2Jam charts a clip mixed from the OJM samples.
+struct PreviewSource {
+    std::string audioPath;  // Audio file (empty for a generated preview)
+    int previewTime = 0;    // Clip start in ms (-1 = 40% of the song)
+    std::string ojnPath;    // O2Jam chart to mix a preview from when there is no audio file
+
+    bool empty() const { return audioPath.empty() && ojnPath.empty(); }
+    const std::string& file() const { return audioPath.empty() ? ojnPath : audioPath; }
+};
+
+// Preview clips (CLIP_MS from the preview point) decoded on a loader thread into in-memory
+// WAV files and kept in an LRU under a byte budget, so previews of nearby songs start without
+// opening or prescanning the audio file. Generated O2Jam previews are also kept on disk under
+// the library index directory and reused across sessions (Clear Index removes them).
+class PreviewCache {
+public:
+    using Clip = std::shared_ptr<const std::vector<uint8_t>>;
+    static const int CLIP_MS = 30000;
+
+    PreviewCache() = default;
+    ~PreviewCache();
+    PreviewCache(const PreviewCache&) = delete;
+    PreviewCache& operator=(const PreviewCache&) = delete;
+
+    void start();
+    void stop();
+
+    Clip get(const PreviewSource& source);      // Cached clip or nullptr
+    void request(const PreviewSource& source);  // Load ahead of any prefetch
+    void prefetch(const std::vector<PreviewSource>& sources);  // Replaces queued prefetches
+
+private:
+    static const size_t MAX_BYTES = 96 * 1024 * 1024;  // ~18 clips of 16-bit stereo
+    static const int RETRY_MS = 10000;                  // Before a failed clip is decoded again
+
+    struct Entry {
+        std::string key;
+        Clip clip;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::list<Entry> lru_;  // Front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+    std::string pinnedKey_;  // Last requested clip, never evicted
+    std::deque<PreviewSource> urgent_;
+    std::deque<PreviewSource> prefetch_;
+    std::unordered_set<std::string> inFlight_;  // Queued or loading
+    // Failed clips and when they may be tried again: a decode can fail only for a while
+    // (audio device being reinitialized), so a failure is not final
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> failed_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    static std::string keyOf(const PreviewSource& source);
+    void enqueue(std::deque<PreviewSource>& queue, const PreviewSource& source);
+    void insert(const std::string& key, Clip clip);
+    void threadMain();
+    static Clip decodeClip(const PreviewSource& source);
+    static Clip generateClip(const std::string& ojnPath);
+};
@@ -0,0 +1,79 @@
+#include "ActiveNoteWindow.h"
+#include <algorithm>
+
+ActiveNoteWindow::ActiveNoteWindow() {
+    clear();
+}
+
+void ActiveNoteWindow::clear() {
+    order_.clear();
+    position_.clear();
+    liveNotes_.clear();
+    autoPlayHead_ = 0;
+    waitingHead_ = 0;
+    resolvedHead_ = 0;
+}
+
+void ActiveNoteWindow::build(const std::vector<Note>& notes) {
+    clear();
+    order_.resize(notes.size());
+    for (size_t i = 0; i < notes.size(); i++) {
+        order_[i] = static_cast<int>(i);
+    }
+    // Parsers already sort by time; stable sort keeps chart order for equal times
+    std::stable_sort(order_.begin(), order_.end(), [&notes](int a, int b) {
+        return notes[a].time < notes[b].time;
+    });
+    position_.resize(notes.size());
+    for (size_t pos = 0; pos < order_.size(); pos++) {
+        position_[order_[pos]] = static_cast<int>(pos);
+    }
+}
+
+int ActiveNoteWindow::nextAutoPlayNote(const std::vector<Note>& notes, int64_t currentTime) {
+    while (autoPlayHead_ < order_.size()) {
+        const Note& note = notes[order_[autoPlayHead_]];
+        if (note.state != NoteState::Waiting) {
+            autoPlayHead_++;
+            continue;
+        }
+        return (note.time <= currentTime) ? order_[autoPlayHead_] : -1;
+    }
+    return -1;
+}
+
+int ActiveNoteWindow::peekWaiting(const std::vector<Note>& notes) {
+    while (waitingHead_ < order_.size()) {
+        const Note& note = notes[order_[waitingHead_]];
+        if (!note.isFakeNote && note.state == NoteState::Waiting) {
+            return order_[waitingHead_];
+        }
+        waitingHead_++;
+    }
+    return -1;
+}
+
+void ActiveNoteWindow::addLive(int noteIndex) {
+    int pos = getPosition(noteIndex);
+    if (pos < 0) return;
+    auto it = std::lower_bound(liveNotes_.begin(), liveNotes_.end(), pos,
+        [this](int idx, int p) { return position_[idx] < p; });
+    if (it != liveNotes_.end() && *it == noteIndex) return;
+    liveNotes_.insert(it, noteIndex);
+}
+
+void ActiveNoteWindow::pruneLive(const std::vector<Note>& notes) {
+    liveNotes_.erase(std::remove_if(liveNotes_.begin(), liveNotes_.end(), [&notes](int idx) {
+        NoteState s = notes[idx].state;
+        return s == NoteState::Hit || s == NoteState::Missed;
+    }), liveNotes_.end());
+}
+
+bool ActiveNoteWindow::allResolved(const std::vector<Note>& notes) {
+    while (resolvedHead_ < order_.size()) {
+        NoteState s = notes[order_[resolvedHead_]].state;
+        if (s != NoteState::Hit && s != NoteState::Missed) return false;
+        resolvedHead_++;
+    }
+    return true;
+}
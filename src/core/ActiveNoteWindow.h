@@ -0,0 +1,49 @@
+#pragma once
+#include "Note.h"
+#include <cstdint>
+#include <vector>
+
+// Active note window for per-frame gameplay updates
+// Notes are visited in time order through heads that only move forward, and
+// holds in progress (Holding/Released) are kept in a small live set, so the
+// per-frame cost depends on the notes in play instead of the chart length.
+class ActiveNoteWindow {
+public:
+    ActiveNoteWindow();
+
+    // Rebuild from beatmap notes (call after loading, notes must not be reordered afterwards)
+    void build(const std::vector<Note>& notes);
+    void clear();
+
+    // AutoPlay: next Waiting note (fake notes included) due at currentTime, -1 if none
+    int nextAutoPlayNote(const std::vector<Note>& notes, int64_t currentTime);
+
+    // Miss detection: earliest Waiting playable note, -1 if none
+    // The caller must move the returned note out of Waiting before asking again
+    int peekWaiting(const std::vector<Note>& notes);
+
+    // Hold note started holding (head hit or head missed)
+    void addLive(int noteIndex);
+
+    // Live holds ordered by note time (may contain notes resolved this frame)
+    const std::vector<int>& getLiveNotes() const { return liveNotes_; }
+
+    // Drop resolved (Hit/Missed) notes from the live set
+    void pruneLive(const std::vector<Note>& notes);
+
+    // Position of a note in time order (for merging live holds with the waiting head)
+    int getPosition(int noteIndex) const {
+        return (noteIndex >= 0 && noteIndex < static_cast<int>(position_.size())) ? position_[noteIndex] : -1;
+    }
+
+    // True when every note (fake notes included) is Hit or Missed
+    bool allResolved(const std::vector<Note>& notes);
+
+private:
+    std::vector<int> order_;      // Note indices sorted by time
+    std::vector<int> position_;   // Note index -> position in order_
+    std::vector<int> liveNotes_;  // Holding/Released holds, sorted by position
+    size_t autoPlayHead_;         // First position AutoPlay has not hit yet
+    size_t waitingHead_;          // First position that may still be Waiting (playable notes)
+    size_t resolvedHead_;         // First position not yet Hit/Missed
+};
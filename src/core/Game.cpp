@@ -24,6 +24,7 @@
 #include "DMRVSongDB.h"
 #include "StarRating.h"
 #include "SongIndex.h"
+#include "WorkStealingPool.h"
 #include "OsuMods.h"
 #include "FileDialog.h"
 #include "stb_image.h"
@@ -39,6 +40,7 @@
 #include <iomanip>
 #include <map>
 #include <set>
+#include <unordered_set>
 
 // FFmpeg for audio transcoding (WMA/HCA -> WAV)
 extern "C" {
@@ -50,8 +52,6 @@ extern "C" {
 }
 
 // ICU for locale-aware string comparison
-#include <unicode/ucol.h>
-#include <unicode/ustring.h>
 
 namespace fs = std::filesystem;
 
@@ -151,19 +151,6 @@ static HitSoundInfo buildEmptyTapHitSoundInfo(const std::vector<TimingPoint>& ti
     return info;
 }
 
-// Helper function to update next note index for a lane after a note is hit/missed
-static void updateLaneNextNoteIndex(int* laneNextNoteIndex, const std::vector<Note>& notes, int lane, int currentIndex) {
-    // Find the next Waiting note in this lane after currentIndex
-    for (size_t i = currentIndex + 1; i < notes.size(); i++) {
-        if (notes[i].lane == lane && !notes[i].isFakeNote) {
-            laneNextNoteIndex[lane] = static_cast<int>(i);
-            return;
-        }
-    }
-    // No more notes in this lane - reset (osu! stable resets keysound here)
-    laneNextNoteIndex[lane] = -1;
-}
-
 // Helper function to format difficulty name (separate function to avoid optimizer issues)
 static std::string formatDifficultyName(const SongEntry& song, int d, int starRatingVersion) {
     std::string diffName;
@@ -269,18 +256,16 @@ Game::Game() : state(GameState::Menu), running(false), musicStarted(false), hasB
 }
 
 Game::~Game() {
-    // Wait for scan thread to finish
+    // Stop the scan after the folders already being parsed
+    scanCancelled = true;
     if (scanThread.joinable()) {
         scanThread.join();
     }
-    // Wait for background load thread to finish
-    if (bgLoadThread.joinable()) {
-        bgLoadThread.join();
-    }
-    if (bgLoadData) {
-        stbi_image_free(bgLoadData);
-        bgLoadData = nullptr;
-    }
+    // Stop background loaders and free their textures while the renderer still exists
+    currentBgTexture = nullptr;
+    backgroundCache.shutdown();
+    previewCache.stop();  // Its loader decodes through BASS
+    SongIndex::close();  // Syncs songs saved since the last scan
     cleanupTempFiles();  // Clean up temp files on exit
     TTF_Quit();
     SDL_Quit();
@@ -328,6 +313,7 @@ bool Game::init() {
         std::cerr << "Renderer init failed" << std::endl;
         return false;
     }
+    backgroundCache.init(renderer.getRenderer());
 
     // Apply saved resolution
     if (settings.resolution >= 0 && settings.resolution <= 2) {
@@ -339,10 +325,17 @@ bool Game::init() {
         std::cerr << "Audio init failed" << std::endl;
         return false;
     }
+    audio.setClockLogging(settings.debugEnabled);
+    audio.setSoftwareMixer(settings.softwareMixer);
+    previewCache.start();
 
     // Initialize key sound manager
     keySoundManager.setAudioManager(&audio);
+    keySoundManager.setProgressCallback([this](float fraction) {
+        loadingProgress = 0.6f + 0.2f * fraction;  // The keysound stage of the loading bar
+    });
     keySoundManager.setKeysoundVolume(settings.keysoundVolume);
+    keySoundManager.setDiskCacheEnabled(settings.keysoundDiskCache);
 
     // Initialize skin manager
     renderer.setSkinManager(&skinManager);
@@ -1212,7 +1205,7 @@ void Game::exportBeatmapAsync() {
                 // Update note filenames to match actual ZIP names
                 for (auto& note : info.notes) {
                     if (!note.filename.empty()) {
-                        std::string fn = fs::path(note.filename).filename().string();
+                        std::string fn = fs::path(note.filename.str()).filename().string();
                         auto rit = pakRenameMap.find(fn);
                         if (rit != pakRenameMap.end()) note.filename = rit->second;
                     }
@@ -1273,7 +1266,7 @@ void Game::exportBeatmapAsync() {
                     addSSFKeysound(note.filename);
                     // Ensure note references .wav filename for .osu output
                     if (!note.filename.empty()) {
-                        std::string stem = fs::path(note.filename).stem().string();
+                        std::string stem = fs::path(note.filename.str()).stem().string();
                         note.filename = stem + ".wav";
                     }
                 }
@@ -1514,7 +1507,7 @@ void Game::exportBeatmapAsync() {
 
             for (const auto& dir : searchDirs) {
                 if (!srcPath.empty()) break;
-                fs::path tryPath = dir / note.filename;
+                fs::path tryPath = dir / note.filename.str();
                 if (fs::exists(tryPath)) { srcPath = tryPath.string(); break; }
                 tryPath = dir / fn;
                 if (fs::exists(tryPath)) { srcPath = tryPath.string(); break; }
@@ -1808,6 +1801,9 @@ void Game::saveConfig() {
     file << "audioOutputMode=" << settings.audioOutputMode << "\n";
     file << "audioBufferSize=" << settings.audioBufferSize << "\n";
     file << "asioDevice=" << settings.asioDevice << "\n";
+    file << "keysoundDiskCache=" << (settings.keysoundDiskCache ? 1 : 0) << "\n";
+    file << "keysoundStreaming=" << (settings.keysoundStreaming ? 1 : 0) << "\n";
+    file << "softwareMixer=" << (settings.softwareMixer ? 1 : 0) << "\n";
 
     file << "\n[Graphics]\n";
     file << "resolution=" << settings.resolution << "\n";
@@ -1870,6 +1866,9 @@ void Game::saveConfig() {
     file << "\n[StarRating]\n";
     file << "starRatingVersion=" << settings.starRatingVersion << "\n";
 
+    file << "\n[SongSelect]\n";
+    file << "songSortMode=" << settings.songSortMode << "\n";
+
     file.close();;
 }
 
@@ -1908,6 +1907,9 @@ void Game::loadConfig() {
                 else if (key == "audioOutputMode") settings.audioOutputMode = std::stoi(value);
                 else if (key == "audioBufferSize") settings.audioBufferSize = std::stoi(value);
                 else if (key == "asioDevice") settings.asioDevice = std::stoi(value);
+                else if (key == "keysoundDiskCache") settings.keysoundDiskCache = (value == "1");
+                else if (key == "keysoundStreaming") settings.keysoundStreaming = (value == "1");
+                else if (key == "softwareMixer") settings.softwareMixer = (value == "1");
             }
             else if (section == "Graphics") {
                 if (key == "resolution") settings.resolution = std::max(0, std::min(2, std::stoi(value)));
@@ -1982,6 +1984,12 @@ void Game::loadConfig() {
             else if (section == "StarRating") {
                 if (key == "starRatingVersion") settings.starRatingVersion = std::stoi(value);
             }
+            else if (section == "SongSelect") {
+                if (key == "songSortMode") {
+                    int mode = std::stoi(value);
+                    if (mode >= 0 && mode < (int)SongSortMode::Count) settings.songSortMode = mode;
+                }
+            }
         } catch (...) {
             // Ignore parsing errors
         }
@@ -2045,10 +2053,14 @@ void Game::resetGame() {
     anyHoldActive = false;
     holdColorChangeTime = 0;
     ppCalculator.reset();
-    // Initialize next note index for each lane
-    for (int i = 0; i < 18; i++) {
-        laneNextNoteIndex[i] = -1;  // Will be set after loading beatmap
-    }
+    // Note indices are rebuilt after loading beatmap
+    laneNoteIndex.clear();
+    activeNotes.clear();
+    pendingInput.clear();
+    simTime = INT64_MIN;
+    stateChangeRequested = false;
+    renderer.clearNoteBuckets();
+    resetSnapshot();
 }
 
 bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
@@ -2362,6 +2374,7 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
     // Clear keysound cache before loading new keysounds
     keySoundManager.clear();
     audio.clearSamples();
+    keySoundManager.setStreaming(settings.keysoundStreaming);
 
     // Load S3P/2DX keysounds for IIDX (must be outside skipParsing block)
     bool isIIDXFile = path.size() > 2 && path.substr(path.size() - 2) == ".1";
@@ -2391,23 +2404,21 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
             if (OjmParser::parse(ojmPath, ojmInfo)) {
                 std::cout << "Loaded OJM: " << ojmInfo.samples.size() << " samples" << std::endl;
 
-                fs::path tempDir = fs::current_path() / "Data" / "Tmp" / "ojm";
-                fs::create_directories(tempDir);
+                // Samples are complete OGG/WAV files in memory: hand them to BASS directly
+                std::vector<int> sampleIds;
+                std::vector<std::pair<const void*, size_t>> buffers;
+                sampleIds.reserve(ojmInfo.samples.size());
+                buffers.reserve(ojmInfo.samples.size());
+                for (const auto& [id, sample] : ojmInfo.samples) {
+                    sampleIds.push_back(id);
+                    buffers.push_back({sample.data.data(), sample.data.size()});
+                }
+                std::vector<int> handles = audio.loadSamplesFromMemory(buffers);
 
                 std::unordered_map<int, int> sampleIdToHandle;
-                for (auto& [id, sample] : ojmInfo.samples) {
-                    std::string ext = sample.isOgg ? ".ogg" : ".wav";
-                    fs::path tempFile = tempDir / (std::to_string(id) + ext);
-
-                    std::ofstream out(tempFile, std::ios::binary);
-                    if (out) {
-                        out.write(reinterpret_cast<const char*>(sample.data.data()), sample.data.size());
-                        out.close();
-
-                        int handle = audio.loadSample(tempFile.string());
-                        if (handle >= 0) {
-                            sampleIdToHandle[id] = handle;
-                        }
+                for (size_t i = 0; i < handles.size(); i++) {
+                    if (handles[i] >= 0) {
+                        sampleIdToHandle[sampleIds[i]] = handles[i];
                     }
                 }
 
@@ -2507,26 +2518,20 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
         // Parse WAV definitions
         BMSData bmsData;
         if (BMSParser::parseFull(actualPath, bmsData)) {
-            std::unordered_map<int, int> wavIdToHandle;
-
+            // Resolved against one listing of the chart folder (any audio extension) and
+            // decoded in parallel by the keysound manager
+            std::vector<int> wavIds;
+            std::vector<std::string> wavPaths;
             for (const auto& [id, filename] : bmsData.wavDefs) {
-                fs::path wavPath = bmsDir / filename;
-                if (!fs::exists(wavPath)) {
-                    std::string stem = wavPath.stem().string();
-                    fs::path parent = wavPath.parent_path();
-                    for (const auto& ext : {".wav", ".ogg", ".mp3"}) {
-                        fs::path tryPath = parent / (stem + ext);
-                        if (fs::exists(tryPath)) {
-                            wavPath = tryPath;
-                            break;
-                        }
-                    }
-                }
-                if (fs::exists(wavPath)) {
-                    int handle = audio.loadSample(wavPath.string());
-                    if (handle >= 0) {
-                        wavIdToHandle[id] = handle;
-                    }
+                wavIds.push_back(id);
+                wavPaths.push_back((bmsDir / filename).string());
+            }
+            std::vector<int> wavHandles = keySoundManager.loadSamples(wavPaths);
+
+            std::unordered_map<int, int> wavIdToHandle;
+            for (size_t i = 0; i < wavHandles.size(); i++) {
+                if (wavHandles[i] >= 0) {
+                    wavIdToHandle[wavIds[i]] = wavHandles[i];
                 }
             }
 
@@ -2582,6 +2587,9 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
         }
     }
 
+    // Precompute SV scroll distances for note positioning
+    renderer.buildScrollTable(beatmap.timingPoints, baseBPM);
+
     // Set HP drain rate from beatmap
     hpManager.setHPDrainRate(beatmap.hp);
 
@@ -2644,6 +2652,10 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
                 return a.time < b.time;
             });
         keySoundManager.preloadStoryboardSamples(beatmap.storyboardSamples);
+    }
+    // Streaming: decode the samples of the opening now, the rest during play
+    keySoundManager.startStreaming(beatmap.notes, beatmap.storyboardSamples);
+    if (!settings.ignoreBeatmapHitsounds) {
         // Warmup audio system to prevent cold start delay
         audio.warmupSamples();
     }
@@ -2709,16 +2721,11 @@ bool Game::loadBeatmap(const std::string& path, bool skipParsing) {
             static_cast<StarRatingVersion>(settings.starRatingVersion), clockRate);
         ppCalculator.init(totalNotes, currentStarRating);
 
-        // Initialize next note index for each lane (for empty tap keysound)
-        for (int i = 0; i < 18; i++) {
-            laneNextNoteIndex[i] = -1;
-        }
-        for (size_t i = 0; i < beatmap.notes.size(); i++) {
-            int lane = beatmap.notes[i].lane;
-            if (lane >= 0 && lane < 18 && laneNextNoteIndex[lane] == -1) {
-                laneNextNoteIndex[lane] = static_cast<int>(i);
-            }
-        }
+        // Build per-lane judgement index (also tracks empty tap keysound note)
+        laneNoteIndex.build(beatmap.notes);
+        activeNotes.build(beatmap.notes);
+        resetSnapshot();
+        renderer.buildNoteBuckets(displayNotes);
     }
     return true;
 }
@@ -3267,10 +3274,23 @@ void Game::run() {
     lastFrameTime = SDL_GetTicks();
 
     Uint64 perfFreq = SDL_GetPerformanceFrequency();
+    Uint64 lastFramePerf = SDL_GetPerformanceCounter();
+
+    // Gameplay simulation runs on its own thread so a slow render does not delay judgement
+    gameplayThreadRunning = true;
+    gameplayThread = std::thread(&Game::gameplayThreadMain, this);
 
     while (running) {
+        // Held for everything except render(), which only reads the published snapshot
+        std::unique_lock<std::mutex> gameplayLock(gameplayMutex);
         Uint64 frameStartPerf = SDL_GetPerformanceCounter();
         int64_t frameStart = SDL_GetTicks();
+        // Real frame time for animations and HP smoothing (capped after stalls such as loading)
+        double frameDeltaMs = std::min((double)(frameStartPerf - lastFramePerf) * 1000.0 / perfFreq, 100.0);
+        lastFramePerf = frameStartPerf;
+
+        // Dead/Result reached by the gameplay thread since the last frame
+        applyRequestedState();
 
         // Performance monitoring - Input
         Uint64 t1 = SDL_GetPerformanceCounter();
@@ -3278,13 +3298,16 @@ void Game::run() {
         Uint64 t2 = SDL_GetPerformanceCounter();
         perfInput = (double)(t2 - t1) * 1000.0 / perfFreq;
 
-        // Performance monitoring - Update
-        if (state == GameState::Playing) {
-            update();
-        } else if (state == GameState::Dead) {
-            // Update slowdown effect (1.0 -> 0.0 over ~1 second)
+        // Performance monitoring - Update (the simulation itself runs on the gameplay thread)
+        if (state != GameState::Playing && !pendingInput.empty()) {
+            // Left Playing this frame (pause/death): apply remaining key events as before
+            applyPendingInput(INT64_MAX);
+            publishSnapshot();
+        }
+        if (state == GameState::Dead) {
+            // Update slowdown effect (1.0 -> 0.0 over 1 second)
             if (deathSlowdown > 0.0f) {
-                deathSlowdown -= 0.016f;  // ~60fps, 1 second to stop
+                deathSlowdown -= (float)(frameDeltaMs / 1000.0);
                 if (deathSlowdown < 0.0f) deathSlowdown = 0.0f;
             }
         } else if (state == GameState::Loading) {
@@ -3368,6 +3391,9 @@ void Game::run() {
         Uint64 t3 = SDL_GetPerformanceCounter();
         perfUpdate = (double)(t3 - t2) * 1000.0 / perfFreq;
 
+        gameplayActive = (state == GameState::Playing);
+        gameplayLock.unlock();
+
         // Performance monitoring - Draw
         render();
         Uint64 t4 = SDL_GetPerformanceCounter();
@@ -3388,6 +3414,11 @@ void Game::run() {
             // Otherwise busy-wait for precision
         }
     }
+
+    gameplayThreadRunning = false;
+    if (gameplayThread.joinable()) {
+        gameplayThread.join();
+    }
 }
 
 void Game::handleInput() {
@@ -3397,6 +3428,7 @@ void Game::handleInput() {
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_EVENT_QUIT) {
                 running = false;
+                scanCancelled = true;
             }
         }
         return;
@@ -3532,10 +3564,8 @@ void Game::handleInput() {
                     } else {
                         SDL_StopTextInput(renderer.getWindow());
                         stopPreviewMusic();
-                        if (currentBgTexture) {
-                            SDL_DestroyTexture(currentBgTexture);
-                            currentBgTexture = nullptr;
-                        }
+                        currentBgTexture = nullptr;
+                        currentBgPath.clear();
                         state = GameState::Menu;
                     }
                 }
@@ -3552,9 +3582,7 @@ void Game::handleInput() {
                 }
                 else if (e.key.key == SDLK_UP) {
                     // Find current song's filtered position
-                    int fp = -1;
-                    for (int f = 0; f < (int)filteredSongIndices.size(); f++)
-                        if (filteredSongIndices[f] == selectedSongIndex) { fp = f; break; }
+                    int fp = selectedFilteredIndex();
                     if (fp >= 0) {
                         const auto& fDiffs = filteredDiffIndices[fp];
                         // Find current diff position in filtered list
@@ -3569,7 +3597,7 @@ void Game::handleInput() {
                             songSelectNeedAutoScroll = true;
                         } else if (fp > 0) {
                             // Move to previous song's last filtered difficulty
-                            selectedSongIndex = filteredSongIndices[fp - 1];
+                            selectFilteredSong(fp - 1);
                             const auto& prevDiffs = filteredDiffIndices[fp - 1];
                             selectedDifficultyIndex = prevDiffs.empty() ? 0 : prevDiffs.back();
                             loadSongBackground(selectedSongIndex, selectedDifficultyIndex);
@@ -3579,9 +3607,7 @@ void Game::handleInput() {
                     }
                 }
                 else if (e.key.key == SDLK_DOWN) {
-                    int fp = -1;
-                    for (int f = 0; f < (int)filteredSongIndices.size(); f++)
-                        if (filteredSongIndices[f] == selectedSongIndex) { fp = f; break; }
+                    int fp = selectedFilteredIndex();
                     if (fp >= 0) {
                         const auto& fDiffs = filteredDiffIndices[fp];
                         int diffPos = -1;
@@ -3595,7 +3621,7 @@ void Game::handleInput() {
                             songSelectNeedAutoScroll = true;
                         } else if (fp < (int)filteredSongIndices.size() - 1) {
                             // Move to next song's first filtered difficulty
-                            selectedSongIndex = filteredSongIndices[fp + 1];
+                            selectFilteredSong(fp + 1);
                             const auto& nextDiffs = filteredDiffIndices[fp + 1];
                             selectedDifficultyIndex = nextDiffs.empty() ? 0 : nextDiffs[0];
                             loadSongBackground(selectedSongIndex, selectedDifficultyIndex);
@@ -3606,11 +3632,9 @@ void Game::handleInput() {
                 }
                 else if (e.key.key == SDLK_LEFT) {
                     // Move to previous song's first filtered difficulty
-                    int fp = -1;
-                    for (int f = 0; f < (int)filteredSongIndices.size(); f++)
-                        if (filteredSongIndices[f] == selectedSongIndex) { fp = f; break; }
+                    int fp = selectedFilteredIndex();
                     if (fp > 0) {
-                        selectedSongIndex = filteredSongIndices[fp - 1];
+                        selectFilteredSong(fp - 1);
                         const auto& prevDiffs = filteredDiffIndices[fp - 1];
                         selectedDifficultyIndex = prevDiffs.empty() ? 0 : prevDiffs[0];
                         loadSongBackground(selectedSongIndex, selectedDifficultyIndex);
@@ -3620,11 +3644,9 @@ void Game::handleInput() {
                 }
                 else if (e.key.key == SDLK_RIGHT) {
                     // Move to next song's first filtered difficulty
-                    int fp = -1;
-                    for (int f = 0; f < (int)filteredSongIndices.size(); f++)
-                        if (filteredSongIndices[f] == selectedSongIndex) { fp = f; break; }
+                    int fp = selectedFilteredIndex();
                     if (fp >= 0 && fp < (int)filteredSongIndices.size() - 1) {
-                        selectedSongIndex = filteredSongIndices[fp + 1];
+                        selectFilteredSong(fp + 1);
                         const auto& nextDiffs = filteredDiffIndices[fp + 1];
                         selectedDifficultyIndex = nextDiffs.empty() ? 0 : nextDiffs[0];
                         loadSongBackground(selectedSongIndex, selectedDifficultyIndex);
@@ -3648,8 +3670,15 @@ void Game::handleInput() {
                     }
                 }
                 else if (e.key.key == SDLK_F5) {
-                    // Force rebuild index (like Clear Index)
-                    startScanAsync(true, GameState::SongSelect);
+                    // Refresh: reparse only changed charts (Clear Index forces a full rebuild)
+                    startScanAsync(false, GameState::SongSelect, true);
+                }
+                else if (e.key.key == SDLK_F3) {
+                    // Cycle sort order; the selection stays on the same song
+                    settings.songSortMode = (settings.songSortMode + 1) % (int)SongSortMode::Count;
+                    saveConfig();
+                    updateSongFilter();
+                    songSelectNeedAutoScroll = true;
                 }
             }
             else if (state == GameState::Settings) {
@@ -3974,19 +4003,11 @@ void Game::handleInput() {
                         if (!replayMode && !autoPlay && !pauseFadingOut) {
                             for (int i = 0; i < beatmap.keyCount; i++) {
                                 if (e.key.key == settings.keys[beatmap.keyCount - 1][i]) {
-                                    SDL_Log("KEY_INPUT: lane=%d key=%d time=%lld", i, (int)e.key.key, (long long)getCurrentGameTime());
-                                    laneKeyDown[i] = true;
-                                    checkJudgement(i);
-                                    // Record frame
-                                    int64_t currentTime = getCurrentGameTime();
-                                    int keyState = 0;
-                                    for (int k = 0; k < beatmap.keyCount; k++) {
-                                        if (laneKeyDown[k]) keyState |= (1 << k);
-                                    }
-                                    if (keyState != lastRecordedKeyState) {
-                                        recordedFrames.push_back({currentTime, keyState});
-                                        lastRecordedKeyState = keyState;
-                                    }
+                                    // Judge at the time the key was pressed, not when the event was drained
+                                    // (applied in time order by the simulation in update())
+                                    int64_t currentTime = getEventGameTime(e.key.timestamp);
+                                    SDL_Log("KEY_INPUT: lane=%d key=%d time=%lld", i, (int)e.key.key, (long long)currentTime);
+                                    pendingInput.push_back({i, true, currentTime});
                                     break;
                                 }
                             }
@@ -4025,18 +4046,7 @@ void Game::handleInput() {
             if (!replayMode && !autoPlay) {
                 for (int i = 0; i < beatmap.keyCount; i++) {
                     if (e.key.key == settings.keys[beatmap.keyCount - 1][i]) {
-                        laneKeyDown[i] = false;
-                        onKeyRelease(i);
-                        // Record frame
-                        int64_t currentTime = getCurrentGameTime();
-                        int keyState = 0;
-                        for (int k = 0; k < beatmap.keyCount; k++) {
-                            if (laneKeyDown[k]) keyState |= (1 << k);
-                        }
-                        if (keyState != lastRecordedKeyState) {
-                            recordedFrames.push_back({currentTime, keyState});
-                            lastRecordedKeyState = keyState;
-                        }
+                        pendingInput.push_back({i, false, getEventGameTime(e.key.timestamp)});
                         break;
                     }
                 }
@@ -4045,7 +4055,8 @@ void Game::handleInput() {
     }
 }
 
-void Game::update() {
+void Game::update(double deltaMs) {
+    lastUpdateTicksNS = SDL_GetTicksNS();
     int64_t elapsed = SDL_GetTicks() - startTime;
 
     // Don't start music during pause fade out
@@ -4090,6 +4101,18 @@ void Game::update() {
         }
     }
     keySoundManager.setTimingPointVolume(tpVolume);
+    keySoundManager.updateStreaming(currentTime);
+
+    // Audio clock jitter/drift, one report per second while debug logging is on
+    AudioClock::Report clockReport;
+    if (settings.debugEnabled && audio.takeClockReport(clockReport)) {
+        char clockDetails[160];
+        snprintf(clockDetails, sizeof(clockDetails),
+                 "samples=%d snaps=%d maxDrift=%.3fms maxJitter=%.3fms meanJitter=%.3fms drift=%.3fms",
+                 clockReport.samples, clockReport.snaps, clockReport.maxDriftMs, clockReport.maxJitterMs,
+                 clockReport.meanJitterMs, clockReport.driftMs);
+        addDebugLog(currentTime, "AUDIO_CLOCK", -1, clockDetails);
+    }
 
     // Play storyboard samples (limit per frame to prevent burst at end)
     // osu! mania: storyboard samples are keysounds that only play on note hit (stable behavior)
@@ -4112,89 +4135,333 @@ void Game::update() {
         }
     }
 
-    // Update HP smoothing (deltaTime in seconds, assuming ~60fps = ~16.67ms per frame)
-    double deltaTime = 16.67 / 1000.0;  // Approximate frame time
-    hpManager.update(deltaTime);
+    // Update HP smoothing with the real frame time
+    hpManager.update(deltaMs / 1000.0);
 
-    // Death mod: check if HP reached 0 (use targetHP, not smoothed currentHP)
-    // Replay mode ignores Death mod
-    if (settings.deathEnabled && !replayMode && hpManager.getTargetHP() <= 0.0 && !autoPlay) {
+    // Advance the gameplay simulation in fixed steps up to the current clock time.
+    // Queued key events are applied at their own timestamps between steps, so judgement,
+    // misses, ticks and combo order do not depend on the frame rate.
+    if (simTime == INT64_MIN || currentTime < simTime || currentTime - simTime > MAX_SIM_CATCHUP_MS) {
+        simTime = currentTime - SIM_STEP_MS;  // Start, seek or stall: resync with a single step
+    }
+    // Key events are stamped on the judgement clock (audio offset applied)
+    int64_t judgeOffset = (musicStarted && hasBackgroundMusic && !pauseFadingOut) ? settings.audioOffset : 0;
+    while (!stateChangeRequested && simTime < currentTime) {
+        simTime = std::min(simTime + SIM_STEP_MS, currentTime);
+        applyPendingInput(simTime + judgeOffset);
+        simulate(simTime);
+    }
+    applyPendingInput(INT64_MAX);
+    if (stateChangeRequested) return;
+
+    // End game when music stops (only for maps with background music)
+    // Don't trigger during pause fade out (audio is paused but not finished)
+    if (hasBackgroundMusic && musicStarted && !audio.isPlaying() && !pauseFadingOut) {
+        requestStateChange(GameState::Result);
+    }
+
+    // Check if all notes are finished
+    if (musicStarted && !showEndPrompt && allNotesFinishedTime == 0) {
+        if (activeNotes.allResolved(beatmap.notes)) {
+            allNotesFinishedTime = SDL_GetTicks();
+        }
+    }
+
+    // Show prompt after 2 seconds if music still playing
+    if (allNotesFinishedTime > 0 && !showEndPrompt) {
+        if (SDL_GetTicks() - allNotesFinishedTime >= 2000) {
+            showEndPrompt = true;
+        }
+    }
+
+    if (settings.lowSpecMode && hitErrors.size() > 20) {
+        hitErrors.erase(hitErrors.begin(), hitErrors.begin() + (hitErrors.size() - 20));
+    } else if (hitErrors.size() > 500) {
+        // Limit hitErrors size to prevent performance degradation
+        hitErrors.erase(hitErrors.begin(), hitErrors.begin() + (hitErrors.size() - 500));
+    }
+}
+
+void Game::applyPendingInput(int64_t upToTime) {
+    size_t applied = 0;
+    while (applied < pendingInput.size() && pendingInput[applied].time <= upToTime) {
+        const PendingInput& input = pendingInput[applied++];
+        laneKeyDown[input.lane] = input.pressed;
+        if (input.pressed) {
+            checkJudgement(input.lane, input.time);
+        } else {
+            onKeyRelease(input.lane, input.time);
+        }
+        // Record frame
+        int keyState = 0;
+        for (int k = 0; k < beatmap.keyCount; k++) {
+            if (laneKeyDown[k]) keyState |= (1 << k);
+        }
+        if (keyState != lastRecordedKeyState) {
+            recordedFrames.push_back({input.time, keyState});
+            lastRecordedKeyState = keyState;
+        }
+    }
+    pendingInput.erase(pendingInput.begin(), pendingInput.begin() + applied);
+}
+
+void Game::requestStateChange(GameState next) {
+    if (stateChangeRequested) return;
+    stateChangeRequested = true;
+    requestedState = next;
+    requestedStateTime = SDL_GetTicks();
+}
+
+void Game::applyRequestedState() {
+    if (!stateChangeRequested) return;
+    stateChangeRequested = false;
+    if (state != GameState::Playing) return;  // Paused or left before the request was seen
+
+    if (requestedState == GameState::Dead) {
         state = GameState::Dead;
-        deathTime = SDL_GetTicks();
+        deathTime = requestedStateTime;
         deathSlowdown = 1.0f;
         deathMenuSelection = 1;  // Default to Retry
         audio.pause();
+    } else if (requestedState == GameState::Result) {
+        cleanupTempDir();
+        if (int late = keySoundManager.getLateSampleCount()) {
+            std::cerr << "[KEYSOUND] " << late << " streamed keysounds were not loaded in time" << std::endl;
+        }
+        state = GameState::Result;
+    }
+}
+
+void Game::resolveNote(int lane, int noteIdx) {
+    laneNoteIndex.onNoteResolved(lane, noteIdx);
+    resolvedSincePublish.push_back(noteIdx);
+}
+
+void Game::emitHitSound(const HitSoundInfo& info, int64_t time) {
+    simEvents.push_back({SimEvent::Type::HitSound, -1, time, info});
+}
+
+void Game::emitHitObjectHit(int64_t time) {
+    simEvents.push_back({SimEvent::Type::HitObjectHit, -1, time, {}});
+}
+
+void Game::emitLighting(int lane, int64_t time) {
+    simEvents.push_back({SimEvent::Type::Lighting, lane, time, {}});
+}
+
+void Game::emitBgaMiss(int64_t time) {
+    simEvents.push_back({SimEvent::Type::BgaMiss, -1, time, {}});
+}
+
+void Game::gameplayThreadMain() {
+    const Uint64 tickNS = 500000;  // 0.5ms: well under the 1ms simulation step
+    Uint64 perfFreq = SDL_GetPerformanceFrequency();
+    Uint64 lastPerf = SDL_GetPerformanceCounter();
+    while (gameplayThreadRunning) {
+        if (gameplayActive) {
+            std::lock_guard<std::mutex> lock(gameplayMutex);
+            Uint64 nowPerf = SDL_GetPerformanceCounter();
+            double deltaMs = std::min((double)(nowPerf - lastPerf) * 1000.0 / perfFreq, 100.0);
+            lastPerf = nowPerf;
+            if (state == GameState::Playing && !stateChangeRequested) {
+                update(deltaMs);
+                publishSnapshot();
+            }
+        } else {
+            lastPerf = SDL_GetPerformanceCounter();
+        }
+        SDL_DelayNS(tickNS);
+    }
+}
+
+void Game::publishSnapshot() {
+    GameplaySnapshot& snap = snapshots.write();
+    int back = snapshots.writeSlot();
+    size_t noteCount = beatmap.notes.size();
+
+    // Notes changed since the last publish: resolved notes, live holds, and holds that
+    // stopped being live. The other buffers queue them to catch up when next written.
+    std::vector<int>& dirty = resolvedSincePublish;
+    const std::vector<int>& live = activeNotes.getLiveNotes();
+    dirty.insert(dirty.end(), livePublished.begin(), livePublished.end());
+    dirty.insert(dirty.end(), live.begin(), live.end());
+    livePublished = live;
+
+    for (int b = 0; b < 3; b++) {
+        if (b == back || snapshotFullResync[b]) continue;
+        if (snapshotStale[b].size() + dirty.size() > noteCount) {
+            snapshotStale[b].clear();
+            snapshotFullResync[b] = true;
+        } else {
+            snapshotStale[b].insert(snapshotStale[b].end(), dirty.begin(), dirty.end());
+        }
+    }
+    snap.notes.resize(noteCount);
+    if (snapshotFullResync[back]) {
+        for (size_t i = 0; i < noteCount; i++) snap.notes[i].capture(beatmap.notes[i]);
+        snapshotFullResync[back] = false;
+    } else {
+        for (int idx : snapshotStale[back]) snap.notes[idx].capture(beatmap.notes[idx]);
+        for (int idx : dirty) snap.notes[idx].capture(beatmap.notes[idx]);
+    }
+    snapshotStale[back].clear();
+    dirty.clear();
+
+    std::copy(laneKeyDown, laneKeyDown + 18, snap.laneKeyDown);
+    snap.combo = combo;
+    snap.maxCombo = maxCombo;
+    snap.score = score;
+    std::copy(judgementCounts, judgementCounts + 6, snap.judgementCounts);
+    snap.accuracy = calculateAccuracy();
+    snap.pp = ppCalculator.getCurrentPP();
+    snap.hpPercent = hpManager.getHPPercent();
+    snap.lastJudgementTime = lastJudgementTime;
+    snap.lastJudgementIndex = lastJudgementIndex;
+    snap.lastComboChangeTime = lastComboChangeTime;
+    snap.comboBreak = comboBreak;
+    snap.comboBreakTime = comboBreakTime;
+    snap.lastComboValue = lastComboValue;
+    snap.canSkip = canSkip;
+    snap.showEndPrompt = showEndPrompt;
+    snap.hitErrors = hitErrors;
+
+    // A buffer that was published but never taken still holds undelivered events
+    if (!snapshotCarryEvents) snap.events.clear();
+    snap.events.insert(snap.events.end(), simEvents.begin(), simEvents.end());
+    simEvents.clear();
+    snapshotCarryEvents = snapshots.publish();
+}
+
+void Game::consumeSnapshot() {
+    if (!snapshots.update()) return;
+    const GameplaySnapshot& snap = snapshots.read();
+    size_t count = std::min(snap.notes.size(), displayNotes.size());
+    for (size_t i = 0; i < count; i++) snap.notes[i].apply(displayNotes[i]);
+
+    for (const SimEvent& e : snap.events) {
+        switch (e.type) {
+            case SimEvent::Type::HitSound:
+                storyboard.onHitSound(e.hitSound, e.time);
+                break;
+            case SimEvent::Type::HitObjectHit:
+                storyboard.onHitObjectHit(e.time);
+                break;
+            case SimEvent::Type::Lighting:
+                renderer.triggerLightingN(e.lane, e.time);
+                break;
+            case SimEvent::Type::BgaMiss:
+                bmsBgaManager.triggerMissLayer(e.time);
+                break;
+        }
+    }
+}
+
+void Game::resetSnapshot() {
+    displayNotes = beatmap.notes;
+    for (int b = 0; b < 3; b++) {
+        GameplaySnapshot& snap = snapshots.slot(b);
+        snap.notes.resize(beatmap.notes.size());
+        for (size_t i = 0; i < beatmap.notes.size(); i++) snap.notes[i].capture(beatmap.notes[i]);
+        snap.events.clear();
+        snapshotStale[b].clear();
+        snapshotFullResync[b] = false;
+    }
+    snapshots.reset();
+    snapshotCarryEvents = false;
+    resolvedSincePublish.clear();
+    livePublished.clear();
+    simEvents.clear();
+    // Make the reset state visible to the next render
+    publishSnapshot();
+    snapshots.update();
+}
+
+void Game::simulate(int64_t currentTime) {
+    // Death mod: check if HP reached 0 (use targetHP, not smoothed currentHP)
+    // Replay mode ignores Death mod
+    if (settings.deathEnabled && !replayMode && hpManager.getTargetHP() <= 0.0 && !autoPlay) {
+        requestStateChange(GameState::Dead);
         return;
     }
 
     if (autoPlay) {
         bool keyStateChanged = false;
-        for (auto& note : beatmap.notes) {
-            if (note.state == NoteState::Waiting && note.time <= currentTime) {
-                // Play key sound for note head
-                keySoundManager.playKeySound(note, false);
+        auto finishAutoPlayHold = [&](Note& note) {
+            // Process remaining ticks before ending hold note
+            while (note.nextTickTime + 100 <= note.endTime) {
+                note.nextTickTime += 100;
+                combo++;
+                if (combo > maxCombo) maxCombo = combo;
+                addDebugLog(currentTime, "AUTOPLAY_TICK", note.lane,
+                    "combo=" + std::to_string(combo) + " maxCombo=" + std::to_string(maxCombo));
+            }
+            // Play tail key sound
+            keySoundManager.playKeySound(note, true);
 
-                // Notify storyboard of hitsound and hit event
-                storyboard.onHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
-                storyboard.onHitObjectHit(currentTime);
+            // Notify storyboard of tail hitsound
+            emitHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, true), currentTime);
 
-                if (note.isHold) {
-                    // Hold note: start holding, set up ticks, no judgement yet
-                    note.state = NoteState::Holding;
-                    note.headHit = true;  // Mark head as hit so it stops at judge line
-                    note.headHitEarly = false;  // AutoPlay hits exactly on time
-                    note.headHitError = 0;
-                    note.nextTickTime = note.time;
-                    laneKeyDown[note.lane] = true;
-                    keyStateChanged = true;
-                } else {
-                    // Regular note: immediate judgement
-                    note.state = NoteState::Hit;
-                    renderer.triggerLightingN(note.lane, currentTime);
-                    processJudgement(judgementSystem.adjustForEnabled(Judgement::Marvelous), note.lane);
-                    hitErrors.push_back({(int64_t)SDL_GetTicks(), 0});  // AutoPlay has 0 offset
-                    // Record key press and release for regular note
-                    int keyState = 0;
-                    for (int k = 0; k < beatmap.keyCount; k++) {
-                        if (laneKeyDown[k]) keyState |= (1 << k);
-                    }
-                    keyState |= (1 << note.lane);  // Press
-                    if (keyState != lastRecordedKeyState) {
-                        recordedFrames.push_back({currentTime, keyState});
-                        lastRecordedKeyState = keyState;
-                    }
-                    keyState &= ~(1 << note.lane);  // Release
-                    if (keyState != lastRecordedKeyState) {
-                        recordedFrames.push_back({currentTime + 1, keyState});
-                        lastRecordedKeyState = keyState;
-                    }
-                }
-                // Update next note index for this lane
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, note.lane,
-                    static_cast<int>(&note - &beatmap.notes[0]));
-            }
+            // Hold note end: give judgement with combo and score
+            note.state = NoteState::Hit;
+            emitLighting(note.lane, currentTime);
+            processJudgement(judgementSystem.adjustForEnabled(Judgement::Marvelous), note.lane);
+            hitErrors.push_back({(int64_t)SDL_GetTicks(), 0});  // AutoPlay has 0 offset
+            laneKeyDown[note.lane] = false;
+            keyStateChanged = true;
+        };
+        // Holds started in earlier frames come first in time order
+        for (int noteIdx : activeNotes.getLiveNotes()) {
+            Note& note = beatmap.notes[noteIdx];
             if (note.state == NoteState::Holding && note.isHold && note.endTime <= currentTime) {
-                // Process remaining ticks before ending hold note
-                while (note.nextTickTime + 100 <= note.endTime) {
-                    note.nextTickTime += 100;
-                    combo++;
-                    if (combo > maxCombo) maxCombo = combo;
-                    addDebugLog(currentTime, "AUTOPLAY_TICK", note.lane,
-                        "combo=" + std::to_string(combo) + " maxCombo=" + std::to_string(maxCombo));
-                }
-                // Play tail key sound
-                keySoundManager.playKeySound(note, true);
+                finishAutoPlayHold(note);
+            }
+        }
+        int noteIdx;
+        while ((noteIdx = activeNotes.nextAutoPlayNote(beatmap.notes, currentTime)) >= 0) {
+            Note& note = beatmap.notes[noteIdx];
+            // Play key sound for note head
+            keySoundManager.playKeySound(note, false);
 
-                // Notify storyboard of tail hitsound
-                storyboard.onHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, true), currentTime);
+            // Notify storyboard of hitsound and hit event
+            emitHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
+            emitHitObjectHit(currentTime);
 
-                // Hold note end: give judgement with combo and score
+            if (note.isHold) {
+                // Hold note: start holding, set up ticks, no judgement yet
+                note.state = NoteState::Holding;
+                note.headHit = true;  // Mark head as hit so it stops at judge line
+                note.headHitEarly = false;  // AutoPlay hits exactly on time
+                note.headHitError = 0;
+                note.nextTickTime = note.time;
+                activeNotes.addLive(noteIdx);
+                laneKeyDown[note.lane] = true;
+                keyStateChanged = true;
+            } else {
+                // Regular note: immediate judgement
                 note.state = NoteState::Hit;
-                renderer.triggerLightingN(note.lane, currentTime);
+                emitLighting(note.lane, currentTime);
                 processJudgement(judgementSystem.adjustForEnabled(Judgement::Marvelous), note.lane);
                 hitErrors.push_back({(int64_t)SDL_GetTicks(), 0});  // AutoPlay has 0 offset
-                laneKeyDown[note.lane] = false;
-                keyStateChanged = true;
+                // Record key press and release for regular note
+                int keyState = 0;
+                for (int k = 0; k < beatmap.keyCount; k++) {
+                    if (laneKeyDown[k]) keyState |= (1 << k);
+                }
+                keyState |= (1 << note.lane);  // Press
+                if (keyState != lastRecordedKeyState) {
+                    recordedFrames.push_back({currentTime, keyState});
+                    lastRecordedKeyState = keyState;
+                }
+                keyState &= ~(1 << note.lane);  // Release
+                if (keyState != lastRecordedKeyState) {
+                    recordedFrames.push_back({currentTime + 1, keyState});
+                    lastRecordedKeyState = keyState;
+                }
+            }
+            // Update next note index for this lane
+            resolveNote(note.lane, noteIdx);
+            if (note.state == NoteState::Holding && note.isHold && note.endTime <= currentTime) {
+                finishAutoPlayHold(note);
             }
         }
         // Record key state change for hold notes
@@ -4273,33 +4540,10 @@ void Game::update() {
         return noteTime < currentTime - judgementSystem.getBadWindow();
     };
 
-    for (auto& note : beatmap.notes) {
-        if (note.isFakeNote) continue;  // Skip fake notes - visual only
-        if (note.state == NoteState::Waiting && hasTimedOut(note.time)) {
-            if (note.isHold) {
-                // Hold note head missed
-                note.state = NoteState::Holding;
-                note.headHitError = judgementSystem.getBadWindow();
-                // If user is already holding the key, don't gray out, don't allow ticks
-                // User must release and re-press to get combo
-                if (laneKeyDown[note.lane]) {
-                    // User was holding before note arrived - no gray, no combo
-                    note.hadComboBreak = false;
-                    note.nextTickTime = INT64_MAX;  // Disable ticks
-                } else {
-                    // Normal head miss - start gray transition
-                    note.hadComboBreak = true;
-                    note.nextTickTime = currentTime;  // Allow ticks when user presses back
-                    note.headGrayStartTime = currentTime;  // Gray out immediately
-                }
-                combo = 0;  // Break combo when head is missed
-            } else {
-                note.state = NoteState::Missed;
-                processJudgement(Judgement::Miss, note.lane);
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, note.lane,
-                    static_cast<int>(&note - &beatmap.notes[0]));
-            }
-        }
+    // Live hold processing: ticks and tail timeout
+    auto updateLiveHold = [&](int noteIdx) {
+        Note& note = beatmap.notes[noteIdx];
+        if (note.isFakeNote) return;  // Skip fake notes - visual only
         if (note.state == NoteState::Holding && note.isHold) {
             // Process hold note ticks (every 100ms)
             // ScoreV1: ticks only affect combo, not score
@@ -4317,8 +4561,7 @@ void Game::update() {
                 note.state = NoteState::Missed;
                 // Record miss when tail times out (whole hold note counts as 1 miss)
                 processJudgement(Judgement::Miss, note.lane);
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, note.lane,
-                    static_cast<int>(&note - &beatmap.notes[0]));
+                resolveNote(note.lane, noteIdx);
             }
         }
         // Released hold notes - no ticks, but check for timeout
@@ -4326,48 +4569,52 @@ void Game::update() {
             if (hasTimedOut(note.endTime)) {
                 note.state = NoteState::Missed;
                 processJudgement(Judgement::Miss, note.lane);
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, note.lane,
-                    static_cast<int>(&note - &beatmap.notes[0]));
+                resolveNote(note.lane, noteIdx);
             }
         }
-    }
-
-    // End game when music stops (only for maps with background music)
-    // Don't trigger during pause fade out (audio is paused but not finished)
-    if (hasBackgroundMusic && musicStarted && !audio.isPlaying() && !pauseFadingOut) {
-        cleanupTempDir();
-        state = GameState::Result;
-    }
+    };
 
-    // Check if all notes are finished
-    if (musicStarted && !showEndPrompt && allNotesFinishedTime == 0) {
-        bool allFinished = true;
-        for (const auto& note : beatmap.notes) {
-            if (note.state == NoteState::Waiting ||
-                note.state == NoteState::Holding ||
-                note.state == NoteState::Released) {
-                allFinished = false;
-                break;
-            }
-        }
-        if (allFinished) {
-            allNotesFinishedTime = SDL_GetTicks();
+    // Walk live holds and timed-out Waiting notes together in time order,
+    // stopping at the first Waiting note still inside the judgement window
+    std::vector<int> liveNotes = activeNotes.getLiveNotes();
+    size_t liveIdx = 0;
+    while (true) {
+        int waitingIdx = activeNotes.peekWaiting(beatmap.notes);
+        bool waitingDue = waitingIdx >= 0 && hasTimedOut(beatmap.notes[waitingIdx].time);
+        if (liveIdx < liveNotes.size() &&
+            (!waitingDue || activeNotes.getPosition(liveNotes[liveIdx]) < activeNotes.getPosition(waitingIdx))) {
+            updateLiveHold(liveNotes[liveIdx++]);
+            continue;
         }
-    }
-
-    // Show prompt after 2 seconds if music still playing
-    if (allNotesFinishedTime > 0 && !showEndPrompt) {
-        if (SDL_GetTicks() - allNotesFinishedTime >= 2000) {
-            showEndPrompt = true;
+        if (!waitingDue) break;
+
+        Note& note = beatmap.notes[waitingIdx];
+        if (note.isHold) {
+            // Hold note head missed
+            note.state = NoteState::Holding;
+            note.headHitError = judgementSystem.getBadWindow();
+            // If user is already holding the key, don't gray out, don't allow ticks
+            // User must release and re-press to get combo
+            if (laneKeyDown[note.lane]) {
+                // User was holding before note arrived - no gray, no combo
+                note.hadComboBreak = false;
+                note.nextTickTime = INT64_MAX;  // Disable ticks
+            } else {
+                // Normal head miss - start gray transition
+                note.hadComboBreak = true;
+                note.nextTickTime = currentTime;  // Allow ticks when user presses back
+                note.headGrayStartTime = currentTime;  // Gray out immediately
+            }
+            combo = 0;  // Break combo when head is missed
+            activeNotes.addLive(waitingIdx);
+            updateLiveHold(waitingIdx);
+        } else {
+            note.state = NoteState::Missed;
+            processJudgement(Judgement::Miss, note.lane);
+            resolveNote(note.lane, waitingIdx);
         }
     }
-
-    if (settings.lowSpecMode && hitErrors.size() > 20) {
-        hitErrors.erase(hitErrors.begin(), hitErrors.begin() + (hitErrors.size() - 20));
-    } else if (hitErrors.size() > 500) {
-        // Limit hitErrors size to prevent performance degradation
-        hitErrors.erase(hitErrors.begin(), hitErrors.begin() + (hitErrors.size() - 500));
-    }
+    activeNotes.pruneLive(beatmap.notes);
 }
 
 void Game::updateReplay() {
@@ -4555,30 +4802,30 @@ void Game::render() {
         SDL_FRect panel = {(float)panelX, (float)startY, (float)panelW, 720.0f - startY};
         SDL_RenderFillRect(renderer.getRenderer(), &panel);
 
-        float currentY = (float)startY;
+        // Row layout is closed-form: every song row has the same height and only the selected
+        // song expands, so only the rows on screen are visited each frame
+        int filteredCount = (int)filteredSongIndices.size();
+        int selFi = selectedFilteredIndex();
+        float expandedHeight = selFi >= 0 ? (float)filteredDiffIndices[selFi].size() * diffRowHeight : 0.0f;
+        auto rowTop = [&](int fi) {
+            return (float)startY + (float)fi * rowHeight + (selFi >= 0 && fi > selFi ? expandedHeight : 0.0f);
+        };
 
-        // First pass: calculate total height and find selected item's Y position
+        // Y position of the selected item
         float selectedItemY = 0;
-        for (int fi = 0; fi < (int)filteredSongIndices.size(); fi++) {
-            int i = filteredSongIndices[fi];
-            if (i == selectedSongIndex) {
-                // Find position of selectedDifficultyIndex within filtered diffs
-                const auto& fDiffs = filteredDiffIndices[fi];
-                int diffPos = 0;
-                for (int fd = 0; fd < (int)fDiffs.size(); fd++) {
-                    if (fDiffs[fd] == selectedDifficultyIndex) { diffPos = fd; break; }
-                }
-                selectedItemY = currentY + diffPos * diffRowHeight;
-                if (diffPos > 0) {
-                    selectedItemY += rowHeight;  // Account for song row
-                }
+        if (selFi >= 0) {
+            // Find position of selectedDifficultyIndex within filtered diffs
+            const auto& fDiffs = filteredDiffIndices[selFi];
+            int diffPos = 0;
+            for (int fd = 0; fd < (int)fDiffs.size(); fd++) {
+                if (fDiffs[fd] == selectedDifficultyIndex) { diffPos = fd; break; }
             }
-            currentY += rowHeight;
-            if (i == selectedSongIndex) {
-                currentY += (int)filteredDiffIndices[fi].size() * diffRowHeight;
+            selectedItemY = rowTop(selFi) + diffPos * diffRowHeight;
+            if (diffPos > 0) {
+                selectedItemY += rowHeight;  // Account for song row
             }
         }
-        float totalHeight = currentY;
+        float totalHeight = rowTop(filteredCount);
 
         // Auto scroll to keep selection visible (only when selection changed via keyboard)
         if (songSelectNeedAutoScroll) {
@@ -4596,13 +4843,21 @@ void Game::render() {
         if (maxScroll < 0) maxScroll = 0;
         if (songSelectScroll > maxScroll) songSelectScroll = maxScroll;
 
-        // Second pass: render (clip to below header bar)
+        // First row that can be on screen (the selected song is kept while its difficulties are)
+        int firstRow = (int)((songSelectScroll - startY) / rowHeight) - 1;
+        if (selFi >= 0 && firstRow > selFi) {
+            firstRow = std::max(selFi, (int)((songSelectScroll - startY - expandedHeight) / rowHeight) - 1);
+        }
+        firstRow = std::max(firstRow, 0);
+
+        // Render visible rows (clip to below header bar)
         SDL_Rect clipRect = {panelX, startY, panelW, 720 - startY};
         SDL_SetRenderClipRect(renderer.getRenderer(), &clipRect);
-        currentY = (float)startY;
-        for (int fi = 0; fi < (int)filteredSongIndices.size(); fi++) {
+        for (int fi = firstRow; fi < filteredCount; fi++) {
             int i = filteredSongIndices[fi];
+            float currentY = rowTop(fi);
             float y = currentY - songSelectScroll;
+            if (y > 720) break;
 
             const SongEntry& song = songList[i];
             bool isSelected = (i == selectedSongIndex);
@@ -4627,7 +4882,7 @@ void Game::render() {
                             stopPreviewMusic();
                             startAsyncLoad(path);
                         } else {
-                            selectedSongIndex = i;
+                            selectFilteredSong(fi);
                             selectedDifficultyIndex = firstDiff;
                             loadSongBackground(i, firstDiff);
                             playPreviewMusic(i, firstDiff);
@@ -4797,7 +5052,12 @@ void Game::render() {
             }
 
             float pad = 10.0f;
-            float maxW = searchW - pad * 2;
+            // Current sort order, right-aligned
+            std::string sortLabel = std::string("Sort: ") + songSortModeName((SongSortMode)settings.songSortMode) + " (F3)";
+            int sortW = renderer.getTextWidth(sortLabel.c_str());
+            renderer.renderText(sortLabel.c_str(), searchX + searchW - pad - sortW, searchY + 4);
+
+            float maxW = searchW - pad * 3 - sortW;
             int textW = renderer.getTextWidth(searchDisplay.c_str());
             if (textW <= (int)maxW) {
                 // Single line
@@ -4836,10 +5096,8 @@ void Game::render() {
         // Back button
         if (renderer.renderButton("Back", 20, 720 - 35 - 20, 80, 35, mouseX, mouseY, mouseClicked)) {
             stopPreviewMusic();
-            if (currentBgTexture) {
-                SDL_DestroyTexture(currentBgTexture);
-                currentBgTexture = nullptr;
-            }
+            currentBgTexture = nullptr;
+            currentBgPath.clear();
             state = GameState::Menu;
         }
     }
@@ -5738,7 +5996,30 @@ void Game::render() {
             char statusStr[64];
             snprintf(statusStr, sizeof(statusStr), "Active: %s", modeNames[(int)audio.getOutputMode()]);
             renderer.renderLabel(statusStr, contentX, row5Y);
-            settingsContentHeight = 300;
+
+            // Decoded keysounds are always reused within a session; this keeps them for the next one
+            float row6Y = row5Y + 35;
+            if (renderer.renderCheckbox("Cache Decoded Keysounds on Disk", settings.keysoundDiskCache,
+                                         contentX, row6Y, mouseX, mouseY, mouseClicked)) {
+                settings.keysoundDiskCache = !settings.keysoundDiskCache;
+                keySoundManager.setDiskCacheEnabled(settings.keysoundDiskCache);
+            }
+
+            // Large BMS/IIDX charts: decode only the opening before play, the rest while playing
+            float row7Y = row6Y + 35;
+            if (renderer.renderCheckbox("Stream Keysounds During Play", settings.keysoundStreaming,
+                                         contentX, row7Y, mouseX, mouseY, mouseClicked)) {
+                settings.keysoundStreaming = !settings.keysoundStreaming;
+            }
+
+            // Takes effect from the next chart load
+            float row8Y = row7Y + 35;
+            if (renderer.renderCheckbox("Software Keysound Mixer", settings.softwareMixer,
+                                         contentX, row8Y, mouseX, mouseY, mouseClicked)) {
+                settings.softwareMixer = !settings.softwareMixer;
+                audio.setSoftwareMixer(settings.softwareMixer);
+            }
+            settingsContentHeight = 405;
         }
         else if (settingsCategory == SettingsCategory::Input) {
             // Key count dropdown
@@ -6101,6 +6382,7 @@ void Game::render() {
             if (renderer.renderCheckbox("Enable Debug Logging", settings.debugEnabled,
                                          contentX, debugY + 30, mouseX, mouseY, mouseClicked)) {
                 settings.debugEnabled = !settings.debugEnabled;
+                audio.setClockLogging(settings.debugEnabled);
 #ifdef _WIN32
                 if (settings.debugEnabled) {
                     AllocConsole();
@@ -6162,6 +6444,8 @@ void Game::render() {
         renderer.renderKeyBindingUI(settings.keys[settings.selectedKeyCount - 1], settings.selectedKeyCount, keyBindingIndex);
     }
     else if (state == GameState::Playing || state == GameState::Paused || state == GameState::Dead) {
+        consumeSnapshot();
+        const GameplaySnapshot& snap = snapshots.read();
         int64_t elapsed = SDL_GetTicks() - startTime;
         // If paused/dead, use frozen time to stop the display
         if (state == GameState::Paused) {
@@ -6188,7 +6472,7 @@ void Game::render() {
         }
 
         // Update and render storyboard background
-        bool isPassing = hpManager.getHPPercent() > 0;
+        bool isPassing = snap.hpPercent > 0;
 
         // Notify storyboard of passing state change for triggers
         if (isPassing != lastStoryboardPassing) {
@@ -6260,21 +6544,21 @@ void Game::render() {
             // Replay mode ignores Hidden/FadeIn mods
             bool useHidden = settings.hiddenEnabled && !replayMode;
             bool useFadeIn = settings.fadeInEnabled && !replayMode;
-            renderer.renderLaneHighlights(laneKeyDown, beatmap.keyCount, useHidden, useFadeIn, combo);
+            renderer.renderLaneHighlights(snap.laneKeyDown, beatmap.keyCount, useHidden, useFadeIn, snap.combo);
         }
 
         // Layer 3: mania-stage-light (below notes, stage bottom, keys)
-        renderer.renderHitLighting(laneKeyDown, beatmap.keyCount);
+        renderer.renderHitLighting(snap.laneKeyDown, beatmap.keyCount);
 
         // Check if skin has custom keyImage
         bool hasCustomKeys = skinManager.hasCustomKeyImage(beatmap.keyCount);
 
         // Build laneHoldActive array for LightingL
         bool laneHoldActive[18] = {false};
-        for (const auto& note : beatmap.notes) {
+        for (const auto& note : displayNotes) {
             if (note.state == NoteState::Holding && note.lane < 18) {
                 // Only show LightingL if user is actually holding
-                if (laneKeyDown[note.lane]) {
+                if (snap.laneKeyDown[note.lane]) {
                     laneHoldActive[note.lane] = true;
                 }
             }
@@ -6300,12 +6584,12 @@ void Game::render() {
 
         if (hasCustomKeys) {
             // Custom keyImage: Keys below notes
-            renderer.renderKeys(laneKeyDown, beatmap.keyCount, currentTime);
-            renderer.renderNotes(beatmap.notes, currentTime, settings.scrollSpeed, baseBPM, settings.bpmScaleMode, beatmap.timingPoints, settings.laneColors, useHidden, useFadeIn, combo, settings.ignoreSV, clockRate);
+            renderer.renderKeys(snap.laneKeyDown, beatmap.keyCount, currentTime);
+            renderer.renderNotes(displayNotes, currentTime, settings.scrollSpeed, baseBPM, settings.bpmScaleMode, beatmap.timingPoints, settings.laneColors, useHidden, useFadeIn, snap.combo, settings.ignoreSV, clockRate);
         } else {
             // Default keyImage: Notes below keys
-            renderer.renderNotes(beatmap.notes, currentTime, settings.scrollSpeed, baseBPM, settings.bpmScaleMode, beatmap.timingPoints, settings.laneColors, useHidden, useFadeIn, combo, settings.ignoreSV, clockRate);
-            renderer.renderKeys(laneKeyDown, beatmap.keyCount, currentTime);
+            renderer.renderNotes(displayNotes, currentTime, settings.scrollSpeed, baseBPM, settings.bpmScaleMode, beatmap.timingPoints, settings.laneColors, useHidden, useFadeIn, snap.combo, settings.ignoreSV, clockRate);
+            renderer.renderKeys(snap.laneKeyDown, beatmap.keyCount, currentTime);
         }
 
         // Layer 5: Stage bottom (above notes)
@@ -6326,13 +6610,13 @@ void Game::render() {
         if (!settings.cinemaEnabled) {
 
         // Judgement animation (below Overlay)
-        int64_t judgementElapsed = now - lastJudgementTime;
+        int64_t judgementElapsed = now - snap.lastJudgementTime;
         if (judgementElapsed < 220) {
-            renderer.renderHitJudgement(lastJudgementIndex, judgementElapsed);
+            renderer.renderHitJudgement(snap.lastJudgementIndex, judgementElapsed);
         }
 
         // HP bar (below Overlay)
-        renderer.renderHPBar(hpManager.getHPPercent());
+        renderer.renderHPBar(snap.hpPercent);
 
         } // end !cinemaEnabled
 
@@ -6345,20 +6629,20 @@ void Game::render() {
         renderer.renderSpeedInfo(settings.scrollSpeed, settings.bpmScaleMode, autoPlay, settings.autoPlayEnabled);
         if (replayMode) {
             renderer.renderText("[REPLAY]", 20, 30);
-            renderer.renderScorePanel(replayInfo.playerName.c_str(), score, calculateAccuracy(), maxCombo);
+            renderer.renderScorePanel(replayInfo.playerName.c_str(), snap.score, snap.accuracy, snap.maxCombo);
         } else {
-            renderer.renderScorePanel(settings.username.c_str(), score, calculateAccuracy(), maxCombo);
+            renderer.renderScorePanel(settings.username.c_str(), snap.score, snap.accuracy, snap.maxCombo);
         }
         // Hide hit error bar in O2Jam mode (overlap-based judgement)
         if (settings.judgeMode != JudgementMode::O2Jam) {
-            renderer.renderHitErrorBar(hitErrors, SDL_GetTicks(),
+            renderer.renderHitErrorBar(snap.hitErrors, SDL_GetTicks(),
                 judgementSystem.getMarvelousWindow(), judgementSystem.getPerfectWindow(),
                 judgementSystem.getGreatWindow(), judgementSystem.getGoodWindow(),
                 judgementSystem.getBadWindow(), judgementSystem.getMissWindow(),
                 judgementSystem.getEnabledArray(), settings.hitErrorBarScale);
         }
         renderer.renderFPS(fps);
-        renderer.renderGameInfo(currentTime, totalTime, judgementCounts, calculateAccuracy(), score);
+        renderer.renderGameInfo(currentTime, totalTime, snap.judgementCounts, snap.accuracy, snap.score);
 
         // Performance monitoring (debug mode only)
         if (settings.debugEnabled) {
@@ -6406,14 +6690,14 @@ void Game::render() {
         renderer.renderText(starText, 20, 655);
 
         // PP display (bottom left of play area)
-        std::string ppText = std::to_string(ppCalculator.getCurrentPP()) + " PP";
+        std::string ppText = std::to_string(snap.pp) + " PP";
         renderer.renderText(ppText.c_str(), 20, 680);
 
         // Combo (above Overlay)
-        int64_t comboAnimTime = now - lastComboChangeTime;
-        int64_t breakAnimTime = now - comboBreakTime;
+        int64_t comboAnimTime = now - snap.lastComboChangeTime;
+        int64_t breakAnimTime = now - snap.comboBreakTime;
         int64_t holdColorElapsed = now - holdColorChangeTime;
-        renderer.renderCombo(combo, comboAnimTime, comboBreak, breakAnimTime, lastComboValue, anyHoldActive, holdColorElapsed);
+        renderer.renderCombo(snap.combo, comboAnimTime, snap.comboBreak, breakAnimTime, snap.lastComboValue, anyHoldActive, holdColorElapsed);
 
         } // end !cinemaEnabled
 
@@ -6437,6 +6721,7 @@ void Game::render() {
             } else {
                 // Fade out complete: pause duration already compensated at resume time,
                 // only add fadeout duration here
+                std::lock_guard<std::mutex> lock(gameplayMutex);
                 pauseFadingOut = false;
                 int64_t fadeoutDuration = SDL_GetTicks() - pauseFadeOutStart;
                 startTime += fadeoutDuration;
@@ -6459,11 +6744,11 @@ void Game::render() {
         }
 
         // Skip prompt
-        if (canSkip && state == GameState::Playing) {
+        if (snap.canSkip && state == GameState::Playing) {
             renderer.renderSkipPrompt();
         }
 
-        if (showEndPrompt) {
+        if (snap.showEndPrompt) {
             renderer.renderText("Press Enter to finish", 1280/2 - 100, 400);
         }
     }
@@ -6484,29 +6769,27 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
     // First check for Released hold notes that can be recovered
     // O2Jam mode: hold notes cannot be recovered once released
     if (settings.judgeMode != JudgementMode::O2Jam) {
-        for (auto& note : beatmap.notes) {
-            if (note.isFakeNote) continue;  // Skip fake notes
-            if (note.state == NoteState::Released && note.lane == lane && note.isHold) {
-                // Recover the hold note
-                // osu! DOES reset tick time on recovery (method_12 sets int_10 = currentTime)
-                note.state = NoteState::Holding;
-                note.nextTickTime = currentTime;  // Reset tick timer on recovery
-                // DO NOT reset headReleaseTime - head should keep falling
-                SDL_Log("HOLD_RECOVER: lane=%d headReleaseTime=%lld", lane, (long long)note.headReleaseTime);
-                addDebugLog(currentTime, "HOLD_RECOVER", lane,
-                    "noteTime=" + std::to_string(note.time) + " endTime=" + std::to_string(note.endTime) +
-                    " nextTickTime=" + std::to_string(note.nextTickTime) +
-                    " headReleaseTime=" + std::to_string(note.headReleaseTime));
-                return Judgement::None;
-            }
+        int releasedIdx = laneNoteIndex.findHold(beatmap.notes, lane, NoteState::Released);
+        if (releasedIdx >= 0) {
+            Note& note = beatmap.notes[releasedIdx];
+            // Recover the hold note
+            // osu! DOES reset tick time on recovery (method_12 sets int_10 = currentTime)
+            note.state = NoteState::Holding;
+            note.nextTickTime = currentTime;  // Reset tick timer on recovery
+            // DO NOT reset headReleaseTime - head should keep falling
+            SDL_Log("HOLD_RECOVER: lane=%d headReleaseTime=%lld", lane, (long long)note.headReleaseTime);
+            addDebugLog(currentTime, "HOLD_RECOVER", lane,
+                "noteTime=" + std::to_string(note.time) + " endTime=" + std::to_string(note.endTime) +
+                " nextTickTime=" + std::to_string(note.nextTickTime) +
+                " headReleaseTime=" + std::to_string(note.headReleaseTime));
+            return Judgement::None;
         }
     }
 
     // Then check for new notes
-    for (size_t noteIdx = 0; noteIdx < beatmap.notes.size(); noteIdx++) {
+    int noteIdx = laneNoteIndex.findWaiting(beatmap.notes, lane);
+    if (noteIdx >= 0) {
         Note& note = beatmap.notes[noteIdx];
-        if (note.state != NoteState::Waiting || note.lane != lane) continue;
-        if (note.isFakeNote) continue;  // Skip fake notes - visual only
 
         int64_t diff = std::abs(note.time - currentTime);
 
@@ -6539,8 +6822,8 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
                 keySoundManager.playKeySound(note, false);
 
                 // Notify storyboard of hitsound and hit event
-                storyboard.onHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
-                storyboard.onHitObjectHit(currentTime);
+                emitHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
+                emitHitObjectHit(currentTime);
 
                 if (note.isHold) {
                     note.state = NoteState::Holding;
@@ -6548,18 +6831,19 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
                     note.headHit = true;  // Mark head as hit
                     note.headHitEarly = (currentTime < note.time);  // Early or late hit
                     note.nextTickTime = currentTime;  // Start ticks from hit time
+                    activeNotes.addLive(noteIdx);
                     SDL_Log("HOLD_HIT: lane=%d headHitEarly=%d currentTime=%lld noteTime=%lld",
                         lane, note.headHitEarly ? 1 : 0, (long long)currentTime, (long long)note.time);
                 } else {
                     note.state = NoteState::Hit;
                     SDL_Log("NOTE_HIT: lane=%d noteTime=%lld currentTime=%lld diff=%lld",
                         lane, (long long)note.time, (long long)currentTime, (long long)diff);
-                    renderer.triggerLightingN(lane, currentTime);
+                    emitLighting(lane, currentTime);
                     Judgement j = getJudgement(diff, note.time, currentTime);
                     processJudgement(j, lane);
                 }
                 // Update next note index for this lane
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, lane, static_cast<int>(noteIdx));
+                resolveNote(lane, noteIdx);
                 hitErrors.push_back({(int64_t)SDL_GetTicks(), currentTime - note.time});
                 return note.isHold ? Judgement::None : getJudgement(diff, note.time, currentTime);
             }
@@ -6567,17 +6851,16 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
             if (isMiss) {
                 note.state = NoteState::Missed;
                 processJudgement(Judgement::Miss, lane);
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, lane, static_cast<int>(noteIdx));
+                resolveNote(lane, noteIdx);
                 hitErrors.push_back({(int64_t)SDL_GetTicks(), currentTime - note.time});
                 return Judgement::Miss;
             }
             // Outside miss window - play empty tap keysound and ignore keypress
-            if (lane >= 0 && lane < 18 && laneNextNoteIndex[lane] >= 0 &&
-                laneNextNoteIndex[lane] < static_cast<int>(beatmap.notes.size())) {
-                const Note& nextNote = beatmap.notes[laneNextNoteIndex[lane]];
+            if (laneNoteIndex.getNextNote(lane) >= 0) {
+                const Note& nextNote = beatmap.notes[laneNoteIndex.getNextNote(lane)];
                 keySoundManager.playKeySound(nextNote, false);
                 // Use timing point's sampleSet for empty tap trigger matching
-                storyboard.onHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
+                emitHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
             }
             return Judgement::None;
         } else {
@@ -6587,8 +6870,8 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
                 keySoundManager.playKeySound(note, false);
 
                 // Notify storyboard of hitsound and hit event
-                storyboard.onHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
-                storyboard.onHitObjectHit(currentTime);
+                emitHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, false), currentTime);
+                emitHitObjectHit(currentTime);
 
                 if (note.isHold) {
                     note.state = NoteState::Holding;
@@ -6596,18 +6879,19 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
                     note.headHit = true;  // Mark head as hit
                     note.headHitEarly = (currentTime < note.time);  // Early or late hit
                     note.nextTickTime = currentTime;  // Start ticks from hit time
+                    activeNotes.addLive(noteIdx);
                     SDL_Log("HOLD_HIT: lane=%d headHitEarly=%d currentTime=%lld noteTime=%lld",
                         lane, note.headHitEarly ? 1 : 0, (long long)currentTime, (long long)note.time);
                 } else {
                     note.state = NoteState::Hit;
                     SDL_Log("NOTE_HIT: lane=%d noteTime=%lld currentTime=%lld diff=%lld",
                         lane, (long long)note.time, (long long)currentTime, (long long)diff);
-                    renderer.triggerLightingN(lane, currentTime);
+                    emitLighting(lane, currentTime);
                     Judgement j = getJudgement(diff, note.time, currentTime);
                     processJudgement(j, lane);
                 }
                 // Update next note index for this lane
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, lane, static_cast<int>(noteIdx));
+                resolveNote(lane, noteIdx);
                 hitErrors.push_back({(int64_t)SDL_GetTicks(), currentTime - note.time});
                 return note.isHold ? Judgement::None : getJudgement(diff, note.time, currentTime);
             }
@@ -6615,31 +6899,29 @@ Judgement Game::checkJudgement(int lane, int64_t atTime) {
             if (isMiss) {
                 note.state = NoteState::Missed;
                 processJudgement(Judgement::Miss, lane);
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, lane, static_cast<int>(noteIdx));
+                resolveNote(lane, noteIdx);
                 hitErrors.push_back({(int64_t)SDL_GetTicks(), currentTime - note.time});
                 return Judgement::Miss;
             }
             // Outside miss window - play empty tap keysound and ignore keypress
-            if (lane >= 0 && lane < 18 && laneNextNoteIndex[lane] >= 0 &&
-                laneNextNoteIndex[lane] < static_cast<int>(beatmap.notes.size())) {
-                const Note& nextNote = beatmap.notes[laneNextNoteIndex[lane]];
+            if (laneNoteIndex.getNextNote(lane) >= 0) {
+                const Note& nextNote = beatmap.notes[laneNoteIndex.getNextNote(lane)];
                 keySoundManager.playKeySound(nextNote, false);
                 // Use timing point's sampleSet for empty tap trigger matching
-                storyboard.onHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
+                emitHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
             }
             return Judgement::None;
         }
     }
 
     // No note hit - play empty tap keysound (next note's keysound in this lane)
-    SDL_Log("Empty tap: lane=%d laneNextNoteIndex=%d", lane, laneNextNoteIndex[lane]);
-    if (lane >= 0 && lane < 18 && laneNextNoteIndex[lane] >= 0 &&
-        laneNextNoteIndex[lane] < static_cast<int>(beatmap.notes.size())) {
-        const Note& nextNote = beatmap.notes[laneNextNoteIndex[lane]];
+    SDL_Log("Empty tap: lane=%d nextNote=%d", lane, laneNoteIndex.getNextNote(lane));
+    if (laneNoteIndex.getNextNote(lane) >= 0) {
+        const Note& nextNote = beatmap.notes[laneNoteIndex.getNextNote(lane)];
         SDL_Log("  Playing empty tap keysound for note at time=%lld", (long long)nextNote.time);
         keySoundManager.playKeySound(nextNote, false);
         // Use timing point's sampleSet for empty tap trigger matching
-        storyboard.onHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
+        emitHitSound(buildEmptyTapHitSoundInfo(beatmap.timingPoints, currentTime, nextNote), currentTime);
     }
 
     return Judgement::None;
@@ -6655,9 +6937,9 @@ void Game::onKeyRelease(int lane, int64_t atTime) {
 
     addDebugLog(currentTime, "KEY_UP", lane, "");
 
-    for (auto& note : beatmap.notes) {
-        if (note.isFakeNote) continue;  // Skip fake notes
-        if (note.state != NoteState::Holding || note.lane != lane) continue;
+    int holdIdx = laneNoteIndex.findHold(beatmap.notes, lane, NoteState::Holding);
+    if (holdIdx >= 0) {
+        Note& note = beatmap.notes[holdIdx];
 
         int64_t rawTailError = std::abs(note.endTime - currentTime);
 
@@ -6688,8 +6970,7 @@ void Game::onKeyRelease(int lane, int64_t atTime) {
                 note.hadComboBreak = true;
                 processJudgement(Judgement::Miss, lane);
                 combo = 0;
-                updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, lane,
-                    static_cast<int>(&note - &beatmap.notes[0]));
+                resolveNote(lane, holdIdx);
                 return;
             }
 
@@ -6704,11 +6985,11 @@ void Game::onKeyRelease(int lane, int64_t atTime) {
             keySoundManager.playKeySound(note, true);
 
             // Notify storyboard of tail hitsound
-            storyboard.onHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, true), currentTime);
+            emitHitSound(buildHitSoundInfo(note, beatmap.timingPoints, currentTime, true), currentTime);
 
             // Normal release at tail
             note.state = NoteState::Hit;
-            renderer.triggerLightingN(lane, currentTime);
+            emitLighting(lane, currentTime);
 
             Judgement j;
             double headError = note.headHitError;
@@ -6827,8 +7108,7 @@ void Game::onKeyRelease(int lane, int64_t atTime) {
             if (!note.hadComboBreak) {
                 processJudgement(Judgement::Miss, note.lane);
             }
-            updateLaneNextNoteIndex(laneNextNoteIndex, beatmap.notes, note.lane,
-                static_cast<int>(&note - &beatmap.notes[0]));
+            resolveNote(note.lane, holdIdx);
         }
         return;
     }
@@ -6869,19 +7149,13 @@ void Game::processJudgement(Judgement j, int lane) {
 
     // Trigger BMS Poor BGA on miss
     if (j == Judgement::Miss && isBmsBga) {
-        bmsBgaManager.triggerMissLayer(getCurrentGameTime());
+        emitBgaMiss(getCurrentGameTime());
     }
 
     // Sudden Death: any miss triggers death
     // Replay mode ignores Sudden Death mod
     if (settings.suddenDeathEnabled && !replayMode && j == Judgement::Miss && !autoPlay) {
-        state = GameState::Dead;
-        deathTime = SDL_GetTicks();
-        deathSlowdown = 1.0f;
-        deathMenuSelection = 1;  // Default to Retry
-        if (hasBackgroundMusic) {
-            audio.pause();
-        }
+        requestStateChange(GameState::Dead);
     }
 
     // Score calculation (osu!mania formula)
@@ -6944,35 +7218,60 @@ void Game::processJudgement(Judgement j, int lane) {
 }
 
 int64_t Game::getCurrentGameTime() const {
+    return static_cast<int64_t>(getCurrentGameTimeExact());
+}
+
+int64_t Game::getRenderTime() const {
+    return static_cast<int64_t>(getRenderTimeExact());
+}
+
+double Game::getCurrentGameTimeExact() const {
     // During pause fade out, return frozen game time
     if (pauseFadingOut) {
-        return pauseGameTime;
+        return (double)pauseGameTime;
     }
-    int64_t elapsed = SDL_GetTicks() - startTime;
+    double elapsed = SDL_GetTicksNS() / 1000000.0 - startTime;
     if (!musicStarted) {
-        return static_cast<int64_t>((elapsed - PREPARE_TIME) * clockRate);
+        return (elapsed - PREPARE_TIME) * clockRate;
     }
     if (hasBackgroundMusic) {
-        return audio.getPosition() + settings.audioOffset;
+        return audio.getPrecisePosition() + settings.audioOffset;
     }
     // No background music: use elapsed time scaled by playback rate
-    return static_cast<int64_t>((elapsed - PREPARE_TIME) * clockRate);
+    return (elapsed - PREPARE_TIME) * clockRate;
 }
 
-int64_t Game::getRenderTime() const {
+double Game::getRenderTimeExact() const {
     // During pause fade out, return frozen game time
     if (pauseFadingOut) {
-        return pauseGameTime;
+        return (double)pauseGameTime;
     }
-    int64_t elapsed = SDL_GetTicks() - startTime;
+    double elapsed = SDL_GetTicksNS() / 1000000.0 - startTime;
     if (!musicStarted) {
-        return static_cast<int64_t>((elapsed - PREPARE_TIME) * clockRate);
+        return (elapsed - PREPARE_TIME) * clockRate;
     }
     if (hasBackgroundMusic) {
-        return audio.getRawPosition();
+        return audio.getPrecisePosition();
     }
     // No background music: use elapsed time scaled by playback rate
-    return static_cast<int64_t>((elapsed - PREPARE_TIME) * clockRate);
+    return (elapsed - PREPARE_TIME) * clockRate;
+}
+
+int64_t Game::getEventGameTime(Uint64 timestampNS) const {
+    double now = getCurrentGameTimeExact();
+    if (pauseFadingOut || timestampNS == 0) {
+        return static_cast<int64_t>(now);
+    }
+    // Events older than the last update are clamped to it, so a press can never land
+    // before a miss that update() has already judged
+    Uint64 eventNS = std::max(timestampNS, lastUpdateTicksNS);
+    Uint64 nowNS = SDL_GetTicksNS();
+    if (eventNS >= nowNS) {
+        return static_cast<int64_t>(now);
+    }
+    // Game time advances at clockRate relative to wall time
+    double lagMs = (double)(nowNS - eventNS) / 1000000.0 * clockRate;
+    return static_cast<int64_t>(std::floor(now - lagMs));
 }
 
 double Game::calculateAccuracy() {
@@ -7030,302 +7329,6 @@ void Game::exportDebugLog() {
     file.close();
 }
 
-// --- Search filtering helpers ---
-
-static bool containsCI(const std::string& haystack, const std::string& needle) {
-    if (needle.empty()) return true;
-    if (haystack.empty()) return false;
-    auto it = std::search(haystack.begin(), haystack.end(),
-                          needle.begin(), needle.end(),
-                          [](char a, char b) {
-                              return tolower((unsigned char)a) == tolower((unsigned char)b);
-                          });
-    return it != haystack.end();
-}
-
-// Word-boundary exact phrase match (case-insensitive)
-static bool containsExactCI(const std::string& haystack, const std::string& needle) {
-    if (needle.empty()) return true;
-    if (haystack.empty()) return false;
-    std::string hLow = haystack, nLow = needle;
-    for (auto& c : hLow) c = tolower((unsigned char)c);
-    for (auto& c : nLow) c = tolower((unsigned char)c);
-    size_t pos = 0;
-    while ((pos = hLow.find(nLow, pos)) != std::string::npos) {
-        bool leftOk = (pos == 0 || hLow[pos - 1] == ' ');
-        bool rightOk = (pos + nLow.size() >= hLow.size() || hLow[pos + nLow.size()] == ' ');
-        if (leftOk && rightOk) return true;
-        pos++;
-    }
-    return false;
-}
-
-static const char* sourceToString(BeatmapSource src) {
-    switch (src) {
-        case BeatmapSource::Osu: return "osu!";
-        case BeatmapSource::DJMaxRespect: return "DJMAX RESPECT";
-        case BeatmapSource::DJMaxOnline: return "DJMAX ONLINE";
-        case BeatmapSource::O2Jam: return "O2Jam";
-        case BeatmapSource::BMS: return "BMS";
-        case BeatmapSource::Malody: return "Malody";
-        case BeatmapSource::MuSynx: return "MUSYNX MUSYNC";
-        case BeatmapSource::IIDX: return "Beatmania IIDX";
-        case BeatmapSource::StepMania: return "StepMania";
-        case BeatmapSource::SDVX: return "Sound Voltex";
-        case BeatmapSource::EZ2AC: return "EZ2AC";
-        case BeatmapSource::EZ2ON: return "EZ2ON REBOOT:R";
-        default: return "";
-    }
-}
-
-// Parse duration string: "1:30", "1m30s", "90" -> seconds
-static double parseDurationSeconds(const std::string& s) {
-    size_t colonPos = s.find(':');
-    if (colonPos != std::string::npos) {
-        try {
-            double mins = std::stod(s.substr(0, colonPos));
-            double secs = std::stod(s.substr(colonPos + 1));
-            return mins * 60.0 + secs;
-        } catch (...) {}
-    }
-    size_t mPos = s.find('m');
-    size_t sPos = s.find('s');
-    if (mPos != std::string::npos) {
-        try {
-            double mins = std::stod(s.substr(0, mPos));
-            double secs = 0;
-            if (sPos != std::string::npos && sPos > mPos + 1)
-                secs = std::stod(s.substr(mPos + 1, sPos - mPos - 1));
-            return mins * 60.0 + secs;
-        } catch (...) {}
-    }
-    try { return std::stod(s); } catch (...) { return -1; }
-}
-
-struct SearchToken {
-    enum Type { FreeText, ExactPhrase, ExcludePhrase, DiffName, KeywordNumeric, KeywordString };
-    Type type;
-    std::string text;
-    std::string key;
-    int op;             // 0: =, 1: >, 2: <, 3: >=, 4: <=
-    double numValue;
-};
-
-static std::vector<SearchToken> parseSearchTokens(const std::string& search) {
-    std::vector<SearchToken> tokens;
-    size_t i = 0;
-    size_t len = search.size();
-
-    while (i < len) {
-        while (i < len && (search[i] == ' ' || search[i] == '\t')) i++;
-        if (i >= len) break;
-
-        // [DiffName]
-        if (search[i] == '[') {
-            size_t end = search.find(']', i + 1);
-            if (end != std::string::npos) {
-                SearchToken t;
-                t.type = SearchToken::DiffName;
-                t.text = search.substr(i + 1, end - i - 1);
-                t.op = 0; t.numValue = 0;
-                tokens.push_back(t);
-                i = end + 1;
-                continue;
-            }
-        }
-
-        // "Quoted phrase" or "Quoted phrase"!
-        if (search[i] == '"') {
-            size_t end = search.find('"', i + 1);
-            if (end != std::string::npos) {
-                std::string phrase = search.substr(i + 1, end - i - 1);
-                bool exclude = (end + 1 < len && search[end + 1] == '!');
-                SearchToken t;
-                t.type = exclude ? SearchToken::ExcludePhrase : SearchToken::ExactPhrase;
-                t.text = phrase;
-                t.op = 0; t.numValue = 0;
-                tokens.push_back(t);
-                i = exclude ? end + 2 : end + 1;
-                continue;
-            }
-        }
-
-        // Read word until whitespace
-        size_t wordStart = i;
-        while (i < len && search[i] != ' ' && search[i] != '\t') i++;
-        std::string word = search.substr(wordStart, i - wordStart);
-        if (word.empty()) continue;
-
-        // Check for keyword filter (key op value)
-        size_t opPos = std::string::npos;
-        int opType = -1;
-        for (size_t j = 0; j < word.size(); j++) {
-            if (word[j] == '>' && j + 1 < word.size() && word[j + 1] == '=') {
-                opPos = j; opType = 3; break;
-            }
-            if (word[j] == '<' && j + 1 < word.size() && word[j + 1] == '=') {
-                opPos = j; opType = 4; break;
-            }
-            if (word[j] == '=') { opPos = j; opType = 0; break; }
-            if (word[j] == '>') { opPos = j; opType = 1; break; }
-            if (word[j] == '<') { opPos = j; opType = 2; break; }
-        }
-
-        if (opPos != std::string::npos && opPos > 0) {
-            std::string key = word.substr(0, opPos);
-            int opLen = (opType == 3 || opType == 4) ? 2 : 1;
-            std::string value = word.substr(opPos + opLen);
-            for (auto& c : key) c = tolower((unsigned char)c);
-
-            bool isNumericKey = (key == "star" || key == "stars" || key == "sr" ||
-                                 key == "hp" || key == "od" || key == "bpm" ||
-                                 key == "length" || key == "key" || key == "keys");
-            bool isStringKey = (key == "creator" || key == "author" || key == "mapper" ||
-                                key == "artist" || key == "title" || key == "diff" ||
-                                key == "source" || key == "tag");
-
-            if (isNumericKey && !value.empty()) {
-                SearchToken t;
-                t.type = SearchToken::KeywordNumeric;
-                t.key = key;
-                t.op = opType;
-                t.numValue = (key == "length") ? parseDurationSeconds(value) : 0;
-                if (key != "length") {
-                    try { t.numValue = std::stod(value); } catch (...) { t.numValue = 0; }
-                }
-                tokens.push_back(t);
-                continue;
-            }
-            if (isStringKey && !value.empty()) {
-                SearchToken t;
-                t.type = SearchToken::KeywordString;
-                t.key = key;
-                t.text = value;
-                t.op = opType; t.numValue = 0;
-                tokens.push_back(t);
-                continue;
-            }
-        }
-
-        // Default: free text
-        SearchToken t;
-        t.type = SearchToken::FreeText;
-        t.text = word;
-        t.op = 0; t.numValue = 0;
-        tokens.push_back(t);
-    }
-
-    return tokens;
-}
-
-static bool compareOp(double val, int op, double target) {
-    switch (op) {
-        case 0: return std::abs(val - target) < 0.01;
-        case 1: return val > target;
-        case 2: return val < target;
-        case 3: return val >= target - 0.001;
-        case 4: return val <= target + 0.001;
-        default: return false;
-    }
-}
-
-static double getDiffNumericValue(const DifficultyInfo& d, const std::string& key, int starVer) {
-    if (key == "star" || key == "stars" || key == "sr") return d.starRatings[starVer];
-    if (key == "hp") return d.hp;
-    if (key == "od") return d.od;
-    if (key == "bpm") return d.bpmMost > 0 ? d.bpmMost : d.bpmMax;
-    if (key == "length") return d.totalLength / 1000.0;
-    if (key == "keys" || key == "key") return d.keyCount;
-    return 0;
-}
-
-static bool matchFreeTextFieldsSong(const SongEntry& song, const std::string& text) {
-    if (containsCI(song.title, text)) return true;
-    if (containsCI(song.titleUnicode, text)) return true;
-    if (containsCI(song.artist, text)) return true;
-    if (containsCI(song.artistUnicode, text)) return true;
-    if (containsCI(song.sourceText, text)) return true;
-    if (containsCI(song.tags, text)) return true;
-    if (containsCI(sourceToString(song.source), text)) return true;
-    return false;
-}
-
-static bool matchFreeTextFieldsDiff(const DifficultyInfo& d, const std::string& text) {
-    if (containsCI(d.version, text)) return true;
-    if (containsCI(d.creator, text)) return true;
-    return false;
-}
-
-static bool matchExactFieldsSong(const SongEntry& song, const std::string& text) {
-    if (containsExactCI(song.title, text)) return true;
-    if (containsExactCI(song.titleUnicode, text)) return true;
-    if (containsExactCI(song.artist, text)) return true;
-    if (containsExactCI(song.artistUnicode, text)) return true;
-    if (containsExactCI(song.sourceText, text)) return true;
-    if (containsExactCI(song.tags, text)) return true;
-    if (containsExactCI(sourceToString(song.source), text)) return true;
-    return false;
-}
-
-static bool matchExactFieldsDiff(const DifficultyInfo& d, const std::string& text) {
-    if (containsExactCI(d.version, text)) return true;
-    if (containsExactCI(d.creator, text)) return true;
-    return false;
-}
-
-// Returns indices of difficulties that match all search tokens (per-difficulty filtering)
-static std::vector<int> getMatchingDifficulties(const SongEntry& song, const std::vector<SearchToken>& tokens, int starVer) {
-    std::vector<int> result;
-    for (int di = 0; di < (int)song.difficulties.size(); di++) {
-        const auto& d = song.difficulties[di];
-        bool allMatched = true;
-        for (const auto& token : tokens) {
-            bool matched = false;
-            switch (token.type) {
-                case SearchToken::FreeText:
-                    matched = matchFreeTextFieldsSong(song, token.text) ||
-                              matchFreeTextFieldsDiff(d, token.text);
-                    break;
-                case SearchToken::ExactPhrase:
-                    matched = matchExactFieldsSong(song, token.text) ||
-                              matchExactFieldsDiff(d, token.text);
-                    break;
-                case SearchToken::ExcludePhrase:
-                    matched = !matchFreeTextFieldsSong(song, token.text) &&
-                              !matchFreeTextFieldsDiff(d, token.text);
-                    break;
-                case SearchToken::DiffName:
-                    matched = containsCI(d.version, token.text);
-                    break;
-                case SearchToken::KeywordNumeric:
-                    matched = compareOp(getDiffNumericValue(d, token.key, starVer), token.op, token.numValue);
-                    break;
-                case SearchToken::KeywordString: {
-                    const std::string& key = token.key;
-                    if (key == "creator" || key == "author" || key == "mapper") {
-                        matched = containsCI(d.creator, token.text);
-                    } else if (key == "artist") {
-                        matched = containsCI(song.artist, token.text);
-                    } else if (key == "title") {
-                        matched = containsCI(song.title, token.text);
-                    } else if (key == "diff") {
-                        matched = containsCI(d.version, token.text);
-                    } else if (key == "source") {
-                        matched = containsCI(sourceToString(song.source), token.text) ||
-                                  containsCI(song.sourceText, token.text);
-                    } else if (key == "tag") {
-                        matched = containsCI(song.tags, token.text);
-                    }
-                    break;
-                }
-            }
-            if (!matched) { allMatched = false; break; }
-        }
-        if (allMatched) result.push_back(di);
-    }
-    return result;
-}
-
 // Helper: extract metadata from parsed BeatmapInfo into DifficultyInfo
 static void extractDiffMetadata(DifficultyInfo& diff, const BeatmapInfo& info) {
     // Length (last note time, considering hold end times)
@@ -7379,11 +7382,139 @@ static void extractDiffMetadata(DifficultyInfo& diff, const BeatmapInfo& info) {
     }
 }
 
-void Game::startScanAsync(bool clearIndex, GameState afterState) {
+// Star ratings (both versions) and the metadata pass of one parsed chart. They only read
+// info and each writes its own fields of diff, so they are queued as separate tasks.
+static void queueDiffAnalysis(DifficultyInfo& diff, const BeatmapInfo& info, int keyCount,
+                              std::vector<std::function<void()>>& tasks) {
+    tasks.push_back([&diff, &info, keyCount] {
+        diff.starRatings[0] = calculateStarRating(info.notes, keyCount, StarRatingVersion::OsuStable_b20260101);
+    });
+    tasks.push_back([&diff, &info, keyCount] {
+        diff.starRatings[1] = calculateStarRating(info.notes, keyCount, StarRatingVersion::OsuStable_b20220101);
+    });
+    tasks.push_back([&diff, &info] { extractDiffMetadata(diff, info); });
+}
+
+// Run queued analysis on the scan pool when called from a scan task, inline otherwise
+static void runDiffAnalysis(std::vector<std::function<void()>>& tasks) {
+    if (WorkStealingPool* pool = WorkStealingPool::current()) {
+        pool->run(tasks);
+        return;
+    }
+    for (auto& task : tasks) task();
+    tasks.clear();
+}
+
+static void analyzeDiff(DifficultyInfo& diff, const BeatmapInfo& info, int keyCount) {
+    std::vector<std::function<void()>> tasks;
+    queueDiffAnalysis(diff, info, keyCount, tasks);
+    runDiffAnalysis(tasks);
+}
+
+// O2Jam: the three difficulties of one .ojn, parsed from a single read and analyzed as one
+// batch. Without a readable header the song still gets level-less entries.
+static bool addOjnDifficulties(const std::string& ojnPath, SongEntry& song, OjnHeader& header) {
+    static const char* DIFF_NAMES[3] = {"Easy", "Normal", "Hard"};
+    std::string ojnHash = OsuParser::calculateMD5(ojnPath);
+
+    BeatmapInfo infos[3];
+    bool parsed[3] = {false, false, false};
+    if (!OjnParser::parseAll(ojnPath, header, infos, parsed)) {
+        for (int i = 0; i < 3; i++) {
+            DifficultyInfo diff;
+            diff.path = ojnPath + ":" + std::to_string(i) + ":0";
+            diff.version = DIFF_NAMES[i];
+            diff.keyCount = 7;
+            diff.hash = ojnHash + ":" + std::to_string(i);
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        }
+        return false;
+    }
+
+    std::string creator(header.noter, strnlen(header.noter, 32));
+    DifficultyInfo diffs[3];
+    std::vector<std::function<void()>> tasks;
+    for (int i = 0; i < 3; i++) {
+        std::string level = std::to_string(header.level[i]);
+        diffs[i].path = ojnPath + ":" + std::to_string(i) + ":" + level;
+        diffs[i].version = std::string(DIFF_NAMES[i]) + " Lv." + level;
+        diffs[i].creator = creator;
+        diffs[i].hash = ojnHash + ":" + std::to_string(i);
+        diffs[i].keyCount = 7;
+        if (parsed[i]) queueDiffAnalysis(diffs[i], infos[i], 7, tasks);
+    }
+    runDiffAnalysis(tasks);
+
+    for (auto& diff : diffs) {
+        song.beatmapFiles.push_back(diff.path);
+        song.difficulties.push_back(std::move(diff));
+    }
+    return true;
+}
+
+// Extensions that may hold a chart (MUSYNX .txt charts are told apart by name)
+static bool isChartExtension(const std::string& ext) {
+    return ext == ".osu" || ext == ".sm" || ext == ".ssc" ||
+           ext == ".bms" || ext == ".bme" || ext == ".bml" || ext == ".pms" ||
+           ext == ".ojn" || ext == ".pt" || ext == ".bytes" ||
+           ext == ".mc" || ext == ".1" || ext == ".vox" || ext == ".ez" || ext == ".ezi" || ext == ".txt";
+}
+
+static DifficultyInfo difficultyFromCache(const CachedDifficulty& cd) {
+    DifficultyInfo diff;
+    diff.path = cd.path;
+    diff.version = cd.version;
+    diff.creator = cd.creator;
+    diff.hash = cd.hash;
+    diff.backgroundPath = cd.backgroundPath;
+    diff.audioPath = cd.audioPath;
+    diff.previewTime = cd.previewTime;
+    diff.keyCount = cd.keyCount;
+    for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) {
+        diff.starRatings[v] = cd.starRatings[v];
+    }
+    diff.totalLength = cd.totalLength;
+    diff.bpmMin = cd.bpmMin;
+    diff.bpmMax = cd.bpmMax;
+    diff.bpmMost = cd.bpmMost;
+    diff.totalObjects = cd.totalObjects;
+    diff.rcCount = cd.rcCount;
+    diff.lnCount = cd.lnCount;
+    diff.od = cd.od;
+    diff.hp = cd.hp;
+    return diff;
+}
+
+// Append the cached difficulties of a chart file if it is unchanged since it was indexed.
+// A file whose time changed but whose size and content did not (touched, copied) still counts.
+static bool reuseCachedChart(const CachedSong& cached, size_t fileIndex, FileFingerprint& fp, SongEntry& song) {
+    const FileFingerprint& old = cached.files[fileIndex];
+    if (old.size != fp.size) return false;
+    if (old.mtimeNs != fp.mtimeNs) {
+        if (old.contentHash.empty() || OsuParser::calculateMD5(fp.path) != old.contentHash) return false;
+    }
+    fp.contentHash = old.contentHash;
+    song.source = static_cast<BeatmapSource>(cached.source);
+    if (song.source == BeatmapSource::IIDX) {
+        // IIDX takes title/artist from its chart branch rather than the metadata pass
+        song.title = cached.title;
+        song.artist = cached.artist;
+    }
+    for (const auto& cd : cached.difficulties) {
+        if (cd.fileIndex != (int)fileIndex) continue;
+        song.beatmapFiles.push_back(cd.path);
+        song.difficulties.push_back(difficultyFromCache(cd));
+    }
+    return true;
+}
+
+void Game::startScanAsync(bool clearIndex, GameState afterState, bool refresh) {
     if (scanRunning) return;
     if (scanThread.joinable()) scanThread.join();
 
     stateAfterScan = afterState;
+    scanCancelled = false;
     scanProgress = 0;
     scanTotal = 0;
     {
@@ -7396,13 +7527,12 @@ void Game::startScanAsync(bool clearIndex, GameState afterState) {
     }
     scanRunning = true;
 
-    scanThread = std::thread([this, clearIndex]() {
+    scanThread = std::thread([this, clearIndex, refresh]() {
         try {
             if (clearIndex) {
-                std::string indexDir = SongIndex::getIndexDir();
-                if (fs::exists(indexDir)) fs::remove_all(indexDir);
+                SongIndex::clear();
             }
-            scanSongsFolder();
+            scanSongsFolder(refresh);
         } catch (const std::exception& e) {
             std::cerr << "[SCAN] Thread exception: " << e.what() << std::endl;
         } catch (...) {
@@ -7414,8 +7544,11 @@ void Game::startScanAsync(bool clearIndex, GameState afterState) {
 
 void Game::finalizeScan() {
     if (scanThread.joinable()) scanThread.join();
+    songSearchIndex.build(songList);
+    songOrder.build(songList);
     updateSongFilter();
-    selectedSongIndex = filteredSongIndices.empty() ? 0 : filteredSongIndices[0];
+    if (filteredSongIndices.empty()) selectedSongIndex = 0;
+    else selectFilteredSong(0);
     selectedDifficultyIndex = (!filteredSongIndices.empty() && !filteredDiffIndices[0].empty()) ? filteredDiffIndices[0][0] : 0;
     songSelectScroll = 0.0f;
     if (stateAfterScan == GameState::SongSelect && !filteredSongIndices.empty()) {
@@ -7428,1353 +7561,1022 @@ void Game::finalizeScan() {
     }
 }
 
-void Game::scanSongsFolder() {
-    std::string songsPath = "Songs";
-
-    if (!fs::exists(songsPath)) {
-        std::cerr << "Songs folder not found" << std::endl;
-        return;
-    }
+void Game::scanFolder(const fs::path& folderPath, std::vector<SongEntry>& results) {
+    try {
+    std::string folderStr = folderPath.string();
 
-    // Helper lambda to check if a folder contains beatmap files
-    auto hasBeatmapFiles = [](const fs::path& folder) -> bool {
-        try {
-            for (const auto& file : fs::directory_iterator(folder)) {
-                if (!file.is_regular_file()) continue;
-                std::string ext = file.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                if (ext == ".osu" || ext == ".sm" || ext == ".ssc" ||
-                    ext == ".bms" || ext == ".bme" || ext == ".bml" || ext == ".pms" ||
-                    ext == ".ojn" || ext == ".pt" || ext == ".bytes" ||
-                    ext == ".mc" || ext == ".1" || ext == ".vox" || ext == ".ez" || ext == ".ezi") {
-                    return true;
-                }
-                // MUSYNX .txt files
-                if (ext == ".txt") {
-                    std::string fname = file.path().filename().string();
-                    if (fname.find("2T") != std::string::npos || fname.find("4T") != std::string::npos || fname.find("6T") != std::string::npos) {
-                        return true;
-                    }
-                }
-            }
-        } catch (...) {}
-        return false;
-    };
+    // Check if we have a valid cached index; a stale one still lets unchanged charts skip parsing
+    CachedSong cached;
+    bool hasCache = SongIndex::loadIndex(folderStr, cached);
+    if (hasCache && SongIndex::isIndexValid(cached)) {
+        // Convert cached song to SongEntry
+        SongEntry song;
+        song.folderPath = cached.folderPath;
+        song.folderName = cached.folderName;
+        song.title = cached.title;
+        song.titleUnicode = cached.titleUnicode;
+        song.artist = cached.artist;
+        song.artistUnicode = cached.artistUnicode;
+        song.backgroundPath = cached.backgroundPath;
+        song.audioPath = cached.audioPath;
+        song.sourceText = cached.sourceText;
+        song.tags = cached.tags;
+        song.previewTime = cached.previewTime;
+        song.source = static_cast<BeatmapSource>(cached.source);
+        song.dateAdded = cached.lastModified;
+
+        std::cerr << "[CACHE] Loading " << cached.title
+                  << " cached.difficulties=" << cached.difficulties.size() << std::endl;
+
+        for (const auto& cd : cached.difficulties) {
+            song.beatmapFiles.push_back(cd.path);
+            song.difficulties.push_back(difficultyFromCache(cd));
+        }
+
+        std::cerr << "[CACHE] Result: beatmapFiles=" << song.beatmapFiles.size()
+                  << " difficulties=" << song.difficulties.size() << std::endl;
 
-    // Recursively collect all folders containing beatmap files
-    std::set<fs::path> currentFolders;
-    std::function<void(const fs::path&)> collectFolders = [&](const fs::path& dir) {
-        try {
-            for (const auto& entry : fs::directory_iterator(dir)) {
-                try {
-                    if (entry.is_directory()) {
-                        if (hasBeatmapFiles(entry.path())) {
-                            currentFolders.insert(entry.path());
-                        } else {
-                            collectFolders(entry.path());
-                        }
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "[SCAN] Skip entry: " << e.what() << std::endl;
-                }
+        if (!song.beatmapFiles.empty()) {
+            // Sort difficulties by star rating (ascending)
+            std::vector<size_t> indices(song.difficulties.size());
+            std::iota(indices.begin(), indices.end(), 0);
+            std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+                return song.difficulties[a].starRatings[settings.starRatingVersion] <
+                       song.difficulties[b].starRatings[settings.starRatingVersion];
+            });
+            std::vector<std::string> sortedFiles;
+            std::vector<DifficultyInfo> sortedDiffs;
+            for (size_t i : indices) {
+                sortedFiles.push_back(song.beatmapFiles[i]);
+                sortedDiffs.push_back(song.difficulties[i]);
             }
-        } catch (const std::exception& e) {
-            std::cerr << "[SCAN] Skip dir: " << e.what() << std::endl;
-        }
-    };
-    collectFolders(songsPath);
-
-    // Build set of existing folder paths in songList
-    std::set<fs::path> existingFolders;
-    for (const auto& song : songList) {
-        existingFolders.insert(fs::path(song.folderPath));
-    }
-
-    // Remove songs whose folders no longer exist
-    songList.erase(
-        std::remove_if(songList.begin(), songList.end(),
-            [&currentFolders](const SongEntry& song) {
-                return currentFolders.find(fs::path(song.folderPath)) == currentFolders.end();
-            }),
-        songList.end());
+            song.beatmapFiles = std::move(sortedFiles);
+            song.difficulties = std::move(sortedDiffs);
 
-    // Find new folders to scan
-    std::vector<fs::path> newFolders;
-    for (const auto& folder : currentFolders) {
-        if (existingFolders.find(folder) == existingFolders.end()) {
-            newFolders.push_back(folder);
+            results.push_back(song);
         }
+        return;  // Cached
     }
 
-    // If no new folders, just re-sort and return
-    if (newFolders.empty()) {
-        std::cerr << "[SCAN] No new folders to scan" << std::endl;
-        goto sort_and_return;
-    }
-
-    std::cerr << "[SCAN] Found " << newFolders.size() << " new folders to scan" << std::endl;
-    scanTotal = (int)newFolders.size();
-    scanProgress = 0;
-
-    for (const auto& folderPath : newFolders) {
-        try {
-        std::string folderStr = folderPath.string();
-        {
-            std::lock_guard<std::mutex> lock(scanMutex);
-            scanStatusText = folderPath.filename().u8string();
+    // Check for multiple OJN files in folder (each OJN is a separate song)
+    {
+        std::vector<std::string> ojnFiles;
+        for (const auto& f : fs::directory_iterator(folderPath)) {
+            if (!f.is_regular_file()) continue;
+            std::string fext = f.path().extension().string();
+            std::transform(fext.begin(), fext.end(), fext.begin(), ::tolower);
+            if (fext == ".ojn") ojnFiles.push_back(f.path().string());
         }
 
-        // Check if we have a valid cached index
-        if (SongIndex::isIndexValid(folderStr)) {
-            CachedSong cached;
-            if (SongIndex::loadIndex(folderStr, cached)) {
-                // Convert cached song to SongEntry
-                SongEntry song;
-                song.folderPath = cached.folderPath;
-                song.folderName = cached.folderName;
-                song.title = cached.title;
-                song.titleUnicode = cached.titleUnicode;
-                song.artist = cached.artist;
-                song.artistUnicode = cached.artistUnicode;
-                song.backgroundPath = cached.backgroundPath;
-                song.audioPath = cached.audioPath;
-                song.sourceText = cached.sourceText;
-                song.tags = cached.tags;
-                song.previewTime = cached.previewTime;
-                song.source = static_cast<BeatmapSource>(cached.source);
-
-                std::cerr << "[CACHE] Loading " << cached.title
-                          << " cached.difficulties=" << cached.difficulties.size() << std::endl;
-
-                for (const auto& cd : cached.difficulties) {
-                    song.beatmapFiles.push_back(cd.path);
-                    DifficultyInfo diff;
-                    diff.path = cd.path;
-                    diff.version = cd.version;
-                    diff.creator = cd.creator;
-                    diff.hash = cd.hash;
-                    diff.backgroundPath = cd.backgroundPath;
-                    diff.audioPath = cd.audioPath;
-                    diff.previewTime = cd.previewTime;
-                    diff.keyCount = cd.keyCount;
-                    for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) {
-                        diff.starRatings[v] = cd.starRatings[v];
+        if (ojnFiles.size() > 1) {
+            // Multiple OJN files: create separate SongEntry for each
+            for (const auto& ojnPath : ojnFiles) {
+                try {
+                // Check per-file cache (use OJN path as cache key)
+                CachedSong ojnCached;
+                if (SongIndex::loadIndex(ojnPath, ojnCached) && SongIndex::isIndexValid(ojnCached)) {
+                    SongEntry song;
+                    song.folderPath = folderStr;  // Actual folder path
+                    song.folderName = fs::path(ojnPath).stem().string();
+                    song.title = ojnCached.title;
+                    song.titleUnicode = ojnCached.titleUnicode;
+                    song.artist = ojnCached.artist;
+                    song.artistUnicode = ojnCached.artistUnicode;
+                    song.backgroundPath = ojnCached.backgroundPath;
+                    song.audioPath = ojnCached.audioPath;
+                    song.sourceText = ojnCached.sourceText;
+                    song.tags = ojnCached.tags;
+                    song.previewTime = ojnCached.previewTime;
+                    song.source = static_cast<BeatmapSource>(ojnCached.source);
+                    song.dateAdded = ojnCached.lastModified;
+                    for (const auto& cd : ojnCached.difficulties) {
+                        song.beatmapFiles.push_back(cd.path);
+                        song.difficulties.push_back(difficultyFromCache(cd));
+                    }
+                    if (!song.beatmapFiles.empty()) {
+                        std::vector<size_t> indices(song.difficulties.size());
+                        std::iota(indices.begin(), indices.end(), 0);
+                        std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+                            return song.difficulties[a].starRatings[settings.starRatingVersion] <
+                                   song.difficulties[b].starRatings[settings.starRatingVersion];
+                        });
+                        std::vector<std::string> sortedFiles;
+                        std::vector<DifficultyInfo> sortedDiffs;
+                        for (size_t idx : indices) {
+                            sortedFiles.push_back(song.beatmapFiles[idx]);
+                            sortedDiffs.push_back(song.difficulties[idx]);
+                        }
+                        song.beatmapFiles = std::move(sortedFiles);
+                        song.difficulties = std::move(sortedDiffs);
+                        results.push_back(song);
                     }
-                    diff.totalLength = cd.totalLength;
-                    diff.bpmMin = cd.bpmMin;
-                    diff.bpmMax = cd.bpmMax;
-                    diff.bpmMost = cd.bpmMost;
-                    diff.totalObjects = cd.totalObjects;
-                    diff.rcCount = cd.rcCount;
-                    diff.lnCount = cd.lnCount;
-                    diff.od = cd.od;
-                    diff.hp = cd.hp;
-                    song.difficulties.push_back(diff);
+                    continue;  // Next OJN file
                 }
 
-                std::cerr << "[CACHE] Result: beatmapFiles=" << song.beatmapFiles.size()
-                          << " difficulties=" << song.difficulties.size() << std::endl;
-
-                if (!song.beatmapFiles.empty()) {
-                    // Sort difficulties by star rating (ascending)
-                    std::vector<size_t> indices(song.difficulties.size());
-                    std::iota(indices.begin(), indices.end(), 0);
-                    std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
-                        return song.difficulties[a].starRatings[settings.starRatingVersion] <
-                               song.difficulties[b].starRatings[settings.starRatingVersion];
-                    });
-                    std::vector<std::string> sortedFiles;
-                    std::vector<DifficultyInfo> sortedDiffs;
-                    for (size_t i : indices) {
-                        sortedFiles.push_back(song.beatmapFiles[i]);
-                        sortedDiffs.push_back(song.difficulties[i]);
-                    }
-                    song.beatmapFiles = std::move(sortedFiles);
-                    song.difficulties = std::move(sortedDiffs);
+                // No cache, parse this OJN file
+                std::cerr << "[SCAN] Parsing OJN: " << ojnPath << std::endl;
+                SongEntry song;
+                song.folderPath = folderStr;
+                song.folderName = fs::path(ojnPath).stem().string();
+                song.source = BeatmapSource::O2Jam;
 
-                    songList.push_back(song);
+                OjnHeader header;
+                if (addOjnDifficulties(ojnPath, song, header)) {
+                    song.title = std::string(header.title, strnlen(header.title, 64));
+                    song.artist = std::string(header.artist, strnlen(header.artist, 32));
+                }
+
+                // Metadata
+                song.backgroundPath = OjnParser::extractCover(ojnPath);
+                // Skip generatePreview during scan (too expensive), generate on-demand
+                song.previewTime = -1;
+                if (song.title.empty()) song.title = song.folderName;
+
+                // Save per-file cache (use OJN path as key)
+                CachedSong cached;
+                cached.folderPath = ojnPath;  // OJN path as cache key
+                cached.folderName = song.folderName;
+                cached.title = song.title;
+                cached.titleUnicode = song.titleUnicode;
+                cached.artist = song.artist;
+                cached.artistUnicode = song.artistUnicode;
+                cached.backgroundPath = song.backgroundPath;
+                cached.audioPath = song.audioPath;
+                cached.sourceText = song.sourceText;
+                cached.tags = song.tags;
+                cached.previewTime = song.previewTime;
+                cached.source = static_cast<int>(song.source);
+                cached.lastModified = SongIndex::getFolderModTime(ojnPath);
+                song.dateAdded = cached.lastModified;
+                for (const auto& d : song.difficulties) {
+                    CachedDifficulty cd;
+                    cd.path = d.path;
+                    cd.version = d.version;
+                    cd.creator = d.creator;
+                    cd.hash = d.hash;
+                    cd.backgroundPath = d.backgroundPath;
+                    cd.audioPath = d.audioPath;
+                    cd.keyCount = d.keyCount;
+                    cd.previewTime = d.previewTime;
+                    for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++)
+                        cd.starRatings[v] = d.starRatings[v];
+                    cd.totalLength = d.totalLength;
+                    cd.bpmMin = d.bpmMin;
+                    cd.bpmMax = d.bpmMax;
+                    cd.bpmMost = d.bpmMost;
+                    cd.totalObjects = d.totalObjects;
+                    cd.rcCount = d.rcCount;
+                    cd.lnCount = d.lnCount;
+                    cd.od = d.od;
+                    cd.hp = d.hp;
+                    cached.difficulties.push_back(cd);
+                }
+                SongIndex::saveIndex(cached);
+
+                // Sort difficulties by star rating
+                std::vector<size_t> indices(song.difficulties.size());
+                std::iota(indices.begin(), indices.end(), 0);
+                std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+                    return song.difficulties[a].starRatings[settings.starRatingVersion] <
+                           song.difficulties[b].starRatings[settings.starRatingVersion];
+                });
+                std::vector<std::string> sortedFiles;
+                std::vector<DifficultyInfo> sortedDiffs;
+                for (size_t idx : indices) {
+                    sortedFiles.push_back(song.beatmapFiles[idx]);
+                    sortedDiffs.push_back(song.difficulties[idx]);
+                }
+                song.beatmapFiles = std::move(sortedFiles);
+                song.difficulties = std::move(sortedDiffs);
+
+                results.push_back(song);
+                } catch (const std::exception& e) {
+                    std::cerr << "[SCAN] OJN parse error: " << ojnPath << " - " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "[SCAN] OJN unknown error: " << ojnPath << std::endl;
                 }
-                scanProgress++;
-                continue;  // Skip to next folder
             }
+            return;  // Skip normal folder processing
         }
+    }
 
-        // Check for multiple OJN files in folder (each OJN is a separate song)
-        {
-            std::vector<std::string> ojnFiles;
-            for (const auto& f : fs::directory_iterator(folderPath)) {
-                if (!f.is_regular_file()) continue;
-                std::string fext = f.path().extension().string();
-                std::transform(fext.begin(), fext.end(), fext.begin(), ::tolower);
-                if (fext == ".ojn") ojnFiles.push_back(f.path().string());
-            }
-
-            if (ojnFiles.size() > 1) {
-                // Multiple OJN files: create separate SongEntry for each
-                for (const auto& ojnPath : ojnFiles) {
-                    try {
-                    // Check per-file cache (use OJN path as cache key)
-                    if (SongIndex::isIndexValid(ojnPath)) {
-                        CachedSong cached;
-                        if (SongIndex::loadIndex(ojnPath, cached)) {
-                            SongEntry song;
-                            song.folderPath = folderStr;  // Actual folder path
-                            song.folderName = fs::path(ojnPath).stem().string();
-                            song.title = cached.title;
-                            song.titleUnicode = cached.titleUnicode;
-                            song.artist = cached.artist;
-                            song.artistUnicode = cached.artistUnicode;
-                            song.backgroundPath = cached.backgroundPath;
-                            song.audioPath = cached.audioPath;
-                            song.sourceText = cached.sourceText;
-                            song.tags = cached.tags;
-                            song.previewTime = cached.previewTime;
-                            song.source = static_cast<BeatmapSource>(cached.source);
-                            for (const auto& cd : cached.difficulties) {
-                                song.beatmapFiles.push_back(cd.path);
-                                DifficultyInfo diff;
-                                diff.path = cd.path;
-                                diff.version = cd.version;
-                                diff.creator = cd.creator;
-                                diff.hash = cd.hash;
-                                diff.backgroundPath = cd.backgroundPath;
-                                diff.audioPath = cd.audioPath;
-                                diff.previewTime = cd.previewTime;
-                                diff.keyCount = cd.keyCount;
-                                for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++)
-                                    diff.starRatings[v] = cd.starRatings[v];
-                                diff.totalLength = cd.totalLength;
-                                diff.bpmMin = cd.bpmMin;
-                                diff.bpmMax = cd.bpmMax;
-                                diff.bpmMost = cd.bpmMost;
-                                diff.totalObjects = cd.totalObjects;
-                                diff.rcCount = cd.rcCount;
-                                diff.lnCount = cd.lnCount;
-                                diff.od = cd.od;
-                                diff.hp = cd.hp;
-                                song.difficulties.push_back(diff);
-                            }
-                            if (!song.beatmapFiles.empty()) {
-                                std::vector<size_t> indices(song.difficulties.size());
-                                std::iota(indices.begin(), indices.end(), 0);
-                                std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
-                                    return song.difficulties[a].starRatings[settings.starRatingVersion] <
-                                           song.difficulties[b].starRatings[settings.starRatingVersion];
-                                });
-                                std::vector<std::string> sortedFiles;
-                                std::vector<DifficultyInfo> sortedDiffs;
-                                for (size_t idx : indices) {
-                                    sortedFiles.push_back(song.beatmapFiles[idx]);
-                                    sortedDiffs.push_back(song.difficulties[idx]);
-                                }
-                                song.beatmapFiles = std::move(sortedFiles);
-                                song.difficulties = std::move(sortedDiffs);
-                                songList.push_back(song);
-                            }
-                            continue;  // Next OJN file
-                        }
-                    }
+    // No valid cache, scan the folder
+    SongEntry song;
+    song.folderPath = folderStr;
+    song.folderName = folderPath.filename().u8string();
 
-                    // No cache, parse this OJN file
-                    std::cerr << "[SCAN] Parsing OJN: " << ojnPath << std::endl;
-                    SongEntry song;
-                    song.folderPath = folderStr;
-                    song.folderName = fs::path(ojnPath).stem().string();
-                    song.source = BeatmapSource::O2Jam;
-
-                    OjnHeader header;
-                    std::string creator;
-                    if (OjnParser::getHeader(ojnPath, header)) {
-                        creator = std::string(header.noter, strnlen(header.noter, 32));
-
-                        DifficultyInfo diffEasy, diffNormal, diffHard;
-                        diffEasy.keyCount = 7;
-                        diffNormal.keyCount = 7;
-                        diffHard.keyCount = 7;
-
-                        BeatmapInfo tempInfo;
-                        std::cerr << "[SCAN]   Parsing Easy..." << std::endl;
-                        if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Easy)) {
-                            std::cerr << "[SCAN]   Easy notes=" << tempInfo.notes.size() << ", calculating SR..." << std::endl;
-                            diffEasy.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                            diffEasy.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                            extractDiffMetadata(diffEasy, tempInfo);
-                        }
-                        std::cerr << "[SCAN]   Parsing Normal..." << std::endl;
-                        if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Normal)) {
-                            std::cerr << "[SCAN]   Normal notes=" << tempInfo.notes.size() << ", calculating SR..." << std::endl;
-                            diffNormal.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                            diffNormal.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                            extractDiffMetadata(diffNormal, tempInfo);
-                        }
-                        std::cerr << "[SCAN]   Parsing Hard..." << std::endl;
-                        if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Hard)) {
-                            std::cerr << "[SCAN]   Hard notes=" << tempInfo.notes.size() << ", calculating SR..." << std::endl;
-                            diffHard.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                            diffHard.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                            extractDiffMetadata(diffHard, tempInfo);
-                        }
-                        std::cerr << "[SCAN]   Done parsing all diffs" << std::endl;
-
-                        std::string pathEasy = ojnPath + ":0:" + std::to_string(header.level[0]);
-                        std::string pathNormal = ojnPath + ":1:" + std::to_string(header.level[1]);
-                        std::string pathHard = ojnPath + ":2:" + std::to_string(header.level[2]);
-
-                        diffEasy.path = pathEasy;
-                        diffEasy.version = "Easy Lv." + std::to_string(header.level[0]);
-                        diffEasy.creator = creator;
-                        diffEasy.hash = OsuParser::calculateMD5(ojnPath) + ":0";
-
-                        diffNormal.path = pathNormal;
-                        diffNormal.version = "Normal Lv." + std::to_string(header.level[1]);
-                        diffNormal.creator = creator;
-                        diffNormal.hash = OsuParser::calculateMD5(ojnPath) + ":1";
-
-                        diffHard.path = pathHard;
-                        diffHard.version = "Hard Lv." + std::to_string(header.level[2]);
-                        diffHard.creator = creator;
-                        diffHard.hash = OsuParser::calculateMD5(ojnPath) + ":2";
-
-                        song.beatmapFiles.push_back(pathEasy);
-                        song.difficulties.push_back(diffEasy);
-                        song.beatmapFiles.push_back(pathNormal);
-                        song.difficulties.push_back(diffNormal);
-                        song.beatmapFiles.push_back(pathHard);
-                        song.difficulties.push_back(diffHard);
-
-                        song.title = std::string(header.title, strnlen(header.title, 64));
-                        song.artist = std::string(header.artist, strnlen(header.artist, 32));
-                    } else {
-                        std::string ojnHash = OsuParser::calculateMD5(ojnPath);
-                        std::string p0 = ojnPath + ":0:0";
-                        std::string p1 = ojnPath + ":1:0";
-                        std::string p2 = ojnPath + ":2:0";
-                        DifficultyInfo d1; d1.path = p0; d1.version = "Easy"; d1.keyCount = 7; d1.hash = ojnHash + ":0";
-                        DifficultyInfo d2; d2.path = p1; d2.version = "Normal"; d2.keyCount = 7; d2.hash = ojnHash + ":1";
-                        DifficultyInfo d3; d3.path = p2; d3.version = "Hard"; d3.keyCount = 7; d3.hash = ojnHash + ":2";
-                        song.beatmapFiles.push_back(p0);
-                        song.difficulties.push_back(d1);
-                        song.beatmapFiles.push_back(p1);
-                        song.difficulties.push_back(d2);
-                        song.beatmapFiles.push_back(p2);
-                        song.difficulties.push_back(d3);
-                    }
+    // Charts indexed before and unchanged since keep their difficulties without reparsing
+    std::unordered_map<std::string, size_t> cachedFiles;
+    if (hasCache) {
+        for (size_t i = 0; i < cached.files.size(); i++) cachedFiles[cached.files[i].path] = i;
+    }
+    std::vector<FileFingerprint> fingerprints;
+    int reusedCharts = 0;
 
-                    // Metadata
-                    song.backgroundPath = OjnParser::extractCover(ojnPath);
-                    // Skip generatePreview during scan (too expensive), generate on-demand
-                    song.previewTime = -1;
-                    if (song.title.empty()) song.title = song.folderName;
-
-                    // Save per-file cache (use OJN path as key)
-                    CachedSong cached;
-                    cached.folderPath = ojnPath;  // OJN path as cache key
-                    cached.folderName = song.folderName;
-                    cached.title = song.title;
-                    cached.titleUnicode = song.titleUnicode;
-                    cached.artist = song.artist;
-                    cached.artistUnicode = song.artistUnicode;
-                    cached.backgroundPath = song.backgroundPath;
-                    cached.audioPath = song.audioPath;
-                    cached.sourceText = song.sourceText;
-                    cached.tags = song.tags;
-                    cached.previewTime = song.previewTime;
-                    cached.source = static_cast<int>(song.source);
-                    cached.lastModified = SongIndex::getFolderModTime(ojnPath);
-                    for (const auto& d : song.difficulties) {
-                        CachedDifficulty cd;
-                        cd.path = d.path;
-                        cd.version = d.version;
-                        cd.creator = d.creator;
-                        cd.hash = d.hash;
-                        cd.backgroundPath = d.backgroundPath;
-                        cd.audioPath = d.audioPath;
-                        cd.keyCount = d.keyCount;
-                        cd.previewTime = d.previewTime;
-                        for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++)
-                            cd.starRatings[v] = d.starRatings[v];
-                        cd.totalLength = d.totalLength;
-                        cd.bpmMin = d.bpmMin;
-                        cd.bpmMax = d.bpmMax;
-                        cd.bpmMost = d.bpmMost;
-                        cd.totalObjects = d.totalObjects;
-                        cd.rcCount = d.rcCount;
-                        cd.lnCount = d.lnCount;
-                        cd.od = d.od;
-                        cd.hp = d.hp;
-                        cached.difficulties.push_back(cd);
-                    }
-                    SongIndex::saveIndex(cached);
-
-                    // Sort difficulties by star rating
-                    std::vector<size_t> indices(song.difficulties.size());
-                    std::iota(indices.begin(), indices.end(), 0);
-                    std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
-                        return song.difficulties[a].starRatings[settings.starRatingVersion] <
-                               song.difficulties[b].starRatings[settings.starRatingVersion];
-                    });
-                    std::vector<std::string> sortedFiles;
-                    std::vector<DifficultyInfo> sortedDiffs;
-                    for (size_t idx : indices) {
-                        sortedFiles.push_back(song.beatmapFiles[idx]);
-                        sortedDiffs.push_back(song.difficulties[idx]);
-                    }
-                    song.beatmapFiles = std::move(sortedFiles);
-                    song.difficulties = std::move(sortedDiffs);
-
-                    songList.push_back(song);
-                    } catch (const std::exception& e) {
-                        std::cerr << "[SCAN] OJN parse error: " << ojnPath << " - " << e.what() << std::endl;
-                    } catch (...) {
-                        std::cerr << "[SCAN] OJN unknown error: " << ojnPath << std::endl;
-                    }
+    // Scan for beatmap files (including subdirectories for Malody support)
+    for (const auto& file : fs::recursive_directory_iterator(folderPath)) {
+        if (!file.is_regular_file()) continue;
+        std::string ext = file.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+        if (isChartExtension(ext)) {
+            FileFingerprint fp;
+            if (SongIndex::getFileFingerprint(file.path().string(), fp)) {
+                auto it = cachedFiles.find(fp.path);
+                bool reused = it != cachedFiles.end() && reuseCachedChart(cached, it->second, fp, song);
+                fingerprints.push_back(fp);
+                if (reused) {
+                    reusedCharts++;
+                    continue;
                 }
-                scanProgress++;
-                continue;  // Skip normal folder processing
             }
         }
 
-        // No valid cache, scan the folder
-        SongEntry song;
-        song.folderPath = folderStr;
-        song.folderName = folderPath.filename().u8string();
-
-        // Scan for beatmap files (including subdirectories for Malody support)
-        for (const auto& file : fs::recursive_directory_iterator(folderPath)) {
-            if (!file.is_regular_file()) continue;
-            std::string ext = file.path().extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-
-            if (ext == ".osu") {
-                song.source = BeatmapSource::Osu;
-
-                // Parse difficulty info from .osu file
-                DifficultyInfo diff;
-                diff.path = file.path().string();
-                diff.keyCount = 4;  // Default
-                int osuMode = -1;  // -1 = not found
-                std::string diffBgFile;
-                std::string diffAudioFile;
-                std::ifstream diffFile(file.path().string());
-                std::string diffLine;
-                while (std::getline(diffFile, diffLine)) {
-                    if (diffLine.find("Mode:") == 0) {
-                        std::string val = diffLine.substr(5);
-                        while (!val.empty() && val[0] == ' ') val.erase(0, 1);
-                        try { osuMode = std::stoi(val); } catch (...) {}
-                    } else if (diffLine.find("Version:") == 0) {
-                        diff.version = diffLine.substr(8);
-                        while (!diff.version.empty() && diff.version[0] == ' ')
-                            diff.version.erase(0, 1);
-                    } else if (diffLine.find("Creator:") == 0) {
-                        diff.creator = diffLine.substr(8);
-                        while (!diff.creator.empty() && diff.creator[0] == ' ')
-                            diff.creator.erase(0, 1);
-                    } else if (diffLine.find("CircleSize:") == 0) {
-                        std::string val = diffLine.substr(11);
-                        while (!val.empty() && val[0] == ' ') val.erase(0, 1);
-                        try { diff.keyCount = std::stoi(val); } catch (...) {}
-                    } else if (diffLine.find("AudioFilename:") == 0) {
-                        diffAudioFile = diffLine.substr(14);
-                        while (!diffAudioFile.empty() && (diffAudioFile[0] == ' ' || diffAudioFile[0] == '\t'))
-                            diffAudioFile.erase(0, 1);
-                        while (!diffAudioFile.empty() && (diffAudioFile.back() == '\r' || diffAudioFile.back() == '\n'))
-                            diffAudioFile.pop_back();
-                    } else if (diffLine.find("PreviewTime:") == 0) {
-                        std::string val = diffLine.substr(12);
-                        while (!val.empty() && val[0] == ' ') val.erase(0, 1);
-                        try { diff.previewTime = std::stoi(val); } catch (...) {}
-                    } else if (diffLine.find("[Events]") == 0) {
-                        // Found Events section, look for background
-                        while (std::getline(diffFile, diffLine)) {
-                            if (diffLine.empty() || diffLine[0] == '/' || diffLine[0] == ' ') continue;
-                            if (diffLine[0] == '[') break;  // Next section
-                            // Background line: 0,0,"filename",0,0
-                            if (diffLine.find("0,0,\"") == 0) {
-                                size_t start = diffLine.find("\"") + 1;
-                                size_t end = diffLine.find("\"", start);
-                                if (end != std::string::npos) {
-                                    diffBgFile = diffLine.substr(start, end - start);
-                                    // Skip video files
-                                    std::string bgExt = diffBgFile.substr(diffBgFile.find_last_of(".") + 1);
-                                    std::transform(bgExt.begin(), bgExt.end(), bgExt.begin(), ::tolower);
-                                    if (bgExt == "mp4" || bgExt == "avi" || bgExt == "flv") {
-                                        diffBgFile.clear();
-                                    }
+        if (ext == ".osu") {
+            song.source = BeatmapSource::Osu;
+
+            // Parse difficulty info from .osu file
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.keyCount = 4;  // Default
+            int osuMode = -1;  // -1 = not found
+            std::string diffBgFile;
+            std::string diffAudioFile;
+            std::ifstream diffFile(file.path().string());
+            std::string diffLine;
+            while (std::getline(diffFile, diffLine)) {
+                if (diffLine.find("Mode:") == 0) {
+                    std::string val = diffLine.substr(5);
+                    while (!val.empty() && val[0] == ' ') val.erase(0, 1);
+                    try { osuMode = std::stoi(val); } catch (...) {}
+                } else if (diffLine.find("Version:") == 0) {
+                    diff.version = diffLine.substr(8);
+                    while (!diff.version.empty() && diff.version[0] == ' ')
+                        diff.version.erase(0, 1);
+                } else if (diffLine.find("Creator:") == 0) {
+                    diff.creator = diffLine.substr(8);
+                    while (!diff.creator.empty() && diff.creator[0] == ' ')
+                        diff.creator.erase(0, 1);
+                } else if (diffLine.find("CircleSize:") == 0) {
+                    std::string val = diffLine.substr(11);
+                    while (!val.empty() && val[0] == ' ') val.erase(0, 1);
+                    try { diff.keyCount = std::stoi(val); } catch (...) {}
+                } else if (diffLine.find("AudioFilename:") == 0) {
+                    diffAudioFile = diffLine.substr(14);
+                    while (!diffAudioFile.empty() && (diffAudioFile[0] == ' ' || diffAudioFile[0] == '\t'))
+                        diffAudioFile.erase(0, 1);
+                    while (!diffAudioFile.empty() && (diffAudioFile.back() == '\r' || diffAudioFile.back() == '\n'))
+                        diffAudioFile.pop_back();
+                } else if (diffLine.find("PreviewTime:") == 0) {
+                    std::string val = diffLine.substr(12);
+                    while (!val.empty() && val[0] == ' ') val.erase(0, 1);
+                    try { diff.previewTime = std::stoi(val); } catch (...) {}
+                } else if (diffLine.find("[Events]") == 0) {
+                    // Found Events section, look for background
+                    while (std::getline(diffFile, diffLine)) {
+                        if (diffLine.empty() || diffLine[0] == '/' || diffLine[0] == ' ') continue;
+                        if (diffLine[0] == '[') break;  // Next section
+                        // Background line: 0,0,"filename",0,0
+                        if (diffLine.find("0,0,\"") == 0) {
+                            size_t start = diffLine.find("\"") + 1;
+                            size_t end = diffLine.find("\"", start);
+                            if (end != std::string::npos) {
+                                diffBgFile = diffLine.substr(start, end - start);
+                                // Skip video files
+                                std::string bgExt = diffBgFile.substr(diffBgFile.find_last_of(".") + 1);
+                                std::transform(bgExt.begin(), bgExt.end(), bgExt.begin(), ::tolower);
+                                if (bgExt == "mp4" || bgExt == "avi" || bgExt == "flv") {
+                                    diffBgFile.clear();
                                 }
-                                break;
                             }
+                            break;
                         }
-                        break;  // Stop after Events section
-                    } else if (diffLine.find("[Editor]") == 0 || diffLine.find("[Metadata]") == 0) {
-                        // Continue to next section
-                    } else if (diffLine.find("[Difficulty]") == 0) {
-                        // Continue reading
                     }
+                    break;  // Stop after Events section
+                } else if (diffLine.find("[Editor]") == 0 || diffLine.find("[Metadata]") == 0) {
+                    // Continue to next section
+                } else if (diffLine.find("[Difficulty]") == 0) {
+                    // Continue reading
                 }
+            }
 
-                // Skip non-mania .osu files (Mode 0=std, 1=taiko, 2=catch, 3=mania)
-                if (osuMode != 3 && osuMode != -1) {
-                    continue;
-                }
-
-                // Skip invalid key counts (0K causes division by zero, >10K unsupported)
-                if (diff.keyCount <= 0 || diff.keyCount > 18) {
-                    continue;
-                }
-
-                // Set per-difficulty background and audio paths
-                if (!diffBgFile.empty()) {
-                    diff.backgroundPath = song.folderPath + "/" + diffBgFile;
-                }
-                if (!diffAudioFile.empty()) {
-                    diff.audioPath = song.folderPath + "/" + diffAudioFile;
-                }
-
-                // Calculate star ratings for all versions
-                BeatmapInfo tempInfo;
-                if (OsuParser::parse(diff.path, tempInfo)) {
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-                }
-
-                // Calculate MD5 hash
-                diff.hash = OsuParser::calculateMD5(diff.path);
-
-                // Add both together to keep them in sync
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".bytes") {
-                song.source = BeatmapSource::DJMaxRespect;
-
-                // Parse difficulty info from filename
-                DifficultyInfo diff;
-                diff.path = file.path().string();
-                std::string fname = file.path().filename().string();
-                std::string lower = fname;
-                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-
-                // Extract key count
-                if (lower.find("_8b_") != std::string::npos) diff.keyCount = 8;
-                else if (lower.find("_6b_") != std::string::npos) diff.keyCount = 6;
-                else if (lower.find("_5b_") != std::string::npos) diff.keyCount = 5;
-                else if (lower.find("_4b_") != std::string::npos) diff.keyCount = 4;
-                else diff.keyCount = 4;
-
-                // Extract difficulty name
-                if (lower.find("_sc") != std::string::npos) diff.version = "SC";
-                else if (lower.find("_mx") != std::string::npos) diff.version = "Maximum";
-                else if (lower.find("_hd") != std::string::npos) diff.version = "Hard";
-                else if (lower.find("_nm") != std::string::npos) diff.version = "Normal";
-                else diff.version = "Normal";
-
-                // Calculate star ratings for all versions
-                BeatmapInfo tempInfo;
-                if (DJMaxParser::parse(diff.path, tempInfo)) {
-                    diff.keyCount = tempInfo.keyCount;  // Use parser's key count (includes analog tracks)
-                    diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-                }
-
-                // Add both together to keep them in sync
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".ojn") {
-                // O2Jam: one file contains 3 difficulties (Easy, Normal, Hard)
-                // Get level info from header
-                OjnHeader header;
-                std::string ojnPath = file.path().string();
-                std::string creator;
-                if (OjnParser::getHeader(ojnPath, header)) {
-                    creator = std::string(header.noter, strnlen(header.noter, 32));
-
-                    // Calculate star ratings and extract metadata for each difficulty
-                    DifficultyInfo diffEasy, diffNormal, diffHard;
-                    diffEasy.keyCount = 7;
-                    diffNormal.keyCount = 7;
-                    diffHard.keyCount = 7;
+            // Skip non-mania .osu files (Mode 0=std, 1=taiko, 2=catch, 3=mania)
+            if (osuMode != 3 && osuMode != -1) {
+                continue;
+            }
 
-                    BeatmapInfo tempInfo;
-                    if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Easy)) {
-                        diffEasy.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                        diffEasy.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                        extractDiffMetadata(diffEasy, tempInfo);
-                    }
-                    if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Normal)) {
-                        diffNormal.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                        diffNormal.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                        extractDiffMetadata(diffNormal, tempInfo);
-                    }
-                    if (OjnParser::parse(ojnPath, tempInfo, OjnDifficulty::Hard)) {
-                        diffHard.starRatings[0] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20260101);
-                        diffHard.starRatings[1] = calculateStarRating(tempInfo.notes, 7, StarRatingVersion::OsuStable_b20220101);
-                        extractDiffMetadata(diffHard, tempInfo);
-                    }
+            // Skip invalid key counts (0K causes division by zero, >10K unsupported)
+            if (diff.keyCount <= 0 || diff.keyCount > 18) {
+                continue;
+            }
 
-                    // Build paths
-                    std::string pathEasy = ojnPath + ":0:" + std::to_string(header.level[0]);
-                    std::string pathNormal = ojnPath + ":1:" + std::to_string(header.level[1]);
-                    std::string pathHard = ojnPath + ":2:" + std::to_string(header.level[2]);
-
-                    // Set remaining fields
-                    diffEasy.path = pathEasy;
-                    diffEasy.version = "Easy Lv." + std::to_string(header.level[0]);
-                    diffEasy.creator = creator;
-                    diffEasy.hash = OsuParser::calculateMD5(ojnPath) + ":0";
-
-                    diffNormal.path = pathNormal;
-                    diffNormal.version = "Normal Lv." + std::to_string(header.level[1]);
-                    diffNormal.creator = creator;
-                    diffNormal.hash = OsuParser::calculateMD5(ojnPath) + ":1";
-
-                    diffHard.path = pathHard;
-                    diffHard.version = "Hard Lv." + std::to_string(header.level[2]);
-                    diffHard.creator = creator;
-                    diffHard.hash = OsuParser::calculateMD5(ojnPath) + ":2";
-
-                    // Add beatmapFiles and difficulties together
-                    song.beatmapFiles.push_back(pathEasy);
-                    song.difficulties.push_back(diffEasy);
-                    song.beatmapFiles.push_back(pathNormal);
-                    song.difficulties.push_back(diffNormal);
-                    song.beatmapFiles.push_back(pathHard);
-                    song.difficulties.push_back(diffHard);
-                } else {
-                    std::string ojnHash = OsuParser::calculateMD5(ojnPath);
-                    std::string p0 = ojnPath + ":0:0";
-                    std::string p1 = ojnPath + ":1:0";
-                    std::string p2 = ojnPath + ":2:0";
-                    DifficultyInfo d1; d1.path = p0; d1.version = "Easy"; d1.keyCount = 7; d1.hash = ojnHash + ":0";
-                    DifficultyInfo d2; d2.path = p1; d2.version = "Normal"; d2.keyCount = 7; d2.hash = ojnHash + ":1";
-                    DifficultyInfo d3; d3.path = p2; d3.version = "Hard"; d3.keyCount = 7; d3.hash = ojnHash + ":2";
-                    song.beatmapFiles.push_back(p0);
-                    song.difficulties.push_back(d1);
-                    song.beatmapFiles.push_back(p1);
-                    song.difficulties.push_back(d2);
-                    song.beatmapFiles.push_back(p2);
-                    song.difficulties.push_back(d3);
-                }
-                song.source = BeatmapSource::O2Jam;
-            } else if (ext == ".pt") {
-                song.source = BeatmapSource::DJMaxOnline;  // DJMAX Online PT files
+            // Set per-difficulty background and audio paths
+            if (!diffBgFile.empty()) {
+                diff.backgroundPath = song.folderPath + "/" + diffBgFile;
+            }
+            if (!diffAudioFile.empty()) {
+                diff.audioPath = song.folderPath + "/" + diffAudioFile;
+            }
 
-                // Parse difficulty info from filename
-                DifficultyInfo diff;
-                diff.path = file.path().string();
-                std::string fname = file.path().filename().string();
-                std::string lower = fname;
-                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            // Calculate star ratings for all versions
+            BeatmapInfo tempInfo;
+            if (OsuParser::parse(diff.path, tempInfo)) {
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            }
 
-                // Detect key count from filename or auto-detect
-                if (lower.find("_7k") != std::string::npos || lower.find("7k_") != std::string::npos ||
-                    lower.find("_7b") != std::string::npos || lower.find("7b_") != std::string::npos) {
-                    diff.keyCount = 7;
-                } else if (lower.find("_5k") != std::string::npos || lower.find("5k_") != std::string::npos ||
-                           lower.find("_5b") != std::string::npos || lower.find("5b_") != std::string::npos) {
-                    diff.keyCount = 5;
-                } else {
-                    diff.keyCount = 5;  // Default to 5K
-                }
-
-                // Extract difficulty name
-                // Simplified format: fire_5kez2.pt, fire_5knm5.pt, fire_5kMX.pt
-                // No suffix (e.g., fire_5k.pt) = Hard difficulty
-                diff.version = "Hard";  // Default
-
-                // First try standard format
-                if (lower.find("_hd_") != std::string::npos || lower.find("_hard") != std::string::npos) {
-                    diff.version = "Hard";
-                } else if (lower.find("_nm_") != std::string::npos || lower.find("_normal") != std::string::npos) {
-                    diff.version = "Normal";
-                } else if (lower.find("_ez_") != std::string::npos || lower.find("_easy") != std::string::npos) {
-                    diff.version = "Easy";
-                } else if (lower.find("_mx_") != std::string::npos || lower.find("_max") != std::string::npos) {
-                    diff.version = "Maximum";
-                } else if (lower.find("_sc_") != std::string::npos || lower.find("_sc.") != std::string::npos) {
-                    diff.version = "SC";
-                } else {
-                    // Try simplified format: extract difficulty after _5k or _7k
-                    size_t kpos = lower.find("_5k");
-                    if (kpos == std::string::npos) kpos = lower.find("_7k");
-                    if (kpos != std::string::npos && kpos + 3 < lower.length()) {
-                        std::string suffix = lower.substr(kpos + 3);
-                        if (suffix.find("hd") == 0) diff.version = "Hard";
-                        else if (suffix.find("mx") == 0) diff.version = "Maximum";
-                        else if (suffix.find("sc") == 0) diff.version = "SC";
-                        else if (suffix.find("nm") == 0) diff.version = "Normal";
-                        else if (suffix.find("ez") == 0) diff.version = "Easy";
-                    }
-                }
+            // Calculate MD5 hash
+            diff.hash = OsuParser::calculateMD5(diff.path);
 
-                // Calculate star ratings
-                BeatmapInfo tempInfo;
-                if (PTParser::parse(diff.path, tempInfo)) {
-                    diff.keyCount = tempInfo.keyCount;  // Use detected key count
-                    diff.hash = OsuParser::calculateMD5(diff.path);  // Calculate hash for replay matching
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-                }
-
-                // Set background image path for DJMAX Online
-                // Format: song/{songname}/eyecatch/{songname}_{diff}.jpg or {songname}_ORG_{diff}.jpg
-                {
-                    // Track extracted PAKs - each PAK only extracted once
-                    static std::unordered_map<std::string, bool> extractedPaks;
-
-                    // Extract song name from PT filename (e.g., "baramlive_5kez2.pt" -> "baramlive")
-                    std::string stem = file.path().stem().string();
-                    size_t underscorePos = stem.find('_');
-                    if (underscorePos != std::string::npos) {
-                        std::string songName = stem.substr(0, underscorePos);
-
-                        // Find PAK file
-                        fs::path pakPath = file.path().parent_path() / (songName + ".pak");
-                        std::string pakKey = pakPath.string();
-                        // Use Data/DJMaxBG instead of Data/Tmp to persist across restarts
-                        fs::path tempDir = fs::current_path() / "Data" / "BG" / pakPath.stem().string();
-
-                        // Extract all eyecatch images from PAK only once
-                        if (fs::exists(pakPath) && extractedPaks.find(pakKey) == extractedPaks.end()) {
-                            extractedPaks[pakKey] = true;  // Mark as processed
-                            SDL_Log("[PAK BG] Processing: %s", pakPath.string().c_str());
-
-                            static PakExtractor bgPakExtractor;
-                            static bool bgKeysLoaded = false;
-                            if (!bgKeysLoaded) {
-                                bgKeysLoaded = bgPakExtractor.loadKeys();
-                                SDL_Log("[PAK BG] Keys loaded: %d", bgKeysLoaded);
-                            }
-                            if (bgKeysLoaded && bgPakExtractor.open(pakPath.string())) {
-                                SDL_Log("[PAK BG] Opened, files: %zu", bgPakExtractor.getFileList().size());
-                                // Print first 5 filenames to see structure
-                                int printed = 0;
-                                for (const auto& pakFile : bgPakExtractor.getFileList()) {
-                                    if (printed < 5) {
-                                        SDL_Log("[PAK BG] File: %s", pakFile.filename.c_str());
-                                        printed++;
-                                    }
+            // Add both together to keep them in sync
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".bytes") {
+            song.source = BeatmapSource::DJMaxRespect;
+
+            // Parse difficulty info from filename
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            std::string fname = file.path().filename().string();
+            std::string lower = fname;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+            // Extract key count
+            if (lower.find("_8b_") != std::string::npos) diff.keyCount = 8;
+            else if (lower.find("_6b_") != std::string::npos) diff.keyCount = 6;
+            else if (lower.find("_5b_") != std::string::npos) diff.keyCount = 5;
+            else if (lower.find("_4b_") != std::string::npos) diff.keyCount = 4;
+            else diff.keyCount = 4;
+
+            // Extract difficulty name
+            if (lower.find("_sc") != std::string::npos) diff.version = "SC";
+            else if (lower.find("_mx") != std::string::npos) diff.version = "Maximum";
+            else if (lower.find("_hd") != std::string::npos) diff.version = "Hard";
+            else if (lower.find("_nm") != std::string::npos) diff.version = "Normal";
+            else diff.version = "Normal";
+
+            // Calculate star ratings for all versions
+            BeatmapInfo tempInfo;
+            if (DJMaxParser::parse(diff.path, tempInfo)) {
+                diff.keyCount = tempInfo.keyCount;  // Use parser's key count (includes analog tracks)
+                diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            }
+
+            // Add both together to keep them in sync
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".ojn") {
+            // O2Jam: one file contains 3 difficulties (Easy, Normal, Hard)
+            OjnHeader header;
+            addOjnDifficulties(file.path().string(), song, header);
+            song.source = BeatmapSource::O2Jam;
+        } else if (ext == ".pt") {
+            song.source = BeatmapSource::DJMaxOnline;  // DJMAX Online PT files
+
+            // Parse difficulty info from filename
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            std::string fname = file.path().filename().string();
+            std::string lower = fname;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+            // Detect key count from filename or auto-detect
+            if (lower.find("_7k") != std::string::npos || lower.find("7k_") != std::string::npos ||
+                lower.find("_7b") != std::string::npos || lower.find("7b_") != std::string::npos) {
+                diff.keyCount = 7;
+            } else if (lower.find("_5k") != std::string::npos || lower.find("5k_") != std::string::npos ||
+                       lower.find("_5b") != std::string::npos || lower.find("5b_") != std::string::npos) {
+                diff.keyCount = 5;
+            } else {
+                diff.keyCount = 5;  // Default to 5K
+            }
+
+            // Extract difficulty name
+            // Simplified format: fire_5kez2.pt, fire_5knm5.pt, fire_5kMX.pt
+            // No suffix (e.g., fire_5k.pt) = Hard difficulty
+            diff.version = "Hard";  // Default
+
+            // First try standard format
+            if (lower.find("_hd_") != std::string::npos || lower.find("_hard") != std::string::npos) {
+                diff.version = "Hard";
+            } else if (lower.find("_nm_") != std::string::npos || lower.find("_normal") != std::string::npos) {
+                diff.version = "Normal";
+            } else if (lower.find("_ez_") != std::string::npos || lower.find("_easy") != std::string::npos) {
+                diff.version = "Easy";
+            } else if (lower.find("_mx_") != std::string::npos || lower.find("_max") != std::string::npos) {
+                diff.version = "Maximum";
+            } else if (lower.find("_sc_") != std::string::npos || lower.find("_sc.") != std::string::npos) {
+                diff.version = "SC";
+            } else {
+                // Try simplified format: extract difficulty after _5k or _7k
+                size_t kpos = lower.find("_5k");
+                if (kpos == std::string::npos) kpos = lower.find("_7k");
+                if (kpos != std::string::npos && kpos + 3 < lower.length()) {
+                    std::string suffix = lower.substr(kpos + 3);
+                    if (suffix.find("hd") == 0) diff.version = "Hard";
+                    else if (suffix.find("mx") == 0) diff.version = "Maximum";
+                    else if (suffix.find("sc") == 0) diff.version = "SC";
+                    else if (suffix.find("nm") == 0) diff.version = "Normal";
+                    else if (suffix.find("ez") == 0) diff.version = "Easy";
+                }
+            }
+
+            // Calculate star ratings
+            BeatmapInfo tempInfo;
+            if (PTParser::parse(diff.path, tempInfo)) {
+                diff.keyCount = tempInfo.keyCount;  // Use detected key count
+                diff.hash = OsuParser::calculateMD5(diff.path);  // Calculate hash for replay matching
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            }
+
+            // Set background image path for DJMAX Online
+            // Format: song/{songname}/eyecatch/{songname}_{diff}.jpg or {songname}_ORG_{diff}.jpg
+            {
+                // Track extracted PAKs - each PAK only extracted once, shared by the scan workers
+                static std::mutex extractedPaksMutex;
+                static std::unordered_set<std::string> extractedPaks;
+
+                // Extract song name from PT filename (e.g., "baramlive_5kez2.pt" -> "baramlive")
+                std::string stem = file.path().stem().string();
+                size_t underscorePos = stem.find('_');
+                if (underscorePos != std::string::npos) {
+                    std::string songName = stem.substr(0, underscorePos);
+
+                    // Find PAK file
+                    fs::path pakPath = file.path().parent_path() / (songName + ".pak");
+                    std::string pakKey = pakPath.string();
+                    // Use Data/DJMaxBG instead of Data/Tmp to persist across restarts
+                    fs::path tempDir = fs::current_path() / "Data" / "BG" / pakPath.stem().string();
+
+                    // Extract all eyecatch images from PAK only once. The charts of one PAK share
+                    // this folder, so the task that claims it extracts before their lookups below.
+                    bool claimed = false;
+                    if (fs::exists(pakPath)) {
+                        std::lock_guard<std::mutex> lock(extractedPaksMutex);
+                        claimed = extractedPaks.insert(pakKey).second;
+                    }
+                    if (claimed) {
+                        SDL_Log("[PAK BG] Processing: %s", pakPath.string().c_str());
+
+                        PakExtractor bgPakExtractor;  // Per task: workers extract different PAKs at once
+                        bool bgKeysLoaded = bgPakExtractor.loadKeys();
+                        if (!bgKeysLoaded) SDL_Log("[PAK BG] Keys not loaded");
+                        if (bgKeysLoaded && bgPakExtractor.open(pakPath.string())) {
+                            SDL_Log("[PAK BG] Opened, files: %zu", bgPakExtractor.getFileList().size());
+                            // Print first 5 filenames to see structure
+                            int printed = 0;
+                            for (const auto& pakFile : bgPakExtractor.getFileList()) {
+                                if (printed < 5) {
+                                    SDL_Log("[PAK BG] File: %s", pakFile.filename.c_str());
+                                    printed++;
                                 }
-                                int eyecatchCount = 0;
-                                for (const auto& pakFile : bgPakExtractor.getFileList()) {
-                                    // Case-insensitive check for eyecatch
-                                    std::string lowerName = pakFile.filename;
-                                    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-                                    if (lowerName.find("/eyecatch/") != std::string::npos ||
-                                        lowerName.find("\\eyecatch\\") != std::string::npos) {
-                                        eyecatchCount++;
-                                        std::string ext = fs::path(pakFile.filename).extension().string();
-                                        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                                        if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
-                                            fs::path outPath = tempDir / pakFile.filename;
-                                            if (!fs::exists(outPath)) {
-                                                std::vector<uint8_t> data;
-                                                if (bgPakExtractor.extractFile(pakFile.filename, data)) {
-                                                    fs::create_directories(outPath.parent_path());
-                                                    std::ofstream out(outPath, std::ios::binary);
-                                                    if (out) {
-                                                        out.write(reinterpret_cast<char*>(data.data()), data.size());
-                                                    }
+                            }
+                            int eyecatchCount = 0;
+                            for (const auto& pakFile : bgPakExtractor.getFileList()) {
+                                // Case-insensitive check for eyecatch
+                                std::string lowerName = pakFile.filename;
+                                std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+                                if (lowerName.find("/eyecatch/") != std::string::npos ||
+                                    lowerName.find("\\eyecatch\\") != std::string::npos) {
+                                    eyecatchCount++;
+                                    std::string ext = fs::path(pakFile.filename).extension().string();
+                                    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                                    if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
+                                        fs::path outPath = tempDir / pakFile.filename;
+                                        if (!fs::exists(outPath)) {
+                                            std::vector<uint8_t> data;
+                                            if (bgPakExtractor.extractFile(pakFile.filename, data)) {
+                                                fs::create_directories(outPath.parent_path());
+                                                std::ofstream out(outPath, std::ios::binary);
+                                                if (out) {
+                                                    out.write(reinterpret_cast<char*>(data.data()), data.size());
                                                 }
                                             }
                                         }
                                     }
                                 }
-                                SDL_Log("[PAK BG] Found %d eyecatch files", eyecatchCount);
-                                bgPakExtractor.close();
                             }
-                        }
-
-                        // Map difficulty version to suffix
-                        std::string diffSuffix = "hd";
-                        if (diff.version == "Easy") diffSuffix = "ez";
-                        else if (diff.version == "Normal") diffSuffix = "nm";
-                        else if (diff.version == "Hard") diffSuffix = "hd";
-                        else if (diff.version == "Maximum") diffSuffix = "mx";
-                        else if (diff.version == "SC") diffSuffix = "sc";
-
-                        // Check for extracted file
-                        fs::path outPath1 = tempDir / "song" / songName / "eyecatch" / (songName + "_" + diffSuffix + ".jpg");
-                        fs::path outPath2 = tempDir / "song" / songName / "eyecatch" / (songName + "_ORG_" + diffSuffix + ".jpg");
-                        if (fs::exists(outPath1)) {
-                            diff.backgroundPath = outPath1.string();
-                        } else if (fs::exists(outPath2)) {
-                            diff.backgroundPath = outPath2.string();
+                            SDL_Log("[PAK BG] Found %d eyecatch files", eyecatchCount);
+                            bgPakExtractor.close();
                         }
                     }
-                }
 
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".bms" || ext == ".bme" || ext == ".bml" || ext == ".pms") {
-                song.source = BeatmapSource::BMS;
-
-                DifficultyInfo diff;
-                diff.path = file.path().string();
-                diff.keyCount = 7;  // Default, will be updated after parsing
+                    // Map difficulty version to suffix
+                    std::string diffSuffix = "hd";
+                    if (diff.version == "Easy") diffSuffix = "ez";
+                    else if (diff.version == "Normal") diffSuffix = "nm";
+                    else if (diff.version == "Hard") diffSuffix = "hd";
+                    else if (diff.version == "Maximum") diffSuffix = "mx";
+                    else if (diff.version == "SC") diffSuffix = "sc";
 
-                // Parse BMS to get metadata and key count
-                BeatmapInfo tempInfo;
-                if (BMSParser::parse(diff.path, tempInfo)) {
-                    diff.keyCount = tempInfo.keyCount;
-                    diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
-                    // For BMS: version = TITLE + ARTIST + Lv.X
-                    std::string diffName = tempInfo.title;
-                    if (!tempInfo.artist.empty()) {
-                        diffName += " " + tempInfo.artist;
-                    }
-                    if (!tempInfo.version.empty()) {
-                        diffName += " " + tempInfo.version;  // Append "Lv.X"
+                    // Check for extracted file
+                    fs::path outPath1 = tempDir / "song" / songName / "eyecatch" / (songName + "_" + diffSuffix + ".jpg");
+                    fs::path outPath2 = tempDir / "song" / songName / "eyecatch" / (songName + "_ORG_" + diffSuffix + ".jpg");
+                    if (fs::exists(outPath1)) {
+                        diff.backgroundPath = outPath1.string();
+                    } else if (fs::exists(outPath2)) {
+                        diff.backgroundPath = outPath2.string();
                     }
-                    diff.version = diffName.empty() ? file.path().stem().string() : diffName;
-                    diff.creator = tempInfo.creator;  // SUBARTIST as charter
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-                } else {
-                    diff.version = file.path().stem().string();
-                }
-
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".1") {
-                // beatmania IIDX chart file
-                song.source = BeatmapSource::IIDX;
-
-                // Extract song ID from filename (e.g., "32083.1" -> 32083)
-                std::string stem = file.path().stem().string();
-                int songId = 0;
-                try {
-                    songId = std::stoi(stem);
-                } catch (...) {
-                    songId = 0;
-                }
-
-                // Look up song info from database
-                static auto iidxDB = getIIDXSongDB();
-                auto it = iidxDB.find(songId);
-                if (it != iidxDB.end()) {
-                    song.title = it->second.title;
-                    song.artist = it->second.artist;
-                } else {
-                    song.title = stem;
-                    song.artist = "Unknown";
                 }
+            }
 
-                try {
-                    std::cout << "[IIDX] Scanning: " << file.path().string() << std::endl;
-                    auto availDiffs = IIDXParser::getAvailableDifficulties(file.path().string());
-                    std::cout << "[IIDX] Found " << availDiffs.size() << " difficulties" << std::endl;
-                    std::string iidxFileHash = OsuParser::calculateMD5(file.path().string());
-
-                    for (int diffIdx : availDiffs) {
-                        DifficultyInfo diff;
-                        diff.path = file.path().string();
-                        diff.keyCount = (diffIdx >= 5) ? 16 : 8;  // DP = 16, SP = 8
-                        diff.version = IIDXParser::getDifficultyName(diffIdx);
-                        diff.hash = iidxFileHash + ":" + std::to_string(diffIdx);  // Hash with difficulty index
-
-                        std::cout << "[IIDX] Parsing difficulty: " << diff.version << std::endl;
-
-                        // Parse to get note count for star rating
-                        BeatmapInfo tempInfo;
-                        if (IIDXParser::parse(diff.path, tempInfo, diffIdx)) {
-                            std::cout << "[IIDX] Calculating star rating..." << std::endl;
-                            diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                                StarRatingVersion::OsuStable_b20260101);
-                            diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                                StarRatingVersion::OsuStable_b20220101);
-                            extractDiffMetadata(diff, tempInfo);
-                            std::cout << "[IIDX] Star rating done" << std::endl;
-                        }
-
-                        song.beatmapFiles.push_back(diff.path);
-                        song.difficulties.push_back(diff);
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "[IIDX] Exception: " << e.what() << std::endl;
-                    continue;
-                } catch (...) {
-                    std::cerr << "[IIDX] Unknown exception" << std::endl;
-                    continue;
-                }
-            } else if (ext == ".mc") {
-                // Malody chart - only Key mode (mode=0) is supported
-                BeatmapInfo tempInfo;
-                if (!MalodyParser::parse(file.path().string(), tempInfo)) {
-                    // Unsupported mode (catch, ring, etc.) - skip this file
-                    continue;
-                }
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".bms" || ext == ".bme" || ext == ".bml" || ext == ".pms") {
+            song.source = BeatmapSource::BMS;
 
-                song.source = BeatmapSource::Malody;
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.keyCount = 7;  // Default, will be updated after parsing
 
-                DifficultyInfo diff;
-                diff.path = file.path().string();
+            // Parse BMS to get metadata and key count
+            BeatmapInfo tempInfo;
+            if (BMSParser::parse(diff.path, tempInfo)) {
                 diff.keyCount = tempInfo.keyCount;
-                diff.version = tempInfo.version.empty() ? file.path().stem().string() : tempInfo.version;
-                diff.creator = tempInfo.creator;
-                diff.hash = tempInfo.beatmapHash;
-                diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                    StarRatingVersion::OsuStable_b20260101);
-                diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                    StarRatingVersion::OsuStable_b20220101);
-                extractDiffMetadata(diff, tempInfo);
+                diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
+                // For BMS: version = TITLE + ARTIST + Lv.X
+                std::string diffName = tempInfo.title;
+                if (!tempInfo.artist.empty()) {
+                    diffName += " " + tempInfo.artist;
+                }
+                if (!tempInfo.version.empty()) {
+                    diffName += " " + tempInfo.version;  // Append "Lv.X"
+                }
+                diff.version = diffName.empty() ? file.path().stem().string() : diffName;
+                diff.creator = tempInfo.creator;  // SUBARTIST as charter
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            } else {
+                diff.version = file.path().stem().string();
+            }
 
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".txt") {
-                // MUSYNX chart - check for 4T or 6T in filename
-                std::string fname = file.path().filename().string();
-                if (fname.find("2T") != std::string::npos || fname.find("4T") != std::string::npos || fname.find("6T") != std::string::npos) {
-                    song.source = BeatmapSource::MuSynx;
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".1") {
+            // beatmania IIDX chart file
+            song.source = BeatmapSource::IIDX;
+
+            // Extract song ID from filename (e.g., "32083.1" -> 32083)
+            std::string stem = file.path().stem().string();
+            int songId = 0;
+            try {
+                songId = std::stoi(stem);
+            } catch (...) {
+                songId = 0;
+            }
+
+            // Look up song info from database
+            static auto iidxDB = getIIDXSongDB();
+            auto it = iidxDB.find(songId);
+            if (it != iidxDB.end()) {
+                song.title = it->second.title;
+                song.artist = it->second.artist;
+            } else {
+                song.title = stem;
+                song.artist = "Unknown";
+            }
+
+            try {
+                std::cout << "[IIDX] Scanning: " << file.path().string() << std::endl;
+                auto availDiffs = IIDXParser::getAvailableDifficulties(file.path().string());
+                std::cout << "[IIDX] Found " << availDiffs.size() << " difficulties" << std::endl;
+                std::string iidxFileHash = OsuParser::calculateMD5(file.path().string());
 
+                for (int diffIdx : availDiffs) {
                     DifficultyInfo diff;
                     diff.path = file.path().string();
-                    diff.keyCount = MuSynxParser::getKeyCountFromFilename(fname);
+                    diff.keyCount = (diffIdx >= 5) ? 16 : 8;  // DP = 16, SP = 8
+                    diff.version = IIDXParser::getDifficultyName(diffIdx);
+                    diff.hash = iidxFileHash + ":" + std::to_string(diffIdx);  // Hash with difficulty index
 
-                    // Extract difficulty from filename
-                    std::string lower = fname;
-                    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-                    if (lower.find("_easy") != std::string::npos) diff.version = "Easy";
-                    else if (lower.find("_hard") != std::string::npos) diff.version = "Hard";
-                    else if (lower.find("_in") != std::string::npos) diff.version = "Inferno";
-                    else diff.version = "Normal";
+                    std::cout << "[IIDX] Parsing difficulty: " << diff.version << std::endl;
 
-                    // Parse to get star rating
+                    // Parse to get note count for star rating
                     BeatmapInfo tempInfo;
-                    if (MuSynxParser::parse(diff.path, tempInfo)) {
-                        diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
-                        diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                            StarRatingVersion::OsuStable_b20260101);
-                        diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                            StarRatingVersion::OsuStable_b20220101);
-                        extractDiffMetadata(diff, tempInfo);
+                    if (IIDXParser::parse(diff.path, tempInfo, diffIdx)) {
+                        std::cout << "[IIDX] Calculating star rating..." << std::endl;
+                        analyzeDiff(diff, tempInfo, diff.keyCount);
+                        std::cout << "[IIDX] Star rating done" << std::endl;
                     }
 
                     song.beatmapFiles.push_back(diff.path);
                     song.difficulties.push_back(diff);
                 }
-            } else if (ext == ".sm" || ext == ".ssc") {
-                // StepMania chart - prefer .ssc over .sm if both exist
-                if (ext == ".sm") {
-                    // Check if .ssc version exists, skip .sm if so
-                    fs::path sscPath = file.path();
-                    sscPath.replace_extension(".ssc");
-                    if (fs::exists(sscPath)) continue;
-                }
-
-                song.source = BeatmapSource::StepMania;
+            } catch (const std::exception& e) {
+                std::cerr << "[IIDX] Exception: " << e.what() << std::endl;
+                continue;
+            } catch (...) {
+                std::cerr << "[IIDX] Unknown exception" << std::endl;
+                continue;
+            }
+        } else if (ext == ".mc") {
+            // Malody chart - only Key mode (mode=0) is supported
+            BeatmapInfo tempInfo;
+            if (!MalodyParser::parse(file.path().string(), tempInfo)) {
+                // Unsupported mode (catch, ring, etc.) - skip this file
+                continue;
+            }
 
-                auto smDiffs = StepManiaParser::getDifficulties(file.path().string());
-                for (size_t i = 0; i < smDiffs.size(); i++) {
-                    const auto& smDiff = smDiffs[i];
-                    DifficultyInfo diff;
-                    diff.path = file.path().string();
-                    diff.keyCount = smDiff.keyCount;
-                    diff.version = smDiff.stepsType + " " + smDiff.difficulty;
-                    diff.hash = OsuParser::calculateMD5(diff.path) + ":" + std::to_string(i);
+            song.source = BeatmapSource::Malody;
 
-                    BeatmapInfo tempInfo;
-                    if (StepManiaParser::parse(diff.path, tempInfo, (int)i)) {
-                        diff.creator = tempInfo.creator;
-                        diff.previewTime = tempInfo.previewTime;
-                        diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                            StarRatingVersion::OsuStable_b20260101);
-                        diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                            StarRatingVersion::OsuStable_b20220101);
-                        extractDiffMetadata(diff, tempInfo);
-                    }
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.keyCount = tempInfo.keyCount;
+            diff.version = tempInfo.version.empty() ? file.path().stem().string() : tempInfo.version;
+            diff.creator = tempInfo.creator;
+            diff.hash = tempInfo.beatmapHash;
+            analyzeDiff(diff, tempInfo, diff.keyCount);
 
-                    song.beatmapFiles.push_back(diff.path);
-                    song.difficulties.push_back(diff);
-                }
-            } else if (ext == ".vox") {
-                // Sound Voltex chart
-                song.source = BeatmapSource::SDVX;
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".txt") {
+            // MUSYNX chart - check for 4T or 6T in filename
+            std::string fname = file.path().filename().string();
+            if (fname.find("2T") != std::string::npos || fname.find("4T") != std::string::npos || fname.find("6T") != std::string::npos) {
+                song.source = BeatmapSource::MuSynx;
 
                 DifficultyInfo diff;
                 diff.path = file.path().string();
-                diff.keyCount = 6;
-                diff.version = VoxParser::getDifficultyName(file.path().filename().string());
-                // Append level from SongDB (e.g. "NOV" -> "NOV 5")
-                {
-                    int songId = VoxParser::getSongIdFromPath(diff.path);
-                    static auto sdvxDB = getSDVXSongDB();
-                    auto dbIt = sdvxDB.find(songId);
-                    if (dbIt != sdvxDB.end()) {
-                        int level = 0;
-                        if (diff.version == "NOV") level = dbIt->second.nov;
-                        else if (diff.version == "ADV") level = dbIt->second.adv;
-                        else if (diff.version == "EXH") level = dbIt->second.exh;
-                        else if (diff.version == "MXM") level = dbIt->second.mxm;
-                        else {
-                            // 4th difficulty (_4i): name depends on infVer
-                            level = dbIt->second.inf;
-                            switch (dbIt->second.infVer) {
-                                case 2: diff.version = "INF"; break;
-                                case 3: diff.version = "GRV"; break;
-                                case 4: diff.version = "HVN"; break;
-                                case 5: diff.version = "VVD"; break;
-                                case 6: diff.version = "XCD"; break;
-                                default: break;
-                            }
-                        }
-                        if (level > 0) diff.version += " " + std::to_string(level);
-                    }
-                }
-                diff.hash = OsuParser::calculateMD5(diff.path);
+                diff.keyCount = MuSynxParser::getKeyCountFromFilename(fname);
+
+                // Extract difficulty from filename
+                std::string lower = fname;
+                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                if (lower.find("_easy") != std::string::npos) diff.version = "Easy";
+                else if (lower.find("_hard") != std::string::npos) diff.version = "Hard";
+                else if (lower.find("_in") != std::string::npos) diff.version = "Inferno";
+                else diff.version = "Normal";
 
+                // Parse to get star rating
                 BeatmapInfo tempInfo;
-                if (VoxParser::parse(diff.path, tempInfo)) {
-                    diff.creator = tempInfo.creator;
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
+                if (MuSynxParser::parse(diff.path, tempInfo)) {
+                    diff.hash = OsuParser::calculateMD5(diff.path);  // Hash for replay matching
+                    analyzeDiff(diff, tempInfo, diff.keyCount);
                 }
 
                 song.beatmapFiles.push_back(diff.path);
                 song.difficulties.push_back(diff);
-            } else if (ext == ".ez") {
-                // EZ2AC chart
-                EZ2ACMode ezMode = EZ2ACParser::detectMode(file.path().string());
-                if (ezMode == EZ2ACMode::Catch ||
-                    ezMode == EZ2ACMode::Unknown)
-                    continue;
+            }
+        } else if (ext == ".sm" || ext == ".ssc") {
+            // StepMania chart - prefer .ssc over .sm if both exist
+            if (ext == ".sm") {
+                // Check if .ssc version exists, skip .sm if so
+                fs::path sscPath = file.path();
+                sscPath.replace_extension(".ssc");
+                if (fs::exists(sscPath)) continue;
+            }
 
-                song.source = BeatmapSource::EZ2AC;
+            song.source = BeatmapSource::StepMania;
 
+            auto smDiffs = StepManiaParser::getDifficulties(file.path().string());
+            for (size_t i = 0; i < smDiffs.size(); i++) {
+                const auto& smDiff = smDiffs[i];
                 DifficultyInfo diff;
                 diff.path = file.path().string();
-                diff.keyCount = EZ2ACParser::modeKeyCount(ezMode);
-                diff.version = EZ2ACParser::modeName(ezMode);
-                diff.hash = OsuParser::calculateMD5(diff.path);
+                diff.keyCount = smDiff.keyCount;
+                diff.version = smDiff.stepsType + " " + smDiff.difficulty;
+                diff.hash = OsuParser::calculateMD5(diff.path) + ":" + std::to_string(i);
 
-                // Look up SongDB for level and BPM
-                float songDbBpm = 0;
-                {
-                    static auto ez2acDB = getEZ2ACSongDB();
-                    std::string folderName = fs::path(diff.path).parent_path().filename().string();
-                    auto dbIt = ez2acDB.find(folderName);
-                    if (dbIt != ez2acDB.end()) {
-                        songDbBpm = dbIt->second.bpm;
-                        // Map EZ2ACMode to SongDB mode index
-                        int modeIdx = -1;
-                        switch (ezMode) {
-                            case EZ2ACMode::FiveKey:        modeIdx = 0; break;
-                            case EZ2ACMode::StreetMix:      modeIdx = 1; break;
-                            case EZ2ACMode::SevenStreetMix: modeIdx = 2; break;
-                            case EZ2ACMode::ClubMix:        modeIdx = 3; break;
-                            case EZ2ACMode::SpaceMix:       modeIdx = 4; break;
-                            case EZ2ACMode::Catch:          modeIdx = 5; break;
-                            case EZ2ACMode::RubyMix:        modeIdx = 6; break;
-                            case EZ2ACMode::ScratchMix:     modeIdx = 7; break;
+                BeatmapInfo tempInfo;
+                if (StepManiaParser::parse(diff.path, tempInfo, (int)i)) {
+                    diff.creator = tempInfo.creator;
+                    diff.previewTime = tempInfo.previewTime;
+                    analyzeDiff(diff, tempInfo, diff.keyCount);
+                }
+
+                song.beatmapFiles.push_back(diff.path);
+                song.difficulties.push_back(diff);
+            }
+        } else if (ext == ".vox") {
+            // Sound Voltex chart
+            song.source = BeatmapSource::SDVX;
+
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.keyCount = 6;
+            diff.version = VoxParser::getDifficultyName(file.path().filename().string());
+            // Append level from SongDB (e.g. "NOV" -> "NOV 5")
+            {
+                int songId = VoxParser::getSongIdFromPath(diff.path);
+                static auto sdvxDB = getSDVXSongDB();
+                auto dbIt = sdvxDB.find(songId);
+                if (dbIt != sdvxDB.end()) {
+                    int level = 0;
+                    if (diff.version == "NOV") level = dbIt->second.nov;
+                    else if (diff.version == "ADV") level = dbIt->second.adv;
+                    else if (diff.version == "EXH") level = dbIt->second.exh;
+                    else if (diff.version == "MXM") level = dbIt->second.mxm;
+                    else {
+                        // 4th difficulty (_4i): name depends on infVer
+                        level = dbIt->second.inf;
+                        switch (dbIt->second.infVer) {
+                            case 2: diff.version = "INF"; break;
+                            case 3: diff.version = "GRV"; break;
+                            case 4: diff.version = "HVN"; break;
+                            case 5: diff.version = "VVD"; break;
+                            case 6: diff.version = "XCD"; break;
                             default: break;
                         }
-                        if (modeIdx >= 0) {
-                            // Detect difficulty slot from filename suffix
-                            std::string stem = fs::path(diff.path).stem().string();
-                            std::string stemLower = stem;
-                            std::transform(stemLower.begin(), stemLower.end(), stemLower.begin(), ::tolower);
-                            int diffSlot = 0; // default = EZ
-                            if (stemLower.length() >= 4 && stemLower.substr(stemLower.length() - 4) == "-shd")
-                                diffSlot = 2; // HD
-                            else if (stemLower.length() >= 3 && stemLower.substr(stemLower.length() - 3) == "-hd")
-                                diffSlot = 1; // NM
-
-                            int level = dbIt->second.levels[modeIdx][diffSlot];
-                            if (level > 0)
-                                diff.version += " Lv." + std::to_string(level);
-                        }
                     }
+                    if (level > 0) diff.version += " " + std::to_string(level);
                 }
+            }
+            diff.hash = OsuParser::calculateMD5(diff.path);
 
-                BeatmapInfo tempInfo;
-                if (EZ2ACParser::parse(diff.path, tempInfo)) {
-                    diff.creator = tempInfo.creator;
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-                }
+            BeatmapInfo tempInfo;
+            if (VoxParser::parse(diff.path, tempInfo)) {
+                diff.creator = tempInfo.creator;
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            }
 
-                // SongDB BPM as fallback if timing points didn't provide one
-                if (diff.bpmMost == 0 && songDbBpm > 0) {
-                    diff.bpmMin = songDbBpm;
-                    diff.bpmMax = songDbBpm;
-                    diff.bpmMost = songDbBpm;
-                }
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".ez") {
+            // EZ2AC chart
+            EZ2ACMode ezMode = EZ2ACParser::detectMode(file.path().string());
+            if (ezMode == EZ2ACMode::Catch ||
+                ezMode == EZ2ACMode::Unknown)
+                continue;
 
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
-            } else if (ext == ".ezi") {
-                // EZ2ON REBOOT:R chart
-                if (!EZ2ONParser::isEZ2ONFile(file.path().string()))
-                    continue;
+            song.source = BeatmapSource::EZ2AC;
+
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.keyCount = EZ2ACParser::modeKeyCount(ezMode);
+            diff.version = EZ2ACParser::modeName(ezMode);
+            diff.hash = OsuParser::calculateMD5(diff.path);
+
+            // Look up SongDB for level and BPM
+            float songDbBpm = 0;
+            {
+                static auto ez2acDB = getEZ2ACSongDB();
+                std::string folderName = fs::path(diff.path).parent_path().filename().string();
+                auto dbIt = ez2acDB.find(folderName);
+                if (dbIt != ez2acDB.end()) {
+                    songDbBpm = dbIt->second.bpm;
+                    // Map EZ2ACMode to SongDB mode index
+                    int modeIdx = -1;
+                    switch (ezMode) {
+                        case EZ2ACMode::FiveKey:        modeIdx = 0; break;
+                        case EZ2ACMode::StreetMix:      modeIdx = 1; break;
+                        case EZ2ACMode::SevenStreetMix: modeIdx = 2; break;
+                        case EZ2ACMode::ClubMix:        modeIdx = 3; break;
+                        case EZ2ACMode::SpaceMix:       modeIdx = 4; break;
+                        case EZ2ACMode::Catch:          modeIdx = 5; break;
+                        case EZ2ACMode::RubyMix:        modeIdx = 6; break;
+                        case EZ2ACMode::ScratchMix:     modeIdx = 7; break;
+                        default: break;
+                    }
+                    if (modeIdx >= 0) {
+                        // Detect difficulty slot from filename suffix
+                        std::string stem = fs::path(diff.path).stem().string();
+                        std::string stemLower = stem;
+                        std::transform(stemLower.begin(), stemLower.end(), stemLower.begin(), ::tolower);
+                        int diffSlot = 0; // default = EZ
+                        if (stemLower.length() >= 4 && stemLower.substr(stemLower.length() - 4) == "-shd")
+                            diffSlot = 2; // HD
+                        else if (stemLower.length() >= 3 && stemLower.substr(stemLower.length() - 3) == "-hd")
+                            diffSlot = 1; // NM
+
+                        int level = dbIt->second.levels[modeIdx][diffSlot];
+                        if (level > 0)
+                            diff.version += " Lv." + std::to_string(level);
+                    }
+                }
+            }
+
+            BeatmapInfo tempInfo;
+            if (EZ2ACParser::parse(diff.path, tempInfo)) {
+                diff.creator = tempInfo.creator;
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+            }
 
-                song.source = BeatmapSource::EZ2ON;
+            // SongDB BPM as fallback if timing points didn't provide one
+            if (diff.bpmMost == 0 && songDbBpm > 0) {
+                diff.bpmMin = songDbBpm;
+                diff.bpmMax = songDbBpm;
+                diff.bpmMost = songDbBpm;
+            }
 
-                DifficultyInfo diff;
-                diff.path = file.path().string();
-                diff.hash = OsuParser::calculateMD5(diff.path);
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
+        } else if (ext == ".ezi") {
+            // EZ2ON REBOOT:R chart
+            if (!EZ2ONParser::isEZ2ONFile(file.path().string()))
+                continue;
 
-                BeatmapInfo tempInfo;
-                if (EZ2ONParser::parse(diff.path, tempInfo)) {
-                    diff.keyCount = tempInfo.keyCount;
-                    diff.version = tempInfo.version;
-                    diff.creator = tempInfo.creator;
-                    diff.starRatings[0] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20260101);
-                    diff.starRatings[1] = calculateStarRating(tempInfo.notes, diff.keyCount,
-                        StarRatingVersion::OsuStable_b20220101);
-                    extractDiffMetadata(diff, tempInfo);
-
-                    // Look up EZ2ON SongDB for difficulty level
-                    std::string ez2onFolder = fs::path(diff.path).parent_path().filename().string();
-                    const EZ2ONSongEntry* ez2onSong = ez2onFindByFolderName(ez2onFolder);
-                    if (ez2onSong) {
-                        // Determine difficulty index: first try from version string, then by note count
-                        int diffIdx = -1;
-                        if (diff.version.find("SHD") != std::string::npos) diffIdx = 3;
-                        else if (diff.version.find("HD") != std::string::npos) diffIdx = 2;
-                        else if (diff.version.find("NM") != std::string::npos) diffIdx = 1;
-                        else if (diff.version.find("EZ") != std::string::npos) diffIdx = 0;
-
-                        if (diffIdx < 0) {
-                            // Fallback: match by note count
-                            diffIdx = ez2onMatchDifficulty(ez2onSong, diff.keyCount,
-                                                           (int)tempInfo.notes.size());
-                            if (diffIdx >= 0) {
-                                static const char* diffNames[] = {"EZ", "NM", "HD", "SHD"};
-                                diff.version += " " + std::string(diffNames[diffIdx]);
-                            }
-                        }
+            song.source = BeatmapSource::EZ2ON;
 
+            DifficultyInfo diff;
+            diff.path = file.path().string();
+            diff.hash = OsuParser::calculateMD5(diff.path);
+
+            BeatmapInfo tempInfo;
+            if (EZ2ONParser::parse(diff.path, tempInfo)) {
+                diff.keyCount = tempInfo.keyCount;
+                diff.version = tempInfo.version;
+                diff.creator = tempInfo.creator;
+                analyzeDiff(diff, tempInfo, diff.keyCount);
+
+                // Look up EZ2ON SongDB for difficulty level
+                std::string ez2onFolder = fs::path(diff.path).parent_path().filename().string();
+                const EZ2ONSongEntry* ez2onSong = ez2onFindByFolderName(ez2onFolder);
+                if (ez2onSong) {
+                    // Determine difficulty index: first try from version string, then by note count
+                    int diffIdx = -1;
+                    if (diff.version.find("SHD") != std::string::npos) diffIdx = 3;
+                    else if (diff.version.find("HD") != std::string::npos) diffIdx = 2;
+                    else if (diff.version.find("NM") != std::string::npos) diffIdx = 1;
+                    else if (diff.version.find("EZ") != std::string::npos) diffIdx = 0;
+
+                    if (diffIdx < 0) {
+                        // Fallback: match by note count
+                        diffIdx = ez2onMatchDifficulty(ez2onSong, diff.keyCount,
+                                                       (int)tempInfo.notes.size());
                         if (diffIdx >= 0) {
-                            int slot = ez2onDiffSlot(diff.keyCount, diffIdx);
-                            if (slot >= 0 && ez2onSong->levels[slot] > 0) {
-                                char lvBuf[16];
-                                snprintf(lvBuf, sizeof(lvBuf), " Lv.%d", ez2onSong->levels[slot] / 10);
-                                diff.version += lvBuf;
-                            }
+                            static const char* diffNames[] = {"EZ", "NM", "HD", "SHD"};
+                            diff.version += " " + std::string(diffNames[diffIdx]);
                         }
+                    }
 
-                        diff.creator = ez2onSong->composer;
+                    if (diffIdx >= 0) {
+                        int slot = ez2onDiffSlot(diff.keyCount, diffIdx);
+                        if (slot >= 0 && ez2onSong->levels[slot] > 0) {
+                            char lvBuf[16];
+                            snprintf(lvBuf, sizeof(lvBuf), " Lv.%d", ez2onSong->levels[slot] / 10);
+                            diff.version += lvBuf;
+                        }
                     }
-                }
 
-                song.beatmapFiles.push_back(diff.path);
-                song.difficulties.push_back(diff);
+                    diff.creator = ez2onSong->composer;
+                }
             }
-        }
 
-        if (song.beatmapFiles.empty()) {
-            scanProgress++;
-            continue;
+            song.beatmapFiles.push_back(diff.path);
+            song.difficulties.push_back(diff);
         }
+    }
 
-        // Read metadata from first beatmap file
-        std::string firstFile = song.beatmapFiles[0];
-        if (song.source == BeatmapSource::Osu) {
-            std::ifstream ifs(firstFile);
-            std::string line;
-            std::string bgFile;
-            std::string audioFile;
-            song.previewTime = 0;
-            while (std::getline(ifs, line)) {
-                if (line.find("Title:") == 0) {
-                    song.title = line.substr(6);
-                } else if (line.find("TitleUnicode:") == 0) {
-                    song.titleUnicode = line.substr(13);
-                } else if (line.find("Artist:") == 0) {
-                    song.artist = line.substr(7);
-                } else if (line.find("ArtistUnicode:") == 0) {
-                    song.artistUnicode = line.substr(14);
-                } else if (line.find("Source:") == 0) {
-                    song.sourceText = line.substr(7);
-                } else if (line.find("Tags:") == 0) {
-                    song.tags = line.substr(5);
-                } else if (line.find("AudioFilename:") == 0) {
-                    audioFile = line.substr(14);
-                    // Trim whitespace and \r\n
-                    while (!audioFile.empty() && (audioFile[0] == ' ' || audioFile[0] == '\t')) audioFile.erase(0, 1);
-                    while (!audioFile.empty() && (audioFile.back() == '\r' || audioFile.back() == '\n')) audioFile.pop_back();
-                } else if (line.find("PreviewTime:") == 0) {
-                    std::string val = line.substr(12);
-                    while (!val.empty() && val[0] == ' ') val.erase(0, 1);
-                    song.previewTime = std::stoi(val);
-                } else if (line.find("[Events]") == 0) {
-                    // Found Events section, look for background
-                    while (std::getline(ifs, line)) {
-                        if (line.empty() || line[0] == '/' || line[0] == ' ') continue;
-                        if (line[0] == '[') break;  // Next section
-                        // Background line: 0,0,"filename",0,0
-                        if (line.find("0,0,\"") == 0) {
-                            size_t start = line.find("\"") + 1;
-                            size_t end = line.find("\"", start);
-                            if (end != std::string::npos) {
-                                bgFile = line.substr(start, end - start);
-                                // Skip video files
-                                std::string ext = bgFile.substr(bgFile.find_last_of(".") + 1);
-                                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                                if (ext == "mp4" || ext == "avi" || ext == "flv") {
-                                    bgFile.clear();
-                                }
+    if (song.beatmapFiles.empty()) {
+        return;
+    }
+
+    // Read metadata from first beatmap file
+    std::string firstFile = song.beatmapFiles[0];
+    if (song.source == BeatmapSource::Osu) {
+        std::ifstream ifs(firstFile);
+        std::string line;
+        std::string bgFile;
+        std::string audioFile;
+        song.previewTime = 0;
+        while (std::getline(ifs, line)) {
+            if (line.find("Title:") == 0) {
+                song.title = line.substr(6);
+            } else if (line.find("TitleUnicode:") == 0) {
+                song.titleUnicode = line.substr(13);
+            } else if (line.find("Artist:") == 0) {
+                song.artist = line.substr(7);
+            } else if (line.find("ArtistUnicode:") == 0) {
+                song.artistUnicode = line.substr(14);
+            } else if (line.find("Source:") == 0) {
+                song.sourceText = line.substr(7);
+            } else if (line.find("Tags:") == 0) {
+                song.tags = line.substr(5);
+            } else if (line.find("AudioFilename:") == 0) {
+                audioFile = line.substr(14);
+                // Trim whitespace and \r\n
+                while (!audioFile.empty() && (audioFile[0] == ' ' || audioFile[0] == '\t')) audioFile.erase(0, 1);
+                while (!audioFile.empty() && (audioFile.back() == '\r' || audioFile.back() == '\n')) audioFile.pop_back();
+            } else if (line.find("PreviewTime:") == 0) {
+                std::string val = line.substr(12);
+                while (!val.empty() && val[0] == ' ') val.erase(0, 1);
+                song.previewTime = std::stoi(val);
+            } else if (line.find("[Events]") == 0) {
+                // Found Events section, look for background
+                while (std::getline(ifs, line)) {
+                    if (line.empty() || line[0] == '/' || line[0] == ' ') continue;
+                    if (line[0] == '[') break;  // Next section
+                    // Background line: 0,0,"filename",0,0
+                    if (line.find("0,0,\"") == 0) {
+                        size_t start = line.find("\"") + 1;
+                        size_t end = line.find("\"", start);
+                        if (end != std::string::npos) {
+                            bgFile = line.substr(start, end - start);
+                            // Skip video files
+                            std::string ext = bgFile.substr(bgFile.find_last_of(".") + 1);
+                            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                            if (ext == "mp4" || ext == "avi" || ext == "flv") {
+                                bgFile.clear();
                             }
-                            break;
-                        }
-                    }
-                }
-            }
-            if (!bgFile.empty()) {
-                song.backgroundPath = song.folderPath + "/" + bgFile;
-            }
-            if (!audioFile.empty()) {
-                song.audioPath = song.folderPath + "/" + audioFile;
-            }
-        } else if (song.source == BeatmapSource::O2Jam) {
-            // Extract actual OJN path (remove :difficulty:level suffix)
-            std::string ojnPath = firstFile;
-            size_t colonPos = ojnPath.rfind(':');
-            if (colonPos != std::string::npos && colonPos > 2) {
-                size_t colonPos2 = ojnPath.rfind(':', colonPos - 1);
-                if (colonPos2 != std::string::npos && colonPos2 > 2) {
-                    ojnPath = ojnPath.substr(0, colonPos2);
-                }
-            }
-            OjnHeader header;
-            if (OjnParser::getHeader(ojnPath, header)) {
-                song.title = std::string(header.title, strnlen(header.title, 64));
-                song.artist = std::string(header.artist, strnlen(header.artist, 32));
-            }
-            // Extract cover image
-            song.backgroundPath = OjnParser::extractCover(ojnPath);
-            // Skip generatePreview during scan (too expensive), generate on-demand
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::DJMaxRespect || song.source == BeatmapSource::DJMaxOnline) {
-            BeatmapInfo info;
-            // Check if it's a PT file or DJMAX bytes file
-            bool parsed = false;
-            if (PTParser::isPTFile(firstFile)) {
-                parsed = PTParser::parse(firstFile, info);
-            } else {
-                parsed = DJMaxParser::parse(firstFile, info);
-            }
-            if (parsed) {
-                song.title = info.title;
-                song.artist = info.artist;
-                // Look up DMRVSongDB for proper display title/artist
-                if (song.source == BeatmapSource::DJMaxRespect) {
-                    const auto* dbSong = DMRVSongDB::findByNameId(info.title);
-                    if (dbSong) {
-                        song.title = dbSong->title;
-                        song.artist = dbSong->artist;
-                    }
-                }
-            }
-            // DJMAX: preview audio is "songname.wav" (without "0-" prefix)
-            // Extract song name from filename (e.g., "songname_4b_nm.bytes" -> "songname")
-            fs::path chartPath(firstFile);
-            std::string chartName = chartPath.stem().string();
-            size_t underscorePos = chartName.find('_');
-            if (underscorePos != std::string::npos) {
-                std::string songName = chartName.substr(0, underscorePos);
-                // Look for songname.wav/ogg/mp3, fallback to 0-songname.wav/ogg/mp3
-                for (const auto& prefix : {"", "0-"}) {
-                    for (const auto& ext : {".wav", ".ogg", ".mp3"}) {
-                        fs::path audioPath = folderPath / (prefix + songName + ext);
-                        if (fs::exists(audioPath)) {
-                            song.audioPath = audioPath.string();
-                            break;
                         }
+                        break;
                     }
-                    if (!song.audioPath.empty()) break;
-                }
-            }
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::BMS) {
-            // For BMS, find the most common title and artist across all difficulties
-            std::unordered_map<std::string, int> titleCounts;
-            std::unordered_map<std::string, int> artistCounts;
-            for (const auto& diff : song.difficulties) {
-                BeatmapInfo info;
-                if (BMSParser::parse(diff.path, info)) {
-                    if (!info.title.empty()) titleCounts[info.title]++;
-                    if (!info.artist.empty()) artistCounts[info.artist]++;
                 }
             }
-            // Find most common title
-            int maxCount = 0;
-            for (const auto& [title, count] : titleCounts) {
-                if (count > maxCount) {
-                    maxCount = count;
-                    song.title = title;
-                }
+        }
+        if (!bgFile.empty()) {
+            song.backgroundPath = song.folderPath + "/" + bgFile;
+        }
+        if (!audioFile.empty()) {
+            song.audioPath = song.folderPath + "/" + audioFile;
+        }
+    } else if (song.source == BeatmapSource::O2Jam) {
+        // Extract actual OJN path (remove :difficulty:level suffix)
+        std::string ojnPath = firstFile;
+        size_t colonPos = ojnPath.rfind(':');
+        if (colonPos != std::string::npos && colonPos > 2) {
+            size_t colonPos2 = ojnPath.rfind(':', colonPos - 1);
+            if (colonPos2 != std::string::npos && colonPos2 > 2) {
+                ojnPath = ojnPath.substr(0, colonPos2);
             }
-            // Find most common artist
-            maxCount = 0;
-            for (const auto& [artist, count] : artistCounts) {
-                if (count > maxCount) {
-                    maxCount = count;
-                    song.artist = artist;
+        }
+        OjnHeader header;
+        if (OjnParser::getHeader(ojnPath, header)) {
+            song.title = std::string(header.title, strnlen(header.title, 64));
+            song.artist = std::string(header.artist, strnlen(header.artist, 32));
+        }
+        // Extract cover image
+        song.backgroundPath = OjnParser::extractCover(ojnPath);
+        // Skip generatePreview during scan (too expensive), generate on-demand
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::DJMaxRespect || song.source == BeatmapSource::DJMaxOnline) {
+        BeatmapInfo info;
+        // Check if it's a PT file or DJMAX bytes file
+        bool parsed = false;
+        if (PTParser::isPTFile(firstFile)) {
+            parsed = PTParser::parse(firstFile, info);
+        } else {
+            parsed = DJMaxParser::parse(firstFile, info);
+        }
+        if (parsed) {
+            song.title = info.title;
+            song.artist = info.artist;
+            // Look up DMRVSongDB for proper display title/artist
+            if (song.source == BeatmapSource::DJMaxRespect) {
+                const auto* dbSong = DMRVSongDB::findByNameId(info.title);
+                if (dbSong) {
+                    song.title = dbSong->title;
+                    song.artist = dbSong->artist;
                 }
             }
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::Malody) {
-            BeatmapInfo info;
-            if (MalodyParser::parse(firstFile, info)) {
-                song.title = info.title;
-                song.artist = info.artist;
-                // Get background and audio from the same directory as the .mc file
-                fs::path mcPath(firstFile);
-                fs::path mcDir = mcPath.parent_path();
-                // Look for background image
-                for (const auto& f : fs::directory_iterator(mcDir)) {
-                    if (!f.is_regular_file()) continue;
-                    std::string ext = f.path().extension().string();
-                    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                    if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
-                        song.backgroundPath = f.path().string();
+        }
+        // DJMAX: preview audio is "songname.wav" (without "0-" prefix)
+        // Extract song name from filename (e.g., "songname_4b_nm.bytes" -> "songname")
+        fs::path chartPath(firstFile);
+        std::string chartName = chartPath.stem().string();
+        size_t underscorePos = chartName.find('_');
+        if (underscorePos != std::string::npos) {
+            std::string songName = chartName.substr(0, underscorePos);
+            // Look for songname.wav/ogg/mp3, fallback to 0-songname.wav/ogg/mp3
+            for (const auto& prefix : {"", "0-"}) {
+                for (const auto& ext : {".wav", ".ogg", ".mp3"}) {
+                    fs::path audioPath = folderPath / (prefix + songName + ext);
+                    if (fs::exists(audioPath)) {
+                        song.audioPath = audioPath.string();
                         break;
                     }
                 }
-                // Audio path from beatmap
-                if (!info.audioFilename.empty()) {
-                    song.audioPath = (mcDir / info.audioFilename).string();
-                }
+                if (!song.audioPath.empty()) break;
             }
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::MuSynx) {
+        }
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::BMS) {
+        // For BMS, find the most common title and artist across all difficulties
+        std::unordered_map<std::string, int> titleCounts;
+        std::unordered_map<std::string, int> artistCounts;
+        for (const auto& diff : song.difficulties) {
             BeatmapInfo info;
-            if (MuSynxParser::parse(firstFile, info)) {
-                song.title = info.title;
-                song.artist = info.artist;
+            if (BMSParser::parse(diff.path, info)) {
+                if (!info.title.empty()) titleCounts[info.title]++;
+                if (!info.artist.empty()) artistCounts[info.artist]++;
             }
-            // Look for audio file in folder
-            for (const auto& f : fs::directory_iterator(folderPath)) {
-                if (!f.is_regular_file()) continue;
-                std::string ext = f.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                if (ext == ".ogg" || ext == ".mp3" || ext == ".wav") {
-                    song.audioPath = f.path().string();
-                    break;
-                }
+        }
+        // Find most common title
+        int maxCount = 0;
+        for (const auto& [title, count] : titleCounts) {
+            if (count > maxCount) {
+                maxCount = count;
+                song.title = title;
+            }
+        }
+        // Find most common artist
+        maxCount = 0;
+        for (const auto& [artist, count] : artistCounts) {
+            if (count > maxCount) {
+                maxCount = count;
+                song.artist = artist;
             }
+        }
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::Malody) {
+        BeatmapInfo info;
+        if (MalodyParser::parse(firstFile, info)) {
+            song.title = info.title;
+            song.artist = info.artist;
+            // Get background and audio from the same directory as the .mc file
+            fs::path mcPath(firstFile);
+            fs::path mcDir = mcPath.parent_path();
             // Look for background image
-            for (const auto& f : fs::directory_iterator(folderPath)) {
+            for (const auto& f : fs::directory_iterator(mcDir)) {
                 if (!f.is_regular_file()) continue;
                 std::string ext = f.path().extension().string();
                 std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
@@ -8783,268 +8585,424 @@ void Game::scanSongsFolder() {
                     break;
                 }
             }
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::StepMania) {
-            BeatmapInfo info;
-            if (StepManiaParser::parse(firstFile, info)) {
-                song.title = info.title;
-                song.artist = info.artist;
-                song.previewTime = info.previewTime;
-                // Get audio path
-                if (!info.audioFilename.empty()) {
-                    fs::path smDir = fs::path(firstFile).parent_path();
-                    song.audioPath = (smDir / info.audioFilename).string();
-                }
+            // Audio path from beatmap
+            if (!info.audioFilename.empty()) {
+                song.audioPath = (mcDir / info.audioFilename).string();
             }
-            // Look for background image
-            fs::path smDir = fs::path(firstFile).parent_path();
-            for (const auto& f : fs::directory_iterator(smDir)) {
-                if (!f.is_regular_file()) continue;
-                std::string fname = f.path().filename().string();
-                std::string ext = f.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                // Prefer files with "bg" or "background" in name
-                if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
-                    std::string lower = fname;
-                    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-                    if (lower.find("bg") != std::string::npos || lower.find("background") != std::string::npos) {
-                        song.backgroundPath = f.path().string();
-                        break;
-                    }
-                    if (song.backgroundPath.empty()) {
-                        song.backgroundPath = f.path().string();
-                    }
-                }
+        }
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::MuSynx) {
+        BeatmapInfo info;
+        if (MuSynxParser::parse(firstFile, info)) {
+            song.title = info.title;
+            song.artist = info.artist;
+        }
+        // Look for audio file in folder
+        for (const auto& f : fs::directory_iterator(folderPath)) {
+            if (!f.is_regular_file()) continue;
+            std::string ext = f.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".ogg" || ext == ".mp3" || ext == ".wav") {
+                song.audioPath = f.path().string();
+                break;
             }
-            if (song.previewTime <= 0) {
-                song.previewTime = -1;  // 40% position fallback
+        }
+        // Look for background image
+        for (const auto& f : fs::directory_iterator(folderPath)) {
+            if (!f.is_regular_file()) continue;
+            std::string ext = f.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
+                song.backgroundPath = f.path().string();
+                break;
             }
-        } else if (song.source == BeatmapSource::SDVX) {
-            BeatmapInfo info;
-            if (VoxParser::parse(firstFile, info)) {
-                song.title = info.title;
-                song.artist = info.artist;
-            }
-            // Audio: {folder}/{folder}.s3v
-            fs::path voxDir = fs::path(firstFile).parent_path();
-            std::string folderName2 = voxDir.filename().string();
-            fs::path audioFile = voxDir / (folderName2 + ".s3v");
-            if (fs::exists(audioFile)) {
-                song.audioPath = audioFile.string();
-            }
-            // Jacket image: jk_{id}_1_b.png
-            for (const auto& f : fs::directory_iterator(voxDir)) {
-                if (!f.is_regular_file()) continue;
-                std::string fname = f.path().filename().string();
-                if (fname.find("jk_") == 0 && fname.find("_1_b.") != std::string::npos) {
+        }
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::StepMania) {
+        BeatmapInfo info;
+        if (StepManiaParser::parse(firstFile, info)) {
+            song.title = info.title;
+            song.artist = info.artist;
+            song.previewTime = info.previewTime;
+            // Get audio path
+            if (!info.audioFilename.empty()) {
+                fs::path smDir = fs::path(firstFile).parent_path();
+                song.audioPath = (smDir / info.audioFilename).string();
+            }
+        }
+        // Look for background image
+        fs::path smDir = fs::path(firstFile).parent_path();
+        for (const auto& f : fs::directory_iterator(smDir)) {
+            if (!f.is_regular_file()) continue;
+            std::string fname = f.path().filename().string();
+            std::string ext = f.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            // Prefer files with "bg" or "background" in name
+            if (ext == ".jpg" || ext == ".png" || ext == ".jpeg") {
+                std::string lower = fname;
+                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                if (lower.find("bg") != std::string::npos || lower.find("background") != std::string::npos) {
                     song.backgroundPath = f.path().string();
                     break;
                 }
-            }
-            song.previewTime = -1;  // 40% position
-        } else if (song.source == BeatmapSource::EZ2AC) {
-            // EZ2AC has no text-based song titles (only bitmap images in songname/)
-            // EZFF header contains chart filename, not song title — use folder name
-            song.title = song.folderName;
-            song.artist = "EZ2AC";
-            // EZ2AC is keysound-only, no separate audio file
-            // Look for background image in song folder
-            fs::path ezDir = fs::path(firstFile).parent_path();
-            for (const auto& f : fs::directory_iterator(ezDir)) {
-                if (!f.is_regular_file()) continue;
-                std::string ext = f.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                if (ext == ".jpg" || ext == ".png" || ext == ".jpeg" || ext == ".bmp") {
+                if (song.backgroundPath.empty()) {
                     song.backgroundPath = f.path().string();
-                    break;
                 }
             }
-            song.previewTime = -1;
-        } else if (song.source == BeatmapSource::EZ2ON) {
-            // Look up EZ2ON SongDB for proper display title/artist
-            const EZ2ONSongEntry* ez2onSong = ez2onFindByFolderName(song.folderName);
-            if (ez2onSong) {
-                song.title = ez2onSong->displayName;
-                song.artist = ez2onSong->composer;
-            } else {
-                song.title = song.folderName;
-                song.artist = "EZ2ON";
+        }
+        if (song.previewTime <= 0) {
+            song.previewTime = -1;  // 40% position fallback
+        }
+    } else if (song.source == BeatmapSource::SDVX) {
+        BeatmapInfo info;
+        if (VoxParser::parse(firstFile, info)) {
+            song.title = info.title;
+            song.artist = info.artist;
+        }
+        // Audio: {folder}/{folder}.s3v
+        fs::path voxDir = fs::path(firstFile).parent_path();
+        std::string folderName2 = voxDir.filename().string();
+        fs::path audioFile = voxDir / (folderName2 + ".s3v");
+        if (fs::exists(audioFile)) {
+            song.audioPath = audioFile.string();
+        }
+        // Jacket image: jk_{id}_1_b.png
+        for (const auto& f : fs::directory_iterator(voxDir)) {
+            if (!f.is_regular_file()) continue;
+            std::string fname = f.path().filename().string();
+            if (fname.find("jk_") == 0 && fname.find("_1_b.") != std::string::npos) {
+                song.backgroundPath = f.path().string();
+                break;
             }
-            // Look for background image
-            fs::path ez2onDir = fs::path(firstFile).parent_path();
-            for (const auto& f : fs::directory_iterator(ez2onDir)) {
-                if (!f.is_regular_file()) continue;
-                std::string ext = f.path().extension().string();
-                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                if (ext == ".jpg" || ext == ".png" || ext == ".jpeg" || ext == ".bmp") {
-                    song.backgroundPath = f.path().string();
-                    break;
-                }
+        }
+        song.previewTime = -1;  // 40% position
+    } else if (song.source == BeatmapSource::EZ2AC) {
+        // EZ2AC has no text-based song titles (only bitmap images in songname/)
+        // EZFF header contains chart filename, not song title — use folder name
+        song.title = song.folderName;
+        song.artist = "EZ2AC";
+        // EZ2AC is keysound-only, no separate audio file
+        // Look for background image in song folder
+        fs::path ezDir = fs::path(firstFile).parent_path();
+        for (const auto& f : fs::directory_iterator(ezDir)) {
+            if (!f.is_regular_file()) continue;
+            std::string ext = f.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".jpg" || ext == ".png" || ext == ".jpeg" || ext == ".bmp") {
+                song.backgroundPath = f.path().string();
+                break;
             }
-            song.previewTime = -1;
         }
-
-        if (song.title.empty()) {
+        song.previewTime = -1;
+    } else if (song.source == BeatmapSource::EZ2ON) {
+        // Look up EZ2ON SongDB for proper display title/artist
+        const EZ2ONSongEntry* ez2onSong = ez2onFindByFolderName(song.folderName);
+        if (ez2onSong) {
+            song.title = ez2onSong->displayName;
+            song.artist = ez2onSong->composer;
+        } else {
             song.title = song.folderName;
+            song.artist = "EZ2ON";
+        }
+        // Look for background image
+        fs::path ez2onDir = fs::path(firstFile).parent_path();
+        for (const auto& f : fs::directory_iterator(ez2onDir)) {
+            if (!f.is_regular_file()) continue;
+            std::string ext = f.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".jpg" || ext == ".png" || ext == ".jpeg" || ext == ".bmp") {
+                song.backgroundPath = f.path().string();
+                break;
+            }
         }
+        song.previewTime = -1;
+    }
+
+    if (song.title.empty()) {
+        song.title = song.folderName;
+    }
+
+    // Save to index cache
+    cached = CachedSong();
+    cached.folderPath = song.folderPath;
+    cached.folderName = song.folderName;
+    cached.title = song.title;
+    cached.titleUnicode = song.titleUnicode;
+    cached.artist = song.artist;
+    cached.artistUnicode = song.artistUnicode;
+    cached.backgroundPath = song.backgroundPath;
+    cached.audioPath = song.audioPath;
+    cached.sourceText = song.sourceText;
+    cached.tags = song.tags;
+    cached.previewTime = song.previewTime;
+    cached.source = static_cast<int>(song.source);
+    cached.lastModified = SongIndex::getFolderModTime(song.folderPath);
+    song.dateAdded = cached.lastModified;
+    std::unordered_map<std::string, int> fileIndices;
+    for (size_t i = 0; i < fingerprints.size(); i++) {
+        // Newly parsed charts get a content hash so a later touch without edits is recognized
+        if (fingerprints[i].contentHash.empty()) fingerprints[i].contentHash = OsuParser::calculateMD5(fingerprints[i].path);
+        fileIndices[fingerprints[i].path] = (int)i;
+    }
+    cached.files = std::move(fingerprints);
+    for (const auto& d : song.difficulties) {
+        CachedDifficulty cd;
+        cd.path = d.path;
+        cd.version = d.version;
+        cd.creator = d.creator;
+        cd.hash = d.hash;
+        cd.backgroundPath = d.backgroundPath;
+        cd.audioPath = d.audioPath;
+        cd.keyCount = d.keyCount;
+        cd.previewTime = d.previewTime;
+        for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) {
+            cd.starRatings[v] = d.starRatings[v];
+        }
+        cd.totalLength = d.totalLength;
+        cd.bpmMin = d.bpmMin;
+        cd.bpmMax = d.bpmMax;
+        cd.bpmMost = d.bpmMost;
+        cd.totalObjects = d.totalObjects;
+        cd.rcCount = d.rcCount;
+        cd.lnCount = d.lnCount;
+        cd.od = d.od;
+        cd.hp = d.hp;
+        // O2Jam difficulties are "file.ojn:difficulty:level"
+        auto fileIt = fileIndices.find(d.path);
+        if (fileIt == fileIndices.end()) {
+            size_t colonPos = d.path.rfind(':');
+            size_t colonPos2 = (colonPos != std::string::npos && colonPos > 2) ? d.path.rfind(':', colonPos - 1) : std::string::npos;
+            if (colonPos2 != std::string::npos && colonPos2 > 2) fileIt = fileIndices.find(d.path.substr(0, colonPos2));
+        }
+        cd.fileIndex = fileIt != fileIndices.end() ? fileIt->second : -1;
+        cached.difficulties.push_back(cd);
+    }
+    SongIndex::saveIndex(cached);
+
+    // Debug output
+    std::cerr << "Song: " << song.title << " beatmapFiles=" << song.beatmapFiles.size()
+              << " difficulties=" << song.difficulties.size() << " reusedCharts=" << reusedCharts << std::endl;
+
+    // Sort difficulties by star rating (ascending)
+    std::vector<size_t> indices(song.difficulties.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+        return song.difficulties[a].starRatings[settings.starRatingVersion] <
+               song.difficulties[b].starRatings[settings.starRatingVersion];
+    });
+    std::vector<std::string> sortedFiles;
+    std::vector<DifficultyInfo> sortedDiffs;
+    for (size_t i : indices) {
+        sortedFiles.push_back(song.beatmapFiles[i]);
+        sortedDiffs.push_back(song.difficulties[i]);
+    }
+    song.beatmapFiles = std::move(sortedFiles);
+    song.difficulties = std::move(sortedDiffs);
 
-        // Save to index cache
-        CachedSong cached;
-        cached.folderPath = song.folderPath;
-        cached.folderName = song.folderName;
-        cached.title = song.title;
-        cached.titleUnicode = song.titleUnicode;
-        cached.artist = song.artist;
-        cached.artistUnicode = song.artistUnicode;
-        cached.backgroundPath = song.backgroundPath;
-        cached.audioPath = song.audioPath;
-        cached.sourceText = song.sourceText;
-        cached.tags = song.tags;
-        cached.previewTime = song.previewTime;
-        cached.source = static_cast<int>(song.source);
-        cached.lastModified = SongIndex::getFolderModTime(song.folderPath);
-        for (const auto& d : song.difficulties) {
-            CachedDifficulty cd;
-            cd.path = d.path;
-            cd.version = d.version;
-            cd.creator = d.creator;
-            cd.hash = d.hash;
-            cd.backgroundPath = d.backgroundPath;
-            cd.audioPath = d.audioPath;
-            cd.keyCount = d.keyCount;
-            cd.previewTime = d.previewTime;
-            for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) {
-                cd.starRatings[v] = d.starRatings[v];
-            }
-            cd.totalLength = d.totalLength;
-            cd.bpmMin = d.bpmMin;
-            cd.bpmMax = d.bpmMax;
-            cd.bpmMost = d.bpmMost;
-            cd.totalObjects = d.totalObjects;
-            cd.rcCount = d.rcCount;
-            cd.lnCount = d.lnCount;
-            cd.od = d.od;
-            cd.hp = d.hp;
-            cached.difficulties.push_back(cd);
-        }
-        SongIndex::saveIndex(cached);
-
-        // Debug output
-        std::cerr << "Song: " << song.title << " beatmapFiles=" << song.beatmapFiles.size()
-                  << " difficulties=" << song.difficulties.size() << std::endl;
+    results.push_back(song);
+    } catch (const std::exception& e) {
+        std::cerr << "[SCAN] Folder error: " << folderPath << " - " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[SCAN] Folder unknown error: " << folderPath << std::endl;
+    }
+}
+
+void Game::scanSongsFolder(bool refresh) {
+    std::string songsPath = "Songs";
+
+    if (!fs::exists(songsPath)) {
+        std::cerr << "Songs folder not found" << std::endl;
+        return;
+    }
+
+    // With a watcher running since the last complete scan, its change list replaces the tree walk
+    std::set<std::string> watchedChanges;
+    bool useWatcher = libraryWatcher.isActive() && !songList.empty();
+    useWatcher = libraryWatcher.takeChanges(watchedChanges) && useWatcher;
+    if (!libraryWatcher.isActive()) libraryWatcher.start(songsPath);
+
+    // Helper lambda to check if a folder contains beatmap files
+    auto hasBeatmapFiles = [](const fs::path& folder) -> bool {
+        try {
+            for (const auto& file : fs::directory_iterator(folder)) {
+                if (!file.is_regular_file()) continue;
+                std::string ext = file.path().extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                if (isChartExtension(ext) && ext != ".txt") {
+                    return true;
+                }
+                // MUSYNX .txt files
+                if (ext == ".txt") {
+                    std::string fname = file.path().filename().string();
+                    if (fname.find("2T") != std::string::npos || fname.find("4T") != std::string::npos || fname.find("6T") != std::string::npos) {
+                        return true;
+                    }
+                }
+            }
+        } catch (...) {}
+        return false;
+    };
 
-        // Sort difficulties by star rating (ascending)
-        std::vector<size_t> indices(song.difficulties.size());
-        std::iota(indices.begin(), indices.end(), 0);
-        std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
-            return song.difficulties[a].starRatings[settings.starRatingVersion] <
-                   song.difficulties[b].starRatings[settings.starRatingVersion];
-        });
-        std::vector<std::string> sortedFiles;
-        std::vector<DifficultyInfo> sortedDiffs;
-        for (size_t i : indices) {
-            sortedFiles.push_back(song.beatmapFiles[i]);
-            sortedDiffs.push_back(song.difficulties[i]);
-        }
-        song.beatmapFiles = std::move(sortedFiles);
-        song.difficulties = std::move(sortedDiffs);
-
-        songList.push_back(song);
-        scanProgress++;
+    // Recursively collect all folders containing beatmap files
+    std::set<fs::path> currentFolders;
+    std::function<void(const fs::path&)> collectFolders = [&](const fs::path& dir) {
+        try {
+            for (const auto& entry : fs::directory_iterator(dir)) {
+                try {
+                    if (entry.is_directory()) {
+                        if (hasBeatmapFiles(entry.path())) {
+                            currentFolders.insert(entry.path());
+                        } else {
+                            collectFolders(entry.path());
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "[SCAN] Skip entry: " << e.what() << std::endl;
+                }
+            }
         } catch (const std::exception& e) {
-            std::cerr << "[SCAN] Folder error: " << folderPath << " - " << e.what() << std::endl;
-            scanProgress++;
-        } catch (...) {
-            std::cerr << "[SCAN] Folder unknown error: " << folderPath << std::endl;
-            scanProgress++;
+            std::cerr << "[SCAN] Skip dir: " << e.what() << std::endl;
         }
-    }
+    };
 
-sort_and_return:
-    // Sort song list by title using ICU locale-aware comparison
-    // Create ICU collator for sorting
-    UErrorCode status = U_ZERO_ERROR;
-    UCollator* collator = ucol_open("", &status);  // Default locale
-    if (U_SUCCESS(status) && collator) {
-        // Set collator strength for case-insensitive comparison
-        ucol_setStrength(collator, UCOL_SECONDARY);
-        // Enable numeric collation ("2" before "10")
-        ucol_setAttribute(collator, UCOL_NUMERIC_COLLATION, UCOL_ON, &status);
-
-        std::sort(songList.begin(), songList.end(),
-            [collator](const SongEntry& a, const SongEntry& b) {
-                // Convert UTF-8 to UTF-16 for ICU
-                UErrorCode err = U_ZERO_ERROR;
-                std::vector<UChar> ua(a.title.length() * 2 + 1);
-                std::vector<UChar> ub(b.title.length() * 2 + 1);
-
-                int32_t lenA = 0, lenB = 0;
-                u_strFromUTF8(ua.data(), (int32_t)ua.size(), &lenA,
-                              a.title.c_str(), -1, &err);
-                err = U_ZERO_ERROR;
-                u_strFromUTF8(ub.data(), (int32_t)ub.size(), &lenB,
-                              b.title.c_str(), -1, &err);
-
-                UCollationResult result = ucol_strcoll(collator,
-                    ua.data(), lenA, ub.data(), lenB);
-                return result == UCOL_LESS;
-            });
+    // Build set of existing folder paths in songList
+    std::set<fs::path> existingFolders;
+    for (const auto& song : songList) {
+        existingFolders.insert(fs::path(song.folderPath));
+    }
 
-        ucol_close(collator);
+    // Known folders to re-check; unchanged charts in them are served from the index
+    std::set<fs::path> changedFolders;
+    if (useWatcher) {
+        currentFolders = existingFolders;
+        for (const auto& dirStr : watchedChanges) {
+            fs::path dir(dirStr);
+            if (dir == fs::path(songsPath)) continue;  // Loose files in the root are not songs
+            std::error_code ec;
+            if (!fs::is_directory(dir, ec)) {
+                // Deleted or moved away: drop it and any song folders below it
+                for (auto it = currentFolders.begin(); it != currentFolders.end();) {
+                    auto rel = it->lexically_relative(dir);
+                    if (!rel.empty() && *rel.begin() != "..") it = currentFolders.erase(it);
+                    else ++it;
+                }
+                continue;
+            }
+            // Change inside a known song folder (possibly in a subdirectory)
+            bool known = false;
+            for (fs::path p = dir; !p.empty() && p != fs::path(songsPath); p = p.parent_path()) {
+                if (currentFolders.count(p)) {
+                    changedFolders.insert(p);
+                    known = true;
+                    break;
+                }
+                if (p == p.parent_path()) break;
+            }
+            if (known) continue;
+            // New folder, or a new collection of folders
+            if (hasBeatmapFiles(dir)) currentFolders.insert(dir);
+            else collectFolders(dir);
+        }
+        std::cerr << "[SCAN] Watcher reported " << watchedChanges.size() << " changed directories" << std::endl;
     } else {
-        // Fallback to simple comparison if ICU fails
-        std::sort(songList.begin(), songList.end(),
-            [](const SongEntry& a, const SongEntry& b) {
-                return a.title < b.title;
-            });
+        collectFolders(songsPath);
+        if (refresh) changedFolders = existingFolders;
     }
-}
 
-void Game::updateSongFilter() {
-    filteredSongIndices.clear();
-    filteredDiffIndices.clear();
-
-    if (songSelectSearch.empty()) {
-        for (int i = 0; i < (int)songList.size(); i++) {
-            filteredSongIndices.push_back(i);
-            // All difficulties visible
-            std::vector<int> allDiffs;
-            for (int d = 0; d < (int)songList[i].difficulties.size(); d++)
-                allDiffs.push_back(d);
-            filteredDiffIndices.push_back(std::move(allDiffs));
+    // Remove songs whose folders no longer exist
+    songList.erase(
+        std::remove_if(songList.begin(), songList.end(),
+            [&currentFolders](const SongEntry& song) {
+                return currentFolders.find(fs::path(song.folderPath)) == currentFolders.end();
+            }),
+        songList.end());
+
+    // Find new folders to scan, plus known folders that may have changed
+    std::vector<fs::path> newFolders;
+    for (const auto& folder : currentFolders) {
+        if (existingFolders.find(folder) == existingFolders.end() || changedFolders.count(folder)) {
+            newFolders.push_back(folder);
         }
-        return;
     }
 
-    auto tokens = parseSearchTokens(songSelectSearch);
-    if (tokens.empty()) {
-        for (int i = 0; i < (int)songList.size(); i++) {
-            filteredSongIndices.push_back(i);
-            std::vector<int> allDiffs;
-            for (int d = 0; d < (int)songList[i].difficulties.size(); d++)
-                allDiffs.push_back(d);
-            filteredDiffIndices.push_back(std::move(allDiffs));
-        }
-        return;
+    // If no new folders, just re-sort and return
+    if (newFolders.empty()) {
+        std::cerr << "[SCAN] No new folders to scan" << std::endl;
+        goto sort_and_return;
     }
 
-    for (int i = 0; i < (int)songList.size(); i++) {
-        auto matchingDiffs = getMatchingDifficulties(songList[i], tokens, settings.starRatingVersion);
-        if (!matchingDiffs.empty()) {
-            filteredSongIndices.push_back(i);
-            filteredDiffIndices.push_back(std::move(matchingDiffs));
+    std::cerr << "[SCAN] Found " << newFolders.size() << " folders to scan ("
+              << changedFolders.size() << " to re-check)" << std::endl;
+    scanTotal = (int)newFolders.size();
+    scanProgress = 0;
+
+    {
+        // Folders are independent: parse them on a work-stealing pool, each into its own
+        // slot, then merge in folder order so the result does not depend on scheduling
+        std::vector<std::vector<SongEntry>> folderResults(newFolders.size());
+        WorkStealingPool pool;
+        std::cerr << "[SCAN] Using " << pool.size() << " threads" << std::endl;
+        for (size_t i = 0; i < newFolders.size(); i++) {
+            pool.submit([this, &newFolders, &folderResults, i]() {
+                if (scanCancelled) return;
+                {
+                    std::lock_guard<std::mutex> lock(scanMutex);
+                    scanStatusText = newFolders[i].filename().u8string();
+                }
+                scanFolder(newFolders[i], folderResults[i]);
+                scanProgress++;
+            });
+        }
+        pool.wait();
+
+        std::lock_guard<std::mutex> lock(scanMutex);
+        if (!changedFolders.empty()) {
+            // Re-checked folders replace their previous entries
+            songList.erase(
+                std::remove_if(songList.begin(), songList.end(),
+                    [&changedFolders](const SongEntry& song) {
+                        return changedFolders.count(fs::path(song.folderPath)) != 0;
+                    }),
+                songList.end());
+        }
+        for (auto& songs : folderResults) {
+            for (auto& song : songs) songList.push_back(std::move(song));
         }
     }
 
+sort_and_return:
+    {
+        // Fold this scan's index updates into the library snapshot, dropping deleted folders
+        std::vector<std::string> liveFolders;
+        liveFolders.reserve(currentFolders.size());
+        for (const auto& folder : currentFolders) liveFolders.push_back(folder.string());
+        SongIndex::flush(liveFolders);
+    }
+    for (auto& song : songList) song.compact();
+    songList.shrink_to_fit();
+    // Title order (ICU collation keys); other orders are rank tables built in finalizeScan
+    SongOrder::sortByTitle(songList);
+}
+
+void Game::updateSongFilter() {
+    if (songSearchIndex.songCount() != songList.size()) {
+        songSearchIndex.build(songList);
+        songOrder.build(songList);
+    }
+    songSearchIndex.query(songSelectSearch, settings.starRatingVersion, filteredSongIndices, filteredDiffIndices);
+    songOrder.apply((SongSortMode)settings.songSortMode, settings.starRatingVersion,
+                    filteredSongIndices, filteredDiffIndices);
+    selectedFilteredSong = -1;
+    if (songSelectSearch.find_first_not_of(" \t") == std::string::npos) {
+        return;  // Everything visible, keep selection and scroll
+    }
+
     // Adjust selection if current selection is not in filtered list
     if (!filteredSongIndices.empty()) {
-        int foundFi = -1;
-        for (int fi = 0; fi < (int)filteredSongIndices.size(); fi++) {
-            if (filteredSongIndices[fi] == selectedSongIndex) { foundFi = fi; break; }
-        }
+        int foundFi = selectedFilteredIndex();
         if (foundFi < 0) {
             // Song not in filtered list, select first
-            selectedSongIndex = filteredSongIndices[0];
+            selectFilteredSong(0);
             selectedDifficultyIndex = filteredDiffIndices[0][0];
             loadSongBackground(selectedSongIndex, selectedDifficultyIndex);
             playPreviewMusic(selectedSongIndex, selectedDifficultyIndex);
@@ -9066,128 +9024,134 @@ void Game::updateSongFilter() {
     songSelectNeedAutoScroll = true;
 }
 
-void Game::loadSongBackground(int songIndex, int diffIndex) {
-    // Cancel any pending background load
-    if (bgLoadThread.joinable()) {
-        bgLoadThread.join();
-    }
-
-    // Free pending load data if any
-    {
-        std::lock_guard<std::mutex> lock(bgLoadMutex);
-        if (bgLoadData) {
-            stbi_image_free(bgLoadData);
-            bgLoadData = nullptr;
-        }
-        bgLoadPending = false;
-    }
-
-    // Free previous texture
-    if (currentBgTexture) {
-        SDL_DestroyTexture(currentBgTexture);
-        currentBgTexture = nullptr;
+int Game::selectedFilteredIndex() {
+    if (selectedFilteredSong != selectedSongIndex) {
+        auto it = std::find(filteredSongIndices.begin(), filteredSongIndices.end(), selectedSongIndex);
+        selectedFilteredPos = it != filteredSongIndices.end() ? (int)(it - filteredSongIndices.begin()) : -1;
+        selectedFilteredSong = selectedSongIndex;
     }
+    return selectedFilteredPos;
+}
 
-    if (songIndex < 0 || songIndex >= (int)songList.size()) return;
-
-    const SongEntry& song = songList[songIndex];
+void Game::selectFilteredSong(int fi) {
+    selectedSongIndex = filteredSongIndices[fi];
+    selectedFilteredPos = fi;
+    selectedFilteredSong = selectedSongIndex;
+}
 
-    // Determine background path: use difficulty-specific if available, otherwise song-level
-    std::string bgPath;
+// Background of a difficulty, falling back to the song-level image
+static std::string songBackgroundPath(const SongEntry& song, int diffIndex) {
     if (diffIndex >= 0 && diffIndex < (int)song.difficulties.size() &&
         !song.difficulties[diffIndex].backgroundPath.empty()) {
-        bgPath = song.difficulties[diffIndex].backgroundPath;
-    } else {
-        bgPath = song.backgroundPath;
+        return song.difficulties[diffIndex].backgroundPath;
     }
+    return song.backgroundPath;
+}
 
-    if (bgPath.empty()) return;
+// Songs on each side of the selection whose backgrounds are decoded ahead of time
+static const int BG_PREFETCH_RADIUS = 3;
 
-    // Start async load
-    bgLoadThread = std::thread([this, bgPath]() {
-        int width, height, channels;
-        unsigned char* data = stbi_load(bgPath.c_str(), &width, &height, &channels, 4);
+void Game::loadSongBackground(int songIndex, int diffIndex) {
+    currentBgTexture = nullptr;
+    currentBgPath.clear();
+    if (songIndex < 0 || songIndex >= (int)songList.size()) return;
 
-        // Crop DJMAX Online eyecatch images (1024x1024 -> 800x600)
-        if (data && width == 1024 && height == 1024) {
-            const int cropW = 800, cropH = 600;
-            unsigned char* cropped = (unsigned char*)malloc(cropW * cropH * 4);
-            if (cropped) {
-                for (int y = 0; y < cropH; y++) {
-                    memcpy(cropped + y * cropW * 4, data + y * width * 4, cropW * 4);
-                }
-                stbi_image_free(data);
-                data = cropped;
-                width = cropW;
-                height = cropH;
-            }
-        }
+    currentBgPath = songBackgroundPath(songList[songIndex], diffIndex);
+    if (!currentBgPath.empty()) {
+        currentBgTexture = backgroundCache.request(currentBgPath);
+    }
 
-        std::lock_guard<std::mutex> lock(bgLoadMutex);
-        bgLoadData = data;
-        bgLoadWidth = width;
-        bgLoadHeight = height;
-        bgLoadPending = true;
-    });
+    // Prefetch the neighbours in the filtered list, nearest first
+    int fp = songIndex == selectedSongIndex ? selectedFilteredIndex()
+                                            : (int)(std::find(filteredSongIndices.begin(), filteredSongIndices.end(),
+                                                              songIndex) - filteredSongIndices.begin());
+    int count = (int)filteredSongIndices.size();
+    if (fp < 0 || fp >= count) return;
+    std::vector<std::string> paths;
+    for (int dist = 1; dist <= BG_PREFETCH_RADIUS; dist++) {
+        for (int fi : {fp + dist, fp - dist}) {
+            if (fi < 0 || fi >= count) continue;
+            const auto& fDiffs = filteredDiffIndices[fi];
+            std::string path = songBackgroundPath(songList[filteredSongIndices[fi]], fDiffs.empty() ? -1 : fDiffs[0]);
+            if (!path.empty()) paths.push_back(std::move(path));
+        }
+    }
+    backgroundCache.prefetch(paths);
 }
 
 void Game::updateBackgroundLoad() {
-    if (!bgLoadPending) return;
-
-    std::lock_guard<std::mutex> lock(bgLoadMutex);
-    if (bgLoadData) {
-        SDL_Surface* surface = SDL_CreateSurface(bgLoadWidth, bgLoadHeight, SDL_PIXELFORMAT_RGBA32);
-        if (surface) {
-            SDL_LockSurface(surface);
-            memcpy(surface->pixels, bgLoadData, bgLoadWidth * bgLoadHeight * 4);
-            SDL_UnlockSurface(surface);
-            if (currentBgTexture) {
-                SDL_DestroyTexture(currentBgTexture);
-            }
-            currentBgTexture = SDL_CreateTextureFromSurface(renderer.getRenderer(), surface);
-            SDL_DestroySurface(surface);
-        }
-        stbi_image_free(bgLoadData);
-        bgLoadData = nullptr;
+    // Prefetched images are only uploaded in song select, gameplay frames upload nothing extra
+    backgroundCache.update(state == GameState::SongSelect ? 1 : 0);
+    if (!currentBgTexture && !currentBgPath.empty()) {
+        currentBgTexture = backgroundCache.get(currentBgPath);
     }
-    bgLoadPending = false;
 }
 
-void Game::playPreviewMusic(int songIndex, int diffIndex) {
-    if (songIndex < 0 || songIndex >= (int)songList.size()) return;
-
-    const SongEntry& song = songList[songIndex];
-
-    // Determine audio path and preview time: use difficulty-specific if available
-    std::string audioPath;
-    int previewTime = song.previewTime;  // Default to song-level
+// What the preview of a difficulty plays: its own audio and preview point if set, otherwise
+// the song's; O2Jam charts without an audio file get a preview mixed from their keysounds
+static PreviewSource previewSourceFor(const SongEntry& song, int diffIndex) {
+    PreviewSource source;
+    source.audioPath = song.audioPath;
+    source.previewTime = song.previewTime;  // Default to song-level
     if (diffIndex >= 0 && diffIndex < (int)song.difficulties.size()) {
-        // Use diff-specific audio if available
-        if (!song.difficulties[diffIndex].audioPath.empty()) {
-            audioPath = song.difficulties[diffIndex].audioPath;
-        } else {
-            audioPath = song.audioPath;
-        }
-        // Use diff-specific preview time if set
-        if (song.difficulties[diffIndex].previewTime != 0) {
-            previewTime = song.difficulties[diffIndex].previewTime;
-        }
-    } else {
-        audioPath = song.audioPath;
+        const DifficultyInfo& diff = song.difficulties[diffIndex];
+        if (!diff.audioPath.empty()) source.audioPath = diff.audioPath;
+        if (diff.previewTime != 0) source.previewTime = diff.previewTime;
     }
 
     // Normalize path separators for cross-platform compatibility
     // (index cache may contain Windows-style backslashes or trailing \r\n)
-    if (!audioPath.empty()) {
+    if (!source.audioPath.empty()) {
         // Remove trailing \r\n from Windows-created index cache
-        while (!audioPath.empty() && (audioPath.back() == '\r' || audioPath.back() == '\n')) {
-            audioPath.pop_back();
+        while (!source.audioPath.empty() && (source.audioPath.back() == '\r' || source.audioPath.back() == '\n')) {
+            source.audioPath.pop_back();
         }
         // Use fs::path to normalize and get proper UTF-8 encoding
-        audioPath = fs::path(audioPath).u8string();
+        source.audioPath = fs::path(source.audioPath).u8string();
     }
 
-    if (audioPath.empty()) {
+    if (source.audioPath.empty() && song.source == BeatmapSource::O2Jam && !song.beatmapFiles.empty()) {
+        // Extract actual OJN path (remove :difficulty:level suffix)
+        std::string ojnPath = song.beatmapFiles[0];
+        size_t colonPos = ojnPath.rfind(':');
+        if (colonPos != std::string::npos && colonPos > 2) {
+            size_t colonPos2 = ojnPath.rfind(':', colonPos - 1);
+            if (colonPos2 != std::string::npos && colonPos2 > 2) {
+                ojnPath = ojnPath.substr(0, colonPos2);
+            }
+        }
+        source.ojnPath = ojnPath;
+    }
+    return source;
+}
+
+// Songs on each side of the selection whose preview clips are decoded ahead of time
+static const int PREVIEW_PREFETCH_RADIUS = 2;
+
+void Game::playPreviewMusic(int songIndex, int diffIndex) {
+    if (songIndex < 0 || songIndex >= (int)songList.size()) return;
+
+    PreviewSource source = previewSourceFor(songList[songIndex], diffIndex);
+    pendingPreview = PreviewSource();
+
+    // Decode this clip and the neighbours' in the background so moving back and forth
+    // through the list starts previews from memory
+    std::vector<PreviewSource> prefetch;
+    prefetch.push_back(source);
+    int fp = songIndex == selectedSongIndex ? selectedFilteredIndex()
+                                            : (int)(std::find(filteredSongIndices.begin(), filteredSongIndices.end(),
+                                                              songIndex) - filteredSongIndices.begin());
+    int count = (int)filteredSongIndices.size();
+    for (int dist = 1; fp >= 0 && fp < count && dist <= PREVIEW_PREFETCH_RADIUS; dist++) {
+        for (int fi : {fp + dist, fp - dist}) {
+            if (fi < 0 || fi >= count) continue;
+            const auto& fDiffs = filteredDiffIndices[fi];
+            prefetch.push_back(previewSourceFor(songList[filteredSongIndices[fi]], fDiffs.empty() ? -1 : fDiffs[0]));
+        }
+    }
+    previewCache.prefetch(prefetch);
+
+    if (source.empty()) {
         // No audio for this song/difficulty - stop current preview if playing
         if (audio.isPlaying()) {
             stopPreviewMusic();
@@ -9197,7 +9161,7 @@ void Game::playPreviewMusic(int songIndex, int diffIndex) {
     }
 
     // Check if the same audio is already playing - no need to reload
-    if (audioPath == currentPreviewAudioPath && audio.isPlaying()) {
+    if (source.file() == currentPreviewAudioPath && audio.isPlaying()) {
         return;
     }
 
@@ -9214,27 +9178,52 @@ void Game::playPreviewMusic(int songIndex, int diffIndex) {
         previewTargetDiffIndex = diffIndex;
     } else {
         // Start playing directly with fade in
-        if (audio.loadMusic(audioPath)) {  // loop by default for preview
-            currentPreviewAudioPath = audioPath;
+        startPreview(std::move(source));
+    }
+}
+
+void Game::startPreview(PreviewSource source) {
+    PreviewCache::Clip clip = previewCache.get(source);
+    bool loaded = false;
+    if (clip) {
+        // The clip already starts at the preview point
+        loaded = audio.loadMusicFromMemory(clip);  // loop by default for preview
+        if (loaded) {
+            audio.setVolume(0);
+            audio.play();
+        }
+    } else if (!source.audioPath.empty()) {
+        loaded = audio.loadMusic(source.audioPath);  // loop by default for preview
+        if (loaded) {
             audio.setVolume(0);
             audio.play();
             // setPosition after play
-            if (previewTime > 0) {
-                audio.setPosition(previewTime);
-            } else if (previewTime == -1) {
+            if (source.previewTime > 0) {
+                audio.setPosition(source.previewTime);
+            } else if (source.previewTime == -1) {
                 int64_t duration = audio.getDuration();
                 audio.setPosition((int64_t)(duration * 0.4));
             }
-            previewFading = true;
-            previewFadeIn = true;
-            previewFadeStart = SDL_GetTicks();
-            previewFadeDuration = 200;
-            previewTargetIndex = -1;
         }
+    } else {
+        // Generated previews are too slow to mix here; start once the loader has the clip
+        previewCache.request(source);
+        pendingPreview = std::move(source);
+        return;
     }
+    pendingPreview = PreviewSource();
+    if (!loaded) return;
+
+    currentPreviewAudioPath = source.file();
+    previewFading = true;
+    previewFadeIn = true;
+    previewFadeStart = SDL_GetTicks();
+    previewFadeDuration = 200;
+    previewTargetIndex = -1;
 }
 
 void Game::stopPreviewMusic() {
+    pendingPreview = PreviewSource();
     if (audio.isPlaying()) {
         previewFading = true;
         previewFadeIn = false;
@@ -9245,6 +9234,9 @@ void Game::stopPreviewMusic() {
 }
 
 void Game::updatePreviewFade() {
+    if (!pendingPreview.empty() && !previewFading && previewCache.get(pendingPreview)) {
+        startPreview(pendingPreview);
+    }
     if (!previewFading) return;
 
     int64_t elapsed = SDL_GetTicks() - previewFadeStart;
@@ -9266,47 +9258,8 @@ void Game::updatePreviewFade() {
             previewFading = false;
             // If there's a target song, play it
             if (previewTargetIndex >= 0 && previewTargetIndex < (int)songList.size()) {
-                const SongEntry& song = songList[previewTargetIndex];
-                // Determine audio path and preview time from difficulty if available
-                std::string audioPath;
-                int previewTime = song.previewTime;  // Default to song-level
-                if (previewTargetDiffIndex >= 0 && previewTargetDiffIndex < (int)song.difficulties.size()) {
-                    if (!song.difficulties[previewTargetDiffIndex].audioPath.empty()) {
-                        audioPath = song.difficulties[previewTargetDiffIndex].audioPath;
-                    } else {
-                        audioPath = song.audioPath;
-                    }
-                    if (song.difficulties[previewTargetDiffIndex].previewTime != 0) {
-                        previewTime = song.difficulties[previewTargetDiffIndex].previewTime;
-                    }
-                } else {
-                    audioPath = song.audioPath;
-                }
-                // Normalize path for cross-platform compatibility
-                if (!audioPath.empty()) {
-                    // Remove trailing \r\n from Windows-created index cache
-                    while (!audioPath.empty() && (audioPath.back() == '\r' || audioPath.back() == '\n')) {
-                        audioPath.pop_back();
-                    }
-                    audioPath = fs::path(audioPath).u8string();
-                }
-                if (!audioPath.empty() && audio.loadMusic(audioPath)) {
-                    currentPreviewAudioPath = audioPath;
-                    audio.setVolume(0);
-                    audio.play();
-                    // setPosition after play
-                    if (previewTime > 0) {
-                        audio.setPosition(previewTime);
-                    } else if (previewTime == -1) {
-                        int64_t duration = audio.getDuration();
-                        audio.setPosition((int64_t)(duration * 0.4));
-                    }
-                    previewFading = true;
-                    previewFadeIn = true;
-                    previewFadeStart = SDL_GetTicks();
-                    previewFadeDuration = 200;
-                    previewTargetIndex = -1;
-                }
+                PreviewSource source = previewSourceFor(songList[previewTargetIndex], previewTargetDiffIndex);
+                if (!source.empty()) startPreview(std::move(source));
             }
         }
     }
@@ -5,6 +5,7 @@
 #include <atomic>
 #include <mutex>
 #include <fstream>
+#include <filesystem>
 #include "Note.h"
 #include "OsuParser.h"
 #include "BMSParser.h"
@@ -22,7 +23,17 @@
 #include "DJMAXOLBgaParser.h"
 #include "VideoGenerator.h"
 #include "JudgementSystem.h"
+#include "LaneNoteIndex.h"
+#include "ActiveNoteWindow.h"
 #include "VideoPlayer.h"
+#include "TripleBuffer.h"
+#include "GameplaySnapshot.h"
+#include "LibraryWatcher.h"
+#include "BackgroundCache.h"
+#include "PreviewCache.h"
+#include "SongSearchIndex.h"
+#include "SongSort.h"
+#include "SongEntry.h"
 
 // Debug log entry for replay analysis
 struct DebugLogEntry {
@@ -58,66 +69,6 @@ enum class LoadingState {
     Cancelled
 };
 
-// Beatmap source type
-enum class BeatmapSource {
-    Osu,
-    DJMaxRespect,  // DJMAX RESPECT (.bytes files)
-    DJMaxOnline,   // DJMAX Online (.pt files)
-    O2Jam,
-    BMS,
-    Malody,
-    MuSynx,
-    IIDX,          // beatmania IIDX (.1 files)
-    StepMania,     // StepMania (.sm/.ssc files)
-    SDVX,          // Sound Voltex (.vox files)
-    EZ2AC,         // EZ2AC (.ez files)
-    EZ2ON          // EZ2ON REBOOT:R (.ezi files)
-};
-
-// Difficulty info for song select
-struct DifficultyInfo {
-    std::string path;       // Full path to beatmap file
-    std::string version;    // Difficulty name
-    std::string creator;    // Charter/mapper
-    std::string hash;       // MD5 hash of beatmap file
-    int keyCount;           // Number of keys (4K, 7K, etc.)
-    // Star ratings for each algorithm version (matches STAR_RATING_VERSION_COUNT)
-    // [0] = b20260101, [1] = b20220101
-    double starRatings[2] = {0.0, 0.0};
-    // Per-difficulty background and audio (may differ from song-level defaults)
-    std::string backgroundPath;  // Background image path for this difficulty
-    std::string audioPath;       // Audio file path for this difficulty
-    int previewTime = 0;         // Preview start time in ms (-1 = 40% position)
-    // Metadata for header display
-    int totalLength = 0;         // Song length in ms (last note time)
-    double bpmMin = 0;           // Minimum BPM
-    double bpmMax = 0;           // Maximum BPM
-    double bpmMost = 0;          // Most dominant BPM (longest duration)
-    int totalObjects = 0;        // Total note count
-    int rcCount = 0;             // Regular (tap) note count
-    int lnCount = 0;             // Long note count
-    float od = 0;                // Overall Difficulty
-    float hp = 0;                // HP Drain
-};
-
-// Song entry for song select screen
-struct SongEntry {
-    std::string folderPath;      // Full path to song folder
-    std::string folderName;      // Folder name (for display)
-    std::string title;           // Song title (from beatmap)
-    std::string titleUnicode;    // Song title (Unicode version)
-    std::string artist;          // Artist name (from beatmap)
-    std::string artistUnicode;   // Artist name (Unicode version)
-    std::string backgroundPath;  // Path to background image
-    std::string audioPath;       // Path to audio file
-    std::string sourceText;      // Source metadata (e.g. "Touhou", "Vocaloid")
-    std::string tags;            // Space-separated tags
-    int previewTime = 0;         // Preview start time in ms
-    std::vector<std::string> beatmapFiles;  // List of beatmap files (legacy)
-    std::vector<DifficultyInfo> difficulties;  // Detailed difficulty info
-    BeatmapSource source;        // osu!, DJMAX, O2Jam
-};
-
 class Game {
 public:
     Game();
@@ -142,7 +93,9 @@ private:
     std::string openSkinFolderDialog();
     void exportBeatmap();  // Export selected song to osu! format
     void handleInput();
-    void update();
+    void update(double deltaMs);
+    void simulate(int64_t currentTime);      // One fixed gameplay step (misses, ticks, autoplay, replay)
+    void applyPendingInput(int64_t upToTime);  // Judge queued key events stamped at or before upToTime
     void render();
     Judgement checkJudgement(int lane, int64_t atTime = INT64_MIN);
     void onKeyRelease(int lane, int64_t atTime = INT64_MIN);
@@ -152,6 +105,22 @@ private:
     void updateReplay();
     int64_t getCurrentGameTime() const;  // Helper to get current game time (with audio offset, for judgement)
     int64_t getRenderTime() const;        // Helper to get render time (without audio offset)
+    double getCurrentGameTimeExact() const;  // Sub-millisecond variants (smoothed audio clock)
+    double getRenderTimeExact() const;
+    int64_t getEventGameTime(Uint64 timestampNS) const;  // Game time at which an SDL event occurred
+
+    // Gameplay thread (simulation) and the snapshot it publishes for rendering
+    void gameplayThreadMain();
+    void publishSnapshot();      // Gameplay side: copy current state into the write buffer
+    void consumeSnapshot();      // Main side: take the newest snapshot and replay its events
+    void resetSnapshot();        // Re-seed all buffers from beatmap.notes (gameplay idle)
+    void resolveNote(int lane, int noteIdx);  // Advance the lane index and mark the note dirty
+    void emitHitSound(const HitSoundInfo& info, int64_t time);
+    void emitHitObjectHit(int64_t time);
+    void emitLighting(int lane, int64_t time);
+    void emitBgaMiss(int64_t time);
+    void requestStateChange(GameState next);  // Gameplay side: ask main to leave Playing
+    void applyRequestedState();               // Main side: perform a requested Dead/Result switch
 
     Renderer renderer;
     AudioManager audio;
@@ -191,7 +160,7 @@ private:
 
     GameState state;
     bool running;
-    bool musicStarted;
+    std::atomic<bool> musicStarted;  // Also read by render() outside the gameplay lock
     bool hasBackgroundMusic;  // false for keysound-only maps
     bool autoPlay;
     double baseBPM;  // Base BPM from first timing point
@@ -199,6 +168,37 @@ private:
     double currentStarRating;   // Star rating with current mods applied
     double scoreMultiplier;     // Score multiplier: 0.5 for HT, 1.0 for others
     int64_t startTime;
+    Uint64 lastUpdateTicksNS = 0;  // SDL_GetTicksNS() when update() last sampled the clock
+
+    // Fixed-timestep gameplay simulation
+    static const int64_t SIM_STEP_MS = 1;            // 1000 Hz
+    static const int64_t MAX_SIM_CATCHUP_MS = 1000;  // Larger gaps resync instead of stepping
+    int64_t simTime = INT64_MIN;                     // Last simulated time (INT64_MIN = not started)
+    struct PendingInput {
+        int lane;
+        bool pressed;
+        int64_t time;  // Judgement clock time of the key event
+    };
+    std::vector<PendingInput> pendingInput;  // Key events awaiting the simulation step they fall in
+
+    // Gameplay runs on its own thread while Playing; the main thread handles events and
+    // rendering. gameplayMutex guards all game state except while render() runs, which
+    // reads only the published snapshot and displayNotes.
+    std::thread gameplayThread;
+    std::atomic<bool> gameplayThreadRunning{false};
+    std::atomic<bool> gameplayActive{false};      // State was Playing when main released the lock
+    std::mutex gameplayMutex;
+    TripleBuffer<GameplaySnapshot> snapshots;
+    std::vector<Note> displayNotes;                // Render copy of beatmap.notes (runtime fields from snapshots)
+    std::vector<int> snapshotStale[3];             // Per buffer: notes changed since it was last written
+    bool snapshotFullResync[3] = {false, false, false};
+    bool snapshotCarryEvents = false;              // Write buffer still holds unread events
+    std::vector<int> resolvedSincePublish;         // Notes resolved since the last publish
+    std::vector<int> livePublished;                // Live notes at the last publish
+    std::vector<SimEvent> simEvents;               // Render-side effects since the last publish
+    bool stateChangeRequested = false;
+    GameState requestedState = GameState::Playing;
+    int64_t requestedStateTime = 0;
     static const int64_t PREPARE_TIME = 2500;
 
     int combo;
@@ -241,7 +241,8 @@ private:
     bool mouseClicked;
     bool mouseDown;
     bool laneKeyDown[18];  // track key state for each lane (up to 18k)
-    int laneNextNoteIndex[18];  // index of next note in each lane (for empty tap keysound)
+    LaneNoteIndex laneNoteIndex;  // per-lane judgement cursors (also tracks empty tap keysound note)
+    ActiveNoteWindow activeNotes;  // time-ordered heads + live holds for per-frame updates
 
     Settings settings;
     SettingsCategory settingsCategory;
@@ -290,39 +291,45 @@ private:
     std::string songSelectSearch;  // Search filter text
     std::vector<int> filteredSongIndices;  // Indices into songList matching current search
     std::vector<std::vector<int>> filteredDiffIndices;  // Per-song matching difficulty indices (parallel to filteredSongIndices)
+    SongSearchIndex songSearchIndex;  // Rebuilt after each scan
+    SongOrder songOrder;              // Sort-mode rank tables, rebuilt after each scan
     int selectedSongIndex;
     int selectedDifficultyIndex;  // Selected difficulty within the song
+    int selectedFilteredPos = -1;   // selectedSongIndex's position in filteredSongIndices (-1 = filtered out),
+    int selectedFilteredSong = -1;  // valid while selectedSongIndex is this song (reset by updateSongFilter)
     float songSelectScroll;  // Scroll offset for song list
     bool songSelectNeedAutoScroll;  // Flag to trigger auto-scroll on selection change
     bool songSelectDragging;  // Mouse drag scrolling
     int songSelectDragStartY;  // Mouse Y when drag started
     float songSelectDragStartScroll;  // Scroll value when drag started
-    SDL_Texture* currentBgTexture;  // Background texture for selected song
-    // Async background loading
-    std::thread bgLoadThread;
-    std::atomic<bool> bgLoadPending{false};
-    std::mutex bgLoadMutex;
-    unsigned char* bgLoadData = nullptr;
-    int bgLoadWidth = 0;
-    int bgLoadHeight = 0;
+    SDL_Texture* currentBgTexture;  // Background texture for selected song (owned by backgroundCache)
+    std::string currentBgPath;      // Background wanted for the selected song
+    BackgroundCache backgroundCache;  // Async decode, neighbour prefetch and texture LRU
     bool songSelectTransition;  // True when transitioning out
     int64_t songSelectTransitionStart;  // Transition start time
-    void scanSongsFolder();
+    void scanSongsFolder(bool refresh);
+    void scanFolder(const std::filesystem::path& folderPath, std::vector<SongEntry>& results);  // Parse one song folder (any thread)
     void updateSongFilter();  // Rebuild filteredSongIndices from songSelectSearch
+    int selectedFilteredIndex();  // Filtered position of the selected song, searched only after it or the filter changed
+    void selectFilteredSong(int fi);  // Select filteredSongIndices[fi] (the difficulty is left to the caller)
 
     // Async Song Scanning
     std::thread scanThread;
     std::atomic<bool> scanRunning{false};
     std::atomic<int> scanProgress{0};
     std::atomic<int> scanTotal{0};
+    std::atomic<bool> scanCancelled{false};  // Set on quit: queued folders are skipped
     std::string scanStatusText;
     std::mutex scanMutex;
     GameState stateAfterScan = GameState::Menu;
-    void startScanAsync(bool clearIndex, GameState afterState);
+    LibraryWatcher libraryWatcher;  // Limits refreshes to changed folders (Linux)
+    // refresh: also re-check folders already in the list (F5)
+    void startScanAsync(bool clearIndex, GameState afterState, bool refresh = false);
     void finalizeScan();
     void loadSongBackground(int songIndex, int diffIndex = -1);
-    void updateBackgroundLoad();  // Check async background load completion
+    void updateBackgroundLoad();  // Upload finished background decodes
     void playPreviewMusic(int songIndex, int diffIndex = -1);
+    void startPreview(PreviewSource source);  // Nothing playing: start now, or once a generated clip is ready
     void stopPreviewMusic();
     void updatePreviewFade();  // Update fade in/out
 
@@ -334,6 +341,8 @@ private:
     int previewTargetIndex;  // Song to play after fade out
     int previewTargetDiffIndex;  // Difficulty to play after fade out
     std::string currentPreviewAudioPath;  // Currently playing audio path (to avoid reloading same audio)
+    PreviewCache previewCache;            // Decoded preview clips of the selection and its neighbours
+    PreviewSource pendingPreview;         // Generated preview waiting for its clip
 
     // Replay Factory
     std::string factoryReplayPath;  // Loaded replay file path
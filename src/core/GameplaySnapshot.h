@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Note.h"
+#include "Renderer.h"
+#include "Storyboard.h"
+
+// Side effect of a simulation step that touches render-side state (storyboard triggers,
+// lighting, BGA), replayed on the main thread when the snapshot is taken
+struct SimEvent {
+    enum class Type { HitSound, HitObjectHit, Lighting, BgaMiss };
+    Type type;
+    int lane;
+    int64_t time;
+    HitSoundInfo hitSound;
+};
+
+// Gameplay state published by the simulation for one rendered frame
+struct GameplaySnapshot {
+    std::vector<NoteRuntime> notes;  // Parallel to beatmap.notes
+    bool laneKeyDown[18] = {false};
+
+    int combo = 0;
+    int maxCombo = 0;
+    int score = 0;
+    int judgementCounts[6] = {0};
+    double accuracy = 100.0;
+    int pp = 0;
+    double hpPercent = 1.0;
+
+    int64_t lastJudgementTime = 0;
+    int lastJudgementIndex = -1;
+    int64_t lastComboChangeTime = 0;
+    bool comboBreak = false;
+    int64_t comboBreakTime = 0;
+    int lastComboValue = 0;
+    bool canSkip = false;
+    bool showEndPrompt = false;
+    std::vector<HitError> hitErrors;
+
+    std::vector<SimEvent> events;  // Since the previous snapshot the reader took
+};
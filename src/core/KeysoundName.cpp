@@ -0,0 +1,64 @@
+#include "KeysoundName.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+// Names are never removed: the table only grows by distinct names. They are stored in
+// fixed-size chunks that never move, so lookup() reads without a lock while other threads
+// intern (keysound streaming and loading run during play). A chunk is published before any
+// id in it is handed out, and an id reaches another thread only through whatever passed it
+// the note, so the name is always visible by the time it is looked up.
+constexpr uint32_t CHUNK_BITS = 10;
+constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+constexpr uint32_t MAX_CHUNKS = 1u << 12;  // 4M distinct names
+
+struct KeysoundTable {
+    std::shared_mutex mutex;  // Guards ids and adding names; lookup() does not take it
+    std::unordered_map<std::string, uint32_t> ids;
+    std::atomic<std::string*> chunks[MAX_CHUNKS] = {};
+    std::atomic<uint32_t> size{1};  // Id 0 is the empty string
+
+    KeysoundTable() { chunks[0].store(new std::string[CHUNK_SIZE]); }
+    ~KeysoundTable() {
+        for (auto& chunk : chunks) delete[] chunk.load();
+    }
+};
+
+KeysoundTable& table() {
+    static KeysoundTable instance;
+    return instance;
+}
+
+}  // namespace
+
+uint32_t KeysoundName::intern(const std::string& name) {
+    if (name.empty()) return 0;
+    KeysoundTable& t = table();
+    {
+        std::shared_lock<std::shared_mutex> lock(t.mutex);
+        auto it = t.ids.find(name);
+        if (it != t.ids.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    auto it = t.ids.find(name);
+    if (it != t.ids.end()) return it->second;
+    uint32_t id = t.size.load(std::memory_order_relaxed);
+    if ((id >> CHUNK_BITS) >= MAX_CHUNKS) return 0;  // Full: the name plays as no sample
+    std::atomic<std::string*>& chunk = t.chunks[id >> CHUNK_BITS];
+    if (!chunk.load(std::memory_order_relaxed)) chunk.store(new std::string[CHUNK_SIZE], std::memory_order_release);
+    chunk.load(std::memory_order_relaxed)[id & (CHUNK_SIZE - 1)] = name;
+    t.ids.emplace(name, id);
+    t.size.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+const std::string& KeysoundName::lookup(uint32_t id) {
+    return table().chunks[id >> CHUNK_BITS].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+}
+
+size_t KeysoundName::tableSize() {
+    return table().size.load(std::memory_order_acquire) - 1;
+}
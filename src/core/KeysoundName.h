@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Interned key sound filename.
+// Notes store a 4-byte id into a process-wide string table instead of a std::string:
+// charts reference the same few hundred sample names thousands of times, so this keeps
+// Note small and makes copying note arrays cheap. Converts to const std::string& so it
+// can be passed wherever a filename string is expected.
+class KeysoundName {
+public:
+    KeysoundName() : id_(0) {}
+    KeysoundName(const std::string& name) : id_(intern(name)) {}
+    KeysoundName(const char* name) : id_(intern(name)) {}
+
+    KeysoundName& operator=(const std::string& name) {
+        id_ = intern(name);
+        return *this;
+    }
+    KeysoundName& operator=(const char* name) {
+        id_ = intern(name);
+        return *this;
+    }
+
+    const std::string& str() const { return lookup(id_); }
+    operator const std::string&() const { return str(); }
+    const char* c_str() const { return str().c_str(); }
+    size_t size() const { return str().size(); }
+    bool empty() const { return id_ == 0; }
+    uint32_t id() const { return id_; }
+
+    bool operator==(const KeysoundName& other) const { return id_ == other.id_; }
+    bool operator!=(const KeysoundName& other) const { return id_ != other.id_; }
+
+    static size_t tableSize();  // Distinct names interned so far
+
+private:
+    uint32_t id_;  // 0 = empty string
+
+    static uint32_t intern(const std::string& name);
+    static const std::string& lookup(uint32_t id);
+};
+
+inline std::string operator+(const std::string& lhs, const KeysoundName& rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const KeysoundName& lhs, const std::string& rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const KeysoundName& lhs, const char* rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const char* lhs, const KeysoundName& rhs) { return lhs + rhs.str(); }
+inline bool operator==(const KeysoundName& lhs, const std::string& rhs) { return lhs.str() == rhs; }
+inline bool operator!=(const KeysoundName& lhs, const std::string& rhs) { return lhs.str() != rhs; }
@@ -0,0 +1,74 @@
+#include "LaneNoteIndex.h"
+
+LaneNoteIndex::LaneNoteIndex() {
+    clear();
+}
+
+void LaneNoteIndex::clear() {
+    for (int i = 0; i < MAX_LANES; i++) {
+        laneNotes_[i].clear();
+        cursor_[i] = 0;
+        nextNote_[i] = -1;
+    }
+    lanePos_.clear();
+}
+
+void LaneNoteIndex::build(const std::vector<Note>& notes) {
+    clear();
+    lanePos_.assign(notes.size(), -1);
+    for (size_t i = 0; i < notes.size(); i++) {
+        const Note& note = notes[i];
+        if (note.isFakeNote) continue;  // Visual only, never judged
+        if (note.lane < 0 || note.lane >= MAX_LANES) continue;
+        lanePos_[i] = static_cast<int>(laneNotes_[note.lane].size());
+        laneNotes_[note.lane].push_back(static_cast<int>(i));
+    }
+    for (int lane = 0; lane < MAX_LANES; lane++) {
+        if (!laneNotes_[lane].empty()) {
+            nextNote_[lane] = laneNotes_[lane][0];
+        }
+    }
+}
+
+void LaneNoteIndex::advance(const std::vector<Note>& notes, int lane) {
+    const std::vector<int>& list = laneNotes_[lane];
+    size_t& pos = cursor_[lane];
+    while (pos < list.size()) {
+        NoteState s = notes[list[pos]].state;
+        if (s != NoteState::Hit && s != NoteState::Missed) break;
+        pos++;
+    }
+}
+
+int LaneNoteIndex::findWaiting(const std::vector<Note>& notes, int lane) {
+    if (lane < 0 || lane >= MAX_LANES) return -1;
+    advance(notes, lane);
+    // Only live holds (and the odd already-resolved overlap) sit between the cursor and the first Waiting note
+    const std::vector<int>& list = laneNotes_[lane];
+    for (size_t pos = cursor_[lane]; pos < list.size(); pos++) {
+        if (notes[list[pos]].state == NoteState::Waiting) return list[pos];
+    }
+    return -1;
+}
+
+int LaneNoteIndex::findHold(const std::vector<Note>& notes, int lane, NoteState state) {
+    if (lane < 0 || lane >= MAX_LANES) return -1;
+    advance(notes, lane);
+    const std::vector<int>& list = laneNotes_[lane];
+    for (size_t pos = cursor_[lane]; pos < list.size(); pos++) {
+        const Note& note = notes[list[pos]];
+        if (note.state == NoteState::Waiting) break;  // Nothing live after the first Waiting note
+        if (note.state == state && note.isHold) return list[pos];
+    }
+    return -1;
+}
+
+void LaneNoteIndex::onNoteResolved(int lane, int noteIndex) {
+    if (lane < 0 || lane >= MAX_LANES) return;
+    if (noteIndex < 0 || noteIndex >= static_cast<int>(lanePos_.size())) return;
+    int pos = lanePos_[noteIndex];
+    if (pos < 0) return;
+    const std::vector<int>& list = laneNotes_[lane];
+    // No more notes in this lane - reset (osu! stable resets keysound here)
+    nextNote_[lane] = (pos + 1 < static_cast<int>(list.size())) ? list[pos + 1] : -1;
+}
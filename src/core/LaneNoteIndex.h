@@ -0,0 +1,45 @@
+#pragma once
+#include "Note.h"
+#include <vector>
+
+// Per-lane judgement index
+// Keeps each lane's playable notes (fake notes excluded) in chart order plus a
+// cursor to the first unresolved one, so key presses/releases only look at the
+// few notes around the judge line instead of scanning the whole chart.
+//
+// Relies on the judgement invariant that within a lane every Holding/Released
+// note comes before the first Waiting note (a note can only start holding when
+// it is the earliest Waiting note in its lane).
+class LaneNoteIndex {
+public:
+    static constexpr int MAX_LANES = 18;
+
+    LaneNoteIndex();
+
+    // Rebuild from beatmap notes (call after loading, notes must not be reordered afterwards)
+    void build(const std::vector<Note>& notes);
+    void clear();
+
+    // First Waiting note in lane (index into notes), -1 if none
+    int findWaiting(const std::vector<Note>& notes, int lane);
+
+    // First hold note in lane with the given live state (Holding or Released), -1 if none
+    int findHold(const std::vector<Note>& notes, int lane, NoteState state);
+
+    // Next note for empty tap keysound, -1 if the lane has no more notes
+    int getNextNote(int lane) const {
+        return (lane >= 0 && lane < MAX_LANES) ? nextNote_[lane] : -1;
+    }
+
+    // Note was hit/missed: empty tap keysound moves to the following note in its lane
+    void onNoteResolved(int lane, int noteIndex);
+
+private:
+    // Skip resolved (Hit/Missed) notes at the front of the lane
+    void advance(const std::vector<Note>& notes, int lane);
+
+    std::vector<int> laneNotes_[MAX_LANES];  // Note indices per lane, chart order
+    std::vector<int> lanePos_;               // Note index -> position in its lane (-1 for fake/invalid)
+    size_t cursor_[MAX_LANES];               // First unresolved position per lane
+    int nextNote_[MAX_LANES];                // Empty tap keysound note per lane
+};
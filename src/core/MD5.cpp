@@ -1,35 +1,12 @@
 #include "MD5.h"
+#include "MappedFile.h"
 #include <fstream>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
-
-// MD5 constants
-static const uint32_t S[64] = {
-    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
-    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
-    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
-    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
-};
-
-static const uint32_t K[64] = {
-    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
-    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
-    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
-    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
-    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
-    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
-    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
-    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
-    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
-    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
-    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
-    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
-    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
-    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
-    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
-    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
-};
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 
@@ -42,36 +19,97 @@ MD5::MD5() : count(0), finalized(false) {
     memset(digest, 0, 16);
 }
 
+// One MD5 step with the round function, message word, constant and shift fixed at compile time
+#define MD5_STEP(f, a, b, c, d, m, k, s) \
+    a += f(b, c, d) + (m) + (k);         \
+    a = ROTL(a, s) + b;
+
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
 void MD5::transform(const uint8_t block[64]) {
     uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
     uint32_t M[16];
 
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+    memcpy(M, block, 64);
+#else
     for (int i = 0; i < 16; i++) {
         M[i] = (uint32_t)block[i*4] | ((uint32_t)block[i*4+1] << 8) |
                ((uint32_t)block[i*4+2] << 16) | ((uint32_t)block[i*4+3] << 24);
     }
-
-    for (int i = 0; i < 64; i++) {
-        uint32_t f, g;
-        if (i < 16) {
-            f = (b & c) | ((~b) & d);
-            g = i;
-        } else if (i < 32) {
-            f = (d & b) | ((~d) & c);
-            g = (5*i + 1) % 16;
-        } else if (i < 48) {
-            f = b ^ c ^ d;
-            g = (3*i + 5) % 16;
-        } else {
-            f = c ^ (b | (~d));
-            g = (7*i) % 16;
-        }
-        uint32_t temp = d;
-        d = c;
-        c = b;
-        b = b + ROTL((a + f + K[i] + M[g]), S[i]);
-        a = temp;
-    }
+#endif
+
+    // Fully unrolled: no per-step branches or table lookups for g and S
+    MD5_STEP(MD5_F, a, b, c, d, M[0],  0xd76aa478, 7)
+    MD5_STEP(MD5_F, d, a, b, c, M[1],  0xe8c7b756, 12)
+    MD5_STEP(MD5_F, c, d, a, b, M[2],  0x242070db, 17)
+    MD5_STEP(MD5_F, b, c, d, a, M[3],  0xc1bdceee, 22)
+    MD5_STEP(MD5_F, a, b, c, d, M[4],  0xf57c0faf, 7)
+    MD5_STEP(MD5_F, d, a, b, c, M[5],  0x4787c62a, 12)
+    MD5_STEP(MD5_F, c, d, a, b, M[6],  0xa8304613, 17)
+    MD5_STEP(MD5_F, b, c, d, a, M[7],  0xfd469501, 22)
+    MD5_STEP(MD5_F, a, b, c, d, M[8],  0x698098d8, 7)
+    MD5_STEP(MD5_F, d, a, b, c, M[9],  0x8b44f7af, 12)
+    MD5_STEP(MD5_F, c, d, a, b, M[10], 0xffff5bb1, 17)
+    MD5_STEP(MD5_F, b, c, d, a, M[11], 0x895cd7be, 22)
+    MD5_STEP(MD5_F, a, b, c, d, M[12], 0x6b901122, 7)
+    MD5_STEP(MD5_F, d, a, b, c, M[13], 0xfd987193, 12)
+    MD5_STEP(MD5_F, c, d, a, b, M[14], 0xa679438e, 17)
+    MD5_STEP(MD5_F, b, c, d, a, M[15], 0x49b40821, 22)
+
+    MD5_STEP(MD5_G, a, b, c, d, M[1],  0xf61e2562, 5)
+    MD5_STEP(MD5_G, d, a, b, c, M[6],  0xc040b340, 9)
+    MD5_STEP(MD5_G, c, d, a, b, M[11], 0x265e5a51, 14)
+    MD5_STEP(MD5_G, b, c, d, a, M[0],  0xe9b6c7aa, 20)
+    MD5_STEP(MD5_G, a, b, c, d, M[5],  0xd62f105d, 5)
+    MD5_STEP(MD5_G, d, a, b, c, M[10], 0x02441453, 9)
+    MD5_STEP(MD5_G, c, d, a, b, M[15], 0xd8a1e681, 14)
+    MD5_STEP(MD5_G, b, c, d, a, M[4],  0xe7d3fbc8, 20)
+    MD5_STEP(MD5_G, a, b, c, d, M[9],  0x21e1cde6, 5)
+    MD5_STEP(MD5_G, d, a, b, c, M[14], 0xc33707d6, 9)
+    MD5_STEP(MD5_G, c, d, a, b, M[3],  0xf4d50d87, 14)
+    MD5_STEP(MD5_G, b, c, d, a, M[8],  0x455a14ed, 20)
+    MD5_STEP(MD5_G, a, b, c, d, M[13], 0xa9e3e905, 5)
+    MD5_STEP(MD5_G, d, a, b, c, M[2],  0xfcefa3f8, 9)
+    MD5_STEP(MD5_G, c, d, a, b, M[7],  0x676f02d9, 14)
+    MD5_STEP(MD5_G, b, c, d, a, M[12], 0x8d2a4c8a, 20)
+
+    MD5_STEP(MD5_H, a, b, c, d, M[5],  0xfffa3942, 4)
+    MD5_STEP(MD5_H, d, a, b, c, M[8],  0x8771f681, 11)
+    MD5_STEP(MD5_H, c, d, a, b, M[11], 0x6d9d6122, 16)
+    MD5_STEP(MD5_H, b, c, d, a, M[14], 0xfde5380c, 23)
+    MD5_STEP(MD5_H, a, b, c, d, M[1],  0xa4beea44, 4)
+    MD5_STEP(MD5_H, d, a, b, c, M[4],  0x4bdecfa9, 11)
+    MD5_STEP(MD5_H, c, d, a, b, M[7],  0xf6bb4b60, 16)
+    MD5_STEP(MD5_H, b, c, d, a, M[10], 0xbebfbc70, 23)
+    MD5_STEP(MD5_H, a, b, c, d, M[13], 0x289b7ec6, 4)
+    MD5_STEP(MD5_H, d, a, b, c, M[0],  0xeaa127fa, 11)
+    MD5_STEP(MD5_H, c, d, a, b, M[3],  0xd4ef3085, 16)
+    MD5_STEP(MD5_H, b, c, d, a, M[6],  0x04881d05, 23)
+    MD5_STEP(MD5_H, a, b, c, d, M[9],  0xd9d4d039, 4)
+    MD5_STEP(MD5_H, d, a, b, c, M[12], 0xe6db99e5, 11)
+    MD5_STEP(MD5_H, c, d, a, b, M[15], 0x1fa27cf8, 16)
+    MD5_STEP(MD5_H, b, c, d, a, M[2],  0xc4ac5665, 23)
+
+    MD5_STEP(MD5_I, a, b, c, d, M[0],  0xf4292244, 6)
+    MD5_STEP(MD5_I, d, a, b, c, M[7],  0x432aff97, 10)
+    MD5_STEP(MD5_I, c, d, a, b, M[14], 0xab9423a7, 15)
+    MD5_STEP(MD5_I, b, c, d, a, M[5],  0xfc93a039, 21)
+    MD5_STEP(MD5_I, a, b, c, d, M[12], 0x655b59c3, 6)
+    MD5_STEP(MD5_I, d, a, b, c, M[3],  0x8f0ccc92, 10)
+    MD5_STEP(MD5_I, c, d, a, b, M[10], 0xffeff47d, 15)
+    MD5_STEP(MD5_I, b, c, d, a, M[1],  0x85845dd1, 21)
+    MD5_STEP(MD5_I, a, b, c, d, M[8],  0x6fa87e4f, 6)
+    MD5_STEP(MD5_I, d, a, b, c, M[15], 0xfe2ce6e0, 10)
+    MD5_STEP(MD5_I, c, d, a, b, M[6],  0xa3014314, 15)
+    MD5_STEP(MD5_I, b, c, d, a, M[13], 0x4e0811a1, 21)
+    MD5_STEP(MD5_I, a, b, c, d, M[4],  0xf7537e82, 6)
+    MD5_STEP(MD5_I, d, a, b, c, M[11], 0xbd3af235, 10)
+    MD5_STEP(MD5_I, c, d, a, b, M[2],  0x2ad7d2bb, 15)
+    MD5_STEP(MD5_I, b, c, d, a, M[9],  0xeb86d391, 21)
 
     state[0] += a;
     state[1] += b;
@@ -127,11 +165,13 @@ void MD5::finalize() {
 
 std::string MD5::hexdigest() const {
     if (!finalized) return "";
-    std::ostringstream oss;
+    static const char hex[] = "0123456789abcdef";
+    std::string out(32, '0');
     for (int i = 0; i < 16; i++) {
-        oss << std::hex << std::setfill('0') << std::setw(2) << (int)digest[i];
+        out[i*2] = hex[digest[i] >> 4];
+        out[i*2+1] = hex[digest[i] & 0xf];
     }
-    return oss.str();
+    return out;
 }
 
 std::string MD5::hash(const uint8_t* data, size_t length) {
@@ -142,17 +182,60 @@ std::string MD5::hash(const uint8_t* data, size_t length) {
 }
 
 std::string MD5::hashFile(const std::string& filepath) {
+    // Hash straight out of the page cache when the file can be mapped
+    MappedFile mapped;
+    if (mapped.open(filepath) && mapped.size() > 0) {
+        return hash(mapped.data(), mapped.size());
+    }
+
     std::ifstream file(filepath, std::ios::binary);
     if (!file) return "";
 
     MD5 md5;
-    char buffer[4096];
-    while (file.read(buffer, sizeof(buffer))) {
-        md5.update((uint8_t*)buffer, file.gcount());
+    std::unique_ptr<char[]> buffer(new char[1 << 20]);
+    while (file.read(buffer.get(), 1 << 20)) {
+        md5.update((uint8_t*)buffer.get(), file.gcount());
     }
     if (file.gcount() > 0) {
-        md5.update((uint8_t*)buffer, file.gcount());
+        md5.update((uint8_t*)buffer.get(), file.gcount());
     }
     md5.finalize();
     return md5.hexdigest();
 }
+
+namespace {
+
+struct CachedDigest {
+    uint64_t size;
+    int64_t mtime;
+    std::string digest;
+};
+
+std::shared_mutex digestCacheMutex;
+std::unordered_map<std::string, CachedDigest> digestCache;
+
+}  // namespace
+
+std::string MD5::hashFileCached(const std::string& filepath) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    uint64_t size = fs::file_size(filepath, ec);
+    if (ec) return hashFile(filepath);
+    int64_t mtime = fs::last_write_time(filepath, ec).time_since_epoch().count();
+    if (ec) return hashFile(filepath);
+
+    {
+        std::shared_lock<std::shared_mutex> lock(digestCacheMutex);
+        auto it = digestCache.find(filepath);
+        if (it != digestCache.end() && it->second.size == size && it->second.mtime == mtime) {
+            return it->second.digest;
+        }
+    }
+
+    std::string digest = hashFile(filepath);
+    if (!digest.empty()) {
+        std::unique_lock<std::shared_mutex> lock(digestCacheMutex);
+        digestCache[filepath] = {size, mtime, digest};
+    }
+    return digest;
+}
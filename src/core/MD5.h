@@ -13,6 +13,8 @@ public:
     // Convenience function
     static std::string hash(const uint8_t* data, size_t length);
     static std::string hashFile(const std::string& filepath);
+    // hashFile through a process-wide (path, size, mtime) -> digest cache (thread-safe)
+    static std::string hashFileCached(const std::string& filepath);
 
 private:
     void transform(const uint8_t block[64]);
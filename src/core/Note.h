@@ -1,15 +1,16 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include "KeysoundName.h"
 
 // Original osu! object type for conversion
-enum class ObjectType {
+enum class ObjectType : uint8_t {
     HitCircle,
     Slider,
     Spinner
 };
 
-enum class NoteState {
+enum class NoteState : uint8_t {
     Waiting,
     Holding,
     Released,  // released mid-hold, can recover
@@ -28,69 +29,103 @@ enum class Judgement {
 };
 
 // osu! SampleSet for hitsounds
-enum class SampleSet {
+enum class SampleSet : uint8_t {
     None = 0,
     Normal = 1,
     Soft = 2,
     Drum = 3
 };
 
+// Laid out hot to cold: the first 64 bytes hold everything the judgement and render
+// loops touch (timing, lane, runtime state); key sound and conversion data follow.
 struct Note {
-    int lane;
+    // Chart timing and placement
     int64_t time;
-    bool isHold;
     int64_t endTime;
+    int lane;
+    bool isHold;
+    bool isFakeNote;       // SV map fake note (NaN time) - visual only, no judgement
+    bool fakeNoteShouldFix; // For fake notes: should position be fixed (extreme SV after endTime)
+    bool fakeNoteHasFixedY; // Whether fakeNoteFixedY has been set
+    float fakeNoteFixedY;  // For fake notes: fixed Y position once appeared
+
+    // Runtime state (see NoteRuntime)
     NoteState state;
-    int64_t nextTickTime;  // for hold note ticks
-    int64_t headHitError;  // for hold note combined judgement
     bool hadComboBreak;    // true if released mid-hold or head missed
     bool headHit;          // true if head was hit (pressed in time)
     bool headHitEarly;     // true if head was hit early (currentTime < note.time)
+    int64_t nextTickTime;  // for hold note ticks
+    int64_t headHitError;  // for hold note combined judgement
     int64_t headReleaseTime; // time when head started falling (after release)
     int64_t headGrayStartTime; // time when head started turning gray (60ms transition)
-    float x;               // original X coordinate (for conversion)
-    ObjectType objectType; // original object type (HitCircle/Slider/Spinner)
-    int spanCount;         // for Slider: number of spans
-    int segmentDuration;   // for Slider: duration per span in ms
-    bool hasClap;          // HIT_CLAP sound
-    bool hasFinish;        // HIT_FINISH sound
-    bool hasWhistle;       // HIT_WHISTLE sound
-    bool isFakeNote;       // SV map fake note (NaN time) - visual only, no judgement
-    bool fakeNoteShouldFix; // For fake notes: should position be fixed (extreme SV after endTime)
-    float fakeNoteFixedY;  // For fake notes: fixed Y position once appeared
-    bool fakeNoteHasFixedY; // Whether fakeNoteFixedY has been set
 
     // Key sound data (from extras field)
+    int sampleHandle;          // Audio handle (-1 = no custom sample)
+    int tailSampleHandle;
     SampleSet sampleSet;       // Main SampleSet (0=default, 1=Normal, 2=Soft, 3=Drum)
     SampleSet additions;       // Additional SampleSet
+    SampleSet tailSampleSet;   // For hold notes: tail sound data
+    SampleSet tailAdditions;
     int customIndex;           // Custom sample index
     int volume;                // Volume (0-100, 0 means use timing point volume)
-    std::string filename;      // Custom sample filename
-    int sampleHandle;          // Audio handle (-1 = no custom sample)
-
-    // For hold notes: tail sound data
-    SampleSet tailSampleSet;
-    SampleSet tailAdditions;
     int tailCustomIndex;
     int tailVolume;
-    std::string tailFilename;
-    int tailSampleHandle;
+    KeysoundName filename;     // Custom sample filename
+    KeysoundName tailFilename;
 
-    // Missed note fall animation (ignore SV)
-    int64_t missedTime;      // Time when note was missed
-    float missedY;           // Y position when note was missed
-    bool missedYSet;         // Whether missedY has been set
+    // Original osu! object data (for conversion)
+    float x;               // original X coordinate
+    ObjectType objectType; // original object type (HitCircle/Slider/Spinner)
+    bool hasClap;          // HIT_CLAP sound
+    bool hasFinish;        // HIT_FINISH sound
+    bool hasWhistle;       // HIT_WHISTLE sound
+    int spanCount;         // for Slider: number of spans
+    int segmentDuration;   // for Slider: duration per span in ms
 
     Note(int lane, int64_t time, bool isHold = false, int64_t endTime = 0)
-        : lane(lane), time(time), isHold(isHold), endTime(endTime),
-          state(NoteState::Waiting), nextTickTime(0), headHitError(0),
-          hadComboBreak(false), headHit(false), headHitEarly(false), headReleaseTime(0), headGrayStartTime(0), x(0),
-          objectType(ObjectType::HitCircle), spanCount(1), segmentDuration(0),
-          hasClap(false), hasFinish(false), hasWhistle(false), isFakeNote(false),
-          fakeNoteShouldFix(false), fakeNoteFixedY(0), fakeNoteHasFixedY(false),
+        : time(time), endTime(endTime), lane(lane), isHold(isHold), isFakeNote(false),
+          fakeNoteShouldFix(false), fakeNoteHasFixedY(false), fakeNoteFixedY(0),
+          state(NoteState::Waiting), hadComboBreak(false), headHit(false), headHitEarly(false),
+          nextTickTime(0), headHitError(0), headReleaseTime(0), headGrayStartTime(0),
+          sampleHandle(-1), tailSampleHandle(-1),
           sampleSet(SampleSet::None), additions(SampleSet::None),
-          customIndex(0), volume(0), sampleHandle(-1),
           tailSampleSet(SampleSet::None), tailAdditions(SampleSet::None),
-          tailCustomIndex(0), tailVolume(0), tailSampleHandle(-1),
-          missedTime(0), missedY(0), missedYSet(false) {}
+          customIndex(0), volume(0), tailCustomIndex(0), tailVolume(0),
+          x(0), objectType(ObjectType::HitCircle), hasClap(false), hasFinish(false), hasWhistle(false),
+          spanCount(1), segmentDuration(0) {}
+};
+
+// Runtime part of a Note, copied on its own where only play state is needed
+// (gameplay snapshots)
+struct NoteRuntime {
+    NoteState state;
+    bool hadComboBreak;
+    bool headHit;
+    bool headHitEarly;
+    int64_t nextTickTime;
+    int64_t headHitError;
+    int64_t headReleaseTime;
+    int64_t headGrayStartTime;
+
+    void capture(const Note& note) {
+        state = note.state;
+        hadComboBreak = note.hadComboBreak;
+        headHit = note.headHit;
+        headHitEarly = note.headHitEarly;
+        nextTickTime = note.nextTickTime;
+        headHitError = note.headHitError;
+        headReleaseTime = note.headReleaseTime;
+        headGrayStartTime = note.headGrayStartTime;
+    }
+
+    void apply(Note& note) const {
+        note.state = state;
+        note.hadComboBreak = hadComboBreak;
+        note.headHit = headHit;
+        note.headHitEarly = headHitEarly;
+        note.nextTickTime = nextTickTime;
+        note.headHitError = headHitError;
+        note.headReleaseTime = headReleaseTime;
+        note.headGrayStartTime = headGrayStartTime;
+    }
 };
@@ -43,6 +43,9 @@ struct Settings {
     int audioOutputMode;  // 0=DirectSound, 1=WASAPI Shared, 2=WASAPI Exclusive, 3=ASIO
     int audioBufferSize;  // Buffer size in ms
     int asioDevice;       // ASIO device index
+    bool keysoundDiskCache;  // Keep decoded keysounds on disk across sessions
+    bool keysoundStreaming;  // Decode keysounds during play, just before they are needed
+    bool softwareMixer;      // Mix keysounds in software instead of a BASS channel per hit
     int quality;
     bool lowSpecMode;
     int resolution;
@@ -103,6 +106,9 @@ struct Settings {
     // Star rating settings
     int starRatingVersion;  // 0 = b20260101
 
+    // Song select
+    int songSortMode;  // SongSortMode
+
     Settings() {
         volume = 100;
         keysoundVolume = 100;
@@ -110,6 +116,9 @@ struct Settings {
         audioOffset = 0;  // Default no offset
         audioOutputMode = 0;  // DirectSound
         audioBufferSize = 40; // 40ms default
+        keysoundDiskCache = false;
+        keysoundStreaming = false;
+        softwareMixer = false;
         asioDevice = 0;
         quality = 2;
         lowSpecMode = false;
@@ -174,6 +183,8 @@ struct Settings {
 
         starRatingVersion = 0;  // Default: b20260101
 
+        songSortMode = 0;  // Default: title
+
         int64_t windows[] = {16, 64, 97, 127, 151, 188};
         double accs[] = {100, 100, 66.67, 33.33, 16.67, 0};
         bool breaks[] = {false, false, false, false, false, true};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Beatmap source type
+enum class BeatmapSource {
+    Osu,
+    DJMaxRespect,  // DJMAX RESPECT (.bytes files)
+    DJMaxOnline,   // DJMAX Online (.pt files)
+    O2Jam,
+    BMS,
+    Malody,
+    MuSynx,
+    IIDX,          // beatmania IIDX (.1 files)
+    StepMania,     // StepMania (.sm/.ssc files)
+    SDVX,          // Sound Voltex (.vox files)
+    EZ2AC,         // EZ2AC (.ez files)
+    EZ2ON          // EZ2ON REBOOT:R (.ezi files)
+};
+
+// Difficulty info for song select
+struct DifficultyInfo {
+    std::string path;       // Full path to beatmap file
+    std::string version;    // Difficulty name
+    std::string creator;    // Charter/mapper
+    std::string hash;       // MD5 hash of beatmap file
+    int keyCount;           // Number of keys (4K, 7K, etc.)
+    // Star ratings for each algorithm version (matches STAR_RATING_VERSION_COUNT)
+    // [0] = b20260101, [1] = b20220101
+    double starRatings[2] = {0.0, 0.0};
+    // Per-difficulty background and audio (may differ from song-level defaults)
+    std::string backgroundPath;  // Background image path for this difficulty
+    std::string audioPath;       // Audio file path for this difficulty
+    int previewTime = 0;         // Preview start time in ms (-1 = 40% position)
+    // Metadata for header display
+    int totalLength = 0;         // Song length in ms (last note time)
+    double bpmMin = 0;           // Minimum BPM
+    double bpmMax = 0;           // Maximum BPM
+    double bpmMost = 0;          // Most dominant BPM (longest duration)
+    int totalObjects = 0;        // Total note count
+    int rcCount = 0;             // Regular (tap) note count
+    int lnCount = 0;             // Long note count
+    float od = 0;                // Overall Difficulty
+    float hp = 0;                // HP Drain
+};
+
+// Song entry for song select screen
+struct SongEntry {
+    std::string folderPath;      // Full path to song folder
+    std::string folderName;      // Folder name (for display)
+    std::string title;           // Song title (from beatmap)
+    std::string titleUnicode;    // Song title (Unicode version)
+    std::string artist;          // Artist name (from beatmap)
+    std::string artistUnicode;   // Artist name (Unicode version)
+    std::string backgroundPath;  // Path to background image
+    std::string audioPath;       // Path to audio file
+    std::string sourceText;      // Source metadata (e.g. "Touhou", "Vocaloid")
+    std::string tags;            // Space-separated tags
+    int previewTime = 0;         // Preview start time in ms
+    std::vector<std::string> beatmapFiles;  // List of beatmap files (legacy)
+    std::vector<DifficultyInfo> difficulties;  // Detailed difficulty info
+    BeatmapSource source;        // osu!, DJMAX, O2Jam
+    int64_t dateAdded = 0;       // Folder modification time when indexed (ns)
+
+    // After a scan: drop per-difficulty paths that repeat the song-level ones (empty already
+    // means "use the song's") and spare vector capacity, so a large library keeps one copy of
+    // each path per song
+    void compact() {
+        for (auto& d : difficulties) {
+            if (d.backgroundPath == backgroundPath) std::string().swap(d.backgroundPath);
+            if (d.audioPath == audioPath) std::string().swap(d.audioPath);
+        }
+        difficulties.shrink_to_fit();
+        beatmapFiles.shrink_to_fit();
+    }
+};
@@ -0,0 +1,457 @@
+#include "SongSearchIndex.h"
+#include "SongEntry.h"
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+
+// --- Search parsing helpers ---
+
+static const char* sourceToString(BeatmapSource src) {
+    switch (src) {
+        case BeatmapSource::Osu: return "osu!";
+        case BeatmapSource::DJMaxRespect: return "DJMAX RESPECT";
+        case BeatmapSource::DJMaxOnline: return "DJMAX ONLINE";
+        case BeatmapSource::O2Jam: return "O2Jam";
+        case BeatmapSource::BMS: return "BMS";
+        case BeatmapSource::Malody: return "Malody";
+        case BeatmapSource::MuSynx: return "MUSYNX MUSYNC";
+        case BeatmapSource::IIDX: return "Beatmania IIDX";
+        case BeatmapSource::StepMania: return "StepMania";
+        case BeatmapSource::SDVX: return "Sound Voltex";
+        case BeatmapSource::EZ2AC: return "EZ2AC";
+        case BeatmapSource::EZ2ON: return "EZ2ON REBOOT:R";
+        default: return "";
+    }
+}
+
+// Parse duration string: "1:30", "1m30s", "90" -> seconds
+static double parseDurationSeconds(const std::string& s) {
+    size_t colonPos = s.find(':');
+    if (colonPos != std::string::npos) {
+        try {
+            double mins = std::stod(s.substr(0, colonPos));
+            double secs = std::stod(s.substr(colonPos + 1));
+            return mins * 60.0 + secs;
+        } catch (...) {}
+    }
+    size_t mPos = s.find('m');
+    size_t sPos = s.find('s');
+    if (mPos != std::string::npos) {
+        try {
+            double mins = std::stod(s.substr(0, mPos));
+            double secs = 0;
+            if (sPos != std::string::npos && sPos > mPos + 1)
+                secs = std::stod(s.substr(mPos + 1, sPos - mPos - 1));
+            return mins * 60.0 + secs;
+        } catch (...) {}
+    }
+    try { return std::stod(s); } catch (...) { return -1; }
+}
+
+static std::vector<SearchToken> parseSearchTokens(const std::string& search) {
+    std::vector<SearchToken> tokens;
+    size_t i = 0;
+    size_t len = search.size();
+
+    while (i < len) {
+        while (i < len && (search[i] == ' ' || search[i] == '\t')) i++;
+        if (i >= len) break;
+
+        // [DiffName]
+        if (search[i] == '[') {
+            size_t end = search.find(']', i + 1);
+            if (end != std::string::npos) {
+                SearchToken t;
+                t.type = SearchToken::DiffName;
+                t.text = search.substr(i + 1, end - i - 1);
+                t.op = 0; t.numValue = 0;
+                tokens.push_back(t);
+                i = end + 1;
+                continue;
+            }
+        }
+
+        // "Quoted phrase" or "Quoted phrase"!
+        if (search[i] == '"') {
+            size_t end = search.find('"', i + 1);
+            if (end != std::string::npos) {
+                std::string phrase = search.substr(i + 1, end - i - 1);
+                bool exclude = (end + 1 < len && search[end + 1] == '!');
+                SearchToken t;
+                t.type = exclude ? SearchToken::ExcludePhrase : SearchToken::ExactPhrase;
+                t.text = phrase;
+                t.op = 0; t.numValue = 0;
+                tokens.push_back(t);
+                i = exclude ? end + 2 : end + 1;
+                continue;
+            }
+        }
+
+        // Read word until whitespace
+        size_t wordStart = i;
+        while (i < len && search[i] != ' ' && search[i] != '\t') i++;
+        std::string word = search.substr(wordStart, i - wordStart);
+        if (word.empty()) continue;
+
+        // Check for keyword filter (key op value)
+        size_t opPos = std::string::npos;
+        int opType = -1;
+        for (size_t j = 0; j < word.size(); j++) {
+            if (word[j] == '>' && j + 1 < word.size() && word[j + 1] == '=') {
+                opPos = j; opType = 3; break;
+            }
+            if (word[j] == '<' && j + 1 < word.size() && word[j + 1] == '=') {
+                opPos = j; opType = 4; break;
+            }
+            if (word[j] == '=') { opPos = j; opType = 0; break; }
+            if (word[j] == '>') { opPos = j; opType = 1; break; }
+            if (word[j] == '<') { opPos = j; opType = 2; break; }
+        }
+
+        if (opPos != std::string::npos && opPos > 0) {
+            std::string key = word.substr(0, opPos);
+            int opLen = (opType == 3 || opType == 4) ? 2 : 1;
+            std::string value = word.substr(opPos + opLen);
+            for (auto& c : key) c = tolower((unsigned char)c);
+
+            bool isNumericKey = (key == "star" || key == "stars" || key == "sr" ||
+                                 key == "hp" || key == "od" || key == "bpm" ||
+                                 key == "length" || key == "key" || key == "keys");
+            bool isStringKey = (key == "creator" || key == "author" || key == "mapper" ||
+                                key == "artist" || key == "title" || key == "diff" ||
+                                key == "source" || key == "tag");
+
+            if (isNumericKey && !value.empty()) {
+                SearchToken t;
+                t.type = SearchToken::KeywordNumeric;
+                t.key = key;
+                t.op = opType;
+                t.numValue = (key == "length") ? parseDurationSeconds(value) : 0;
+                if (key != "length") {
+                    try { t.numValue = std::stod(value); } catch (...) { t.numValue = 0; }
+                }
+                tokens.push_back(t);
+                continue;
+            }
+            if (isStringKey && !value.empty()) {
+                SearchToken t;
+                t.type = SearchToken::KeywordString;
+                t.key = key;
+                t.text = value;
+                t.op = opType; t.numValue = 0;
+                tokens.push_back(t);
+                continue;
+            }
+        }
+
+        // Default: free text
+        SearchToken t;
+        t.type = SearchToken::FreeText;
+        t.text = word;
+        t.op = 0; t.numValue = 0;
+        tokens.push_back(t);
+    }
+
+    return tokens;
+}
+
+static bool compareOp(double val, int op, double target) {
+    switch (op) {
+        case 0: return std::abs(val - target) < 0.01;
+        case 1: return val > target;
+        case 2: return val < target;
+        case 3: return val >= target - 0.001;
+        case 4: return val <= target + 0.001;
+        default: return false;
+    }
+}
+
+// Same folding the old per-keystroke comparison used (ASCII case-insensitive)
+static std::string fold(const std::string& s) {
+    std::string out = s;
+    for (auto& c : out) c = (char)tolower((unsigned char)c);
+    return out;
+}
+
+static void appendField(std::string& text, const std::string& field) {
+    if (!text.empty()) text += '\x01';
+    text += fold(field);
+}
+
+// Word-boundary phrase match on folded text; fields are separated by '\x01'
+static bool containsWord(const std::string& haystack, const std::string& needle) {
+    if (needle.empty()) return true;
+    size_t pos = 0;
+    while ((pos = haystack.find(needle, pos)) != std::string::npos) {
+        bool leftOk = pos == 0 || haystack[pos - 1] == ' ' || haystack[pos - 1] == '\x01';
+        size_t end = pos + needle.size();
+        bool rightOk = end >= haystack.size() || haystack[end] == ' ' || haystack[end] == '\x01';
+        if (leftOk && rightOk) return true;
+        pos++;
+    }
+    return false;
+}
+
+static bool contains(const std::string& haystack, const std::string& needle) {
+    return haystack.find(needle) != std::string::npos;
+}
+
+static uint32_t trigramKey(const char* p) {
+    return ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint8_t)p[2];
+}
+
+static void collectTrigrams(const std::string& text, std::vector<uint32_t>& out) {
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        if (text[i] == '\x01' || text[i + 1] == '\x01' || text[i + 2] == '\x01') continue;
+        out.push_back(trigramKey(&text[i]));
+    }
+}
+
+// Column for a numeric keyword (order of SongSearchIndex::Column)
+static int numericColumn(const std::string& key, int starVer) {
+    if (key == "star" || key == "stars" || key == "sr") return starVer == 1 ? 1 : 0;
+    if (key == "hp") return 2;
+    if (key == "od") return 3;
+    if (key == "bpm") return 4;
+    if (key == "length") return 5;
+    return 6;  // key, keys
+}
+
+void SongSearchIndex::build(const std::vector<SongEntry>& songs) {
+    songs_.clear();
+    diffs_.clear();
+    trigrams_.clear();
+    for (auto& column : columns_) column.clear();
+    lastValid_ = false;
+
+    songs_.reserve(songs.size());
+    std::vector<uint32_t> songTrigrams;
+    for (uint32_t si = 0; si < songs.size(); si++) {
+        const SongEntry& song = songs[si];
+        IndexedSong is;
+        appendField(is.text, song.title);
+        appendField(is.text, song.titleUnicode);
+        appendField(is.text, song.artist);
+        appendField(is.text, song.artistUnicode);
+        appendField(is.text, song.sourceText);
+        appendField(is.text, song.tags);
+        appendField(is.text, sourceToString(song.source));
+        is.title = fold(song.title);
+        is.artist = fold(song.artist);
+        is.source = fold(sourceToString(song.source)) + '\x01' + fold(song.sourceText);
+        is.tags = fold(song.tags);
+        is.firstDiff = (uint32_t)diffs_.size();
+        is.diffCount = (uint32_t)song.difficulties.size();
+
+        songTrigrams.clear();
+        collectTrigrams(is.text, songTrigrams);
+        for (const auto& d : song.difficulties) {
+            IndexedDiff id;
+            id.version = fold(d.version);
+            id.creator = fold(d.creator);
+            id.text = id.version + '\x01' + id.creator;
+            id.values[ColStar0] = d.starRatings[0];
+            id.values[ColStar1] = d.starRatings[1];
+            id.values[ColHp] = d.hp;
+            id.values[ColOd] = d.od;
+            id.values[ColBpm] = d.bpmMost > 0 ? d.bpmMost : d.bpmMax;
+            id.values[ColLength] = d.totalLength / 1000.0;
+            id.values[ColKeys] = d.keyCount;
+            collectTrigrams(id.text, songTrigrams);
+            for (int c = 0; c < COLUMN_COUNT; c++) {
+                columns_[c].push_back({id.values[c], (uint32_t)diffs_.size()});
+            }
+            diffs_.push_back(std::move(id));
+        }
+        std::sort(songTrigrams.begin(), songTrigrams.end());
+        songTrigrams.erase(std::unique(songTrigrams.begin(), songTrigrams.end()), songTrigrams.end());
+        for (uint32_t t : songTrigrams) trigrams_[t].push_back(si);
+        songs_.push_back(std::move(is));
+    }
+    for (auto& column : columns_) {
+        std::sort(column.begin(), column.end(), [](const ColumnEntry& a, const ColumnEntry& b) { return a.value < b.value; });
+    }
+}
+
+bool SongSearchIndex::matches(const IndexedSong& song, const IndexedDiff& diff,
+                              const std::vector<SearchToken>& tokens, int starVer) const {
+    for (const auto& token : tokens) {
+        bool matched = false;
+        switch (token.type) {
+            case SearchToken::FreeText:
+                matched = contains(song.text, token.text) || contains(diff.text, token.text);
+                break;
+            case SearchToken::ExactPhrase:
+                matched = containsWord(song.text, token.text) || containsWord(diff.text, token.text);
+                break;
+            case SearchToken::ExcludePhrase:
+                matched = !contains(song.text, token.text) && !contains(diff.text, token.text);
+                break;
+            case SearchToken::DiffName:
+                matched = contains(diff.version, token.text);
+                break;
+            case SearchToken::KeywordNumeric:
+                matched = compareOp(diff.values[numericColumn(token.key, starVer)], token.op, token.numValue);
+                break;
+            case SearchToken::KeywordString: {
+                const std::string& key = token.key;
+                if (key == "creator" || key == "author" || key == "mapper") {
+                    matched = contains(diff.creator, token.text);
+                } else if (key == "artist") {
+                    matched = contains(song.artist, token.text);
+                } else if (key == "title") {
+                    matched = contains(song.title, token.text);
+                } else if (key == "diff") {
+                    matched = contains(diff.version, token.text);
+                } else if (key == "source") {
+                    matched = contains(song.source, token.text);
+                } else if (key == "tag") {
+                    matched = contains(song.tags, token.text);
+                }
+                break;
+            }
+        }
+        if (!matched) return false;
+    }
+    return true;
+}
+
+// Songs whose combined text contains every trigram of the (folded) token
+void SongSearchIndex::trigramCandidates(const std::string& text, std::vector<uint32_t>& songs) const {
+    std::vector<uint32_t> keys;
+    collectTrigrams(text, keys);
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t key : keys) {
+        auto it = trigrams_.find(key);
+        if (it == trigrams_.end()) {
+            songs.clear();
+            return;
+        }
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    songs = *lists[0];
+    std::vector<uint32_t> next;
+    for (size_t i = 1; i < lists.size() && !songs.empty(); i++) {
+        next.clear();
+        std::set_intersection(songs.begin(), songs.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        songs.swap(next);
+    }
+}
+
+// Difficulties whose column value satisfies a numeric filter
+void SongSearchIndex::columnCandidates(const SearchToken& token, int starVer, std::vector<uint8_t>& diffMask) const {
+    const auto& column = columns_[numericColumn(token.key, starVer)];
+    auto below = [](const ColumnEntry& e, double v) { return e.value < v; };
+    auto above = [](double v, const ColumnEntry& e) { return v < e.value; };
+    double t = token.numValue;
+    auto first = column.begin(), last = column.end();
+    switch (token.op) {
+        case 0: first = std::lower_bound(column.begin(), column.end(), t - 0.01, below);
+                last = std::upper_bound(first, column.end(), t + 0.01, above); break;
+        case 1: first = std::upper_bound(column.begin(), column.end(), t, above); break;
+        case 2: last = std::lower_bound(column.begin(), column.end(), t, below); break;
+        case 3: first = std::lower_bound(column.begin(), column.end(), t - 0.001, below); break;
+        case 4: last = std::upper_bound(column.begin(), column.end(), t + 0.001, above); break;
+    }
+    std::vector<uint8_t> mask(diffs_.size(), 0);
+    for (auto it = first; it < last; ++it) {
+        if (compareOp(it->value, token.op, t)) mask[it->diff] = 1;
+    }
+    if (diffMask.empty()) {
+        diffMask.swap(mask);
+    } else {
+        for (size_t i = 0; i < mask.size(); i++) diffMask[i] &= mask[i];
+    }
+}
+
+// True if every result of the new query is among the previous results: same tokens, each
+// substring filter at least as long (containing the old text), possibly with tokens added
+bool SongSearchIndex::refines(const std::vector<SearchToken>& tokens, int starVer) const {
+    if (!lastValid_ || lastTokens_.empty() || starVer != lastStarVer_ || tokens.size() < lastTokens_.size()) return false;
+    for (size_t i = 0; i < lastTokens_.size(); i++) {
+        const SearchToken& a = lastTokens_[i];
+        const SearchToken& b = tokens[i];
+        if (a.type != b.type || a.key != b.key || a.op != b.op || a.numValue != b.numValue) return false;
+        bool substringFilter = a.type == SearchToken::FreeText || a.type == SearchToken::DiffName ||
+                               a.type == SearchToken::KeywordString;
+        if (substringFilter ? !contains(b.text, a.text) : a.text != b.text) return false;
+    }
+    return true;
+}
+
+void SongSearchIndex::query(const std::string& search, int starVer,
+                            std::vector<int>& songIndices, std::vector<std::vector<int>>& diffIndices) {
+    songIndices.clear();
+    diffIndices.clear();
+    starVer = starVer == 1 ? 1 : 0;
+
+    auto tokens = parseSearchTokens(search);
+    for (auto& token : tokens) token.text = fold(token.text);
+
+    if (tokens.empty()) {
+        for (uint32_t si = 0; si < songs_.size(); si++) {
+            std::vector<int> allDiffs(songs_[si].diffCount);
+            for (int d = 0; d < (int)allDiffs.size(); d++) allDiffs[d] = d;
+            songIndices.push_back((int)si);
+            diffIndices.push_back(std::move(allDiffs));
+        }
+    } else if (refines(tokens, starVer)) {
+        for (size_t k = 0; k < lastSongs_.size(); k++) {
+            const IndexedSong& song = songs_[lastSongs_[k]];
+            std::vector<int> matching;
+            for (int d : lastDiffs_[k]) {
+                if (matches(song, diffs_[song.firstDiff + d], tokens, starVer)) matching.push_back(d);
+            }
+            if (!matching.empty()) {
+                songIndices.push_back(lastSongs_[k]);
+                diffIndices.push_back(std::move(matching));
+            }
+        }
+    } else {
+        // Narrow with the trigram index and numeric columns, then verify each candidate
+        std::vector<uint32_t> candidates, tokenSongs, next;
+        bool narrowed = false;
+        std::vector<uint8_t> diffMask;
+        for (const auto& token : tokens) {
+            if (token.type == SearchToken::KeywordNumeric) {
+                columnCandidates(token, starVer, diffMask);
+                continue;
+            }
+            if (token.type == SearchToken::ExcludePhrase || token.text.size() < 3) continue;
+            trigramCandidates(token.text, tokenSongs);
+            if (!narrowed) {
+                candidates.swap(tokenSongs);
+                narrowed = true;
+            } else {
+                next.clear();
+                std::set_intersection(candidates.begin(), candidates.end(), tokenSongs.begin(), tokenSongs.end(),
+                                      std::back_inserter(next));
+                candidates.swap(next);
+            }
+        }
+        if (!narrowed) {
+            candidates.resize(songs_.size());
+            for (uint32_t si = 0; si < songs_.size(); si++) candidates[si] = si;
+        }
+        for (uint32_t si : candidates) {
+            const IndexedSong& song = songs_[si];
+            std::vector<int> matching;
+            for (uint32_t d = 0; d < song.diffCount; d++) {
+                uint32_t di = song.firstDiff + d;
+                if (!diffMask.empty() && !diffMask[di]) continue;
+                if (matches(song, diffs_[di], tokens, starVer)) matching.push_back((int)d);
+            }
+            if (!matching.empty()) {
+                songIndices.push_back((int)si);
+                diffIndices.push_back(std::move(matching));
+            }
+        }
+    }
+
+    lastTokens_ = std::move(tokens);
+    lastStarVer_ = starVer;
+    lastSongs_ = songIndices;
+    lastDiffs_ = diffIndices;
+    lastValid_ = true;
+}
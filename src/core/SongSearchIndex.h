@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SongEntry;
+
+struct SearchToken {
+    enum Type { FreeText, ExactPhrase, ExcludePhrase, DiffName, KeywordNumeric, KeywordString };
+    Type type;
+    std::string text;
+    std::string key;
+    int op;             // 0: =, 1: >, 2: <, 3: >=, 4: <=
+    double numValue;
+};
+
+// Song-select search index, built once per scan.
+// Holds case-folded field text per song and difficulty, a trigram index over all free text
+// (song-level posting lists) and sorted numeric columns for keyword filters. A query that
+// only narrows the previous one (typing further) is evaluated against the previous result.
+class SongSearchIndex {
+public:
+    void build(const std::vector<SongEntry>& songs);
+    size_t songCount() const { return songs_.size(); }
+
+    // Songs matching the search and, per song, the matching difficulty indices
+    void query(const std::string& search, int starVer,
+               std::vector<int>& songIndices, std::vector<std::vector<int>>& diffIndices);
+
+private:
+    enum Column { ColStar0, ColStar1, ColHp, ColOd, ColBpm, ColLength, ColKeys, COLUMN_COUNT };
+
+    struct IndexedSong {
+        std::string text;    // All free-text fields, folded, separated by '\x01'
+        std::string title;
+        std::string artist;
+        std::string source;  // Source name and source text
+        std::string tags;
+        uint32_t firstDiff;
+        uint32_t diffCount;
+    };
+    struct IndexedDiff {
+        std::string text;    // Version and creator, folded
+        std::string version;
+        std::string creator;
+        double values[COLUMN_COUNT];
+    };
+    struct ColumnEntry {
+        double value;
+        uint32_t diff;       // Index into diffs_
+    };
+
+    std::vector<IndexedSong> songs_;
+    std::vector<IndexedDiff> diffs_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams_;  // Trigram -> ascending song indices
+    std::vector<ColumnEntry> columns_[COLUMN_COUNT];                // Ascending by value
+
+    // Previous query, for incremental refinement
+    std::vector<SearchToken> lastTokens_;
+    int lastStarVer_ = -1;
+    bool lastValid_ = false;
+    std::vector<int> lastSongs_;
+    std::vector<std::vector<int>> lastDiffs_;
+
+    bool refines(const std::vector<SearchToken>& tokens, int starVer) const;
+    bool matches(const IndexedSong& song, const IndexedDiff& diff, const std::vector<SearchToken>& tokens, int starVer) const;
+    void trigramCandidates(const std::string& text, std::vector<uint32_t>& songs) const;
+    void columnCandidates(const SearchToken& token, int starVer, std::vector<uint8_t>& diffMask) const;
+};
@@ -0,0 +1,168 @@
+#include "SongSort.h"
+#include "Game.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <unicode/ucol.h>
+#include <unicode/ustring.h>
+
+const char* songSortModeName(SongSortMode mode) {
+    switch (mode) {
+        case SongSortMode::Title: return "Title";
+        case SongSortMode::Artist: return "Artist";
+        case SongSortMode::Stars: return "Stars";
+        case SongSortMode::Bpm: return "BPM";
+        case SongSortMode::Length: return "Length";
+        case SongSortMode::DateAdded: return "Date Added";
+        default: return "";
+    }
+}
+
+namespace {
+
+// Null-terminated collation keys for a list of strings, stored back to back
+class CollationKeys {
+public:
+    CollationKeys(const std::vector<SongEntry>& songs, std::string SongEntry::*field) {
+        offsets_.reserve(songs.size());
+        UErrorCode status = U_ZERO_ERROR;
+        UCollator* collator = ucol_open("", &status);  // Default locale
+        if (U_SUCCESS(status) && collator) {
+            // Case-insensitive, numeric ("2" before "10")
+            ucol_setStrength(collator, UCOL_SECONDARY);
+            ucol_setAttribute(collator, UCOL_NUMERIC_COLLATION, UCOL_ON, &status);
+        } else if (collator) {
+            ucol_close(collator);
+            collator = nullptr;
+        }
+
+        std::vector<UChar> utf16;
+        for (const auto& song : songs) {
+            const std::string& text = song.*field;
+            offsets_.push_back(keys_.size());
+            if (!collator) {
+                // ICU unavailable: plain byte order
+                keys_.insert(keys_.end(), text.begin(), text.end());
+                keys_.push_back(0);
+                continue;
+            }
+            // UTF-16 never needs more code units than UTF-8 has bytes
+            utf16.resize(text.size() + 1);
+            int32_t len = 0;
+            UErrorCode err = U_ZERO_ERROR;
+            u_strFromUTF8(utf16.data(), (int32_t)utf16.size(), &len, text.c_str(), (int32_t)text.size(), &err);
+            if (U_FAILURE(err)) len = 0;
+
+            size_t start = keys_.size();
+            keys_.resize(start + text.size() * 4 + 16);
+            int32_t need = ucol_getSortKey(collator, utf16.data(), len, &keys_[start], (int32_t)(keys_.size() - start));
+            if (need > (int32_t)(keys_.size() - start)) {
+                keys_.resize(start + need);
+                need = ucol_getSortKey(collator, utf16.data(), len, &keys_[start], need);
+            }
+            keys_.resize(start + need);  // Includes the terminating 0
+        }
+        if (collator) ucol_close(collator);
+    }
+
+    bool less(uint32_t a, uint32_t b) const {
+        return strcmp(reinterpret_cast<const char*>(&keys_[offsets_[a]]),
+                      reinterpret_cast<const char*>(&keys_[offsets_[b]])) < 0;
+    }
+
+private:
+    std::vector<uint8_t> keys_;
+    std::vector<size_t> offsets_;
+};
+
+std::vector<uint32_t> identityOrder(size_t n) {
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    return order;
+}
+
+std::vector<uint32_t> ranksOf(const std::vector<uint32_t>& order) {
+    std::vector<uint32_t> ranks(order.size());
+    for (uint32_t pos = 0; pos < order.size(); pos++) ranks[order[pos]] = pos;
+    return ranks;
+}
+
+// Ranks by a per-song number; ties keep title order
+template <typename Value>
+std::vector<uint32_t> ranksByValue(const std::vector<SongEntry>& songs, Value value, bool descending) {
+    std::vector<double> values(songs.size());
+    for (size_t i = 0; i < songs.size(); i++) values[i] = value(songs[i]);
+    auto order = identityOrder(songs.size());
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return descending ? values[a] > values[b] : values[a] < values[b];
+    });
+    return ranksOf(order);
+}
+
+// Per-song value over its difficulties (the hardest chart's stars, the longest length, ...)
+template <typename Field>
+double maxOverDiffs(const SongEntry& song, Field field) {
+    double best = 0;
+    for (const auto& d : song.difficulties) best = std::max(best, (double)field(d));
+    return best;
+}
+
+}  // namespace
+
+void SongOrder::sortByTitle(std::vector<SongEntry>& songs) {
+    CollationKeys keys(songs, &SongEntry::title);
+    auto order = identityOrder(songs.size());
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys.less(a, b); });
+
+    std::vector<SongEntry> sorted;
+    sorted.reserve(songs.size());
+    for (uint32_t i : order) sorted.push_back(std::move(songs[i]));
+    songs.swap(sorted);
+}
+
+void SongOrder::build(const std::vector<SongEntry>& songs) {
+    {
+        CollationKeys keys(songs, &SongEntry::artist);
+        auto order = identityOrder(songs.size());
+        std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys.less(a, b); });
+        ranks_[RankArtist] = ranksOf(order);
+    }
+    ranks_[RankStars0] = ranksByValue(songs, [](const SongEntry& s) {
+        return maxOverDiffs(s, [](const DifficultyInfo& d) { return d.starRatings[0]; }); }, false);
+    ranks_[RankStars1] = ranksByValue(songs, [](const SongEntry& s) {
+        return maxOverDiffs(s, [](const DifficultyInfo& d) { return d.starRatings[1]; }); }, false);
+    ranks_[RankBpm] = ranksByValue(songs, [](const SongEntry& s) {
+        return maxOverDiffs(s, [](const DifficultyInfo& d) { return d.bpmMost > 0 ? d.bpmMost : d.bpmMax; }); }, false);
+    ranks_[RankLength] = ranksByValue(songs, [](const SongEntry& s) {
+        return maxOverDiffs(s, [](const DifficultyInfo& d) { return d.totalLength; }); }, false);
+    // Newest first
+    ranks_[RankDateAdded] = ranksByValue(songs, [](const SongEntry& s) { return (double)s.dateAdded; }, true);
+}
+
+void SongOrder::apply(SongSortMode mode, int starVer,
+                      std::vector<int>& songIndices, std::vector<std::vector<int>>& diffIndices) const {
+    const std::vector<uint32_t>* ranks = nullptr;
+    switch (mode) {
+        case SongSortMode::Artist: ranks = &ranks_[RankArtist]; break;
+        case SongSortMode::Stars: ranks = &ranks_[starVer == 1 ? RankStars1 : RankStars0]; break;
+        case SongSortMode::Bpm: ranks = &ranks_[RankBpm]; break;
+        case SongSortMode::Length: ranks = &ranks_[RankLength]; break;
+        case SongSortMode::DateAdded: ranks = &ranks_[RankDateAdded]; break;
+        default: return;  // Title: songList order
+    }
+    if (ranks->empty()) return;
+
+    std::vector<uint32_t> order = identityOrder(songIndices.size());
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return (*ranks)[songIndices[a]] < (*ranks)[songIndices[b]];
+    });
+    std::vector<int> songs(order.size());
+    std::vector<std::vector<int>> diffs(order.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        songs[k] = songIndices[order[k]];
+        diffs[k] = std::move(diffIndices[order[k]]);
+    }
+    songIndices.swap(songs);
+    diffIndices.swap(diffs);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct SongEntry;
+
+enum class SongSortMode { Title, Artist, Stars, Bpm, Length, DateAdded, Count };
+
+const char* songSortModeName(SongSortMode mode);
+
+// Song list orderings. songList itself is kept in title order (ICU collation); every other
+// order is a precomputed rank table, so switching sort mode only reorders the filtered view.
+class SongOrder {
+public:
+    // Sort by title using one collation key per song, then move each entry exactly once
+    static void sortByTitle(std::vector<SongEntry>& songs);
+
+    // Precompute ranks for all orders (songs must already be in title order)
+    void build(const std::vector<SongEntry>& songs);
+
+    // Reorder a filtered view (song indices and their parallel difficulty lists)
+    void apply(SongSortMode mode, int starVer,
+               std::vector<int>& songIndices, std::vector<std::vector<int>>& diffIndices) const;
+
+private:
+    enum Table { RankArtist, RankStars0, RankStars1, RankBpm, RankLength, RankDateAdded, TABLE_COUNT };
+    std::vector<uint32_t> ranks_[TABLE_COUNT];  // Song index -> position in that order
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-writer / single-reader triple buffer.
+// The writer fills write() and publish()es it; the reader calls update() to take the
+// newest published buffer and then reads it with read(). Neither side ever waits:
+// the writer always has a free buffer and the reader keeps its current one until a
+// newer one is available.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : back_(0), middle_(1), front_(2) {}
+
+    T& write() { return buffers_[back_]; }
+    int writeSlot() const { return back_; }
+
+    // Hand the write buffer to the reader. Returns true if the buffer received in
+    // exchange was published but never read (its contents were dropped).
+    bool publish() {
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(back_ | FRESH), std::memory_order_acq_rel);
+        back_ = previous & INDEX_MASK;
+        return (previous & FRESH) != 0;
+    }
+
+    // Take the newest published buffer; returns false if nothing new was published
+    bool update() {
+        if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(front_), std::memory_order_acq_rel);
+        front_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& read() const { return buffers_[front_]; }
+
+    // Direct access to all buffers while neither side is running (initialization)
+    T& slot(int i) { return buffers_[i]; }
+    void reset() {
+        back_ = 0;
+        middle_.store(1, std::memory_order_release);
+        front_ = 2;
+    }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;  // Middle buffer holds data the reader has not taken
+
+    T buffers_[3];
+    int back_;                     // Owned by the writer
+    std::atomic<uint8_t> middle_;  // Exchanged between writer and reader
+    int front_;                    // Owned by the reader
+};
@@ -0,0 +1,162 @@
+#include "WorkStealingPool.h"
+#include <iostream>
+
+namespace {
+// Set on worker threads so run() can tell a nested batch from an outside caller
+thread_local WorkStealingPool* tlsPool = nullptr;
+}
+
+WorkStealingPool* WorkStealingPool::current() {
+    return tlsPool;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 4;
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers_.emplace_back(&WorkStealingPool::workerMain, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workReady_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    unsigned index = nextQueue_++ % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+        pending_++;
+    }
+    workReady_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    allDone_.wait(lock, [this] { return pending_ == 0; });
+}
+
+std::function<void()> WorkStealingPool::take(unsigned index) {
+    // Own queue first (front), then steal from the others (back)
+    for (size_t n = 0; n < queues_.size(); n++) {
+        Queue& q = *queues_[(index + n) % queues_.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        std::function<void()> task;
+        if (n == 0) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        } else {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        return task;
+    }
+    return nullptr;
+}
+
+namespace {
+// Tasks of one run() call. Each is taken exactly once, either by a pool worker or by the
+// caller while it waits, so a waiting worker only ever runs work of its own batch.
+struct Batch {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::deque<std::function<void()>> tasks;
+    size_t remaining = 0;
+
+    std::function<void()> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return nullptr;
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        return task;
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) done.notify_all();
+    }
+};
+}
+
+void WorkStealingPool::run(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) return;
+    const size_t count = tasks.size();
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+    for (auto& task : tasks) {
+        batch->tasks.push_back(std::move(task));
+    }
+    tasks.clear();
+
+    // One pool task per batch task; whichever runs first takes the next one in the batch
+    for (size_t i = 0; i < count; i++) {
+        submit([batch] {
+            std::function<void()> task = batch->take();
+            if (!task) return;  // Already run by the waiting caller
+            invoke(task);
+            batch->finish();
+        });
+    }
+
+    if (tlsPool == this) {
+        // Help with this batch instead of blocking a worker
+        while (std::function<void()> task = batch->take()) {
+            invoke(task);
+            batch->finish();
+        }
+    }
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch] { return batch->remaining == 0; });
+}
+
+void WorkStealingPool::invoke(std::function<void()>& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "[POOL] Task exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[POOL] Task unknown exception" << std::endl;
+    }
+}
+
+void WorkStealingPool::runReserved(unsigned index) {
+    std::function<void()> task;
+    while (!(task = take(index))) {
+        std::this_thread::yield();  // Reserved by the caller, so some queue holds it
+    }
+    invoke(task);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) allDone_.notify_all();
+}
+
+void WorkStealingPool::workerMain(unsigned index) {
+    tlsPool = this;
+    while (true) {
+        {
+            // Reserve one queued task; it is guaranteed to be in some queue
+            std::unique_lock<std::mutex> lock(mutex_);
+            workReady_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+            if (queued_ == 0) return;  // Stopping with nothing left
+            queued_--;
+        }
+        runReserved(index);
+    }
+}
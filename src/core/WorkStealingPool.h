@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task queue per worker.
+// Tasks are spread over the queues round-robin; a worker takes from its own queue and,
+// when that is empty, steals from the back of another worker's queue, so a few slow
+// tasks (huge folders, big charts) do not leave the other workers idle.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threadCount = 0);  // 0 = hardware concurrency
+    ~WorkStealingPool();  // Finishes queued tasks, then joins the workers
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();  // Block until every submitted task has finished
+
+    // Run a batch of tasks and return once all of them have finished. A worker of this pool
+    // calling it runs the batch's own tasks while it waits, so nested batches cannot starve
+    // the pool; it never picks up unrelated tasks, which would nest without bound.
+    void run(std::vector<std::function<void()>>& tasks);
+
+    static WorkStealingPool* current();  // Pool the calling thread works for, or nullptr
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<unsigned> nextQueue_{0};
+
+    std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::condition_variable allDone_;
+    size_t queued_ = 0;   // Submitted, not yet taken by a worker
+    size_t pending_ = 0;  // Submitted, not yet finished
+    bool stopping_ = false;
+
+    void workerMain(unsigned index);
+    std::function<void()> take(unsigned index);
+    void runReserved(unsigned index);  // Run a task already counted off queued_
+    static void invoke(std::function<void()>& task);
+};
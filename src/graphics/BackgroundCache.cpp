@@ -0,0 +1,231 @@
+#include "BackgroundCache.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+BackgroundCache::~BackgroundCache() {
+    shutdown();
+}
+
+void BackgroundCache::init(SDL_Renderer* renderer) {
+    renderer_ = renderer;
+    int w = 0, h = 0;
+    if (SDL_GetCurrentRenderOutputSize(renderer_, &w, &h) && w > 0 && h > 0) {
+        targetW_ = w;
+        targetH_ = h;
+    }
+    stopping_ = false;
+    for (unsigned i = 0; i < LOADER_THREADS; i++) {
+        workers_.emplace_back(&BackgroundCache::workerMain, this);
+    }
+}
+
+void BackgroundCache::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        urgent_.clear();
+        prefetch_.clear();
+    }
+    workReady_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+    workers_.clear();
+    done_.clear();
+    inFlight_.clear();
+
+    for (auto& e : lru_) SDL_DestroyTexture(e.texture);
+    lru_.clear();
+    index_.clear();
+    pixels_ = 0;
+    current_.clear();
+}
+
+SDL_Texture* BackgroundCache::get(const std::string& path) {
+    auto it = index_.find(path);
+    if (it == index_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->texture;
+}
+
+SDL_Texture* BackgroundCache::request(const std::string& path) {
+    current_ = path;
+    if (SDL_Texture* texture = get(path)) return texture;
+    if (failed_.count(path)) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inFlight_.count(path)) {
+        // Already prefetching: promote it unless a loader has it already
+        auto it = std::find(prefetch_.begin(), prefetch_.end(), path);
+        if (it == prefetch_.end()) return nullptr;
+        prefetch_.erase(it);
+    }
+    // The previous request is no longer wanted once the selection has moved on
+    if (!urgent_.empty() && urgent_ != path) inFlight_.erase(urgent_);
+    urgent_ = path;
+    inFlight_.insert(path);
+    workReady_.notify_one();
+    return nullptr;
+}
+
+void BackgroundCache::prefetch(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& p : prefetch_) inFlight_.erase(p);
+    prefetch_.clear();
+    for (const auto& p : paths) {
+        if (index_.count(p) || failed_.count(p) || inFlight_.count(p)) continue;
+        prefetch_.push_back(p);
+        inFlight_.insert(p);
+    }
+    if (!prefetch_.empty()) workReady_.notify_all();
+}
+
+void BackgroundCache::update(int maxPrefetchUploads) {
+    std::vector<Decoded> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int w = 0, h = 0;
+        if (renderer_ && SDL_GetCurrentRenderOutputSize(renderer_, &w, &h) && w > 0 && h > 0) {
+            targetW_ = w;
+            targetH_ = h;
+        }
+        if (done_.empty()) return;
+        int prefetched = 0;
+        for (size_t i = 0; i < done_.size();) {
+            bool wanted = done_[i].path == current_;
+            if (wanted || prefetched < maxPrefetchUploads) {
+                if (!wanted) prefetched++;
+                inFlight_.erase(done_[i].path);
+                ready.push_back(std::move(done_[i]));
+                done_.erase(done_.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+    for (auto& d : ready) upload(d);
+}
+
+void BackgroundCache::upload(Decoded& decoded) {
+    if (decoded.rgba.empty()) {
+        failed_.insert(decoded.path);
+        return;
+    }
+    if (index_.count(decoded.path)) return;
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                             decoded.w, decoded.h);
+    if (!texture) return;
+    SDL_UpdateTexture(texture, nullptr, decoded.rgba.data(), decoded.w * 4);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    size_t pixels = (size_t)decoded.w * decoded.h;
+    lru_.push_front({decoded.path, texture, pixels});
+    index_[decoded.path] = lru_.begin();
+    pixels_ += pixels;
+    evict();
+}
+
+void BackgroundCache::evict() {
+    auto it = lru_.end();
+    while (pixels_ > MAX_PIXELS && it != lru_.begin()) {
+        --it;
+        if (it->path == current_ || it == lru_.begin()) continue;  // Keep the shown and the newest image
+        SDL_DestroyTexture(it->texture);
+        pixels_ -= it->pixels;
+        index_.erase(it->path);
+        it = lru_.erase(it);
+    }
+}
+
+void BackgroundCache::workerMain() {
+    for (;;) {
+        std::string path;
+        int maxW, maxH;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workReady_.wait(lock, [this] { return stopping_ || !urgent_.empty() || !prefetch_.empty(); });
+            if (stopping_) return;
+            if (!urgent_.empty()) {
+                path.swap(urgent_);
+            } else {
+                path = std::move(prefetch_.front());
+                prefetch_.pop_front();
+            }
+            maxW = targetW_;
+            maxH = targetH_;
+        }
+
+        Decoded decoded;
+        decoded.path = path;
+        decode(path, maxW, maxH, decoded);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        if (!inFlight_.count(path)) continue;  // Dropped while decoding
+        done_.push_back(std::move(decoded));
+    }
+}
+
+void BackgroundCache::decode(const std::string& path, int maxW, int maxH, Decoded& out) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "[BG] Failed to load " << path << std::endl;
+        return;
+    }
+
+    // Crop DJMAX Online eyecatch images (1024x1024 -> 800x600)
+    int srcW = width, srcH = height;
+    if (width == 1024 && height == 1024) {
+        srcW = 800;
+        srcH = 600;
+    }
+    const size_t stride = (size_t)width * 4;
+
+    // Backgrounds are stretched to the screen, so each axis is only limited by the output size
+    int w = std::min(srcW, maxW);
+    int h = std::min(srcH, maxH);
+    out.w = w;
+    out.h = h;
+    out.rgba.resize((size_t)w * h * 4);
+
+    if (w == srcW && h == srcH) {
+        for (int y = 0; y < h; y++) {
+            memcpy(&out.rgba[(size_t)y * w * 4], data + y * stride, (size_t)w * 4);
+        }
+    } else {
+        // Box filter: each output pixel averages the source pixels it covers
+        std::vector<uint32_t> sums((size_t)w * 4);
+        for (int y = 0; y < h; y++) {
+            int sy0 = (int)((int64_t)y * srcH / h);
+            int sy1 = std::max(sy0 + 1, (int)((int64_t)(y + 1) * srcH / h));
+            std::fill(sums.begin(), sums.end(), 0u);
+            for (int sy = sy0; sy < sy1; sy++) {
+                const unsigned char* row = data + sy * stride;
+                for (int x = 0; x < w; x++) {
+                    int sx0 = (int)((int64_t)x * srcW / w);
+                    int sx1 = std::max(sx0 + 1, (int)((int64_t)(x + 1) * srcW / w));
+                    uint32_t* s = &sums[(size_t)x * 4];
+                    for (int sx = sx0; sx < sx1; sx++) {
+                        const unsigned char* p = row + sx * 4;
+                        s[0] += p[0];
+                        s[1] += p[1];
+                        s[2] += p[2];
+                        s[3] += p[3];
+                    }
+                }
+            }
+            uint8_t* dst = &out.rgba[(size_t)y * w * 4];
+            for (int x = 0; x < w; x++) {
+                int sx0 = (int)((int64_t)x * srcW / w);
+                int sx1 = std::max(sx0 + 1, (int)((int64_t)(x + 1) * srcW / w));
+                uint32_t count = (uint32_t)((sx1 - sx0) * (sy1 - sy0));
+                for (int c = 0; c < 4; c++) dst[x * 4 + c] = (uint8_t)((sums[(size_t)x * 4 + c] + count / 2) / count);
+            }
+        }
+    }
+    stbi_image_free(data);
+}
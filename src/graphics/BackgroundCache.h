@@ -0,0 +1,78 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Song-select backgrounds. Images are decoded by a small pool of loader threads, downscaled
+// to the render output size and kept as textures in an LRU under a pixel budget, so going
+// back to a song (or moving to a prefetched neighbour) shows its background immediately.
+// Everything except the loaders runs on the render thread.
+class BackgroundCache {
+public:
+    BackgroundCache() = default;
+    ~BackgroundCache();
+    BackgroundCache(const BackgroundCache&) = delete;
+    BackgroundCache& operator=(const BackgroundCache&) = delete;
+
+    void init(SDL_Renderer* renderer);
+    void shutdown();  // Stop the loaders and destroy all textures (before destroying the renderer)
+
+    // Texture for path if it is loaded; otherwise its load is queued ahead of any prefetch
+    // and nullptr is returned. The last requested image is never evicted.
+    SDL_Texture* request(const std::string& path);
+    SDL_Texture* get(const std::string& path);  // Loaded texture or nullptr, never queues
+
+    // Replace queued prefetches with these paths (nearest first)
+    void prefetch(const std::vector<std::string>& paths);
+
+    // Upload finished decodes: the requested image always, at most maxPrefetchUploads others
+    void update(int maxPrefetchUploads);
+
+private:
+    static const size_t MAX_PIXELS = 24 * 1024 * 1024;  // 96MB of RGBA textures
+    static const unsigned LOADER_THREADS = 2;
+
+    struct Entry {
+        std::string path;
+        SDL_Texture* texture;
+        size_t pixels;
+    };
+    struct Decoded {
+        std::string path;
+        std::vector<uint8_t> rgba;  // Empty = decode failed
+        int w = 0;
+        int h = 0;
+    };
+
+    SDL_Renderer* renderer_ = nullptr;
+    std::list<Entry> lru_;  // Front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t pixels_ = 0;
+    std::string current_;                  // Last requested path (pinned)
+    std::unordered_set<std::string> failed_;  // Unreadable images, not retried
+
+    // Loader state
+    std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::string urgent_;                   // Requested image, taken before prefetches
+    std::deque<std::string> prefetch_;
+    std::unordered_set<std::string> inFlight_;  // Queued, decoding or waiting for upload
+    std::vector<Decoded> done_;
+    int targetW_ = 1280;
+    int targetH_ = 720;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void workerMain();
+    static void decode(const std::string& path, int maxW, int maxH, Decoded& out);
+    void upload(Decoded& decoded);
+    void evict();
+};
@@ -20,6 +20,7 @@ Renderer::Renderer() : window(nullptr), renderer(nullptr), font(nullptr),
 }
 
 Renderer::~Renderer() {
+    textCache.clear();
     if (font) TTF_CloseFont(font);
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
@@ -45,6 +46,7 @@ bool Renderer::init() {
     if (!font) {
         return false;
     }
+    textCache.init(renderer);
     return true;
 }
 
@@ -184,6 +186,7 @@ void Renderer::clear() {
 
 void Renderer::present() {
     SDL_RenderPresent(renderer);
+    textCache.endFrame();
 }
 
 float Renderer::getLaneX(int lane) const {
@@ -212,44 +215,12 @@ float Renderer::getColumnSpacing(int lane) const {
     return 0.0f;
 }
 
-// Binary search to find the index of the last timing point at or before the given time
-static int findTimingPointIndex(int64_t time, const std::vector<TimingPoint>& timingPoints) {
-    if (timingPoints.empty()) return -1;
-
-    int left = 0, right = (int)timingPoints.size() - 1;
-    int result = -1;
-
-    while (left <= right) {
-        int mid = left + (right - left) / 2;
-        if (timingPoints[mid].time <= time) {
-            result = mid;
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
-    }
-    return result;
-}
-
 double Renderer::getSVMultiplier(int64_t time, const std::vector<TimingPoint>& timingPoints) const {
-    int idx = findTimingPointIndex(time, timingPoints);
-    if (idx < 0) return 1.0;
-
-    // Search backwards from idx to find the nearest green line
-    for (int i = idx; i >= 0; i--) {
-        const auto& tp = timingPoints[i];
-        if (!tp.uninherited && tp.beatLength < 0) {
-            double sv = -tp.beatLength;
-            // Allow very small SV (0.001) for Malody scroll=0 effect
-            sv = std::max(0.1, std::min(10000.0, sv));
-            return sv / 100.0;
-        }
-    }
-    return 1.0;
+    return ScrollTable::svMultiplierAt(time, timingPoints);
 }
 
 double Renderer::getBaseBeatLength(int64_t time, const std::vector<TimingPoint>& timingPoints) const {
-    int idx = findTimingPointIndex(time, timingPoints);
+    int idx = ScrollTable::findTimingPoint(time, timingPoints);
     if (idx < 0) return 500.0;  // default 120 BPM
 
     // Search backwards from idx to find the nearest red line
@@ -264,6 +235,14 @@ double Renderer::getBaseBeatLength(int64_t time, const std::vector<TimingPoint>&
     return 500.0;
 }
 
+void Renderer::buildScrollTable(const std::vector<TimingPoint>& timingPoints, double baseBPM) {
+    scrollTable_.build(timingPoints, baseBPM);
+}
+
+void Renderer::clearScrollTable() {
+    scrollTable_.clear();
+}
+
 int Renderer::getNoteY(int64_t noteTime, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, bool ignoreSV, double clockRate) const {
     // osu!mania scroll speed formula from source code analysis:
     // distance = 21.0 * userSpeed * timeDiff / effectiveBeatLength
@@ -290,67 +269,9 @@ int Renderer::getNoteY(int64_t noteTime, int64_t currentTime, int scrollSpeed, d
         return judgeLineY - NOTE_HEIGHT - static_cast<int>(pixelOffset);
     }
 
-    // With SV: cumulative pixel offset with SV changes
-    double pixelOffset = 0.0;
-    double t1 = currentTime;
-    double t2 = noteTime;
-
-    // Get current base beat length (from red line) - search backwards
-    double currentBaseBL = baseBeatLength;
-    int startIdx = findTimingPointIndex(t1, timingPoints);
-    if (startIdx >= 0) {
-        for (int i = startIdx; i >= 0; i--) {
-            const auto& tp = timingPoints[i];
-            if (tp.uninherited && tp.beatLength > 0) {
-                // Clamp to reasonable range to prevent overflow from extreme SV maps
-                currentBaseBL = std::clamp(tp.beatLength, 1.0, 10000000.0);
-                break;
-            }
-        }
-    }
-
-    if (t1 >= t2) {
-        // Note is in the past
-        double sv = getSVMultiplier(t1, timingPoints);
-        double effectiveBL = currentBaseBL * sv;
-        double pixelOffset = 21.0 * userSpeed * (t2 - t1) / std::max(effectiveBL, 1.0) * scale;
-        return judgeLineY - NOTE_HEIGHT - static_cast<int>(pixelOffset);
-    }
-
-    // Note is in the future - calculate cumulative distance with SV changes
-    double currentSV = getSVMultiplier(t1, timingPoints);
-
-    // Use binary search to find starting index for the loop
-    int loopStartIdx = startIdx + 1;
-    int endIdx = findTimingPointIndex(t2, timingPoints);
-
-    for (int i = loopStartIdx; i <= endIdx && i < (int)timingPoints.size(); i++) {
-        const auto& tp = timingPoints[i];
-        if (tp.time < t1) continue;
-        if (tp.time >= t2) break;
-
-        double segmentTime = tp.time - t1;
-        double effectiveBL = currentBaseBL * currentSV;
-        pixelOffset += 21.0 * userSpeed * segmentTime / std::max(effectiveBL, 1.0) * scale;
-
-        t1 = tp.time;
-        if (tp.uninherited && tp.beatLength > 0) {
-            // Clamp to reasonable range to prevent overflow from extreme SV maps
-            currentBaseBL = std::clamp(tp.beatLength, 1.0, 10000000.0);
-        } else if (!tp.uninherited && tp.beatLength < 0) {
-            double sv = -tp.beatLength;
-            // Allow very small SV (0.001) for Malody scroll=0 effect
-            sv = std::max(0.1, std::min(10000.0, sv));
-            currentSV = sv / 100.0;
-        }
-    }
-
-    // Calculate remaining segment [t1, t2]
-    double remainingTime = t2 - t1;
-    double effectiveBL = currentBaseBL * currentSV;
-    pixelOffset += 21.0 * userSpeed * remainingTime / std::max(effectiveBL, 1.0) * scale;
-
-    return judgeLineY - NOTE_HEIGHT - static_cast<int>(pixelOffset);
+    // With SV: precomputed scroll table when it matches this beatmap, else the segment walk
+    return judgeLineY - NOTE_HEIGHT -
+           scrollTable_.pixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, timingPoints);
 }
 
 int Renderer::getHoldHeadY(const Note& note, int naturalY, int64_t currentTime, int scrollSpeed, int releaseNaturalY) const {
@@ -853,6 +774,117 @@ SDL_Color Renderer::getNoteSDLColor(NoteColor color) {
     }
 }
 
+void Renderer::buildNoteBuckets(const std::vector<Note>& notes) {
+    clearNoteBuckets();
+
+    for (size_t i = 0; i < notes.size(); i++) {
+        const Note& note = notes[i];
+        if (note.isFakeNote) {
+            fakeNotes_.push_back(static_cast<int>(i));
+        } else if (note.lane >= 0 && note.lane < 18) {
+            laneNotes_[note.lane].push_back(static_cast<int>(i));
+        }
+    }
+    // Lanes are scanned by head time, fake notes (tail only) by end time
+    for (auto& list : laneNotes_) {
+        std::stable_sort(list.begin(), list.end(), [&notes](int a, int b) {
+            return notes[a].time < notes[b].time;
+        });
+    }
+    std::stable_sort(fakeNotes_.begin(), fakeNotes_.end(), [&notes](int a, int b) {
+        return notes[a].endTime < notes[b].endTime;
+    });
+
+    // First group of fixed fake notes (within 2000ms of the first one) appears and disappears together
+    const int64_t groupThreshold = 2000;
+    for (int idx : fakeNotes_) {
+        const Note& n = notes[idx];
+        if (n.fakeNoteShouldFix && n.endTime < firstFakeEndTime_) {
+            firstFakeEndTime_ = n.endTime;
+        }
+    }
+    if (firstFakeEndTime_ != INT64_MAX) {
+        for (int idx : fakeNotes_) {
+            const Note& n = notes[idx];
+            if (n.fakeNoteShouldFix && n.endTime <= firstFakeEndTime_ + groupThreshold &&
+                n.endTime > lastFakeEndTime_) {
+                lastFakeEndTime_ = n.endTime;
+            }
+        }
+    }
+
+    noteBucketsSource_ = notes.data();
+    noteBucketsSourceSize_ = notes.size();
+}
+
+void Renderer::clearNoteBuckets() {
+    for (int i = 0; i < 18; i++) {
+        laneNotes_[i].clear();
+        laneStart_[i] = 0;
+    }
+    fakeNotes_.clear();
+    fakeStart_ = 0;
+    firstFakeEndTime_ = INT64_MAX;
+    lastFakeEndTime_ = INT64_MIN;
+    lastNoteRenderTime_ = INT64_MIN;
+    noteBucketsSource_ = nullptr;
+    noteBucketsSourceSize_ = 0;
+    visibleNotes_.clear();
+}
+
+bool Renderer::hasNoteBuckets(const std::vector<Note>& notes) const {
+    return noteBucketsSource_ == notes.data() && noteBucketsSourceSize_ == notes.size();
+}
+
+void Renderer::collectVisibleNotes(const std::vector<Note>& notes, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, bool ignoreSV, double clockRate) {
+    visibleNotes_.clear();
+
+    // Start indices only move forward; rewind them if time went backwards (retry/seek)
+    if (currentTime < lastNoteRenderTime_) {
+        for (int i = 0; i < 18; i++) laneStart_[i] = 0;
+        fakeStart_ = 0;
+    }
+    lastNoteRenderTime_ = currentTime;
+
+    // Fake notes: tail only, visible from 5s before endTime until endTime
+    while (fakeStart_ < fakeNotes_.size() && notes[fakeNotes_[fakeStart_]].endTime <= currentTime) {
+        fakeStart_++;
+    }
+    for (size_t pos = fakeStart_; pos < fakeNotes_.size(); pos++) {
+        if (notes[fakeNotes_[pos]].endTime - currentTime > 5000) break;
+        visibleNotes_.push_back(fakeNotes_[pos]);
+    }
+
+    // Scroll position is monotonic in note time (SV and beat length are clamped positive),
+    // so each lane is visited from the first note still on screen up to the first note above it
+    for (int lane = 0; lane < 18; lane++) {
+        const std::vector<int>& list = laneNotes_[lane];
+        size_t& start = laneStart_[lane];
+        while (start < list.size()) {
+            const Note& note = notes[list[start]];
+            if (note.state == NoteState::Holding) break;  // Head is pinned at the judge line
+            if (note.state != NoteState::Hit) {
+                // Hold heads never fall below their tail, so the tail decides when a hold is gone
+                int64_t lastTime = note.isHold ? std::max(note.time, note.endTime) : note.time;
+                int lastY = getNoteY(lastTime, currentTime, scrollSpeed, baseBPM, bpmScaleMode, timingPoints, ignoreSV, clockRate);
+                if (lastY <= windowHeight + 200 + NOTE_HEIGHT) break;
+            }
+            start++;
+        }
+        for (size_t pos = start; pos < list.size(); pos++) {
+            const Note& note = notes[list[pos]];
+            if (note.state == NoteState::Waiting) {
+                int y = getNoteY(note.time, currentTime, scrollSpeed, baseBPM, bpmScaleMode, timingPoints, ignoreSV, clockRate);
+                if (y < -NOTE_HEIGHT * 3) break;  // Above the playfield, and so is the rest of the lane
+            }
+            visibleNotes_.push_back(list[pos]);
+        }
+    }
+
+    // Draw in chart order, as before culling
+    std::sort(visibleNotes_.begin(), visibleNotes_.end());
+}
+
 void Renderer::renderNotes(std::vector<Note>& notes, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, const NoteColor* colors, bool hiddenMod, bool fadeInMod, int combo, bool ignoreSV, double clockRate) {
     // osu!stable formula: coverHeight = Min(400, 160 + combo / 2) in 480px coordinate
     // Scale to our coordinate system (judgeLineY)
@@ -870,29 +902,18 @@ void Renderer::renderNotes(std::vector<Note>& notes, int64_t currentTime, int sc
     int fadeInFadeEndY = coverHeight;
     int fadeInFadeStartY = fadeInFadeEndY - gradientHeight;
 
-    // Pre-calculate firstFakeEndTime and lastFakeEndTime to avoid O(n²) nested loops
-    const int64_t groupThreshold = 2000;
-    int64_t firstFakeEndTime = INT64_MAX;
-    int64_t lastFakeEndTime = INT64_MIN;
-    for (const auto& n : notes) {
-        if (n.isFakeNote && n.fakeNoteShouldFix) {
-            if (n.endTime < firstFakeEndTime) {
-                firstFakeEndTime = n.endTime;
-            }
-        }
-    }
-    // Find last fake note in first group
-    if (firstFakeEndTime != INT64_MAX) {
-        for (const auto& n : notes) {
-            if (n.isFakeNote && n.fakeNoteShouldFix &&
-                n.endTime <= firstFakeEndTime + groupThreshold &&
-                n.endTime > lastFakeEndTime) {
-                lastFakeEndTime = n.endTime;
-            }
-        }
+    // Fake note group bounds are computed once in buildNoteBuckets
+    if (!hasNoteBuckets(notes)) {
+        buildNoteBuckets(notes);
     }
+    const int64_t groupThreshold = 2000;
+    const int64_t firstFakeEndTime = firstFakeEndTime_;
+    const int64_t lastFakeEndTime = lastFakeEndTime_;
+
+    collectVisibleNotes(notes, currentTime, scrollSpeed, baseBPM, bpmScaleMode, timingPoints, ignoreSV, clockRate);
 
-    for (auto& note : notes) {
+    for (int noteIdx : visibleNotes_) {
+        Note& note = notes[noteIdx];
         // Fake notes (NaN time in SV maps) - only render tail
         bool isFakeNote = note.isFakeNote;
 
@@ -964,14 +985,6 @@ void Renderer::renderNotes(std::vector<Note>& notes, int64_t currentTime, int sc
                 }
 
                 // First group disappears together at last note's endTime
-                int64_t lastFakeEndTime = firstFakeEndTime;
-                for (const auto& n : notes) {
-                    if (n.isFakeNote && n.fakeNoteShouldFix &&
-                        n.endTime <= firstFakeEndTime + groupThreshold &&
-                        n.endTime > lastFakeEndTime) {
-                        lastFakeEndTime = n.endTime;
-                    }
-                }
                 if (currentTime >= lastFakeEndTime) continue;
             } else {
                 // Normal fake notes: calculate position normally
@@ -1293,15 +1306,11 @@ void Renderer::renderNotes(std::vector<Note>& notes, int64_t currentTime, int sc
 void Renderer::renderJudgement(const std::string& text) {
     if (!font || text.empty()) return;
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), text.length(), white);
-    if (!surface) return;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    float x = (float)(windowWidth / 2 - surface->w / 2);
+    int w, h;
+    if (!textCache.measure(font, text.c_str(), text.length(), &w, &h)) return;
+    float x = (float)(windowWidth / 2 - w / 2);
     float y = (float)(judgeLineY - 140);
-    SDL_FRect dst = { x, y, (float)surface->w, (float)surface->h };
-    SDL_RenderTexture(renderer, texture, nullptr, &dst);
-    SDL_DestroyTexture(texture);
-    SDL_DestroySurface(surface);
+    textCache.draw(font, text.c_str(), text.length(), white, x, y);
 }
 
 void Renderer::renderHitJudgement(int judgement, int64_t elapsedMs) {
@@ -1417,13 +1426,7 @@ void Renderer::renderSpeedInfo(int scrollSpeed, bool bpmScaleMode, bool autoPlay
         snprintf(buf, sizeof(buf), "Speed: %d (%s)", scrollSpeed, modeStr);
     }
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* surface = TTF_RenderText_Blended(font, buf, strlen(buf), white);
-    if (!surface) return;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FRect dst = { 10, 10, (float)surface->w, (float)surface->h };
-    SDL_RenderTexture(renderer, texture, nullptr, &dst);
-    SDL_DestroyTexture(texture);
-    SDL_DestroySurface(surface);
+    textCache.draw(font, buf, strlen(buf), white, 10, 10);
 }
 
 void Renderer::renderCombo(int combo, int64_t comboAnimTime, bool comboBreak, int64_t breakAnimTime, int lastComboValue, bool holdActive, int64_t holdColorTime) {
@@ -1519,17 +1522,13 @@ void Renderer::renderCombo(int combo, int64_t comboAnimTime, bool comboBreak, in
         }
         if (!useSkinDigits && font) {
             SDL_Color breakColor = {colorBreak.r, colorBreak.g, colorBreak.b, (uint8_t)(alpha * 255)};
-            SDL_Surface* surface = TTF_RenderText_Blended(font, buf, strlen(buf), breakColor);
-            if (surface) {
-                SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-                float w = (float)surface->w * breakScale;
-                float h = (float)surface->h * breakScale;
+            int tw, th;
+            if (textCache.measure(font, buf, strlen(buf), &tw, &th)) {
+                float w = (float)tw * breakScale;
+                float h = (float)th * breakScale;
                 float x = centerX - w / 2;
-                float y = comboY - (h - surface->h) / 2;
-                SDL_FRect dst = { x, y, w, h };
-                SDL_RenderTexture(renderer, texture, nullptr, &dst);
-                SDL_DestroyTexture(texture);
-                SDL_DestroySurface(surface);
+                float y = comboY - (h - th) / 2;
+                textCache.draw(font, buf, strlen(buf), breakColor, x, y, breakScale, breakScale);
             }
         }
     }
@@ -1608,19 +1607,15 @@ void Renderer::renderCombo(int combo, int64_t comboAnimTime, bool comboBreak, in
 
     char buf[32];
     snprintf(buf, sizeof(buf), "%d", combo);
-    SDL_Surface* surface = TTF_RenderText_Blended(font, buf, strlen(buf), currentColor);
-    if (!surface) return;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    int tw, th;
+    if (!textCache.measure(font, buf, strlen(buf), &tw, &th)) return;
 
-    float w = (float)surface->w;
-    float h = (float)surface->h * scaleY;
+    float w = (float)tw;
+    float h = (float)th * scaleY;
     float x = centerX - w / 2;
-    float y = comboY - (h - surface->h) / 2;
+    float y = comboY - (h - th) / 2;
 
-    SDL_FRect dst = { x, y, w, h };
-    SDL_RenderTexture(renderer, texture, nullptr, &dst);
-    SDL_DestroyTexture(texture);
-    SDL_DestroySurface(surface);
+    textCache.draw(font, buf, strlen(buf), currentColor, x, y, 1.0f, scaleY);
 }
 
 void Renderer::renderHPBar(double hpPercent) {
@@ -1787,13 +1782,9 @@ void Renderer::renderFPS(int fps) {
     char buf[32];
     snprintf(buf, sizeof(buf), "FPS: %d", fps);
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* surface = TTF_RenderText_Blended(font, buf, strlen(buf), white);
-    if (!surface) return;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FRect dst = { (float)(windowWidth - surface->w - 10), 10, (float)surface->w, (float)surface->h };
-    SDL_RenderTexture(renderer, texture, nullptr, &dst);
-    SDL_DestroyTexture(texture);
-    SDL_DestroySurface(surface);
+    int w, h;
+    if (!textCache.measure(font, buf, strlen(buf), &w, &h)) return;
+    textCache.draw(font, buf, strlen(buf), white, (float)(windowWidth - w - 10), 10);
 }
 
 void Renderer::renderGameInfo(int64_t currentTime, int64_t totalTime, const int* judgeCounts, double accuracy, int score) {
@@ -1804,13 +1795,7 @@ void Renderer::renderGameInfo(int64_t currentTime, int64_t totalTime, const int*
     float lineHeight = 28;
 
     auto drawLine = [&](const char* text) {
-        SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-        if (!s) return;
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        SDL_FRect dst = { x, y, (float)s->w, (float)s->h };
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
+        if (!textCache.draw(font, text, strlen(text), white, x, y)) return;
         y += lineHeight;
     };
 
@@ -2038,14 +2023,10 @@ void Renderer::renderResult(const std::string& title, const std::string& creator
     float lineHeight = 35;
 
     auto drawText = [&](const char* text, float yPos) {
-        SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-        if (!s) return;
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        float x = (float)(windowWidth / 2 - s->w / 2);
-        SDL_FRect dst = { x, yPos, (float)s->w, (float)s->h };
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
+        int w, h;
+        if (!textCache.measure(font, text, strlen(text), &w, &h)) return;
+        float x = (float)(windowWidth / 2 - w / 2);
+        textCache.draw(font, text, strlen(text), white, x, yPos);
     };
 
     drawText("== RESULT ==", y);
@@ -2088,26 +2069,15 @@ void Renderer::renderMenu() {
     if (!font) return;
     SDL_Color white = {255, 255, 255, 255};
 
+    int w, h;
     const char* title = "Mania Player";
-    SDL_Surface* s = TTF_RenderText_Blended(font, title, strlen(title), white);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        float x = (float)(windowWidth / 2 - s->w / 2);
-        SDL_FRect dst = { x, 150, (float)s->w, (float)s->h };
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
+    if (textCache.measure(font, title, strlen(title), &w, &h)) {
+        textCache.draw(font, title, strlen(title), white, (float)(windowWidth / 2 - w / 2), 150);
     }
 
     const char* version = "Version 0.0.7";
-    s = TTF_RenderText_Blended(font, version, strlen(version), white);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        float x = (float)(windowWidth / 2 - s->w / 2);
-        SDL_FRect dst = { x, 190, (float)s->w, (float)s->h };
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
+    if (textCache.measure(font, version, strlen(version), &w, &h)) {
+        textCache.draw(font, version, strlen(version), white, (float)(windowWidth / 2 - w / 2), 190);
     }
 }
 
@@ -2128,15 +2098,11 @@ bool Renderer::renderButton(const char* text, float x, float y, float w, float h
 
     if (font) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            float tx = x + (w - s->w) / 2;
-            float ty = y + (h - s->h) / 2;
-            SDL_FRect dst = { tx, ty, (float)s->w, (float)s->h };
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        int tw, th;
+        if (textCache.measure(font, text, strlen(text), &tw, &th)) {
+            float tx = x + (w - tw) / 2;
+            float ty = y + (h - th) / 2;
+            textCache.draw(font, text, strlen(text), white, tx, ty);
         }
     }
 
@@ -2162,13 +2128,9 @@ bool Renderer::renderCheckbox(const char* label, bool checked, float x, float y,
 
     if (font) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, label, strlen(label), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {x + boxSize + 8, y + (boxSize - s->h) / 2, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        int tw, th;
+        if (textCache.measure(font, label, strlen(label), &tw, &th)) {
+            textCache.draw(font, label, strlen(label), white, x + boxSize + 8, y + (boxSize - th) / 2);
         }
     }
     return hover && clicked;
@@ -2206,14 +2168,7 @@ int Renderer::renderSliderWithValue(float x, float y, float w, int value, int mi
         char buf[16];
         snprintf(buf, sizeof(buf), "%d", newValue);
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, buf, strlen(buf), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {x + w + 10, y, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
-        }
+        textCache.draw(font, buf, strlen(buf), white, x + w + 10, y);
     }
 
     return newValue;
@@ -2251,14 +2206,7 @@ int Renderer::renderSliderWithFloatValue(float x, float y, float w, int value, i
         char buf[16];
         snprintf(buf, sizeof(buf), "%.1f", newValue / divisor);
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, buf, strlen(buf), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {x + w + 10, y, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
-        }
+        textCache.draw(font, buf, strlen(buf), white, x + w + 10, y);
     }
 
     return newValue;
@@ -2275,15 +2223,11 @@ void Renderer::renderCategoryButton(const char* text, float x, float y, float w,
 
     if (font) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            float tx = x + (w - s->w) / 2;
-            float ty = y + (h - s->h) / 2;
-            SDL_FRect dst = {tx, ty, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        int tw, th;
+        if (textCache.measure(font, text, strlen(text), &tw, &th)) {
+            float tx = x + (w - tw) / 2;
+            float ty = y + (h - th) / 2;
+            textCache.draw(font, text, strlen(text), white, tx, ty);
         }
     }
 }
@@ -2302,14 +2246,7 @@ void Renderer::renderSettingsWindow(int mouseX, int mouseY) {
 
     if (font) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, "Settings", 8, white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {winX + 20, winY + 15, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
-        }
+        textCache.draw(font, "Settings", 8, white, winX + 20, winY + 15);
     }
 }
 
@@ -2324,28 +2261,20 @@ void Renderer::renderKeyBindingUI(SDL_Keycode* keys, int keyCount, int currentIn
         snprintf(keyName, sizeof(keyName), "%s", name);
 
         SDL_Color c = (i == currentIndex) ? yellow : white;
-        SDL_Surface* s = TTF_RenderText_Blended(font, keyName, strlen(keyName), c);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            float x = (float)(getLaneX(i) + laneWidth / 2 - s->w / 2);
+        int tw, th;
+        if (textCache.measure(font, keyName, strlen(keyName), &tw, &th)) {
+            float x = (float)(getLaneX(i) + laneWidth / 2 - tw / 2);
             float y = (float)(judgeLineY - 80);
-            SDL_FRect dst = {x, y, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+            textCache.draw(font, keyName, strlen(keyName), c, x, y);
         }
 
         if (i == currentIndex) {
             const char* arrow = "v";
-            SDL_Surface* as = TTF_RenderText_Blended(font, arrow, 1, yellow);
-            if (as) {
-                SDL_Texture* at = SDL_CreateTextureFromSurface(renderer, as);
-                float ax = (float)(getLaneX(i) + laneWidth / 2 - as->w / 2);
+            int aw, ah;
+            if (textCache.measure(font, arrow, 1, &aw, &ah)) {
+                float ax = (float)(getLaneX(i) + laneWidth / 2 - aw / 2);
                 float ay = (float)(judgeLineY - 110);
-                SDL_FRect adst = {ax, ay, (float)as->w, (float)as->h};
-                SDL_RenderTexture(renderer, at, nullptr, &adst);
-                SDL_DestroyTexture(at);
-                SDL_DestroySurface(as);
+                textCache.draw(font, arrow, 1, yellow, ax, ay);
             }
         }
     }
@@ -2354,54 +2283,29 @@ void Renderer::renderKeyBindingUI(SDL_Keycode* keys, int keyCount, int currentIn
 void Renderer::renderText(const char* text, float x, float y) {
     if (!font) return;
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        SDL_FRect dst = {x, y, (float)s->w, (float)s->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
-    }
+    textCache.draw(font, text, strlen(text), white, x, y);
 }
 
 void Renderer::renderTextRight(const char* text, float rightX, float y) {
     if (!font) return;
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
+    int w, h;
+    if (textCache.measure(font, text, strlen(text), &w, &h)) {
         // Right-align: x = rightX - textWidth
-        SDL_FRect dst = {rightX - (float)s->w, y, (float)s->w, (float)s->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
+        textCache.draw(font, text, strlen(text), white, rightX - (float)w, y);
     }
 }
 
 void Renderer::renderTextClipped(const char* text, float x, float y, float maxWidth) {
     if (!font || !text || maxWidth <= 0) return;
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        float srcW = (float)s->w;
-        float srcH = (float)s->h;
-        float dstW = srcW > maxWidth ? maxWidth : srcW;
-        SDL_FRect src = {0, 0, dstW, srcH};
-        SDL_FRect dst = {x, y, dstW, srcH};
-        SDL_RenderTexture(renderer, t, &src, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
-    }
+    textCache.draw(font, text, strlen(text), white, x, y, 1.0f, 1.0f, maxWidth);
 }
 
 int Renderer::getTextWidth(const char* text) {
     if (!font || !text || !text[0]) return 0;
-    SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), white);
-    if (s) {
-        int w = s->w;
-        SDL_DestroySurface(s);
+    int w, h;
+    if (textCache.measure(font, text, strlen(text), &w, &h)) {
         return w;
     }
     return 0;
@@ -2410,14 +2314,7 @@ int Renderer::getTextWidth(const char* text) {
 void Renderer::renderLabel(const char* text, float x, float y) {
     if (!font) return;
     SDL_Color gray = {180, 180, 180, 255};
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), gray);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        SDL_FRect dst = {x, y, (float)s->w, (float)s->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
-    }
+    textCache.draw(font, text, strlen(text), gray, x, y);
 }
 
 int Renderer::renderDropdown(const char* label, const char** options, int optionCount, int selected,
@@ -2439,13 +2336,10 @@ int Renderer::renderDropdown(const char* label, const char** options, int option
 
     if (font && selected >= 0 && selected < optionCount) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, options[selected], strlen(options[selected]), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {x + 8, y + (h - s->h) / 2, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        const char* opt = options[selected];
+        int tw, th;
+        if (textCache.measure(font, opt, strlen(opt), &tw, &th)) {
+            textCache.draw(font, opt, strlen(opt), white, x + 8, y + (h - th) / 2);
         }
     }
 
@@ -2515,13 +2409,9 @@ void Renderer::renderDropdownOverlay() {
         if (font && i < (int)pendingDropdown_.options.size()) {
             SDL_Color white = {255, 255, 255, 255};
             const std::string& opt = pendingDropdown_.options[i];
-            SDL_Surface* s = TTF_RenderText_Blended(font, opt.c_str(), opt.size(), white);
-            if (s) {
-                SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-                SDL_FRect dst = {x + 8, optY + (h - s->h) / 2, (float)s->w, (float)s->h};
-                SDL_RenderTexture(renderer, t, nullptr, &dst);
-                SDL_DestroyTexture(t);
-                SDL_DestroySurface(s);
+            int tw, th;
+            if (textCache.measure(font, opt.c_str(), opt.size(), &tw, &th)) {
+                textCache.draw(font, opt.c_str(), opt.size(), white, x + 8, optY + (h - th) / 2);
             }
         }
     }
@@ -2548,13 +2438,9 @@ bool Renderer::renderRadioButton(const char* label, bool selected, float x, floa
 
     if (font) {
         SDL_Color white = {255, 255, 255, 255};
-        SDL_Surface* s = TTF_RenderText_Blended(font, label, strlen(label), white);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_FRect dst = {x + size + 8, y + (size - s->h) / 2, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        int tw, th;
+        if (textCache.measure(font, label, strlen(label), &tw, &th)) {
+            textCache.draw(font, label, strlen(label), white, x + size + 8, y + (size - th) / 2);
         }
     }
 
@@ -2563,23 +2449,15 @@ bool Renderer::renderRadioButton(const char* label, bool selected, float x, floa
 
 bool Renderer::renderClickableLabel(const char* text, float x, float y, int mouseX, int mouseY, bool clicked) {
     if (!font) return false;
-    SDL_Surface* s = TTF_RenderText_Blended(font, text, strlen(text), {200, 200, 255, 255});
-    if (!s) return false;
+    int tw, th;
+    if (!textCache.measure(font, text, strlen(text), &tw, &th)) return false;
 
-    float w = (float)s->w;
-    float h = (float)s->h;
+    float w = (float)tw;
+    float h = (float)th;
     bool hover = mouseX >= x && mouseX <= x + w && mouseY >= y && mouseY <= y + h;
-    SDL_DestroySurface(s);
 
     SDL_Color color = hover ? SDL_Color{255, 255, 100, 255} : SDL_Color{200, 200, 255, 255};
-    s = TTF_RenderText_Blended(font, text, strlen(text), color);
-    if (s) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-        SDL_FRect dst = {x, y, (float)s->w, (float)s->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(s);
-    }
+    textCache.draw(font, text, strlen(text), color, x, y);
 
     return hover && clicked;
 }
@@ -2630,46 +2508,33 @@ void Renderer::renderPauseMenu(int selection, float alpha) {
     float lineHeight = 60;
 
     // Title
+    // Menu text is faded twice (colour alpha and texture alpha mod)
     SDL_Color white = {255, 255, 255, a};
-    SDL_Surface* titleSurf = TTF_RenderText_Blended(font, "PAUSED", 6, white);
-    if (titleSurf) {
-        SDL_Texture* titleTex = SDL_CreateTextureFromSurface(renderer, titleSurf);
-        SDL_SetTextureAlphaMod(titleTex, a);
-        float tx = (float)(windowWidth / 2 - titleSurf->w / 2);
-        SDL_FRect dst = {tx, 200, (float)titleSurf->w, (float)titleSurf->h};
-        SDL_RenderTexture(renderer, titleTex, nullptr, &dst);
-        SDL_DestroyTexture(titleTex);
-        SDL_DestroySurface(titleSurf);
+    uint8_t a2 = (uint8_t)(a * a / 255);
+    int tw, th;
+    if (textCache.measure(font, "PAUSED", 6, &tw, &th)) {
+        float tx = (float)(windowWidth / 2 - tw / 2);
+        textCache.draw(font, "PAUSED", 6, SDL_Color{255, 255, 255, a2}, tx, 200);
     }
 
     // Menu options
     for (int i = 0; i < 3; i++) {
-        SDL_Color color = (i == selection) ? SDL_Color{255, 255, 0, a} : white;
+        SDL_Color color = (i == selection) ? SDL_Color{255, 255, 0, a2} : SDL_Color{255, 255, 255, a2};
         const char* prefix = (i == selection) ? "> " : "  ";
         char buf[32];
         snprintf(buf, sizeof(buf), "%s%s", prefix, options[i]);
 
-        SDL_Surface* s = TTF_RenderText_Blended(font, buf, strlen(buf), color);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_SetTextureAlphaMod(t, a);
-            float x = (float)(windowWidth / 2 - s->w / 2);
-            SDL_FRect dst = {x, menuY + i * lineHeight, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        if (textCache.measure(font, buf, strlen(buf), &tw, &th)) {
+            float x = (float)(windowWidth / 2 - tw / 2);
+            textCache.draw(font, buf, strlen(buf), color, x, menuY + i * lineHeight);
         }
     }
 
     // Hint
-    SDL_Surface* hint = TTF_RenderText_Blended(font, "Up/Down to select, Enter to confirm", 36, white);
-    if (hint) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, hint);
-        float x = (float)(windowWidth / 2 - hint->w / 2);
-        SDL_FRect dst = {x, 500, (float)hint->w, (float)hint->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(hint);
+    const char* hint = "Up/Down to select, Enter to confirm";
+    if (textCache.measure(font, hint, strlen(hint), &tw, &th)) {
+        float x = (float)(windowWidth / 2 - tw / 2);
+        textCache.draw(font, hint, strlen(hint), white, x, 500);
     }
 }
 
@@ -2680,25 +2545,18 @@ void Renderer::renderPauseCountdown(float seconds, float alpha) {
     char buf[16];
     snprintf(buf, sizeof(buf), "%.2f", seconds);
 
-    SDL_Color yellow = {255, 255, 0, a};
-    SDL_Surface* surf = TTF_RenderText_Blended(font, buf, strlen(buf), yellow);
-    if (!surf) return;
-
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surf);
-    SDL_SetTextureAlphaMod(tex, a);
-    SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_LINEAR);
+    // Faded by both colour alpha and texture alpha mod
+    SDL_Color yellow = {255, 255, 0, (uint8_t)(a * a / 255)};
+    int tw, th;
+    if (!textCache.measure(font, buf, strlen(buf), &tw, &th)) return;
 
-    // Scale up 3x for visibility
+    // Scale up 3x for visibility (cached textures use the default linear scale mode)
     float scale = 3.0f;
-    float w = surf->w * scale;
-    float h = surf->h * scale;
+    float w = tw * scale;
+    float h = th * scale;
     float x = (windowWidth - w) / 2.0f;
     float y = (windowHeight - h) / 2.0f;
-    SDL_FRect dst = {x, y, w, h};
-    SDL_RenderTexture(renderer, tex, nullptr, &dst);
-
-    SDL_DestroyTexture(tex);
-    SDL_DestroySurface(surf);
+    textCache.draw(font, buf, strlen(buf), yellow, x, y, scale, scale);
 }
 
 void Renderer::renderDeathMenu(int selection, float slowdown, float alpha) {
@@ -2713,17 +2571,13 @@ void Renderer::renderDeathMenu(int selection, float slowdown, float alpha) {
     if (!font) return;
 
     // Title "You Died!"
-    SDL_Color red = {255, 60, 60, a};
+    // Menu text is faded twice (colour alpha and texture alpha mod)
     SDL_Color white = {255, 255, 255, a};
-    SDL_Surface* titleSurf = TTF_RenderText_Blended(font, "You Died!", 9, red);
-    if (titleSurf) {
-        SDL_Texture* titleTex = SDL_CreateTextureFromSurface(renderer, titleSurf);
-        SDL_SetTextureAlphaMod(titleTex, a);
-        float tx = (float)(windowWidth / 2 - titleSurf->w / 2);
-        SDL_FRect dst = {tx, 180, (float)titleSurf->w, (float)titleSurf->h};
-        SDL_RenderTexture(renderer, titleTex, nullptr, &dst);
-        SDL_DestroyTexture(titleTex);
-        SDL_DestroySurface(titleSurf);
+    uint8_t a2 = (uint8_t)(a * a / 255);
+    int tw, th;
+    if (textCache.measure(font, "You Died!", 9, &tw, &th)) {
+        float tx = (float)(windowWidth / 2 - tw / 2);
+        textCache.draw(font, "You Died!", 9, SDL_Color{255, 60, 60, a2}, tx, 180);
     }
 
     // Menu options
@@ -2732,32 +2586,22 @@ void Renderer::renderDeathMenu(int selection, float slowdown, float alpha) {
     float lineHeight = 60;
 
     for (int i = 0; i < 3; i++) {
-        SDL_Color color = (i == selection) ? SDL_Color{255, 255, 0, a} : white;
+        SDL_Color color = (i == selection) ? SDL_Color{255, 255, 0, a2} : SDL_Color{255, 255, 255, a2};
         const char* prefix = (i == selection) ? "> " : "  ";
         char buf[32];
         snprintf(buf, sizeof(buf), "%s%s", prefix, options[i]);
 
-        SDL_Surface* s = TTF_RenderText_Blended(font, buf, strlen(buf), color);
-        if (s) {
-            SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-            SDL_SetTextureAlphaMod(t, a);
-            float x = (float)(windowWidth / 2 - s->w / 2);
-            SDL_FRect dst = {x, menuY + i * lineHeight, (float)s->w, (float)s->h};
-            SDL_RenderTexture(renderer, t, nullptr, &dst);
-            SDL_DestroyTexture(t);
-            SDL_DestroySurface(s);
+        if (textCache.measure(font, buf, strlen(buf), &tw, &th)) {
+            float x = (float)(windowWidth / 2 - tw / 2);
+            textCache.draw(font, buf, strlen(buf), color, x, menuY + i * lineHeight);
         }
     }
 
     // Hint
-    SDL_Surface* hint = TTF_RenderText_Blended(font, "Up/Down to select, Enter to confirm", 36, white);
-    if (hint) {
-        SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, hint);
-        float x = (float)(windowWidth / 2 - hint->w / 2);
-        SDL_FRect dst = {x, 520, (float)hint->w, (float)hint->h};
-        SDL_RenderTexture(renderer, t, nullptr, &dst);
-        SDL_DestroyTexture(t);
-        SDL_DestroySurface(hint);
+    const char* hint = "Up/Down to select, Enter to confirm";
+    if (textCache.measure(font, hint, strlen(hint), &tw, &th)) {
+        float x = (float)(windowWidth / 2 - tw / 2);
+        textCache.draw(font, hint, strlen(hint), white, x, 520);
     }
 }
 
@@ -2765,16 +2609,12 @@ void Renderer::renderSkipPrompt() {
     if (!font) return;
 
     SDL_Color white = {255, 255, 255, 200};
-    SDL_Surface* surf = TTF_RenderText_Blended(font, "Press Space to skip...", 22, white);
-    if (surf) {
-        SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surf);
+    int tw, th;
+    if (textCache.measure(font, "Press Space to skip...", 22, &tw, &th)) {
         // Position at bottom-right corner with some padding
-        float x = (float)(windowWidth - surf->w - 20);
-        float y = (float)(windowHeight - surf->h - 20);
-        SDL_FRect dst = {x, y, (float)surf->w, (float)surf->h};
-        SDL_RenderTexture(renderer, tex, nullptr, &dst);
-        SDL_DestroyTexture(tex);
-        SDL_DestroySurface(surf);
+        float x = (float)(windowWidth - tw - 20);
+        float y = (float)(windowHeight - th - 20);
+        textCache.draw(font, "Press Space to skip...", 22, white, x, y);
     }
 }
 
@@ -2825,23 +2665,17 @@ bool Renderer::renderTextInput(const char* label, std::string& text, float x, fl
 
         if (text.empty() && !editing) {
             // Show placeholder
-            SDL_Surface* s = TTF_RenderText_Blended(font, "...", 3, white);
-            if (s) {
-                SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-                SDL_FRect dst = {x + padding, inputY + (h - s->h) / 2, (float)s->w, (float)s->h};
-                SDL_RenderTexture(renderer, t, nullptr, &dst);
-                SDL_DestroyTexture(t);
-                SDL_DestroySurface(s);
+            int tw, th;
+            if (textCache.measure(font, "...", 3, &tw, &th)) {
+                textCache.draw(font, "...", 3, white, x + padding, inputY + (h - th) / 2);
             }
         } else {
             // Calculate cursor position in pixels
             float cursorPixelX = 0;
             if (cursorPos > 0 && !text.empty()) {
-                std::string beforeCursor = text.substr(0, cursorPos);
-                SDL_Surface* s = TTF_RenderText_Blended(font, beforeCursor.c_str(), beforeCursor.length(), white);
-                if (s) {
-                    cursorPixelX = (float)s->w;
-                    SDL_DestroySurface(s);
+                int tw, th;
+                if (textCache.measure(font, text.c_str(), std::min((size_t)cursorPos, text.length()), &tw, &th)) {
+                    cursorPixelX = (float)tw;
                 }
             }
 
@@ -2868,13 +2702,9 @@ bool Renderer::renderTextInput(const char* label, std::string& text, float x, fl
 
             // Render full text
             if (!text.empty()) {
-                SDL_Surface* s = TTF_RenderText_Blended(font, text.c_str(), text.length(), white);
-                if (s) {
-                    SDL_Texture* t = SDL_CreateTextureFromSurface(renderer, s);
-                    SDL_FRect dst = {x + padding - scrollOffset, inputY + (h - s->h) / 2, (float)s->w, (float)s->h};
-                    SDL_RenderTexture(renderer, t, nullptr, &dst);
-                    SDL_DestroyTexture(t);
-                    SDL_DestroySurface(s);
+                int tw, th;
+                if (textCache.measure(font, text.c_str(), text.length(), &tw, &th)) {
+                    textCache.draw(font, text.c_str(), text.length(), white, x + padding - scrollOffset, inputY + (h - th) / 2);
                 }
             }
 
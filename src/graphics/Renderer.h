@@ -7,6 +7,8 @@
 #include "Settings.h"
 #include "OsuParser.h"
 #include "ReplayAnalyzer.h"
+#include "ScrollTable.h"
+#include "TextCache.h"
 
 class SkinManager;
 
@@ -34,6 +36,12 @@ public:
     void triggerLightingN(int lane, int64_t time);  // Trigger LightingN animation on note hit
     int getJudgeLineY() const { return judgeLineY; }  // Get judge line Y position
     int getNoteY(int64_t noteTime, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, bool ignoreSV = false, double clockRate = 1.0) const;
+    // Precompute scroll distance table for getNoteY (call after loading beatmap timing points)
+    void buildScrollTable(const std::vector<TimingPoint>& timingPoints, double baseBPM);
+    void clearScrollTable();
+    // Bucket notes by lane for visible-range culling in renderNotes (call after loading beatmap notes)
+    void buildNoteBuckets(const std::vector<Note>& notes);
+    void clearNoteBuckets();
     void renderLaneHighlights(const bool* laneKeyDown, int keyCount, bool hiddenMod, bool fadeInMod, int combo);
     void renderNotes(std::vector<Note>& notes, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, const NoteColor* colors, bool hiddenMod = false, bool fadeInMod = false, int combo = 0, bool ignoreSV = false, double clockRate = 1.0);
     void renderJudgeLine();
@@ -103,6 +111,7 @@ private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* font;
+    TextCache textCache;  // Rasterized text reused across frames
     SkinManager* skinManager = nullptr;
     int laneStartX;
     int windowWidth;
@@ -154,6 +163,23 @@ private:
         int* resultPtr = nullptr;
     } pendingDropdown_;
 
+    ScrollTable scrollTable_;  // SV scroll distance for getNoteY
+
+    // Visible-range culling for renderNotes: note indices per lane sorted by time, with
+    // start indices advanced past notes that have scrolled off the bottom of the playfield
+    std::vector<int> laneNotes_[18];
+    size_t laneStart_[18] = {};
+    std::vector<int> fakeNotes_;        // Fake notes sorted by endTime (only their tail is drawn)
+    size_t fakeStart_ = 0;
+    int64_t firstFakeEndTime_ = INT64_MAX;  // First group of fixed fake notes
+    int64_t lastFakeEndTime_ = INT64_MIN;
+    int64_t lastNoteRenderTime_ = INT64_MIN;
+    const Note* noteBucketsSource_ = nullptr;  // Notes the buckets were built from
+    size_t noteBucketsSourceSize_ = 0;
+    std::vector<int> visibleNotes_;     // Per-frame scratch list
+    bool hasNoteBuckets(const std::vector<Note>& notes) const;
+    void collectVisibleNotes(const std::vector<Note>& notes, int64_t currentTime, int scrollSpeed, double baseBPM, bool bpmScaleMode, const std::vector<TimingPoint>& timingPoints, bool ignoreSV, double clockRate);
+
     int getHoldHeadY(const Note& note, int naturalY, int64_t currentTime, int scrollSpeed, int releaseNaturalY) const;
     double getSVMultiplier(int64_t time, const std::vector<TimingPoint>& timingPoints) const;
     double getBaseBeatLength(int64_t time, const std::vector<TimingPoint>& timingPoints) const;
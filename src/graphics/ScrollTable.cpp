@@ -0,0 +1,199 @@
+#include "ScrollTable.h"
+#include <algorithm>
+#include <cmath>
+
+// Clamp to reasonable range to prevent overflow from extreme SV maps
+// Min: 1ms (60000 BPM), Max: 10000000ms (0.006 BPM) for extreme SV maps
+static double clampBeatLength(double beatLength) {
+    return std::clamp(beatLength, 1.0, 10000000.0);
+}
+
+// Allow very small SV (0.001) for Malody scroll=0 effect
+static double clampSV(double beatLength) {
+    double sv = -beatLength;
+    sv = std::max(0.1, std::min(10000.0, sv));
+    return sv / 100.0;
+}
+
+int ScrollTable::findTimingPoint(int64_t time, const std::vector<TimingPoint>& timingPoints) {
+    if (timingPoints.empty()) return -1;
+
+    int left = 0, right = (int)timingPoints.size() - 1;
+    int result = -1;
+
+    while (left <= right) {
+        int mid = left + (right - left) / 2;
+        if (timingPoints[mid].time <= time) {
+            result = mid;
+            left = mid + 1;
+        } else {
+            right = mid - 1;
+        }
+    }
+    return result;
+}
+
+double ScrollTable::svMultiplierAt(int64_t time, const std::vector<TimingPoint>& timingPoints) {
+    int idx = findTimingPoint(time, timingPoints);
+    if (idx < 0) return 1.0;
+
+    // Search backwards from idx to find the nearest green line
+    for (int i = idx; i >= 0; i--) {
+        const auto& tp = timingPoints[i];
+        if (!tp.uninherited && tp.beatLength < 0) {
+            return clampSV(tp.beatLength);
+        }
+    }
+    return 1.0;
+}
+
+void ScrollTable::build(const std::vector<TimingPoint>& timingPoints, double baseBPM) {
+    clear();
+    if (timingPoints.empty()) return;
+
+    // Same segment walk as walkPixelOffset, with the same clamps
+    double currentBaseBL = 60000.0 / std::max(baseBPM, 1.0);
+    double currentSV = 1.0;
+    double effectiveBL = std::max(currentBaseBL * currentSV, 1.0);
+    double beats = 0.0;
+    double t1 = timingPoints[0].time;
+
+    segments_.reserve(timingPoints.size() + 1);
+    segments_.push_back({t1, effectiveBL, 0.0});
+    for (const auto& tp : timingPoints) {
+        beats += (tp.time - t1) / effectiveBL;
+        t1 = tp.time;
+        if (tp.uninherited && tp.beatLength > 0) {
+            currentBaseBL = clampBeatLength(tp.beatLength);
+        } else if (!tp.uninherited && tp.beatLength < 0) {
+            currentSV = clampSV(tp.beatLength);
+        }
+        effectiveBL = std::max(currentBaseBL * currentSV, 1.0);
+        segments_.push_back({tp.time, effectiveBL, beats});
+    }
+
+    source_ = timingPoints.data();
+    sourceSize_ = timingPoints.size();
+    bpm_ = baseBPM;
+}
+
+void ScrollTable::clear() {
+    segments_.clear();
+    source_ = nullptr;
+    sourceSize_ = 0;
+    bpm_ = 0.0;
+}
+
+bool ScrollTable::matches(const std::vector<TimingPoint>& timingPoints, double baseBPM) const {
+    return !segments_.empty() && source_ == timingPoints.data() &&
+           sourceSize_ == timingPoints.size() && bpm_ == baseBPM;
+}
+
+// Binary search for the segment containing time (last timing point at or before time)
+const ScrollTable::Segment& ScrollTable::findSegment(double time) const {
+    auto it = std::upper_bound(segments_.begin() + 1, segments_.end(), time,
+        [](double t, const Segment& seg) { return t < seg.time; });
+    return *(it - 1);
+}
+
+double ScrollTable::beatsAt(double time) const {
+    const Segment& seg = findSegment(time);
+    return seg.beats + (time - seg.time) / seg.beatLength;
+}
+
+int ScrollTable::pixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale, double baseBPM,
+                             const std::vector<TimingPoint>& timingPoints) const {
+    int offset;
+    if (tablePixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, timingPoints, offset)) {
+        return offset;
+    }
+    return walkPixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, timingPoints);
+}
+
+bool ScrollTable::tablePixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale,
+                                   double baseBPM, const std::vector<TimingPoint>& timingPoints, int& offset) const {
+    if (!matches(timingPoints, baseBPM)) return false;
+
+    double t1 = currentTime;
+    double t2 = noteTime;
+    if (t1 >= t2) {
+        // Note is in the past - extend at the current segment's speed
+        const Segment& seg = findSegment(t1);
+        double pixelOffset = 21.0 * userSpeed * (t2 - t1) / seg.beatLength * scale;
+        offset = static_cast<int>(pixelOffset);
+        return true;
+    }
+    double beats1 = beatsAt(t1);
+    double beats2 = beatsAt(t2);
+    double pixelOffset = 21.0 * userSpeed * (beats2 - beats1) * scale;
+    // Prefix sums round differently from the segment walk; if the offset is within
+    // rounding error of a pixel boundary, leave it to the walk so output stays identical
+    double magnitude = 21.0 * userSpeed * (std::abs(beats1) + std::abs(beats2)) * scale;
+    double tolerance = magnitude * 1e-12 + 1e-9;
+    double fraction = pixelOffset - std::floor(pixelOffset);
+    if (fraction > tolerance && fraction < 1.0 - tolerance) {
+        offset = static_cast<int>(pixelOffset);
+        return true;
+    }
+    return false;
+}
+
+int ScrollTable::walkPixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale,
+                                 double baseBPM, const std::vector<TimingPoint>& timingPoints) {
+    // Cumulative pixel offset with SV changes
+    double pixelOffset = 0.0;
+    double t1 = currentTime;
+    double t2 = noteTime;
+
+    // Get current base beat length (from red line) - search backwards
+    double currentBaseBL = 60000.0 / std::max(baseBPM, 1.0);
+    int startIdx = findTimingPoint(currentTime, timingPoints);
+    if (startIdx >= 0) {
+        for (int i = startIdx; i >= 0; i--) {
+            const auto& tp = timingPoints[i];
+            if (tp.uninherited && tp.beatLength > 0) {
+                currentBaseBL = clampBeatLength(tp.beatLength);
+                break;
+            }
+        }
+    }
+
+    if (t1 >= t2) {
+        // Note is in the past
+        double sv = svMultiplierAt(currentTime, timingPoints);
+        double effectiveBL = currentBaseBL * sv;
+        double pixelOffset = 21.0 * userSpeed * (t2 - t1) / std::max(effectiveBL, 1.0) * scale;
+        return static_cast<int>(pixelOffset);
+    }
+
+    // Note is in the future - calculate cumulative distance with SV changes
+    double currentSV = svMultiplierAt(currentTime, timingPoints);
+
+    // Use binary search to find starting index for the loop
+    int loopStartIdx = startIdx + 1;
+    int endIdx = findTimingPoint(noteTime, timingPoints);
+
+    for (int i = loopStartIdx; i <= endIdx && i < (int)timingPoints.size(); i++) {
+        const auto& tp = timingPoints[i];
+        if (tp.time < t1) continue;
+        if (tp.time >= t2) break;
+
+        double segmentTime = tp.time - t1;
+        double effectiveBL = currentBaseBL * currentSV;
+        pixelOffset += 21.0 * userSpeed * segmentTime / std::max(effectiveBL, 1.0) * scale;
+
+        t1 = tp.time;
+        if (tp.uninherited && tp.beatLength > 0) {
+            currentBaseBL = clampBeatLength(tp.beatLength);
+        } else if (!tp.uninherited && tp.beatLength < 0) {
+            currentSV = clampSV(tp.beatLength);
+        }
+    }
+
+    // Calculate remaining segment [t1, t2]
+    double remainingTime = t2 - t1;
+    double effectiveBL = currentBaseBL * currentSV;
+    pixelOffset += 21.0 * userSpeed * remainingTime / std::max(effectiveBL, 1.0) * scale;
+
+    return static_cast<int>(pixelOffset);
+}
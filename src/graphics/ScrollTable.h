@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "OsuParser.h"
+
+// SV scroll distance for Renderer::getNoteY. build() stores the cumulative beats travelled
+// (time / effective beat length) at every timing point, so the distance between two times is
+// two binary-searched lookups and a subtraction instead of a walk over the timing points.
+// Stored in beats so scroll speed, speed mode, clock rate and resolution need no rebuild.
+// Has no SDL dependency, so the table can be checked against the walk outside the game.
+class ScrollTable {
+public:
+    void build(const std::vector<TimingPoint>& timingPoints, double baseBPM);
+    void clear();
+    bool matches(const std::vector<TimingPoint>& timingPoints, double baseBPM) const;  // Built from these
+
+    // Pixels noteTime is above the judge line at currentTime: 21 * userSpeed px per beat at
+    // 480p, times scale. Uses the table when it matches, otherwise the segment walk.
+    int pixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale, double baseBPM,
+                    const std::vector<TimingPoint>& timingPoints) const;
+
+    // Table lookup only; false if the table does not match or the offset is within rounding
+    // error of a pixel boundary, where only the walk gives the exact pixel
+    bool tablePixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale, double baseBPM,
+                          const std::vector<TimingPoint>& timingPoints, int& offset) const;
+
+    // Segment walk over the timing points between the two times (the reference result)
+    static int walkPixelOffset(int64_t noteTime, int64_t currentTime, double userSpeed, double scale, double baseBPM,
+                               const std::vector<TimingPoint>& timingPoints);
+
+    // Index of the last timing point at or before time, -1 if none
+    static int findTimingPoint(int64_t time, const std::vector<TimingPoint>& timingPoints);
+    // SV of the nearest green line at or before time (1.0 if none)
+    static double svMultiplierAt(int64_t time, const std::vector<TimingPoint>& timingPoints);
+
+private:
+    struct Segment {
+        double time;        // Segment start (timing point time)
+        double beatLength;  // Effective beat length in this segment (red line * SV, min 1ms)
+        double beats;       // Cumulative beats at segment start
+    };
+    std::vector<Segment> segments_;  // [0] = before first timing point
+    const TimingPoint* source_ = nullptr;  // Timing points the table was built from
+    size_t sourceSize_ = 0;
+    double bpm_ = 0.0;
+
+    const Segment& findSegment(double time) const;
+    double beatsAt(double time) const;
+};
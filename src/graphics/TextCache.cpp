@@ -0,0 +1,233 @@
+#include "TextCache.h"
+#include <algorithm>
+#include <cstring>
+
+TextCache::TextCache() {}
+
+TextCache::~TextCache() {
+    clear();
+}
+
+void TextCache::init(SDL_Renderer* renderer) {
+    clear();
+    renderer_ = renderer;
+}
+
+void TextCache::clear() {
+    for (auto& e : lru_) {
+        if (e.texture) SDL_DestroyTexture(e.texture);
+    }
+    lru_.clear();
+    index_.clear();
+    pixels_ = 0;
+    for (auto& kv : atlases_) {
+        if (kv.second.texture) SDL_DestroyTexture(kv.second.texture);
+    }
+    atlases_.clear();
+}
+
+void TextCache::endFrame() {
+    frame_++;
+    evict(true);
+}
+
+bool TextCache::measure(TTF_Font* font, const char* text, size_t length, int* w, int* h) const {
+    if (!font || !text || length == 0) return false;
+    return TTF_GetStringSize(font, text, length, w, h);
+}
+
+bool TextCache::draw(TTF_Font* font, const char* text, size_t length, SDL_Color color, float x, float y,
+                     float scaleX, float scaleY, float maxWidth) {
+    if (!renderer_ || !font || !text || length == 0) return false;
+
+    if (useAtlas(text, length)) {
+        const GlyphAtlas* atlas = getAtlas(font);
+        if (atlas && drawAtlas(font, *atlas, text, length, color, x, y, scaleX, scaleY, maxWidth)) {
+            return true;
+        }
+    }
+
+    const Entry* e = get(font, text, length, color);
+    if (!e) return false;
+
+    float srcW = (float)e->w;
+    float dstW = srcW * scaleX;
+    if (maxWidth > 0 && dstW > maxWidth) {
+        srcW = maxWidth / scaleX;
+        dstW = maxWidth;
+    }
+    SDL_FRect src = {0, 0, srcW, (float)e->h};
+    SDL_FRect dst = {x, y, dstW, e->h * scaleY};
+    SDL_SetTextureAlphaMod(e->texture, color.a);
+    SDL_RenderTexture(renderer_, e->texture, &src, &dst);
+    return true;
+}
+
+const TextCache::Entry* TextCache::get(TTF_Font* font, const char* text, size_t length, SDL_Color color) {
+    // Key: font pointer + RGB + text (alpha is applied at draw time)
+    uint32_t rgb = ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+    scratchKey_.assign(reinterpret_cast<const char*>(&font), sizeof(font));
+    scratchKey_.append(reinterpret_cast<const char*>(&rgb), sizeof(rgb));
+    scratchKey_.append(text, length);
+
+    auto found = index_.find(scratchKey_);
+    if (found != index_.end()) {
+        auto it = found->second;
+        it->lastFrame = frame_;
+        lru_.splice(lru_.begin(), lru_, it);
+        return &*it;
+    }
+
+    SDL_Color opaque = {color.r, color.g, color.b, 255};
+    SDL_Surface* s = TTF_RenderText_Blended(font, text, length, opaque);
+    if (!s) return nullptr;
+    SDL_Texture* t = SDL_CreateTextureFromSurface(renderer_, s);
+    int w = s->w;
+    int h = s->h;
+    SDL_DestroySurface(s);
+    if (!t) return nullptr;
+
+    lru_.push_front(Entry{scratchKey_, t, w, h, frame_});
+    index_[scratchKey_] = lru_.begin();
+    pixels_ += (size_t)w * h;
+    evict(false);
+    return &lru_.front();
+}
+
+void TextCache::evict(bool staleOnly) {
+    while (!lru_.empty()) {
+        auto last = std::prev(lru_.end());
+        bool stale = last->lastFrame + EVICT_FRAMES < frame_;
+        // Over budget: drop least recently used, but never text drawn this frame
+        bool overBudget = !staleOnly && (lru_.size() > MAX_ENTRIES || pixels_ > MAX_PIXELS) &&
+                          last->lastFrame != frame_;
+        if (!stale && !overBudget) break;
+        destroyEntry(last);
+    }
+}
+
+void TextCache::destroyEntry(std::list<Entry>::iterator it) {
+    if (it->texture) SDL_DestroyTexture(it->texture);
+    pixels_ -= (size_t)it->w * it->h;
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+bool TextCache::useAtlas(const char* text, size_t length) {
+    if (length > ATLAS_MAX_LENGTH) return false;
+    bool hasDigit = false;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c < ATLAS_FIRST || c >= ATLAS_FIRST + ATLAS_COUNT) return false;
+        if (c >= '0' && c <= '9') hasDigit = true;
+    }
+    return hasDigit;
+}
+
+const TextCache::GlyphAtlas* TextCache::getAtlas(TTF_Font* font) {
+    auto found = atlases_.find(font);
+    if (found != atlases_.end()) {
+        return found->second.texture ? &found->second : nullptr;
+    }
+    GlyphAtlas& atlas = atlases_[font];
+    if (!buildAtlas(font, atlas)) {
+        if (atlas.texture) SDL_DestroyTexture(atlas.texture);
+        atlas.texture = nullptr;
+        return nullptr;
+    }
+    return &atlas;
+}
+
+bool TextCache::buildAtlas(TTF_Font* font, GlyphAtlas& atlas) {
+    const int maxRowWidth = 1024;
+    const int padding = 1;
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* glyphs[ATLAS_COUNT] = {};
+
+    // Render each glyph white (colour is applied with texture colour mod) and pack into rows
+    int penX = 0, penY = 0, rowH = 0, atlasW = 0;
+    for (int i = 0; i < ATLAS_COUNT; i++) {
+        Uint32 ch = (Uint32)(ATLAS_FIRST + i);
+        if (!TTF_FontHasGlyph(font, ch)) continue;
+        int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+        if (!TTF_GetGlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance)) continue;
+        atlas.present[i] = true;
+        atlas.advance[i] = advance;
+        atlas.offsetX[i] = std::min(0, minx);
+
+        SDL_Surface* s = TTF_RenderGlyph_Blended(font, ch, white);
+        if (!s) continue;  // e.g. space: advance only
+        if (penX + s->w > maxRowWidth) {
+            penX = 0;
+            penY += rowH + padding;
+            rowH = 0;
+        }
+        atlas.rects[i] = {penX, penY, s->w, s->h};
+        glyphs[i] = s;
+        penX += s->w + padding;
+        rowH = std::max(rowH, s->h);
+        atlasW = std::max(atlasW, penX);
+    }
+    int atlasH = penY + rowH;
+
+    bool ok = atlasW > 0 && atlasH > 0;
+    SDL_Surface* sheet = ok ? SDL_CreateSurface(atlasW, atlasH, SDL_PIXELFORMAT_ARGB8888) : nullptr;
+    if (sheet) {
+        SDL_FillSurfaceRect(sheet, nullptr, 0);
+        for (int i = 0; i < ATLAS_COUNT; i++) {
+            if (!glyphs[i]) continue;
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphs[i], nullptr, sheet, &atlas.rects[i]);
+        }
+        atlas.texture = SDL_CreateTextureFromSurface(renderer_, sheet);
+        SDL_DestroySurface(sheet);
+    }
+    for (int i = 0; i < ATLAS_COUNT; i++) {
+        if (glyphs[i]) SDL_DestroySurface(glyphs[i]);
+    }
+    if (!atlas.texture) return false;
+
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    atlas.hasKerning = TTF_GetFontKerning(font);
+    return true;
+}
+
+bool TextCache::drawAtlas(TTF_Font* font, const GlyphAtlas& atlas, const char* text, size_t length, SDL_Color color,
+                          float x, float y, float scaleX, float scaleY, float maxWidth) {
+    for (size_t i = 0; i < length; i++) {
+        if (!atlas.present[(unsigned char)text[i] - ATLAS_FIRST]) return false;
+    }
+
+    // Glyphs are laid out like TTF_RenderText: pen advances plus kerning, with the
+    // string shifted right by the first glyph's negative bearing
+    int firstOffset = atlas.offsetX[(unsigned char)text[0] - ATLAS_FIRST];
+    SDL_SetTextureColorMod(atlas.texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas.texture, color.a);
+
+    int pen = -firstOffset;
+    Uint32 prev = 0;
+    for (size_t i = 0; i < length; i++) {
+        Uint32 ch = (unsigned char)text[i];
+        int g = (int)ch - ATLAS_FIRST;
+        if (prev && atlas.hasKerning) {
+            int kerning = 0;
+            if (TTF_GetGlyphKerning(font, prev, ch, &kerning)) pen += kerning;
+        }
+        prev = ch;
+
+        const SDL_Rect& r = atlas.rects[g];
+        float localX = (pen + atlas.offsetX[g]) * scaleX;
+        pen += atlas.advance[g];
+        if (r.w <= 0) continue;
+        if (maxWidth > 0 && localX >= maxWidth) break;
+
+        SDL_FRect src = {(float)r.x, (float)r.y, (float)r.w, (float)r.h};
+        SDL_FRect dst = {x + localX, y, r.w * scaleX, r.h * scaleY};
+        if (maxWidth > 0 && localX + dst.w > maxWidth) {
+            dst.w = maxWidth - localX;
+            src.w = dst.w / scaleX;
+        }
+        SDL_RenderTexture(renderer_, atlas.texture, &src, &dst);
+    }
+    return true;
+}
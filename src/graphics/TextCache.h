@@ -0,0 +1,73 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Caches rasterized text so per-frame UI strings are not re-rendered and re-uploaded
+// every frame. Whole strings live in an LRU keyed by (font, colour, text) and are
+// evicted after going unused for a number of frames; short ASCII strings containing
+// digits (FPS, score, timers) are composed from a per-font glyph atlas instead so
+// that constantly changing numbers do not churn the LRU.
+class TextCache {
+public:
+    TextCache();
+    ~TextCache();
+
+    void init(SDL_Renderer* renderer);
+    void clear();      // Destroy all textures (call before destroying the renderer)
+    void endFrame();   // Advance frame counter and evict stale entries
+
+    // Text size from font metrics (no rasterization)
+    bool measure(TTF_Font* font, const char* text, size_t length, int* w, int* h) const;
+
+    // Draw text with its top-left at (x, y). Colour alpha is applied as texture alpha mod.
+    // maxWidth > 0 clips the text on the right (in destination pixels).
+    bool draw(TTF_Font* font, const char* text, size_t length, SDL_Color color, float x, float y,
+              float scaleX = 1.0f, float scaleY = 1.0f, float maxWidth = 0.0f);
+
+private:
+    static const uint64_t EVICT_FRAMES = 600;      // ~10s at 60fps
+    static const size_t MAX_ENTRIES = 512;
+    static const size_t MAX_PIXELS = 4 * 1024 * 1024;  // 16MB of RGBA textures
+    static const int ATLAS_FIRST = 32;             // Printable ASCII range
+    static const int ATLAS_COUNT = 95;
+    static const size_t ATLAS_MAX_LENGTH = 32;
+
+    struct Entry {
+        std::string key;
+        SDL_Texture* texture;
+        int w;
+        int h;
+        uint64_t lastFrame;
+    };
+
+    struct GlyphAtlas {
+        SDL_Texture* texture = nullptr;
+        SDL_Rect rects[ATLAS_COUNT] = {};  // Source rect of each glyph in the atlas
+        int offsetX[ATLAS_COUNT] = {};     // Glyph surface origin relative to pen position
+        int advance[ATLAS_COUNT] = {};
+        bool present[ATLAS_COUNT] = {};    // Font has this glyph
+        bool hasKerning = false;
+    };
+
+    SDL_Renderer* renderer_ = nullptr;
+    uint64_t frame_ = 0;
+    size_t pixels_ = 0;
+    std::list<Entry> lru_;  // Front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::unordered_map<TTF_Font*, GlyphAtlas> atlases_;  // nullptr texture = atlas unavailable
+    std::string scratchKey_;
+
+    const Entry* get(TTF_Font* font, const char* text, size_t length, SDL_Color color);
+    void evict(bool staleOnly);
+    void destroyEntry(std::list<Entry>::iterator it);
+
+    static bool useAtlas(const char* text, size_t length);
+    const GlyphAtlas* getAtlas(TTF_Font* font);
+    bool buildAtlas(TTF_Font* font, GlyphAtlas& atlas);
+    bool drawAtlas(TTF_Font* font, const GlyphAtlas& atlas, const char* text, size_t length, SDL_Color color,
+                   float x, float y, float scaleX, float scaleY, float maxWidth);
+};
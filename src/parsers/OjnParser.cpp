@@ -1,4 +1,5 @@
 #include "OjnParser.h"
+#include "MappedFile.h"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
@@ -33,66 +34,48 @@ std::string OjnParser::readString(const char* buffer, size_t maxLen) {
     return std::string(buffer, len);
 }
 
+void OjnParser::readHeader(const uint8_t* data, OjnHeader& header) {
+    size_t pos = 0;
+    auto read = [&](void* dst, size_t n) {
+        memcpy(dst, data + pos, n);
+        pos += n;
+    };
+
+    read(&header.songId, 4);
+    read(header.signature, 4);
+    read(&header.encodeVersion, 4);
+    read(&header.genre, 4);
+    read(&header.bpm, 4);
+    for (int i = 0; i < 4; i++) read(&header.level[i], 2);
+    for (int i = 0; i < 3; i++) read(&header.eventCount[i], 4);
+    for (int i = 0; i < 3; i++) read(&header.noteCount[i], 4);
+    for (int i = 0; i < 3; i++) read(&header.measureCount[i], 4);
+    for (int i = 0; i < 3; i++) read(&header.packageCount[i], 4);
+    read(&header.oldEncode, 2);
+    read(&header.oldSongId, 2);
+    read(header.oldGenre, 20);
+    read(&header.bmpSize, 4);
+    read(&header.oldFileVersion, 4);
+    read(header.title, 64);
+    read(header.artist, 32);
+    read(header.noter, 32);
+    read(header.ojmFile, 32);
+    read(&header.coverSize, 4);
+    for (int i = 0; i < 3; i++) read(&header.time[i], 4);
+    for (int i = 0; i < 3; i++) read(&header.noteOffset[i], 4);
+    read(&header.coverOffset, 4);
+}
+
 bool OjnParser::getHeader(const std::string& filepath, OjnHeader& header) {
     std::ifstream file(filepath, std::ios::binary);
     if (!file) return false;
 
     // Read header (300 bytes)
-    file.read(reinterpret_cast<char*>(&header.songId), 4);
-    file.read(header.signature, 4);
-    file.read(reinterpret_cast<char*>(&header.encodeVersion), 4);
-    file.read(reinterpret_cast<char*>(&header.genre), 4);
-    file.read(reinterpret_cast<char*>(&header.bpm), 4);
-
-    // Level (4 x int16)
-    for (int i = 0; i < 4; i++) {
-        file.read(reinterpret_cast<char*>(&header.level[i]), 2);
-    }
-
-    // Event counts (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.eventCount[i]), 4);
-    }
-
-    // Note counts (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.noteCount[i]), 4);
-    }
-
-    // Measure counts (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.measureCount[i]), 4);
-    }
-
-    // Package counts (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.packageCount[i]), 4);
-    }
-
-    file.read(reinterpret_cast<char*>(&header.oldEncode), 2);
-    file.read(reinterpret_cast<char*>(&header.oldSongId), 2);
-    file.read(header.oldGenre, 20);
-    file.read(reinterpret_cast<char*>(&header.bmpSize), 4);
-    file.read(reinterpret_cast<char*>(&header.oldFileVersion), 4);
-    file.read(header.title, 64);
-    file.read(header.artist, 32);
-    file.read(header.noter, 32);
-    file.read(header.ojmFile, 32);
-    file.read(reinterpret_cast<char*>(&header.coverSize), 4);
-
-    // Time (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.time[i]), 4);
-    }
-
-    // Note offsets (3 x int32)
-    for (int i = 0; i < 3; i++) {
-        file.read(reinterpret_cast<char*>(&header.noteOffset[i]), 4);
-    }
-
-    file.read(reinterpret_cast<char*>(&header.coverOffset), 4);
-
-    return file.good();
+    uint8_t buffer[HEADER_SIZE];
+    file.read(reinterpret_cast<char*>(buffer), HEADER_SIZE);
+    if (!file.good()) return false;
+    readHeader(buffer, header);
+    return true;
 }
 
 std::vector<OjnDifficulty> OjnParser::getAvailableDifficulties(const std::string& filepath) {
@@ -198,13 +181,30 @@ int64_t OjnParser::measureToMs(int measure, int position, float bpm,
 
 bool OjnParser::parse(const std::string& filepath, BeatmapInfo& info,
                       OjnDifficulty difficulty) {
-    OjnHeader header;
-    if (!getHeader(filepath, header)) {
+    MappedFile file;
+    if (!file.open(filepath) || file.size() < HEADER_SIZE) {
         return false;
     }
+    OjnHeader header;
+    readHeader(file.data(), header);
+    return parseChart(file.data(), file.size(), header, static_cast<int>(difficulty), info);
+}
 
-    int diffIdx = static_cast<int>(difficulty);
+bool OjnParser::parseAll(const std::string& filepath, OjnHeader& header,
+                         BeatmapInfo (&infos)[3], bool (&parsed)[3]) {
+    MappedFile file;
+    if (!file.open(filepath) || file.size() < HEADER_SIZE) {
+        return false;
+    }
+    readHeader(file.data(), header);
+    for (int i = 0; i < 3; i++) {
+        parsed[i] = parseChart(file.data(), file.size(), header, i, infos[i]);
+    }
+    return true;
+}
 
+bool OjnParser::parseChart(const uint8_t* data, size_t size, const OjnHeader& header,
+                           int diffIdx, BeatmapInfo& info) {
     // Fill metadata
     info.title = readString(header.title, 64);
     info.artist = readString(header.artist, 32);
@@ -222,11 +222,17 @@ bool OjnParser::parse(const std::string& filepath, BeatmapInfo& info,
     info.notes.clear();
     info.timingPoints.clear();
 
-    // Open file and seek to note data
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file) return false;
-
-    file.seekg(header.noteOffset[diffIdx]);
+    // Note data; an offset outside the file leaves the chart empty
+    size_t pos = header.noteOffset[diffIdx] >= 0 ? (size_t)header.noteOffset[diffIdx] : size;
+    auto read = [&](void* dst, size_t n) {
+        if (pos > size || size - pos < n) {
+            pos = size + 1;  // Truncated: every later read fails too
+            return false;
+        }
+        memcpy(dst, data + pos, n);
+        pos += n;
+        return true;
+    };
 
     // BPM changes list
     std::vector<std::pair<int, float>> bpmChanges;
@@ -245,11 +251,7 @@ bool OjnParser::parse(const std::string& filepath, BeatmapInfo& info,
         int16_t channel;
         int16_t eventCount;
 
-        file.read(reinterpret_cast<char*>(&measure), 4);
-        file.read(reinterpret_cast<char*>(&channel), 2);
-        file.read(reinterpret_cast<char*>(&eventCount), 2);
-
-        if (!file.good()) break;
+        if (!read(&measure, 4) || !read(&channel, 2) || !read(&eventCount, 2)) break;
         if (eventCount < 0 || eventCount > 10000) continue;  // Skip corrupted package
 
         // Read events for this package
@@ -258,7 +260,7 @@ bool OjnParser::parse(const std::string& filepath, BeatmapInfo& info,
             // BPM events store a float across all 4 bytes;
             // note events use: sampleId(2) + pan(1) + noteType(1)
             char eventData[4];
-            file.read(eventData, 4);
+            if (!read(eventData, 4)) break;
 
             int16_t sampleId;
             int8_t pan;
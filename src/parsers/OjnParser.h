@@ -67,6 +67,11 @@ public:
     static bool parse(const std::string& filepath, BeatmapInfo& info,
                       OjnDifficulty difficulty = OjnDifficulty::Hard);
 
+    // Parse all three difficulties from a single read of the file. parsed[i] tells whether
+    // infos[i] was filled; returns false if the file or its header could not be read.
+    static bool parseAll(const std::string& filepath, OjnHeader& header,
+                         BeatmapInfo (&infos)[3], bool (&parsed)[3]);
+
     // Check if file is an OJN file
     static bool isOjnFile(const std::string& filepath);
 
@@ -80,6 +85,15 @@ public:
     static std::string extractCover(const std::string& filepath);
 
 private:
+    static const size_t HEADER_SIZE = 300;
+
+    // Decode the 300-byte header from a buffer
+    static void readHeader(const uint8_t* data, OjnHeader& header);
+
+    // Fill info with one difficulty's notes from the whole file in memory
+    static bool parseChart(const uint8_t* data, size_t size, const OjnHeader& header,
+                           int diffIdx, BeatmapInfo& info);
+
     // Convert measure position to milliseconds
     static int64_t measureToMs(int measure, int position, float bpm,
                                const std::vector<std::pair<int, float>>& bpmChanges);
@@ -8,7 +8,7 @@
 #include <SDL3/SDL.h>
 
 std::string OsuParser::calculateMD5(const std::string& filepath) {
-    return MD5::hashFile(filepath);
+    return MD5::hashFileCached(filepath);
 }
 
 std::string OsuParser::trim(const std::string& str) {
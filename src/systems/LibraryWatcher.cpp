@@ -0,0 +1,117 @@
+#include "LibraryWatcher.h"
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+LibraryWatcher::~LibraryWatcher() {
+    stop();
+}
+
+bool LibraryWatcher::takeChanges(std::set<std::string>& dirs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirs.swap(changed_);
+    changed_.clear();
+    bool complete = !overflowed_;
+    overflowed_ = false;
+    return complete;
+}
+
+#ifdef __linux__
+
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+bool LibraryWatcher::start(const std::string& root) {
+    if (active_) return true;
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        std::cerr << "[WATCH] inotify unavailable, refresh will rescan the whole library" << std::endl;
+        return false;
+    }
+    addWatchRecursive(root);
+    std::cerr << "[WATCH] Watching " << watches_.size() << " directories" << std::endl;
+    stopping_ = false;
+    active_ = true;
+    thread_ = std::thread(&LibraryWatcher::threadMain, this);
+    return true;
+}
+
+void LibraryWatcher::stop() {
+    if (!active_) return;
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+    close(fd_);
+    fd_ = -1;
+    watches_.clear();
+    active_ = false;
+}
+
+void LibraryWatcher::addWatchRecursive(const std::string& dir) {
+    int wd = inotify_add_watch(fd_, dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        // Typically max_user_watches; changes below here are missed, so force a full rescan
+        std::lock_guard<std::mutex> lock(mutex_);
+        overflowed_ = true;
+        return;
+    }
+    watches_[wd] = dir;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::error_code typeEc;
+        if (entry.is_directory(typeEc) && !entry.is_symlink(typeEc)) addWatchRecursive(entry.path().string());
+    }
+}
+
+void LibraryWatcher::threadMain() {
+    alignas(inotify_event) char buf[16384];
+    while (!stopping_) {
+        pollfd pfd = {fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        ssize_t len = read(fd_, buf, sizeof(buf));
+        if (len <= 0) continue;
+        for (char* p = buf; p < buf + len;) {
+            const inotify_event* ev = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                overflowed_ = true;
+                continue;
+            }
+            auto it = watches_.find(ev->wd);
+            if (it == watches_.end()) continue;
+            std::string dir = it->second;
+            if (ev->mask & IN_IGNORED) {
+                watches_.erase(it);
+                continue;
+            }
+
+            std::string child = ev->len > 0 ? (fs::path(dir) / ev->name).string() : std::string();
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)) && !child.empty()) {
+                addWatchRecursive(child);
+            }
+
+            // A directory event concerns the directory itself, a file event its parent
+            std::lock_guard<std::mutex> lock(mutex_);
+            changed_.insert((ev->mask & IN_ISDIR) && !child.empty() ? child : dir);
+        }
+    }
+}
+
+#else
+
+bool LibraryWatcher::start(const std::string&) {
+    return false;
+}
+
+void LibraryWatcher::stop() {}
+
+#endif
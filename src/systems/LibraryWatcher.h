@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Watches the Songs tree for changes so a refresh only rescans the folders that changed.
+// Linux only (inotify); elsewhere start() fails and callers fall back to a full walk.
+// Every directory under the root is watched and newly created ones are added as they appear.
+class LibraryWatcher {
+public:
+    LibraryWatcher() = default;
+    ~LibraryWatcher();
+    LibraryWatcher(const LibraryWatcher&) = delete;
+    LibraryWatcher& operator=(const LibraryWatcher&) = delete;
+
+    bool start(const std::string& root);
+    void stop();
+    bool isActive() const { return active_; }
+
+    // Directories with changes since the last call. Returns false if events were lost
+    // (queue overflow), in which case the caller must rescan everything.
+    bool takeChanges(std::set<std::string>& dirs);
+
+private:
+    std::atomic<bool> active_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    std::mutex mutex_;
+    std::set<std::string> changed_;
+    bool overflowed_ = false;
+
+#ifdef __linux__
+    int fd_ = -1;
+    std::unordered_map<int, std::string> watches_;  // Watch descriptor -> directory
+
+    void addWatchRecursive(const std::string& dir);
+    void threadMain();
+#endif
+};
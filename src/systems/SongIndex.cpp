@@ -1,192 +1,831 @@
 #include "SongIndex.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
-#include <functional>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
 // Index file version (increment when format changes)
-static const int INDEX_VERSION = 7;
+static const int INDEX_VERSION = 9;
 
-std::string SongIndex::getIndexDir() {
-    return (fs::path("Data") / "Index").string();
+namespace {
+
+const char DB_MAGIC[8] = {'M', 'P', 'L', 'I', 'B', 'D', 'B', '\0'};
+const char JOURNAL_MAGIC[8] = {'M', 'P', 'L', 'I', 'B', 'J', 'N', '\0'};
+const uint32_t RECORD_MAGIC = 0x44524353;  // "SCRD"
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct DbHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t songCount;
+    uint32_t diffCount;
+    uint32_t fileCount;
+    uint32_t bucketCount;       // Power of two
+    uint64_t songTableOffset;
+    uint64_t diffTableOffset;
+    uint64_t fileTableOffset;
+    uint64_t bucketTableOffset;
+    uint64_t stringPoolOffset;
+    uint64_t stringPoolSize;
+};
+
+struct SongRecord {
+    uint64_t pathHash;
+    int64_t lastModified;
+    StringRef folderPath;       // Lookup key
+    StringRef folderName;
+    StringRef title;
+    StringRef titleUnicode;
+    StringRef artist;
+    StringRef artistUnicode;
+    StringRef backgroundPath;
+    StringRef audioPath;
+    StringRef sourceText;
+    StringRef tags;
+    int32_t previewTime;
+    int32_t source;
+    uint32_t firstDiff;
+    uint32_t diffCount;
+    uint32_t firstFile;
+    uint32_t fileCount;
+};
+
+struct DiffRecord {
+    StringRef path;
+    StringRef version;
+    StringRef creator;
+    StringRef hash;
+    StringRef backgroundPath;
+    StringRef audioPath;
+    int32_t keyCount;
+    int32_t previewTime;
+    double starRatings[STAR_RATING_VERSION_COUNT];
+    double bpmMin;
+    double bpmMax;
+    double bpmMost;
+    int32_t totalLength;
+    int32_t totalObjects;
+    int32_t rcCount;
+    int32_t lnCount;
+    float od;
+    float hp;
+    int32_t fileIndex;
+};
+
+struct FileRecord {
+    StringRef path;
+    StringRef contentHash;
+    uint64_t size;
+    int64_t mtimeNs;
+};
+
+struct JournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t size;      // Payload bytes
+    uint64_t checksum;  // FNV-1a of the payload
+};
+
+uint64_t fnv1a(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t hashPath(const std::string& path) {
+    return fnv1a(path.data(), path.size());
 }
 
-std::string SongIndex::hashPath(const std::string& path) {
-    // Simple hash using std::hash
-    std::hash<std::string> hasher;
-    size_t h = hasher(path);
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
-    return std::string(buf);
+// Write buffered data of f through to the disk
+bool syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
 }
 
-std::string SongIndex::getIndexPath(const std::string& folderPath) {
-    std::string indexDir = getIndexDir();
-    if (!fs::exists(indexDir)) {
-        fs::create_directories(indexDir);
+// Replace to with from, durably: the new name survives a crash once this returns true
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExW(fs::path(from).c_str(), fs::path(to).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(from.c_str(), to.c_str()) != 0) return false;
+    // The rename lives in the directory, which needs its own sync
+    std::string dir = fs::path(to).parent_path().string();
+    int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// Journal payload encoding
+class ByteWriter {
+public:
+    std::string bytes;
+    template <typename T> void put(const T& v) { bytes.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void putString(const std::string& s) {
+        put((uint32_t)s.size());
+        bytes.append(s);
+    }
+};
+
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : p_(data), end_(data + size) {}
+    bool ok() const { return ok_; }
+    template <typename T> void get(T& v) {
+        if (!ok_ || (size_t)(end_ - p_) < sizeof(v)) { ok_ = false; return; }
+        memcpy(&v, p_, sizeof(v));
+        p_ += sizeof(v);
+    }
+    void getString(std::string& s) {
+        uint32_t len = 0;
+        get(len);
+        if (!ok_ || (size_t)(end_ - p_) < len) { ok_ = false; return; }
+        s.assign(p_, len);
+        p_ += len;
+    }
+private:
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+std::string encodeSong(const CachedSong& song) {
+    ByteWriter w;
+    w.put(song.lastModified);
+    w.putString(song.folderPath);
+    w.putString(song.folderName);
+    w.putString(song.title);
+    w.putString(song.titleUnicode);
+    w.putString(song.artist);
+    w.putString(song.artistUnicode);
+    w.putString(song.backgroundPath);
+    w.putString(song.audioPath);
+    w.putString(song.sourceText);
+    w.putString(song.tags);
+    w.put(song.previewTime);
+    w.put(song.source);
+    w.put((uint32_t)song.difficulties.size());
+    for (const auto& diff : song.difficulties) {
+        w.putString(diff.path);
+        w.putString(diff.version);
+        w.putString(diff.creator);
+        w.putString(diff.hash);
+        w.putString(diff.backgroundPath);
+        w.putString(diff.audioPath);
+        w.put(diff.keyCount);
+        w.put(diff.previewTime);
+        w.put(diff.starRatings);
+        w.put(diff.totalLength);
+        w.put(diff.bpmMin);
+        w.put(diff.bpmMax);
+        w.put(diff.bpmMost);
+        w.put(diff.totalObjects);
+        w.put(diff.rcCount);
+        w.put(diff.lnCount);
+        w.put(diff.od);
+        w.put(diff.hp);
+        w.put(diff.fileIndex);
+    }
+    w.put((uint32_t)song.files.size());
+    for (const auto& file : song.files) {
+        w.putString(file.path);
+        w.putString(file.contentHash);
+        w.put(file.size);
+        w.put(file.mtimeNs);
     }
-    return (fs::path(indexDir) / (hashPath(folderPath) + ".idx")).string();
+    return w.bytes;
 }
 
-int64_t SongIndex::getFolderModTime(const std::string& folderPath) {
+bool decodeSong(const char* data, size_t size, CachedSong& song) {
+    ByteReader r(data, size);
+    r.get(song.lastModified);
+    r.getString(song.folderPath);
+    r.getString(song.folderName);
+    r.getString(song.title);
+    r.getString(song.titleUnicode);
+    r.getString(song.artist);
+    r.getString(song.artistUnicode);
+    r.getString(song.backgroundPath);
+    r.getString(song.audioPath);
+    r.getString(song.sourceText);
+    r.getString(song.tags);
+    r.get(song.previewTime);
+    r.get(song.source);
+    uint32_t diffCount = 0;
+    r.get(diffCount);
+    if (!r.ok() || diffCount > size) return false;
+    song.difficulties.clear();
+    song.difficulties.reserve(diffCount);
+    for (uint32_t i = 0; i < diffCount && r.ok(); i++) {
+        CachedDifficulty diff;
+        r.getString(diff.path);
+        r.getString(diff.version);
+        r.getString(diff.creator);
+        r.getString(diff.hash);
+        r.getString(diff.backgroundPath);
+        r.getString(diff.audioPath);
+        r.get(diff.keyCount);
+        r.get(diff.previewTime);
+        r.get(diff.starRatings);
+        r.get(diff.totalLength);
+        r.get(diff.bpmMin);
+        r.get(diff.bpmMax);
+        r.get(diff.bpmMost);
+        r.get(diff.totalObjects);
+        r.get(diff.rcCount);
+        r.get(diff.lnCount);
+        r.get(diff.od);
+        r.get(diff.hp);
+        r.get(diff.fileIndex);
+        song.difficulties.push_back(diff);
+    }
+    uint32_t fileCount = 0;
+    r.get(fileCount);
+    if (!r.ok() || fileCount > size) return false;
+    song.files.clear();
+    song.files.reserve(fileCount);
+    for (uint32_t i = 0; i < fileCount && r.ok(); i++) {
+        FileFingerprint file;
+        r.getString(file.path);
+        r.getString(file.contentHash);
+        r.get(file.size);
+        r.get(file.mtimeNs);
+        song.files.push_back(file);
+    }
+    return r.ok();
+}
+
+class LibraryDB {
+public:
+    std::mutex mutex;
+
+    void ensureOpen();
+    void close();
+    bool find(const std::string& folderPath, CachedSong& song);
+    bool append(const CachedSong& song);
+    bool compact(const std::unordered_set<std::string>& liveFolders);
+
+private:
+    bool opened_ = false;
+    MappedFile file_;
+    const DbHeader* header_ = nullptr;
+    const SongRecord* songs_ = nullptr;
+    const DiffRecord* diffs_ = nullptr;
+    const FileRecord* files_ = nullptr;
+    const uint32_t* buckets_ = nullptr;  // Song index + 1, 0 = empty
+    const char* strings_ = nullptr;
+    std::unordered_map<std::string, CachedSong> journal_;  // Newer than the snapshot
+    FILE* journalOut_ = nullptr;
+
+    static std::string dbPath() { return (fs::path(SongIndex::getIndexDir()) / "library.db").string(); }
+    static std::string journalPath() { return (fs::path(SongIndex::getIndexDir()) / "library.journal").string(); }
+
+    void mapSnapshot();
+    bool snapshotConsistent() const;
+    void loadJournal();
+    bool startJournal();
+    void closeJournal();
+    const SongRecord* findRecord(const std::string& folderPath) const;
+    std::string str(const StringRef& ref) const { return std::string(strings_ + ref.offset, ref.length); }
+    void decodeRecord(const SongRecord& rec, CachedSong& song) const;
+    bool writeSnapshot(const std::string& path, const std::vector<CachedSong>& songs) const;
+};
+
+LibraryDB& db() {
+    static LibraryDB instance;
+    return instance;
+}
+
+void LibraryDB::ensureOpen() {
+    if (opened_) return;
+    opened_ = true;
     try {
-        auto ftime = fs::last_write_time(folderPath);
-        // C++17 compatible: use time_since_epoch directly
-        auto duration = ftime.time_since_epoch();
-        return std::chrono::duration_cast<std::chrono::seconds>(duration).count();
-    } catch (...) {
-        return 0;
+        fs::create_directories(SongIndex::getIndexDir());
+        // Per-folder .idx files from older versions are superseded by the database
+        for (const auto& entry : fs::directory_iterator(SongIndex::getIndexDir())) {
+            if (entry.path().extension() == ".idx") {
+                std::error_code ec;
+                fs::remove(entry.path(), ec);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[INDEX] " << e.what() << std::endl;
     }
+    mapSnapshot();
+    loadJournal();
 }
 
-void SongIndex::writeString(std::ofstream& f, const std::string& s) {
-    uint32_t len = (uint32_t)s.size();
-    f.write(reinterpret_cast<const char*>(&len), sizeof(len));
-    if (len > 0) {
-        f.write(s.data(), len);
+void LibraryDB::close() {
+    file_.close();
+    header_ = nullptr;
+    songs_ = nullptr;
+    diffs_ = nullptr;
+    files_ = nullptr;
+    buckets_ = nullptr;
+    strings_ = nullptr;
+    journal_.clear();
+    closeJournal();
+    opened_ = false;
+}
+
+void LibraryDB::mapSnapshot() {
+    if (!file_.open(dbPath())) return;
+
+    const uint8_t* base = file_.data();
+    size_t size = file_.size();
+    bool valid = size >= sizeof(DbHeader);
+    const DbHeader* h = valid ? reinterpret_cast<const DbHeader*>(base) : nullptr;
+    auto fits = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+    valid = valid && memcmp(h->magic, DB_MAGIC, sizeof(DB_MAGIC)) == 0 && h->version == (uint32_t)INDEX_VERSION &&
+            h->bucketCount > 0 && (h->bucketCount & (h->bucketCount - 1)) == 0 &&
+            h->songTableOffset % alignof(SongRecord) == 0 && h->diffTableOffset % alignof(DiffRecord) == 0 &&
+            h->fileTableOffset % alignof(FileRecord) == 0 && h->bucketTableOffset % alignof(uint32_t) == 0 &&
+            fits(h->songTableOffset, (uint64_t)h->songCount * sizeof(SongRecord)) &&
+            fits(h->diffTableOffset, (uint64_t)h->diffCount * sizeof(DiffRecord)) &&
+            fits(h->fileTableOffset, (uint64_t)h->fileCount * sizeof(FileRecord)) &&
+            fits(h->bucketTableOffset, (uint64_t)h->bucketCount * sizeof(uint32_t)) &&
+            fits(h->stringPoolOffset, h->stringPoolSize);
+    if (!valid) {
+        std::cerr << "[INDEX] library.db is missing or outdated, songs will be rescanned" << std::endl;
+        file_.close();
+        return;
+    }
+    header_ = h;
+    songs_ = reinterpret_cast<const SongRecord*>(base + h->songTableOffset);
+    diffs_ = reinterpret_cast<const DiffRecord*>(base + h->diffTableOffset);
+    files_ = reinterpret_cast<const FileRecord*>(base + h->fileTableOffset);
+    buckets_ = reinterpret_cast<const uint32_t*>(base + h->bucketTableOffset);
+    strings_ = reinterpret_cast<const char*>(base + h->stringPoolOffset);
+    if (!snapshotConsistent()) {
+        std::cerr << "[INDEX] library.db is corrupt, songs will be rescanned" << std::endl;
+        file_.close();
+        header_ = nullptr;
+        songs_ = nullptr;
+        diffs_ = nullptr;
+        files_ = nullptr;
+        buckets_ = nullptr;
+        strings_ = nullptr;
     }
 }
 
-std::string SongIndex::readString(std::ifstream& f) {
-    uint32_t len = 0;
-    f.read(reinterpret_cast<char*>(&len), sizeof(len));
-    if (len == 0 || len > 10000) return "";
-    std::string s(len, '\0');
-    f.read(&s[0], len);
-    return s;
+// Every reference in the tables must stay inside its table or the string pool, so a corrupt
+// file is rejected once here instead of being read out of bounds on lookups
+bool LibraryDB::snapshotConsistent() const {
+    const uint64_t poolSize = header_->stringPoolSize;
+    auto inPool = [poolSize](const StringRef& r) { return r.offset <= poolSize && r.length <= poolSize - r.offset; };
+    auto inTable = [](uint32_t first, uint32_t count, uint32_t size) { return first <= size && count <= size - first; };
+
+    for (uint32_t i = 0; i < header_->songCount; i++) {
+        const SongRecord& s = songs_[i];
+        if (!inPool(s.folderPath) || !inPool(s.folderName) || !inPool(s.title) || !inPool(s.titleUnicode) ||
+            !inPool(s.artist) || !inPool(s.artistUnicode) || !inPool(s.backgroundPath) || !inPool(s.audioPath) ||
+            !inPool(s.sourceText) || !inPool(s.tags) ||
+            !inTable(s.firstDiff, s.diffCount, header_->diffCount) ||
+            !inTable(s.firstFile, s.fileCount, header_->fileCount)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header_->diffCount; i++) {
+        const DiffRecord& d = diffs_[i];
+        if (!inPool(d.path) || !inPool(d.version) || !inPool(d.creator) || !inPool(d.hash) ||
+            !inPool(d.backgroundPath) || !inPool(d.audioPath)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header_->fileCount; i++) {
+        if (!inPool(files_[i].path) || !inPool(files_[i].contentHash)) return false;
+    }
+    for (uint32_t i = 0; i < header_->bucketCount; i++) {
+        if (buckets_[i] > header_->songCount) return false;
+    }
+    return true;
 }
 
-bool SongIndex::isIndexValid(const std::string& folderPath) {
-    std::string indexPath = getIndexPath(folderPath);
-    if (!fs::exists(indexPath)) return false;
+void LibraryDB::loadJournal() {
+    std::string path = journalPath();
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes;
+    if (in) {
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        in.close();
+    }
 
-    std::ifstream f(indexPath, std::ios::binary);
-    if (!f) return false;
+    // Replay complete records; anything after the first torn or corrupt record is dropped
+    size_t validEnd = 0;
+    JournalHeader jh;
+    if (bytes.size() >= sizeof(jh)) {
+        memcpy(&jh, bytes.data(), sizeof(jh));
+        if (memcmp(jh.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 && jh.version == (uint32_t)INDEX_VERSION) {
+            size_t pos = sizeof(jh);
+            validEnd = pos;
+            while (bytes.size() - pos >= sizeof(RecordHeader)) {
+                RecordHeader rh;
+                memcpy(&rh, bytes.data() + pos, sizeof(rh));
+                const char* payload = bytes.data() + pos + sizeof(rh);
+                if (rh.magic != RECORD_MAGIC || bytes.size() - pos - sizeof(rh) < rh.size ||
+                    fnv1a(payload, rh.size) != rh.checksum) {
+                    break;
+                }
+                CachedSong song;
+                if (!decodeSong(payload, rh.size, song)) break;
+                journal_[song.folderPath] = std::move(song);
+                pos += sizeof(rh) + rh.size;
+                validEnd = pos;
+            }
+        }
+    }
 
-    // Read version
-    int version = 0;
-    f.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if (version != INDEX_VERSION) return false;
+    std::error_code ec;
+    if (validEnd == 0) {
+        startJournal();
+        return;
+    }
+    if (validEnd < bytes.size()) {
+        std::cerr << "[INDEX] Dropping torn journal tail (" << (bytes.size() - validEnd) << " bytes)" << std::endl;
+        fs::resize_file(path, validEnd, ec);
+    }
+    journalOut_ = fopen(path.c_str(), "ab");
+}
 
-    // Read stored mod time
-    int64_t storedModTime = 0;
-    f.read(reinterpret_cast<char*>(&storedModTime), sizeof(storedModTime));
+bool LibraryDB::startJournal() {
+    closeJournal();
+    journalOut_ = fopen(journalPath().c_str(), "wb");
+    if (!journalOut_) return false;
+    JournalHeader jh = {};
+    memcpy(jh.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    jh.version = INDEX_VERSION;
+    return fwrite(&jh, sizeof(jh), 1, journalOut_) == 1 && syncFile(journalOut_);
+}
 
-    // Compare with current mod time
-    int64_t currentModTime = getFolderModTime(folderPath);
-    return storedModTime == currentModTime;
+void LibraryDB::closeJournal() {
+    if (journalOut_) {
+        syncFile(journalOut_);
+        fclose(journalOut_);
+    }
+    journalOut_ = nullptr;
 }
 
-bool SongIndex::loadIndex(const std::string& folderPath, CachedSong& song) {
-    std::string indexPath = getIndexPath(folderPath);
-    std::ifstream f(indexPath, std::ios::binary);
-    if (!f) return false;
+const SongRecord* LibraryDB::findRecord(const std::string& folderPath) const {
+    if (!header_) return nullptr;
+    uint64_t h = hashPath(folderPath);
+    uint32_t mask = header_->bucketCount - 1;
+    for (uint32_t i = (uint32_t)h & mask, n = 0; n < header_->bucketCount; i = (i + 1) & mask, n++) {
+        uint32_t slot = buckets_[i];
+        if (slot == 0 || slot > header_->songCount) return nullptr;
+        const SongRecord& rec = songs_[slot - 1];
+        if (rec.pathHash == h && rec.folderPath.length == folderPath.size() &&
+            memcmp(strings_ + rec.folderPath.offset, folderPath.data(), folderPath.size()) == 0) {
+            return &rec;
+        }
+    }
+    return nullptr;
+}
 
-    // Read version
-    int version = 0;
-    f.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if (version != INDEX_VERSION) return false;
-
-    // Read mod time
-    f.read(reinterpret_cast<char*>(&song.lastModified), sizeof(song.lastModified));
-
-    // Read song info
-    song.folderPath = readString(f);
-    song.folderName = readString(f);
-    song.title = readString(f);
-    song.titleUnicode = readString(f);
-    song.artist = readString(f);
-    song.artistUnicode = readString(f);
-    song.backgroundPath = readString(f);
-    song.audioPath = readString(f);
-    song.sourceText = readString(f);
-    song.tags = readString(f);
-    f.read(reinterpret_cast<char*>(&song.previewTime), sizeof(song.previewTime));
-    f.read(reinterpret_cast<char*>(&song.source), sizeof(song.source));
-
-    // Read difficulties
-    uint32_t diffCount = 0;
-    f.read(reinterpret_cast<char*>(&diffCount), sizeof(diffCount));
+void LibraryDB::decodeRecord(const SongRecord& rec, CachedSong& song) const {
+    song.lastModified = rec.lastModified;
+    song.folderPath = str(rec.folderPath);
+    song.folderName = str(rec.folderName);
+    song.title = str(rec.title);
+    song.titleUnicode = str(rec.titleUnicode);
+    song.artist = str(rec.artist);
+    song.artistUnicode = str(rec.artistUnicode);
+    song.backgroundPath = str(rec.backgroundPath);
+    song.audioPath = str(rec.audioPath);
+    song.sourceText = str(rec.sourceText);
+    song.tags = str(rec.tags);
+    song.previewTime = rec.previewTime;
+    song.source = rec.source;
     song.difficulties.clear();
-    song.difficulties.reserve(diffCount);
-
-    for (uint32_t i = 0; i < diffCount; i++) {
+    song.difficulties.reserve(rec.diffCount);
+    for (uint32_t i = 0; i < rec.diffCount && rec.firstDiff + i < header_->diffCount; i++) {
+        const DiffRecord& d = diffs_[rec.firstDiff + i];
         CachedDifficulty diff;
-        diff.path = readString(f);
-        diff.version = readString(f);
-        diff.creator = readString(f);
-        diff.hash = readString(f);
-        diff.backgroundPath = readString(f);
-        diff.audioPath = readString(f);
-        f.read(reinterpret_cast<char*>(&diff.keyCount), sizeof(diff.keyCount));
-        f.read(reinterpret_cast<char*>(&diff.previewTime), sizeof(diff.previewTime));
-        f.read(reinterpret_cast<char*>(diff.starRatings), sizeof(diff.starRatings));
-        f.read(reinterpret_cast<char*>(&diff.totalLength), sizeof(diff.totalLength));
-        f.read(reinterpret_cast<char*>(&diff.bpmMin), sizeof(diff.bpmMin));
-        f.read(reinterpret_cast<char*>(&diff.bpmMax), sizeof(diff.bpmMax));
-        f.read(reinterpret_cast<char*>(&diff.bpmMost), sizeof(diff.bpmMost));
-        f.read(reinterpret_cast<char*>(&diff.totalObjects), sizeof(diff.totalObjects));
-        f.read(reinterpret_cast<char*>(&diff.rcCount), sizeof(diff.rcCount));
-        f.read(reinterpret_cast<char*>(&diff.lnCount), sizeof(diff.lnCount));
-        f.read(reinterpret_cast<char*>(&diff.od), sizeof(diff.od));
-        f.read(reinterpret_cast<char*>(&diff.hp), sizeof(diff.hp));
+        diff.path = str(d.path);
+        diff.version = str(d.version);
+        diff.creator = str(d.creator);
+        diff.hash = str(d.hash);
+        diff.backgroundPath = str(d.backgroundPath);
+        diff.audioPath = str(d.audioPath);
+        diff.keyCount = d.keyCount;
+        diff.previewTime = d.previewTime;
+        for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) diff.starRatings[v] = d.starRatings[v];
+        diff.totalLength = d.totalLength;
+        diff.bpmMin = d.bpmMin;
+        diff.bpmMax = d.bpmMax;
+        diff.bpmMost = d.bpmMost;
+        diff.totalObjects = d.totalObjects;
+        diff.rcCount = d.rcCount;
+        diff.lnCount = d.lnCount;
+        diff.od = d.od;
+        diff.hp = d.hp;
+        diff.fileIndex = d.fileIndex;
         song.difficulties.push_back(diff);
     }
+    song.files.clear();
+    song.files.reserve(rec.fileCount);
+    for (uint32_t i = 0; i < rec.fileCount && rec.firstFile + i < header_->fileCount; i++) {
+        const FileRecord& f = files_[rec.firstFile + i];
+        FileFingerprint file;
+        file.path = str(f.path);
+        file.contentHash = str(f.contentHash);
+        file.size = f.size;
+        file.mtimeNs = f.mtimeNs;
+        song.files.push_back(file);
+    }
+}
 
-    return f.good();
+bool LibraryDB::find(const std::string& folderPath, CachedSong& song) {
+    auto it = journal_.find(folderPath);
+    if (it != journal_.end()) {
+        song = it->second;
+        return true;
+    }
+    const SongRecord* rec = findRecord(folderPath);
+    if (!rec) return false;
+    decodeRecord(*rec, song);
+    return true;
 }
 
-bool SongIndex::saveIndex(const CachedSong& song) {
-    std::string indexPath = getIndexPath(song.folderPath);
-    std::ofstream f(indexPath, std::ios::binary);
+bool LibraryDB::append(const CachedSong& song) {
+    if (!journalOut_ && !startJournal()) return false;
+    std::string payload = encodeSong(song);
+    RecordHeader rh = {RECORD_MAGIC, (uint32_t)payload.size(), fnv1a(payload.data(), payload.size())};
+    // Not synced per record: a song lost in a crash is only rescanned, and the torn tail is
+    // dropped on load. compact() and close() sync the journal once per scan and on exit.
+    bool ok = fwrite(&rh, sizeof(rh), 1, journalOut_) == 1 &&
+              fwrite(payload.data(), 1, payload.size(), journalOut_) == payload.size();
+    journal_[song.folderPath] = song;
+    return ok;
+}
+
+bool LibraryDB::writeSnapshot(const std::string& path, const std::vector<CachedSong>& songs) const {
+    std::string pool;
+    auto addString = [&pool](const std::string& s) {
+        StringRef ref = {(uint32_t)pool.size(), (uint32_t)s.size()};
+        pool.append(s);
+        return ref;
+    };
+
+    std::vector<SongRecord> songTable;
+    std::vector<DiffRecord> diffTable;
+    std::vector<FileRecord> fileTable;
+    songTable.reserve(songs.size());
+    for (const auto& song : songs) {
+        SongRecord rec = {};
+        rec.pathHash = hashPath(song.folderPath);
+        rec.lastModified = song.lastModified;
+        rec.folderPath = addString(song.folderPath);
+        rec.folderName = addString(song.folderName);
+        rec.title = addString(song.title);
+        rec.titleUnicode = addString(song.titleUnicode);
+        rec.artist = addString(song.artist);
+        rec.artistUnicode = addString(song.artistUnicode);
+        rec.backgroundPath = addString(song.backgroundPath);
+        rec.audioPath = addString(song.audioPath);
+        rec.sourceText = addString(song.sourceText);
+        rec.tags = addString(song.tags);
+        rec.previewTime = song.previewTime;
+        rec.source = song.source;
+        rec.firstDiff = (uint32_t)diffTable.size();
+        rec.diffCount = (uint32_t)song.difficulties.size();
+        for (const auto& diff : song.difficulties) {
+            DiffRecord d = {};
+            d.path = addString(diff.path);
+            d.version = addString(diff.version);
+            d.creator = addString(diff.creator);
+            d.hash = addString(diff.hash);
+            d.backgroundPath = addString(diff.backgroundPath);
+            d.audioPath = addString(diff.audioPath);
+            d.keyCount = diff.keyCount;
+            d.previewTime = diff.previewTime;
+            for (int v = 0; v < STAR_RATING_VERSION_COUNT; v++) d.starRatings[v] = diff.starRatings[v];
+            d.bpmMin = diff.bpmMin;
+            d.bpmMax = diff.bpmMax;
+            d.bpmMost = diff.bpmMost;
+            d.totalLength = diff.totalLength;
+            d.totalObjects = diff.totalObjects;
+            d.rcCount = diff.rcCount;
+            d.lnCount = diff.lnCount;
+            d.od = diff.od;
+            d.hp = diff.hp;
+            d.fileIndex = diff.fileIndex;
+            diffTable.push_back(d);
+        }
+        rec.firstFile = (uint32_t)fileTable.size();
+        rec.fileCount = (uint32_t)song.files.size();
+        for (const auto& file : song.files) {
+            FileRecord f = {};
+            f.path = addString(file.path);
+            f.contentHash = addString(file.contentHash);
+            f.size = file.size;
+            f.mtimeNs = file.mtimeNs;
+            fileTable.push_back(f);
+        }
+        songTable.push_back(rec);
+    }
+
+    // Open-addressed hash table at most half full
+    uint32_t bucketCount = 16;
+    while (bucketCount < songTable.size() * 2) bucketCount <<= 1;
+    std::vector<uint32_t> buckets(bucketCount, 0);
+    for (uint32_t i = 0; i < songTable.size(); i++) {
+        uint32_t slot = (uint32_t)songTable[i].pathHash & (bucketCount - 1);
+        while (buckets[slot] != 0) slot = (slot + 1) & (bucketCount - 1);
+        buckets[slot] = i + 1;
+    }
+
+    DbHeader h = {};
+    memcpy(h.magic, DB_MAGIC, sizeof(DB_MAGIC));
+    h.version = INDEX_VERSION;
+    h.songCount = (uint32_t)songTable.size();
+    h.diffCount = (uint32_t)diffTable.size();
+    h.fileCount = (uint32_t)fileTable.size();
+    h.bucketCount = bucketCount;
+    h.songTableOffset = sizeof(DbHeader);
+    h.diffTableOffset = h.songTableOffset + songTable.size() * sizeof(SongRecord);
+    h.fileTableOffset = h.diffTableOffset + diffTable.size() * sizeof(DiffRecord);
+    h.bucketTableOffset = h.fileTableOffset + fileTable.size() * sizeof(FileRecord);
+    h.stringPoolOffset = h.bucketTableOffset + buckets.size() * sizeof(uint32_t);
+    h.stringPoolSize = pool.size();
+
+    FILE* f = fopen(path.c_str(), "wb");
     if (!f) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(songTable.data(), sizeof(SongRecord), songTable.size(), f) == songTable.size() &&
+              fwrite(diffTable.data(), sizeof(DiffRecord), diffTable.size(), f) == diffTable.size() &&
+              fwrite(fileTable.data(), sizeof(FileRecord), fileTable.size(), f) == fileTable.size() &&
+              fwrite(buckets.data(), sizeof(uint32_t), buckets.size(), f) == buckets.size() &&
+              fwrite(pool.data(), 1, pool.size(), f) == pool.size() &&
+              syncFile(f);  // On disk before the rename makes it the snapshot
+    return fclose(f) == 0 && ok;
+}
+
+// Songs are keyed by folder, or by chart file for folders holding several O2Jam songs
+bool isLive(const std::string& key, const std::unordered_set<std::string>& liveFolders) {
+    if (liveFolders.count(key)) return true;
+    std::error_code ec;
+    return liveFolders.count(fs::path(key).parent_path().string()) && fs::is_regular_file(key, ec);
+}
 
-    // Write version
-    int version = INDEX_VERSION;
-    f.write(reinterpret_cast<const char*>(&version), sizeof(version));
-
-    // Write mod time
-    f.write(reinterpret_cast<const char*>(&song.lastModified), sizeof(song.lastModified));
-
-    // Write song info
-    writeString(f, song.folderPath);
-    writeString(f, song.folderName);
-    writeString(f, song.title);
-    writeString(f, song.titleUnicode);
-    writeString(f, song.artist);
-    writeString(f, song.artistUnicode);
-    writeString(f, song.backgroundPath);
-    writeString(f, song.audioPath);
-    writeString(f, song.sourceText);
-    writeString(f, song.tags);
-    f.write(reinterpret_cast<const char*>(&song.previewTime), sizeof(song.previewTime));
-    f.write(reinterpret_cast<const char*>(&song.source), sizeof(song.source));
-
-    // Write difficulties
-    uint32_t diffCount = (uint32_t)song.difficulties.size();
-    f.write(reinterpret_cast<const char*>(&diffCount), sizeof(diffCount));
+bool LibraryDB::compact(const std::unordered_set<std::string>& liveFolders) {
+    // The scan's songs are on disk even if no snapshot can be written
+    if (journalOut_) syncFile(journalOut_);
 
-    for (const auto& diff : song.difficulties) {
-        writeString(f, diff.path);
-        writeString(f, diff.version);
-        writeString(f, diff.creator);
-        writeString(f, diff.hash);
-        writeString(f, diff.backgroundPath);
-        writeString(f, diff.audioPath);
-        f.write(reinterpret_cast<const char*>(&diff.keyCount), sizeof(diff.keyCount));
-        f.write(reinterpret_cast<const char*>(&diff.previewTime), sizeof(diff.previewTime));
-        f.write(reinterpret_cast<const char*>(diff.starRatings), sizeof(diff.starRatings));
-        f.write(reinterpret_cast<const char*>(&diff.totalLength), sizeof(diff.totalLength));
-        f.write(reinterpret_cast<const char*>(&diff.bpmMin), sizeof(diff.bpmMin));
-        f.write(reinterpret_cast<const char*>(&diff.bpmMax), sizeof(diff.bpmMax));
-        f.write(reinterpret_cast<const char*>(&diff.bpmMost), sizeof(diff.bpmMost));
-        f.write(reinterpret_cast<const char*>(&diff.totalObjects), sizeof(diff.totalObjects));
-        f.write(reinterpret_cast<const char*>(&diff.rcCount), sizeof(diff.rcCount));
-        f.write(reinterpret_cast<const char*>(&diff.lnCount), sizeof(diff.lnCount));
-        f.write(reinterpret_cast<const char*>(&diff.od), sizeof(diff.od));
-        f.write(reinterpret_cast<const char*>(&diff.hp), sizeof(diff.hp));
-    }
-
-    return f.good();
+    // Snapshot songs not superseded by the journal, then the journal itself; songs of folders
+    // that are gone from the library are dropped
+    std::vector<CachedSong> songs;
+    size_t dropped = 0;
+    if (header_) {
+        songs.reserve(header_->songCount + journal_.size());
+        for (uint32_t i = 0; i < header_->songCount; i++) {
+            const SongRecord& rec = songs_[i];
+            std::string key = str(rec.folderPath);
+            if (journal_.count(key)) continue;
+            if (!isLive(key, liveFolders)) {
+                dropped++;
+                continue;
+            }
+            songs.emplace_back();
+            decodeRecord(rec, songs.back());
+        }
+    }
+    for (const auto& [path, song] : journal_) {
+        if (isLive(path, liveFolders)) songs.push_back(song);
+        else dropped++;
+    }
+    if (journal_.empty() && dropped == 0) return true;
+
+    std::string tmpPath = dbPath() + ".tmp";
+    if (!writeSnapshot(tmpPath, songs)) {
+        std::cerr << "[INDEX] Failed to write " << tmpPath << std::endl;
+        return false;
+    }
+
+    // The mapping must be released before the file can be replaced (Windows)
+    file_.close();
+    header_ = nullptr;
+    bool replaced = replaceFile(tmpPath, dbPath());
+    mapSnapshot();
+    if (!replaced) {
+        std::cerr << "[INDEX] Failed to replace library.db" << std::endl;
+        return false;
+    }
+    // Only now is the journal redundant; a crash before this point replays it harmlessly
+    journal_.clear();
+    startJournal();
+    std::cerr << "[INDEX] Wrote library.db with " << songs.size() << " songs (" << dropped
+              << " removed)" << std::endl;
+    return true;
+}
+
+}  // namespace
+
+std::string SongIndex::getIndexDir() {
+    return (fs::path("Data") / "Index").string();
+}
+
+int64_t SongIndex::getFolderModTime(const std::string& folderPath) {
+    try {
+        auto ftime = fs::last_write_time(folderPath);
+        // C++17 compatible: use time_since_epoch directly
+        auto duration = ftime.time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    } catch (...) {
+        return 0;
+    }
+}
+
+bool SongIndex::getFileFingerprint(const std::string& path, FileFingerprint& fp) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec) return false;
+    auto ftime = fs::last_write_time(path, ec);
+    if (ec) return false;
+    fp.path = path;
+    fp.size = size;
+    fp.mtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(ftime.time_since_epoch()).count();
+    fp.contentHash.clear();
+    return true;
+}
+
+bool SongIndex::isIndexValid(const CachedSong& song) {
+    // Adding or removing files changes the folder time; in-place edits only show on the files
+    if (getFolderModTime(song.folderPath) != song.lastModified) return false;
+    FileFingerprint current;
+    for (const auto& file : song.files) {
+        if (!getFileFingerprint(file.path, current)) return false;
+        if (current.size != file.size || current.mtimeNs != file.mtimeNs) return false;
+    }
+    return true;
+}
+
+bool SongIndex::loadIndex(const std::string& folderPath, CachedSong& song) {
+    LibraryDB& d = db();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.ensureOpen();
+    return d.find(folderPath, song);
+}
+
+bool SongIndex::saveIndex(const CachedSong& song) {
+    LibraryDB& d = db();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.ensureOpen();
+    return d.append(song);
+}
+
+bool SongIndex::flush(const std::vector<std::string>& liveFolders) {
+    std::unordered_set<std::string> live(liveFolders.begin(), liveFolders.end());
+    LibraryDB& d = db();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.ensureOpen();
+    return d.compact(live);
+}
+
+void SongIndex::close() {
+    LibraryDB& d = db();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.close();
+}
+
+void SongIndex::clear() {
+    LibraryDB& d = db();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.close();
+    std::error_code ec;
+    fs::remove_all(getIndexDir(), ec);
 }
@@ -6,6 +6,14 @@
 // Number of star rating versions we store
 constexpr int STAR_RATING_VERSION_COUNT = 2;
 
+// Identity of a chart file when it was last parsed
+struct FileFingerprint {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    std::string contentHash;  // MD5, lets a touched but unmodified file keep its cache
+};
+
 // Cached difficulty info
 struct CachedDifficulty {
     std::string path;
@@ -29,6 +37,7 @@ struct CachedDifficulty {
     int lnCount = 0;
     float od = 0;
     float hp = 0;
+    int fileIndex = -1;  // Source chart file in CachedSong::files
 };
 
 // Cached song entry
@@ -45,35 +54,47 @@ struct CachedSong {
     std::string tags;            // Space-separated tags
     int previewTime;
     int source;  // 0=Osu, 1=DJMax, 2=O2Jam
-    int64_t lastModified;  // Folder modification time
+    int64_t lastModified;  // Folder modification time (ns)
     std::vector<CachedDifficulty> difficulties;
+    std::vector<FileFingerprint> files;  // Chart files in the folder, including ones that yielded no difficulty
 };
 
+// Song library cache: one memory-mapped database file for the whole library.
+// Data/Index/library.db is an immutable snapshot (fixed-layout song and difficulty
+// tables, a string pool and a folder-path hash table). Songs saved since the snapshot
+// are appended to library.journal as checksummed records, synced once per flush() and on
+// close(); flush() folds them into a new snapshot that is synced to a temp file and renamed
+// over the old one. A crash at any point leaves either the old or the new snapshot plus a
+// journal whose torn tail is ignored (songs lost with it are rescanned). A snapshot with
+// references outside its tables is discarded and rescanned.
+// All functions are thread-safe.
 class SongIndex {
 public:
     // Get index directory path
     static std::string getIndexDir();
 
-    // Get index file path for a song folder
-    static std::string getIndexPath(const std::string& folderPath);
-
-    // Check if index is valid (folder not modified)
-    static bool isIndexValid(const std::string& folderPath);
+    // Check if a loaded entry is still valid (folder and all chart files unmodified)
+    static bool isIndexValid(const CachedSong& song);
 
     // Load cached song from index
     static bool loadIndex(const std::string& folderPath, CachedSong& song);
 
-    // Save song to index
+    // Save song to index (appended to the journal)
     static bool saveIndex(const CachedSong& song);
 
-    // Get folder modification time
-    static int64_t getFolderModTime(const std::string& folderPath);
+    // Fold journaled songs into a new snapshot and drop songs whose folder is not in
+    // liveFolders (call after a scan with every song folder it found)
+    static bool flush(const std::vector<std::string>& liveFolders);
+
+    // Write the journal through and close the database; the next call reopens it (on exit)
+    static void close();
 
-private:
-    // Simple hash for folder path
-    static std::string hashPath(const std::string& path);
+    // Close and delete the database (forced rescan)
+    static void clear();
+
+    // Get folder modification time (ns)
+    static int64_t getFolderModTime(const std::string& folderPath);
 
-    // Write/read helpers
-    static void writeString(std::ofstream& f, const std::string& s);
-    static std::string readString(std::ifstream& f);
+    // Stat a file for change detection (contentHash is left empty)
+    static bool getFileFingerprint(const std::string& path, FileFingerprint& fp);
 };
@@ -0,0 +1,195 @@
+// AudioClock against a stub backend: a device position that only advances once per buffer
+// period, sampled on a jittery wall clock. Checks the 10% drift correction per raw update,
+// the 50 ms snap, monotonicity, pause/seek/stall handling and the per-second reports.
+#include "TestUtil.h"
+#include "AudioClock.h"
+#include <cmath>
+#include <random>
+
+static bool near(double a, double b, double tolerance = 1e-9) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+// Position a device reports at wall time t: whole periods of audio played since startMs
+struct StubDevice {
+    double periodMs;
+    double rate;
+    double startMs;
+    double positionMs;  // Where it was started or seeked to
+
+    double rawAt(double t) const {
+        if (t < startMs) return positionMs;
+        return positionMs + std::floor((t - startMs) / periodMs) * periodMs * rate;
+    }
+};
+
+static void testCorrectionAndSnap() {
+    AudioClock clock;
+    AudioClock::Sample last = {};
+    clock.setObserver([&](const AudioClock::Sample& s) { last = s; });
+
+    // First update follows raw
+    CHECK(near(clock.update(0, true, 0), 0));
+    CHECK(last.snapped);
+
+    // Raw unchanged: extrapolate by the wall clock
+    CHECK(near(clock.update(0, true, 10), 10));
+    CHECK(!last.snapped);
+    CHECK(near(last.driftMs, 0));
+
+    // Raw 20 ms ahead of the extrapolation: 10% of it is corrected
+    CHECK(near(clock.update(40, true, 20), 22));
+    CHECK(near(last.driftMs, 20));
+    CHECK(near(last.jitterMs, 2));
+
+    // Drift of exactly 50 ms is still corrected gradually...
+    CHECK(near(clock.update(73, true, 21), 23 + 5));
+    CHECK(!last.snapped);
+    // ...beyond it the clock snaps to raw
+    CHECK(near(clock.update(79.5, true, 22), 79.5));
+    CHECK(last.snapped);
+    CHECK(near(last.driftMs, 50.5));
+
+    // Negative drift never runs the clock backwards
+    CHECK(near(clock.update(79.5, true, 32), 89.5));
+    CHECK(near(clock.update(80.5, true, 32.5), 89.5));
+    CHECK(near(last.driftMs, -9.5));
+
+    // Rate scales the extrapolation
+    clock.setRate(1.5);
+    CHECK(near(clock.update(80.5, true, 42.5), 89.5 + 15));
+    clock.setRate(0);  // Invalid rates fall back to 1
+    CHECK(near(clock.getRate(), 1.0));
+}
+
+// A device stepping in 10 ms periods, sampled every ~1 ms with wall clock jitter
+static void testSteppedDevice(double rate) {
+    StubDevice device = {10.0, rate, 0.0, 0.0};
+    AudioClock clock;
+    clock.setRate(rate);
+    int snaps = 0;
+    double maxJitter = 0;
+    clock.setObserver([&](const AudioClock::Sample& s) {
+        if (s.snapped) snaps++;
+        maxJitter = std::fmax(maxJitter, std::fabs(s.jitterMs));
+    });
+
+    // Start mid-period: the clock snaps to raw 0 while 5 ms of audio have really played
+    double t = 5.0;
+    clock.update(device.rawAt(t), true, t);
+    snaps = 0;
+
+    // First raw step at 10 ms: predicted 5, drift 5, corrected by 0.5
+    CHECK(near(clock.update(device.rawAt(10.0), true, 10.0), (5.0 + 0.5) * rate));
+
+    // Sampled exactly on each step, the 5 ms start error decays by 0.9 per period
+    double previous = clock.getTime();
+    bool monotonic = true;
+    for (t = 11.0; t <= 1000.0; t += 1.0) {
+        double smoothed = clock.update(device.rawAt(t), true, t);
+        if (smoothed < previous) monotonic = false;
+        previous = smoothed;
+    }
+    CHECK(std::fabs(clock.getTime() - 1000.0 * rate) < 0.001 * rate);
+
+    // Jittery sampling sees each step up to a tick late; the clock stays within about a tick
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> tick(0.7, 1.3);
+    double maxError = 0;
+    while (t < 3000.0) {
+        t += tick(rng);
+        double smoothed = clock.update(device.rawAt(t), true, t);
+        if (smoothed < previous) monotonic = false;
+        previous = smoothed;
+        maxError = std::fmax(maxError, std::fabs(smoothed - t * rate));
+    }
+    CHECK_EQ(snaps, 0);
+    CHECK(monotonic);
+    CHECK(maxError < 1.3 * rate);
+    // Far smoother than the raw 10 ms steps
+    CHECK(maxJitter < 1.0 * rate);
+}
+
+static void testDiscontinuities() {
+    AudioClock clock;
+    bool snapped = false;
+    clock.setObserver([&](const AudioClock::Sample& s) { snapped = s.snapped; });
+    StubDevice device = {10.0, 1.0, 0.0, 0.0};
+    double t = 0;
+    for (; t <= 500; t += 1) clock.update(device.rawAt(t), true, t);
+
+    // Seek: raw jumps forward
+    device = {10.0, 1.0, t, 30000.0};
+    CHECK(near(clock.update(device.rawAt(t), true, t), 30000.0));
+    CHECK(snapped);
+    for (t += 1; t <= 1000; t += 1) clock.update(device.rawAt(t), true, t);
+
+    // Stall: raw stops while "running", the clock runs ahead, then snaps back when raw moves
+    double stalledRaw = device.rawAt(t);
+    for (double end = t + 100; t < end; t += 1) clock.update(stalledRaw, true, t);
+    CHECK(clock.getTime() > stalledRaw + 90);
+    CHECK(near(clock.update(stalledRaw + 10, true, t), stalledRaw + 10));
+    CHECK(snapped);
+
+    // Paused: follows raw exactly, without counting as a snap
+    CHECK(near(clock.update(12345.0, false, t + 50), 12345.0));
+    CHECK(!snapped);
+    CHECK(near(clock.update(12345.0, false, t + 60), 12345.0));
+    // Resumed: snaps to raw, then extrapolates again
+    CHECK(near(clock.update(12345.0, true, t + 70), 12345.0));
+    CHECK(snapped);
+    CHECK(near(clock.update(12345.0, true, t + 75), 12350.0));
+
+    // reset(): the next update snaps
+    clock.reset();
+    CHECK(near(clock.update(100.0, true, t + 80), 100.0));
+    CHECK(snapped);
+
+    // A wall clock going backwards re-syncs instead of extrapolating
+    CHECK(near(clock.update(110.0, true, t + 70), 110.0));
+}
+
+static void testReports() {
+    StubDevice device = {10.0, 1.0, 0.0, 0.0};
+    AudioClock clock;
+    AudioClock::Report report;
+
+    // Off by default
+    for (double t = 0; t <= 1500; t += 1) clock.update(device.rawAt(t), true, t);
+    CHECK(!clock.takeReport(report));
+
+    clock.setLogging(true);
+    int reports = 0;
+    int samples = 0;
+    for (double t = 1501; t <= 4000; t += 1) {
+        clock.update(device.rawAt(t), true, t);
+        if (clock.takeReport(report)) {
+            reports++;
+            samples += report.samples;
+            CHECK_EQ(report.snaps, 0);
+            CHECK(report.maxDriftMs <= 10.0);
+            CHECK(report.meanJitterMs <= report.maxJitterMs);
+            CHECK(std::fabs(report.driftMs) <= 10.0);
+            CHECK(!clock.takeReport(report));  // Handed out once
+        }
+    }
+    CHECK_EQ(reports, 2);
+    CHECK(samples >= 2000 && samples <= 2004);
+
+    // Paused updates are not counted; disabling drops a pending report
+    for (double t = 4001; t <= 6000; t += 1) clock.update(0.0, false, t);
+    CHECK(!clock.takeReport(report));
+    for (double t = 6001; t <= 8000; t += 1) clock.update(device.rawAt(t), true, t);
+    clock.setLogging(false);
+    CHECK(!clock.takeReport(report));
+}
+
+int main() {
+    testCorrectionAndSnap();
+    testSteppedDevice(1.0);
+    testSteppedDevice(1.5);
+    testSteppedDevice(0.75);
+    testDiscontinuities();
+    testReports();
+    return test::result();
+}
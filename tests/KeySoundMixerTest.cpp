@@ -0,0 +1,363 @@
+// KeySoundMixer::render() driven headless, the way the null output does: sample-accurate
+// starts across block boundaries, gains, the resampling path, voice stealing at MAX_VOICES,
+// and removed samples outliving every render() that could still be reading them.
+#include "TestUtil.h"
+#include "KeySoundMixer.h"
+#include "PcmSample.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+
+static PcmSample randomPcm(int frames, int channels, uint32_t freq, unsigned seed) {
+    PcmSample pcm;
+    pcm.freq = freq;
+    pcm.channels = (uint16_t)channels;
+    pcm.data.resize((size_t)frames * channels * 2);
+    std::mt19937 rng(seed);
+    for (int i = 0; i < frames * channels; i++) {
+        int16_t v = (int16_t)(rng() & 0xffff);
+        memcpy(&pcm.data[i * 2], &v, 2);
+    }
+    return pcm;
+}
+
+static PcmSample constantPcm(int frames, int16_t value, uint32_t freq = 44100) {
+    PcmSample pcm;
+    pcm.freq = freq;
+    pcm.channels = 1;
+    pcm.data.resize((size_t)frames * 2);
+    for (int i = 0; i < frames; i++) memcpy(&pcm.data[i * 2], &value, 2);
+    return pcm;
+}
+
+static int16_t sampleAt(const PcmSample& pcm, size_t index) {
+    int16_t v;
+    memcpy(&v, &pcm.data[index * 2], 2);
+    return v;
+}
+
+static std::vector<float> renderBlocks(KeySoundMixer& mixer, size_t blocks, size_t frames) {
+    std::vector<float> all, out(frames * 2);
+    for (size_t b = 0; b < blocks; b++) {
+        mixer.render(out.data(), frames);
+        all.insert(all.end(), out.begin(), out.end());
+    }
+    return all;
+}
+
+static int lastNonZeroFrame(const std::vector<float>& out) {
+    for (size_t f = out.size() / 2; f-- > 0;) {
+        if (out[f * 2] != 0.0f || out[f * 2 + 1] != 0.0f) return (int)f;
+    }
+    return -1;
+}
+
+// setSample() frees what it can before adding; with no sample it adds nothing
+static void collect(KeySoundMixer& mixer) {
+    mixer.setSample(0, nullptr);
+}
+
+static bool silent(const std::vector<float>& out) {
+    return std::all_of(out.begin(), out.end(), [](float v) { return v == 0.0f; });
+}
+
+// Unit-step mixing (SIMD body and scalar tail) of mono, stereo and >2 channel samples, started
+// on a frame inside the second block
+static void testSampleAccurateStart() {
+    for (int channels : {1, 2, 3}) {
+        KeySoundMixer mixer(44100);
+        PcmSample pcm = randomPcm(1003, channels, 44100, channels);
+        mixer.setSample(7, pcm);
+        renderBlocks(mixer, 1, 512);  // Output frames 1..512
+        CHECK(mixer.play(7, 0.5f, -0.5f, 1.0f, 0, 1 + 512 + 100));
+        std::vector<float> out = renderBlocks(mixer, 4, 512);
+
+        const float gainL = 0.5f / 32768.0f, gainR = 0.25f / 32768.0f;
+        const size_t right = channels >= 2 ? 1 : 0;
+        double maxError = 0;
+        for (int f = 0; f < 2048; f++) {
+            int s = f - 100;
+            float l = 0, r = 0;
+            if (s >= 0 && s < 1003) {
+                l = sampleAt(pcm, (size_t)s * channels) * gainL;
+                r = sampleAt(pcm, (size_t)s * channels + right) * gainR;
+            }
+            maxError = std::max(maxError, (double)std::fabs(out[f * 2] - l) + std::fabs(out[f * 2 + 1] - r));
+        }
+        CHECK(maxError < 1e-6);
+        CHECK(out[99 * 2] == 0.0f && out[99 * 2 + 1] == 0.0f);
+        CHECK_EQ(lastNonZeroFrame(out), 100 + 1003 - 1);
+    }
+
+    // A start past the end of the next block waits for its own block
+    KeySoundMixer mixer(44100);
+    mixer.setSample(1, constantPcm(64, 1000));
+    renderBlocks(mixer, 1, 256);  // Frames 1..256
+    mixer.play(1, 1.0f, 0.0f, 1.0f, 0, 257 + 256 + 40);
+    std::vector<float> out = renderBlocks(mixer, 2, 256);
+    CHECK(std::all_of(out.begin(), out.begin() + (256 + 40) * 2, [](float v) { return v == 0.0f; }));
+    CHECK(out[(256 + 40) * 2] != 0.0f);
+    CHECK_EQ(lastNonZeroFrame(out), 256 + 40 + 63);
+}
+
+// gainL = volume * min(1, 1 - pan), gainR = volume * min(1, 1 + pan), pan clamped to [-1, 1]
+static void testGains() {
+    struct Case { float volume, pan, left, right; };
+    const Case cases[] = {
+        {1.0f, 0.0f, 0.5f, 0.5f},
+        {0.5f, -0.5f, 0.25f, 0.125f},
+        {0.5f, 0.5f, 0.125f, 0.25f},
+        {0.8f, -1.0f, 0.4f, 0.0f},
+        {0.8f, 1.0f, 0.0f, 0.4f},
+        {1.0f, 3.0f, 0.0f, 0.5f},
+        {0.0f, 0.0f, 0.0f, 0.0f},
+    };
+    for (const Case& c : cases) {
+        KeySoundMixer mixer(44100);
+        mixer.setSample(1, constantPcm(64, 16384));  // Half of full scale
+        mixer.play(1, c.volume, c.pan);
+        std::vector<float> out = renderBlocks(mixer, 1, 64);
+        for (int f = 0; f < 64; f++) {
+            CHECK(std::fabs(out[f * 2] - c.left) < 1e-6);
+            CHECK(std::fabs(out[f * 2 + 1] - c.right) < 1e-6);
+        }
+    }
+
+    // Voices add up
+    KeySoundMixer mixer(44100);
+    mixer.setSample(1, constantPcm(64, 16384));
+    mixer.setSample(2, constantPcm(64, -8192));
+    mixer.play(1, 1.0f);
+    mixer.play(2, 1.0f, 1.0f);
+    std::vector<float> out = renderBlocks(mixer, 1, 64);
+    CHECK(std::fabs(out[0] - 0.5f) < 1e-6);
+    CHECK(std::fabs(out[1] - 0.25f) < 1e-6);
+}
+
+// Samples at another rate, or played faster or slower, go through linear interpolation
+static void testResampling() {
+    KeySoundMixer mixer(44100);
+    PcmSample pcm = randomPcm(1000, 1, 22050, 5);
+    mixer.setSample(1, pcm);
+
+    // Twice as long at the output rate, with a midpoint between every two source frames
+    mixer.play(1, 1.0f);
+    std::vector<float> out = renderBlocks(mixer, 1, 4096);
+    CHECK_EQ(lastNonZeroFrame(out), 1999);
+    float mid = (sampleAt(pcm, 0) + sampleAt(pcm, 1)) * 0.5f / 32768.0f;
+    CHECK(std::fabs(out[0] - sampleAt(pcm, 0) / 32768.0f) < 1e-6);
+    CHECK(std::fabs(out[2] - mid) < 1e-6);
+    CHECK(std::fabs(out[4] - sampleAt(pcm, 1) / 32768.0f) < 1e-6);
+
+    // offsetMs skips source frames: 20 ms = 441 in, 559 left, 1118 output frames
+    mixer.play(1, 1.0f, 0.0f, 1.0f, 20);
+    out = renderBlocks(mixer, 1, 4096);
+    CHECK_EQ(lastNonZeroFrame(out), 1117);
+    CHECK(std::fabs(out[0] - sampleAt(pcm, 441) / 32768.0f) < 1e-6);
+
+    // rate 2 at the sample's own rate is every other source frame
+    KeySoundMixer fast(22050);
+    fast.setSample(1, pcm);
+    fast.play(1, 1.0f, 0.0f, 2.0f);
+    out = renderBlocks(fast, 1, 1024);
+    CHECK_EQ(lastNonZeroFrame(out), 499);
+    CHECK(std::fabs(out[3 * 2] - sampleAt(pcm, 6) / 32768.0f) < 1e-6);
+
+    // The resampled path also starts on its own frame
+    KeySoundMixer late(44100);
+    late.setSample(1, pcm);
+    late.play(1, 1.0f, 0.0f, 1.0f, 0, 1 + 300);
+    out = renderBlocks(late, 1, 4096);
+    CHECK(out[299 * 2] == 0.0f);
+    CHECK_EQ(lastNonZeroFrame(out), 300 + 1999);
+}
+
+// With every voice busy, a new hit takes over the voice that started first
+static void testVoiceStealing() {
+    KeySoundMixer mixer(44100);
+    mixer.setSample(1, constantPcm(100000, 16384));  // Audible
+    mixer.setSample(2, constantPcm(100000, 0));      // Busy but silent
+    std::vector<float> out;
+
+    mixer.play(1, 1.0f);
+    out = renderBlocks(mixer, 1, 256);
+    CHECK(std::fabs(out[0] - 0.5f) < 1e-6);
+
+    // MAX_VOICES in use: nothing is stolen yet
+    for (int i = 1; i < KeySoundMixer::MAX_VOICES; i++) mixer.play(2, 1.0f);
+    out = renderBlocks(mixer, 1, 256);
+    CHECK(std::fabs(out[0] - 0.5f) < 1e-6);
+    CHECK(std::fabs(out[255 * 2] - 0.5f) < 1e-6);
+
+    // One more steals the oldest voice, the audible one
+    mixer.play(2, 1.0f);
+    out = renderBlocks(mixer, 1, 256);
+    CHECK(silent(out));
+
+    // A hit scheduled inside the block steals on its own frame too: the voices started in the
+    // last block are now the oldest, and the newest (this one) survives the next steal
+    mixer.play(1, 1.0f, 0.0f, 1.0f, 0, 1 + 3 * 256 + 10);
+    out = renderBlocks(mixer, 1, 256);
+    CHECK(out[9 * 2] == 0.0f);
+    CHECK(std::fabs(out[10 * 2] - 0.5f) < 1e-6);
+    mixer.play(2, 1.0f);
+    out = renderBlocks(mixer, 1, 256);
+    CHECK(std::fabs(out[0] - 0.5f) < 1e-6);
+
+    // Pause, resume and stop apply to every voice
+    mixer.pauseAll();
+    CHECK(silent(renderBlocks(mixer, 1, 256)));
+    mixer.resumeAll();
+    CHECK(!silent(renderBlocks(mixer, 1, 256)));
+    mixer.stopAll();
+    CHECK(silent(renderBlocks(mixer, 1, 256)));
+}
+
+// A removed sample stays allocated until its stop is queued and every render() that started
+// before that has finished
+static void testRetiredSamples() {
+    std::vector<float> out(256 * 2);
+
+    // Nothing rendering: freed as soon as the stop is queued
+    {
+        KeySoundMixer mixer(44100);
+        mixer.setSample(1, constantPcm(1000, 100));
+        mixer.play(1, 1.0f);
+        mixer.removeSample(1);
+        collect(mixer);
+        CHECK_EQ(mixer.retiredCount(), (size_t)0);
+        CHECK(silent(renderBlocks(mixer, 1, 256)));
+    }
+
+    // Full queue: the stop cannot be queued, so the sample waits for a render() to drain it
+    {
+        KeySoundMixer mixer(44100);
+        mixer.setSample(1, constantPcm(1000, 100));
+        mixer.setSample(2, constantPcm(1000, 100));
+        size_t queued = 0;
+        while (mixer.play(2, 1.0f)) queued++;
+        CHECK_EQ(queued, KeySoundMixer::QUEUE_SIZE);
+        mixer.removeSample(1);
+        collect(mixer);
+        CHECK_EQ(mixer.retiredCount(), (size_t)1);
+        mixer.render(out.data(), 256);
+        collect(mixer);
+        CHECK_EQ(mixer.retiredCount(), (size_t)0);
+    }
+
+    // A render() in flight on the audio thread keeps the sample alive until it ends
+    {
+        KeySoundMixer mixer(44100);
+        mixer.setSample(1, randomPcm(1 << 20, 1, 32000, 3));
+        for (int i = 0; i < KeySoundMixer::MAX_VOICES; i++) mixer.play(1, 0.01f, 0.0f, 1.0f + i * 0.001f);
+        std::atomic<bool> started{false};
+        std::chrono::steady_clock::time_point renderEnd;
+        std::thread device([&] {
+            std::vector<float> big((size_t)1 << 21);
+            started = true;
+            mixer.render(big.data(), big.size() / 2);  // Resampling 128 voices for a while
+            renderEnd = std::chrono::steady_clock::now();
+        });
+        while (!started) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        mixer.removeSample(1);
+        collect(mixer);
+        size_t retired = mixer.retiredCount();
+        auto checkedAt = std::chrono::steady_clock::now();
+        device.join();
+        if (checkedAt < renderEnd) {
+            CHECK_EQ(retired, (size_t)1);
+        } else {
+            std::cout << "note: render() ended before the check; in-flight case not exercised" << std::endl;
+        }
+        collect(mixer);
+        CHECK_EQ(mixer.retiredCount(), (size_t)0);
+    }
+
+    // Replacing and clearing retire too
+    {
+        KeySoundMixer mixer(44100);
+        mixer.setSample(1, constantPcm(10, 1));
+        mixer.setSample(2, constantPcm(10, 1));
+        mixer.setSample(1, constantPcm(20, 1));
+        CHECK(mixer.hasSample(1));
+        mixer.clear();
+        CHECK(!mixer.hasSample(1) && !mixer.hasSample(2));
+        CHECK_EQ(mixer.retiredCount(), (size_t)0);
+    }
+}
+
+// The game thread replacing, removing and playing samples against a running output; with
+// sanitizers this catches a sample freed under render()
+static void testConcurrentUse() {
+    KeySoundMixer mixer(48000);
+    std::atomic<bool> stop{false};
+    std::thread device([&] {
+        std::vector<float> out(240 * 2);
+        while (!stop) {
+            mixer.render(out.data(), 240);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    std::mt19937 rng(1);
+    std::vector<PcmSample> pcms;
+    for (int i = 0; i < 8; i++) pcms.push_back(randomPcm(2000 + i * 500, 1 + i % 2, i % 3 ? 48000 : 44100, i));
+    for (int it = 0; it < 20000; it++) {
+        int id = rng() % 16;
+        switch (rng() % 6) {
+            case 0: mixer.setSample(id, pcms[rng() % 8]); break;
+            case 1: mixer.removeSample(id); break;
+            case 2: if (rng() % 200 == 0) mixer.clear(); break;
+            default: mixer.play(id, 0.3f, 0.2f, (rng() % 2) ? 1.0f : 1.5f, 0, mixer.scheduleFrame()); break;
+        }
+        if (it % 50 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    mixer.clear();
+    stop = true;
+    device.join();
+    renderBlocks(mixer, 1, 240);  // Drains the queue, so the last stops fit
+    mixer.clear();
+    CHECK_EQ(mixer.retiredCount(), (size_t)0);
+}
+
+// With an output buffer, renders come in bursts with gaps up to the buffer's length between
+// them; a hit in such a gap is still scheduled from the current time, not the next block
+static void testBufferedSchedule() {
+    KeySoundMixer mixer(44100);
+    mixer.setSample(1, constantPcm(64, 1000));
+    renderBlocks(mixer, 4, 64);  // One burst: frames 1..256
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_EQ(mixer.scheduleFrame(), (uint64_t)0);  // Unbuffered, the output looks stalled
+
+    mixer.setOutputBuffer(8192);
+    uint64_t first = mixer.scheduleFrame();
+    CHECK(first >= 257 + 64 + 441);  // At least 10 ms past the burst, plus a block
+    CHECK(first < 257 + 64 + 8192);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    uint64_t second = mixer.scheduleFrame();
+    CHECK(second > first);
+
+    CHECK(mixer.play(1, 1.0f, 0.0f, 1.0f, 0, first));
+    std::vector<float> out = renderBlocks(mixer, 160, 64);  // Frames 257..10496
+    size_t start = (size_t)(first - 257);
+    CHECK(out[(start - 1) * 2] == 0.0f);
+    CHECK(out[start * 2] != 0.0f);
+    CHECK_EQ(lastNonZeroFrame(out), (int)start + 63);
+}
+
+int main() {
+    testSampleAccurateStart();
+    testGains();
+    testResampling();
+    testVoiceStealing();
+    testRetiredSamples();
+    testBufferedSchedule();
+    testConcurrentUse();
+    return test::result();
+}
@@ -0,0 +1,143 @@
+// ScrollTable must give the same pixel as the timing point walk it replaced, for every note
+// Renderer::getNoteY can be asked about: random charts with extreme red lines, huge and
+// Malody scroll=0 SV, ignored lines, duplicate timing points, and notes in the past (fake
+// notes) or before the first timing point.
+#include "TestUtil.h"
+#include "ScrollTable.h"
+#include <random>
+
+static TimingPoint redLine(double time, double beatLength) {
+    TimingPoint tp = {};
+    tp.time = time;
+    tp.beatLength = beatLength;
+    tp.uninherited = true;
+    return tp;
+}
+
+static TimingPoint greenLine(double time, double beatLength) {
+    TimingPoint tp = {};
+    tp.time = time;
+    tp.beatLength = beatLength;
+    tp.uninherited = false;
+    return tp;
+}
+
+static std::vector<TimingPoint> randomChart(std::mt19937& rng) {
+    static const double RED[] = {300.0, 500.0, 0.5, 1.0, 3.7, 12345.6, 20000000.0, 0.0, -500.0};
+    static const double GREEN[] = {-100.0, -50.0, -200.0, -100000.0, -0.01, -0.0001, -33.3, -1e9, 75.0, 0.0};
+    std::uniform_int_distribution<int> count(1, 80);
+    std::uniform_int_distribution<int> gap(0, 3000);
+    std::uniform_int_distribution<int> pick(0, 99);
+
+    std::vector<TimingPoint> tps;
+    double time = std::uniform_int_distribution<int>(-2000, 3000)(rng);
+    tps.push_back(redLine(time, RED[rng() % 3]));
+    int n = count(rng);
+    for (int i = 0; i < n; i++) {
+        if (pick(rng) >= 15) time += gap(rng);  // Otherwise a duplicate time
+        if (pick(rng) < 25) {
+            tps.push_back(redLine(time, RED[rng() % (sizeof(RED) / sizeof(RED[0]))]));
+        } else if (pick(rng) < 50) {
+            tps.push_back(greenLine(time, GREEN[rng() % (sizeof(GREEN) / sizeof(GREEN[0]))]));
+        } else {
+            // Arbitrary SV from 0.1% to 10000%
+            double sv = std::pow(10.0, std::uniform_real_distribution<double>(-1.0, 4.0)(rng));
+            tps.push_back(greenLine(time, -100.0 / (sv / 100.0)));
+        }
+    }
+    return tps;
+}
+
+// A time near the chart: on a timing point, just around one, or anywhere (also before it)
+static int64_t randomTime(std::mt19937& rng, const std::vector<TimingPoint>& tps) {
+    const TimingPoint& tp = tps[rng() % tps.size()];
+    switch (rng() % 4) {
+        case 0: return (int64_t)tp.time;
+        case 1: return (int64_t)tp.time + std::uniform_int_distribution<int>(-3, 3)(rng);
+        default: {
+            int64_t first = (int64_t)tps.front().time - 5000;
+            int64_t span = (int64_t)(tps.back().time - tps.front().time) + 10000;
+            return first + (int64_t)(rng() % (uint64_t)span);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(20260101);
+    static const double SCALES[] = {1.0, 720.0 / 480.0, 1080.0 / 480.0, 1440.0 / 480.0, 2160.0 / 480.0};
+    static const double BPMS[] = {120.0, 180.0, 0.5, 100000.0, 1.0};
+
+    long long queries = 0, tableHits = 0, mismatches = 0;
+    for (int chart = 0; chart < 400; chart++) {
+        std::vector<TimingPoint> tps = randomChart(rng);
+        double baseBPM = BPMS[rng() % 5];
+        ScrollTable table;
+        table.build(tps, baseBPM);
+        CHECK(table.matches(tps, baseBPM));
+
+        for (int q = 0; q < 2000; q++) {
+            int64_t currentTime = randomTime(rng, tps);
+            // Mostly the visible window ahead; sometimes far ahead or in the past (fake notes)
+            int64_t noteTime;
+            switch (rng() % 5) {
+                case 0: noteTime = currentTime - (int64_t)(rng() % 5000); break;
+                case 1: noteTime = randomTime(rng, tps); break;
+                default: noteTime = currentTime + (int64_t)(rng() % 4000); break;
+            }
+            // bpmScaleMode speeds 1-40, or fixed mode at 100+ BPM (at most the same)
+            double userSpeed = 1 + rng() % 40;
+            if (rng() % 2) userSpeed *= 100.0 / (100.0 + rng() % 300);
+            double scale = SCALES[rng() % 5];
+
+            int expected = ScrollTable::walkPixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, tps);
+            int got = table.pixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, tps);
+            int fromTable = 0;
+            if (table.tablePixelOffset(noteTime, currentTime, userSpeed, scale, baseBPM, tps, fromTable)) {
+                tableHits++;
+                if (fromTable != expected) mismatches++;
+            }
+            if (got != expected) {
+                mismatches++;
+                if (mismatches <= 5) {
+                    std::cout << "chart " << chart << " current " << currentTime << " note " << noteTime
+                              << ": " << got << " vs walk " << expected << std::endl;
+                }
+            }
+            queries++;
+        }
+    }
+    std::cout << queries << " queries, " << tableHits << " from the table, "
+              << (queries - tableHits) << " fell back to the walk" << std::endl;
+    CHECK_EQ(mismatches, 0LL);
+    // The walk is only the fallback for offsets on a pixel boundary (exact ones included,
+    // which integer speeds at round BPMs hit often)
+    CHECK(tableHits > queries * 9 / 10);
+
+    // A table built for other timing points (or another BPM) is never used
+    {
+        std::vector<TimingPoint> a = {redLine(0, 500), greenLine(1000, -50)};
+        std::vector<TimingPoint> b = a;
+        ScrollTable table;
+        table.build(a, 120.0);
+        int offset = 0;
+        CHECK(!table.tablePixelOffset(2000, 0, 10, 1.0, 120.0, b, offset));
+        CHECK(!table.tablePixelOffset(2000, 0, 10, 1.0, 150.0, a, offset));
+        CHECK_EQ(table.pixelOffset(2000, 0, 10, 1.0, 120.0, b),
+                 ScrollTable::walkPixelOffset(2000, 0, 10, 1.0, 120.0, b));
+        table.clear();
+        CHECK(!table.matches(a, 120.0));
+    }
+
+    // Known values: 1 beat at 120 BPM is 21 px per unit of speed at 480p; SV 2x doubles it
+    {
+        std::vector<TimingPoint> tps = {redLine(0, 500), greenLine(1000, -50)};
+        ScrollTable table;
+        table.build(tps, 120.0);
+        CHECK_EQ(table.pixelOffset(500, 0, 10, 1.0, 120.0, tps), 210);
+        CHECK_EQ(table.pixelOffset(1500, 1000, 10, 1.0, 120.0, tps), 420);
+        CHECK_EQ(table.pixelOffset(1500, 500, 10, 1.0, 120.0, tps), 630);
+        CHECK_EQ(table.pixelOffset(0, 500, 10, 1.0, 120.0, tps), -210);  // In the past
+    }
+
+    return test::result();
+}
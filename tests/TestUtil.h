@@ -0,0 +1,41 @@
+#pragma once
+#include <iostream>
+
+// Minimal checks for the test executables: a failed CHECK prints its location and the test
+// exits non-zero through test::result(). ctest runs each executable.
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int result() {
+    if (failures() > 0) {
+        std::cout << failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
+
+}  // namespace test
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cout << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            test::failures()++;                                                         \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                  \
+    do {                                                                                \
+        auto checkA_ = (a);                                                             \
+        auto checkB_ = (b);                                                             \
+        if (!(checkA_ == checkB_)) {                                                    \
+            std::cout << __FILE__ << ":" << __LINE__ << ": CHECK_EQ failed: " #a " == " #b \
+                      << " (" << checkA_ << " vs " << checkB_ << ")" << std::endl;       \
+            test::failures()++;                                                         \
+        }                                                                               \
+    } while (0)
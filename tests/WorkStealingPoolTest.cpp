@@ -0,0 +1,85 @@
+// WorkStealingPool: submitted tasks all run before wait() returns, run() batches finish from
+// outside and inside the pool, nested batches do not recurse into unrelated tasks, and a
+// throwing task does not take a worker down.
+#include "TestUtil.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+static void testSubmitAndWait() {
+    WorkStealingPool pool(4);
+    CHECK_EQ(pool.size(), 4u);
+    CHECK(WorkStealingPool::current() == nullptr);
+    std::atomic<int> count{0};
+    std::atomic<int> onPool{0};
+    for (int i = 0; i < 1000; i++) {
+        pool.submit([&] {
+            count++;
+            if (WorkStealingPool::current() == &pool) onPool++;
+        });
+    }
+    pool.wait();
+    CHECK_EQ(count.load(), 1000);
+    CHECK_EQ(onPool.load(), 1000);
+}
+
+static void testRunFromOutside() {
+    WorkStealingPool pool(3);
+    std::atomic<int> count{0};
+    std::vector<std::function<void()>> tasks;
+    for (int i = 0; i < 100; i++) tasks.push_back([&] { count++; });
+    pool.run(tasks);
+    CHECK_EQ(count.load(), 100);
+    CHECK(tasks.empty());
+}
+
+// Folder tasks that each run a batch of analysis tasks, as the scan does. A worker waiting in
+// run() only helps with its own batch, so a task never runs inside another folder task.
+static void testNestedRun(unsigned threads) {
+    static thread_local int depth = 0;
+    WorkStealingPool pool(threads);
+    std::atomic<int> inner{0};
+    std::atomic<int> maxDepth{0};
+    auto enter = [&] {
+        int d = ++depth;
+        int seen = maxDepth.load();
+        while (d > seen && !maxDepth.compare_exchange_weak(seen, d)) {}
+    };
+    for (int i = 0; i < 400; i++) {
+        pool.submit([&] {
+            enter();
+            std::vector<std::function<void()>> tasks;
+            for (int t = 0; t < 3; t++) {
+                tasks.push_back([&] {
+                    enter();
+                    inner++;
+                    depth--;
+                });
+            }
+            WorkStealingPool::current()->run(tasks);
+            depth--;
+        });
+    }
+    pool.wait();
+    CHECK_EQ(inner.load(), 1200);
+    CHECK(maxDepth.load() <= 2);  // Folder task, then one of its own analysis tasks
+}
+
+static void testThrowingTask() {
+    WorkStealingPool pool(2);
+    std::atomic<int> count{0};
+    pool.submit([] { throw std::runtime_error("expected by WorkStealingPoolTest"); });
+    for (int i = 0; i < 10; i++) pool.submit([&] { count++; });
+    pool.wait();
+    CHECK_EQ(count.load(), 10);
+}
+
+int main() {
+    testSubmitAndWait();
+    testRunFromOutside();
+    testNestedRun(1);
+    testNestedRun(4);
+    testThrowingTask();
+    return test::result();
+}